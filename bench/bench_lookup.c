@@ -0,0 +1,170 @@
+/*
+ * bench_lookup.c — random access by name in a large archive.
+ *
+ * Writes an archive of N tiny entries with a sorted central directory and a
+ * name index (ghost slot 0), then resolves Q random names four ways:
+ *
+ *   libzip      zip_open() (builds libzip's name hash table) + zip_name_locate()
+ *   bisect      tacozip_cd_find() on the memory-mapped sorted central directory
+ *   index       tacozip_name_index_find() on the memory-mapped name index
+ *   index-pread tacozip_find_indexed(): ghost read plus three positioned reads
+ *               per name, the access pattern of a remote range reader
+ *
+ * "setup" is the work done once before the first lookup. The numbers that
+ * matter at 1M/10M entries are libzip's setup time and memory against the
+ * per-lookup cost of the two table-free paths.
+ *
+ * Usage: bench_lookup [-n entries] [-q queries] [-o archive] [-keep]
+ * POSIX only.
+ */
+
+#define _GNU_SOURCE
+#include "tacozip.h"
+#include <zip.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static long max_rss_kib(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+static void entry_name(char *buf, size_t cap, uint64_t i) {
+    snprintf(buf, cap, "tiles/z%02u/%010llu.bin", (unsigned)(i % 20), (unsigned long long)i);
+}
+
+static int build(const char *path, uint64_t n) {
+    tacozip_writer_opts_t opts;
+    tacozip_writer_opts_init(&opts);
+    opts.ghost_slots = 1;
+    opts.sort_cd = 1;
+
+    tacozip_writer_t *w;
+    int rc = tacozip_writer_begin(path, &opts, &w);
+    if (rc != TACOZ_OK) return rc;
+    char name[64];
+    for (uint64_t i = 0; i < n && rc == TACOZ_OK; i++) {
+        entry_name(name, sizeof(name), i);
+        rc = tacozip_writer_add_buffer(w, name, &i, sizeof(i));
+    }
+    if (rc == TACOZ_OK) rc = tacozip_writer_add_name_index(w, "index.tnx", 0);
+    if (rc != TACOZ_OK) {
+        tacozip_writer_abort(w);
+        return rc;
+    }
+    return tacozip_writer_finish(w);
+}
+
+static void report(const char *name, double setup, double secs, size_t q, size_t misses) {
+    printf("%-12s setup %9.3f ms  %9.0f ns/lookup  (%zu misses)\n",
+           name, setup * 1e3, secs / (double)q * 1e9, misses);
+}
+
+int main(int argc, char **argv) {
+    uint64_t n = 1000000;
+    size_t q = 200000;
+    const char *path = "bench_lookup.zip";
+    int keep = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) n = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-q") && i + 1 < argc) q = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) path = argv[++i];
+        else if (!strcmp(argv[i], "-keep")) keep = 1;
+        else {
+            fprintf(stderr, "usage: %s [-n entries] [-q queries] [-o archive] [-keep]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (n == 0 || q == 0) return 2;
+
+    double t = now();
+    int rc = build(path, n);
+    if (rc != TACOZ_OK) {
+        fprintf(stderr, "cannot write %s (%d)\n", path, rc);
+        return 1;
+    }
+    printf("wrote %llu entries to %s in %.2f s\n", (unsigned long long)n, path, now() - t);
+
+    /* Query names drawn uniformly, generated up front. */
+    char (*names)[64] = malloc(q * sizeof(*names));
+    if (!names) return 1;
+    unsigned long long seed = 42;
+    for (size_t i = 0; i < q; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        entry_name(names[i], sizeof(names[i]), (seed >> 17) % n);
+    }
+
+    taco_ghost_t *g = malloc(sizeof(*g));
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (!g || fd < 0 || fstat(fd, &st) != 0 || tacozip_read_ghost_v2(path, g) != TACOZ_OK) {
+        fprintf(stderr, "cannot reopen %s\n", path);
+        return 1;
+    }
+    const unsigned char *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 1;
+    int sorted = (g->flags & TACO_GHOST_F_CD_SORTED) != 0;
+    size_t misses;
+
+    /* libzip */
+    long rss0 = max_rss_kib();
+    t = now();
+    int err;
+    zip_t *za = zip_open(path, ZIP_RDONLY, &err);
+    double setup = now() - t;
+    if (za) {
+        misses = 0;
+        t = now();
+        for (size_t i = 0; i < q; i++) misses += zip_name_locate(za, names[i], 0) < 0;
+        report("libzip", setup, now() - t, q, misses);
+        printf("%-12s max RSS grew by %ld KiB\n", "", max_rss_kib() - rss0);
+        zip_close(za);
+    } else {
+        printf("%-12s cannot open with libzip (%d)\n", "libzip", err);
+    }
+
+    /* Bisection over the sorted central directory */
+    taco_entry_info_t e;
+    misses = 0;
+    t = now();
+    for (size_t i = 0; i < q; i++)
+        misses += tacozip_cd_find(map + g->cd_offset, (size_t)g->cd_size, sorted, names[i], &e) != TACOZ_OK;
+    report("bisect", 0, now() - t, q, misses);
+
+    /* Perfect-hash name index */
+    taco_index_entry_t x;
+    misses = 0;
+    t = now();
+    for (size_t i = 0; i < q; i++)
+        misses += tacozip_name_index_find(map + g->slots[0].offset, (size_t)g->slots[0].length,
+                                          g->slots[0].offset, names[i], &x) != TACOZ_OK;
+    report("index", 0, now() - t, q, misses);
+
+    size_t pq = q < 20000 ? q : 20000;
+    misses = 0;
+    t = now();
+    for (size_t i = 0; i < pq; i++) misses += tacozip_find_indexed(path, 0, names[i], &x) != TACOZ_OK;
+    report("index-pread", 0, now() - t, pq, misses);
+
+    munmap((void *)map, (size_t)st.st_size);
+    free(g);
+    free(names);
+    if (!keep) unlink(path);
+    return 0;
+}
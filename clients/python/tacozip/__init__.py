@@ -17,8 +17,13 @@ from .loader import self_check
 # Import APIs directly from bindings
 from .bindings import (
     create, read_ghost, update_ghost,
-    create_multi, read_ghost_multi, update_ghost_multi,
-    replace_file
+    create_multi, read_ghost_multi, update_ghost_multi, create_placed,
+    read_ghost_v2, read_ghost_info, update_ghost_v2, rewrite_ghost,
+    parse_ghost_head, GhostInfo, UniformLayout,
+    find_entry, list_prefix, cd_find, cd_list_prefix, EntryInfo,
+    find_indexed, name_index_find, locate_by_id, read_by_id, id_table_get,
+    replace_file, remove_entries, rename_entry, put_file, compact, CompactStats,
+    log_commit, log_versions, LogVersion, create_from_dir, merge, split, Writer, Reader
 )
 
 # Package metadata
@@ -48,7 +53,18 @@ __all__ = [
     "TACOZ_ERR_INVALID_GHOST",
     "TACOZ_ERR_PARAM",
     "TACOZ_ERR_NOT_FOUND",
+    "TACOZ_ERR_BUSY",
     "TACO_GHOST_MAX_ENTRIES",
+    "TACO_GHOST_V2_MAX_SLOTS",
+    "TACO_GHOST_INLINE_MAX",
+    "TACO_GHOST_F_SLOT_CRC",
+    "TACO_GHOST_F_CD_SORTED",
+    "TACO_GHOST_F_UNIFORM",
+    "TACO_GHOST_HEAD_MAX",
+    "TACOZIP_DURABLE_DEFAULT",
+    "TACOZIP_DURABLE_NONE",
+    "TACOZIP_DURABLE_DATA",
+    "TACOZIP_DURABLE_FULL",
     
     # Exceptions
     "TacozipError",
@@ -62,7 +78,46 @@ __all__ = [
     "create_multi",
     "read_ghost_multi",
     "update_ghost_multi",
+    "create_placed",
+
+    # Ghost v2 API
+    "read_ghost_v2",
+    "read_ghost_info",
+    "update_ghost_v2",
+    "rewrite_ghost",
+    "parse_ghost_head",
+    "GhostInfo",
+    "UniformLayout",
+
+    # Central directory lookup
+    "find_entry",
+    "list_prefix",
+    "cd_find",
+    "cd_list_prefix",
+    "EntryInfo",
+    "find_indexed",
+    "name_index_find",
+    "locate_by_id",
+    "read_by_id",
+    "id_table_get",
     
     # File operations
     "replace_file",
+    "remove_entries",
+    "rename_entry",
+    "put_file",
+    "compact",
+    "CompactStats",
+    "log_commit",
+    "log_versions",
+    "LogVersion",
+    "create_from_dir",
+    "merge",
+    "split",
+
+    # Incremental writer
+    "Writer",
+
+    # Shared reader
+    "Reader",
 ]
\ No newline at end of file
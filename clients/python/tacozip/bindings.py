@@ -1,9 +1,17 @@
 import ctypes
-from ctypes import c_char_p, c_size_t, c_uint64, c_int, c_uint8, Structure, POINTER
-from typing import List, Tuple
+from ctypes import (
+    c_char_p, c_size_t, c_uint, c_uint64, c_int, c_int64, c_uint8, c_void_p,
+    Structure, POINTER, CFUNCTYPE,
+)
+from typing import BinaryIO, Dict, List, NamedTuple, Optional, Tuple
 
 from .loader import get_library
-from .config import TACOZ_OK, TACO_GHOST_MAX_ENTRIES
+from .config import (
+    TACOZ_OK, TACOZ_ERR_PARAM, TACO_GHOST_MAX_ENTRIES, TACO_GHOST_V2_MAX_SLOTS,
+    TACO_GHOST_INLINE_MAX, TACO_GHOST_F_SLOT_CRC, TACO_GHOST_F_CD_SORTED,
+    TACO_GHOST_F_UNIFORM, TACOZIP_DURABLE_DEFAULT,
+    TACOZ_ERR_NOT_FOUND, TACOZ_ERR_INVALID_GHOST,
+)
 from .exceptions import TacozipError
 
 
@@ -26,6 +34,147 @@ class TacoMetaArray(Structure):
     ]
 
 
+class TacoGhost(Structure):
+    """Ghost contents in either format (taco_ghost_t)."""
+    _fields_ = [
+        ("version", ctypes.c_uint16),
+        ("flags", ctypes.c_uint32),
+        ("count", ctypes.c_uint16),
+        ("cd_offset", c_uint64),
+        ("cd_size", c_uint64),
+        ("cd_entries", c_uint64),
+        ("generation", c_uint64),
+        ("uniform_base", c_uint64),
+        ("uniform_stride", c_uint64),
+        ("uniform_size", c_uint64),
+        ("uniform_count", c_uint64),
+        ("slots", TacoMetaEntry * TACO_GHOST_V2_MAX_SLOTS),
+        ("slot_crc", ctypes.c_uint32 * TACO_GHOST_V2_MAX_SLOTS),
+        ("inline_len", ctypes.c_uint32 * TACO_GHOST_V2_MAX_SLOTS),
+        ("inline_off", ctypes.c_uint32 * TACO_GHOST_V2_MAX_SLOTS),
+        ("inline_used", ctypes.c_uint32),
+        ("inline_data", ctypes.c_ubyte * TACO_GHOST_INLINE_MAX),
+    ]
+
+
+class TacozipWriterOpts(Structure):
+    """Options for the incremental writer."""
+    _fields_ = [
+        ("buffer_size", c_size_t),
+        ("cd_mem_cap", c_size_t),
+        ("open_ahead", c_uint),
+        ("ghost_slots", c_uint),
+        ("ghost_inline", c_uint),
+        ("ghost_slack", c_uint),
+        ("sort_cd", c_int),
+        ("uniform_size", c_uint64),
+        ("uniform_align", c_uint),
+        ("durability", c_int),
+    ]
+
+
+class TacozipSplitOpts(Structure):
+    """Options for splitting an archive."""
+    _fields_ = [
+        ("threads", c_uint),
+        ("manifest_path", c_char_p),
+        ("durability", c_int),
+    ]
+
+
+class TacozipSlice(Structure):
+    """Byte range of a source file stored as one entry."""
+    _fields_ = [
+        ("src_path", c_char_p),
+        ("offset", c_uint64),
+        ("length", c_uint64),
+        ("crc32", ctypes.c_uint32),
+        ("has_crc", c_int),
+    ]
+
+
+class TacozipDirOpts(Structure):
+    """Options for directory ingestion."""
+    _fields_ = [
+        ("include", POINTER(c_char_p)),
+        ("num_include", c_size_t),
+        ("exclude", POINTER(c_char_p)),
+        ("num_exclude", c_size_t),
+        ("arc_prefix", c_char_p),
+        ("sort", c_int),
+        ("threads", c_uint),
+        ("follow_symlinks", c_int),
+    ]
+
+
+class TacozipMergeOpts(Structure):
+    """Options for merging archives."""
+    _fields_ = [
+        ("align", c_uint),
+        ("ghost_slack", c_uint),
+        ("durability", c_int),
+    ]
+
+
+TACOZIP_SORT_PATH = 0
+TACOZIP_SORT_NONE = 1
+
+TACOZIP_META_LAST = 0
+TACOZIP_META_FIRST = 1
+
+
+# int64_t (*tacozip_read_fn)(void *user, void *buf, size_t cap)
+READ_FN = CFUNCTYPE(c_int64, c_void_p, c_void_p, c_size_t)
+
+
+class TacozipCompactStats(Structure):
+    """Space accounting filled in by tacozip_compact."""
+    _fields_ = [
+        ("file_size", c_uint64),
+        ("dead_bytes", c_uint64),
+        ("holes", c_uint64),
+        ("largest_hole", c_uint64),
+        ("bytes_moved", c_uint64),
+        ("reclaimed", c_uint64),
+    ]
+
+
+class TacoEntryInfo(Structure):
+    """One central-directory record reported by the lookup functions."""
+    _fields_ = [
+        ("name", ctypes.POINTER(ctypes.c_char)),
+        ("name_len", ctypes.c_uint16),
+        ("method", ctypes.c_uint16),
+        ("crc32", ctypes.c_uint32),
+        ("compressed_size", c_uint64),
+        ("uncompressed_size", c_uint64),
+        ("lfh_offset", c_uint64),
+    ]
+
+
+class TacoIndexEntry(Structure):
+    """Where an entry found through the name index lives."""
+    _fields_ = [("offset", c_uint64), ("length", c_uint64), ("crc32", ctypes.c_uint32)]
+
+
+# int (*tacozip_entry_fn)(void *user, const taco_entry_info_t *entry)
+ENTRY_FN = CFUNCTYPE(c_int, c_void_p, POINTER(TacoEntryInfo))
+
+
+class TacozipLogVersion(Structure):
+    """One published directory of a log-structured archive."""
+    _fields_ = [
+        ("generation", c_uint64),
+        ("cd_offset", c_uint64),
+        ("cd_size", c_uint64),
+        ("cd_entries", c_uint64),
+        ("end", c_uint64),
+    ]
+
+
+LOG_FN = CFUNCTYPE(c_int, c_void_p, POINTER(TacozipLogVersion))
+
+
 # Global library instance
 _lib = get_library()
 
@@ -48,6 +197,12 @@ _lib.tacozip_create_multi.argtypes = [
 ]
 _lib.tacozip_create_multi.restype = c_int
 
+_lib.tacozip_create_placed.argtypes = [
+    c_char_p, POINTER(c_char_p), POINTER(c_char_p), c_size_t,
+    POINTER(c_char_p), POINTER(c_char_p), c_size_t, c_int
+]
+_lib.tacozip_create_placed.restype = c_int
+
 _lib.tacozip_read_ghost_multi.argtypes = [c_char_p, POINTER(TacoMetaArray)]
 _lib.tacozip_read_ghost_multi.restype = c_int
 
@@ -59,6 +214,173 @@ _lib.tacozip_update_ghost_multi.restype = c_int
 _lib.tacozip_replace_file.argtypes = [c_char_p, c_char_p, c_char_p]
 _lib.tacozip_replace_file.restype = c_int
 
+_lib.tacozip_remove_entries.argtypes = [c_char_p, POINTER(c_char_p), c_size_t]
+_lib.tacozip_remove_entries.restype = c_int
+
+_lib.tacozip_rename_entry.argtypes = [c_char_p, c_char_p, c_char_p]
+_lib.tacozip_rename_entry.restype = c_int
+
+_lib.tacozip_compact.argtypes = [c_char_p, c_uint64, POINTER(TacozipCompactStats)]
+_lib.tacozip_compact.restype = c_int
+
+_lib.tacozip_put_file.argtypes = [c_char_p, c_char_p, c_char_p]
+_lib.tacozip_put_file.restype = c_int
+
+_lib.tacozip_log_commit.argtypes = [
+    c_char_p, POINTER(c_char_p), POINTER(c_char_p), c_size_t, c_int, POINTER(TacozipLogVersion)
+]
+_lib.tacozip_log_commit.restype = c_int
+
+_lib.tacozip_log_versions.argtypes = [c_char_p, LOG_FN, c_void_p]
+_lib.tacozip_log_versions.restype = c_int
+
+_lib.tacozip_writer_opts_init.argtypes = [POINTER(TacozipWriterOpts)]
+_lib.tacozip_writer_opts_init.restype = None
+
+_lib.tacozip_writer_begin.argtypes = [c_char_p, POINTER(TacozipWriterOpts), POINTER(c_void_p)]
+_lib.tacozip_writer_begin.restype = c_int
+
+_lib.tacozip_writer_set_ghost.argtypes = [
+    c_void_p, POINTER(c_uint64), POINTER(c_uint64), c_size_t
+]
+_lib.tacozip_writer_set_ghost.restype = c_int
+
+_lib.tacozip_writer_set_ghost_v2.argtypes = [c_void_p, POINTER(TacoGhost)]
+_lib.tacozip_writer_set_ghost_v2.restype = c_int
+
+_lib.tacozip_ghost_init.argtypes = [POINTER(TacoGhost)]
+_lib.tacozip_ghost_init.restype = None
+
+_lib.tacozip_ghost_set_inline.argtypes = [POINTER(TacoGhost), c_uint, c_char_p, ctypes.c_uint32]
+_lib.tacozip_ghost_set_inline.restype = c_int
+
+_lib.tacozip_read_ghost_v2.argtypes = [c_char_p, POINTER(TacoGhost)]
+_lib.tacozip_read_ghost_v2.restype = c_int
+
+_lib.tacozip_update_ghost_v2.argtypes = [c_char_p, POINTER(TacoGhost)]
+_lib.tacozip_update_ghost_v2.restype = c_int
+
+_lib.tacozip_rewrite_ghost.argtypes = [c_char_p, POINTER(TacoGhost), ctypes.c_uint32, c_int]
+_lib.tacozip_rewrite_ghost.restype = c_int
+
+_lib.tacozip_parse_ghost_head.argtypes = [c_char_p, c_size_t, POINTER(TacoGhost)]
+_lib.tacozip_parse_ghost_head.restype = c_int
+
+_lib.tacozip_cd_find.argtypes = [c_char_p, c_size_t, c_int, c_char_p, POINTER(TacoEntryInfo)]
+_lib.tacozip_cd_find.restype = c_int
+
+_lib.tacozip_cd_list_prefix.argtypes = [c_char_p, c_size_t, c_int, c_char_p, ENTRY_FN, c_void_p]
+_lib.tacozip_cd_list_prefix.restype = c_int
+
+_lib.tacozip_find_entry.argtypes = [c_char_p, c_char_p, POINTER(TacoEntryInfo)]
+_lib.tacozip_find_entry.restype = c_int
+
+_lib.tacozip_list_prefix.argtypes = [c_char_p, c_char_p, ENTRY_FN, c_void_p]
+_lib.tacozip_list_prefix.restype = c_int
+
+_lib.tacozip_writer_add_name_index.argtypes = [c_void_p, c_char_p, c_uint]
+_lib.tacozip_writer_add_name_index.restype = c_int
+
+_lib.tacozip_name_index_find.argtypes = [c_char_p, c_size_t, c_uint64, c_char_p, POINTER(TacoIndexEntry)]
+_lib.tacozip_name_index_find.restype = c_int
+
+_lib.tacozip_find_indexed.argtypes = [c_char_p, c_uint, c_char_p, POINTER(TacoIndexEntry)]
+_lib.tacozip_find_indexed.restype = c_int
+
+_lib.tacozip_writer_add_id_table.argtypes = [c_void_p, c_char_p, c_uint]
+_lib.tacozip_writer_add_id_table.restype = c_int
+
+_lib.tacozip_id_table_get.argtypes = [c_char_p, c_size_t, c_uint64, c_uint64, POINTER(c_uint64), POINTER(c_uint64)]
+_lib.tacozip_id_table_get.restype = c_int
+
+_lib.tacozip_locate_by_id.argtypes = [c_char_p, c_uint, c_uint64, POINTER(c_uint64), POINTER(c_uint64)]
+_lib.tacozip_locate_by_id.restype = c_int
+
+_lib.tacozip_read_by_id.argtypes = [c_char_p, c_uint, c_uint64, c_void_p, c_size_t, POINTER(c_uint64)]
+_lib.tacozip_read_by_id.restype = c_int
+
+_lib.tacozip_reader_open.argtypes = [c_char_p, POINTER(c_void_p)]
+_lib.tacozip_reader_open.restype = c_int
+
+_lib.tacozip_reader_open_version.argtypes = [c_char_p, c_uint64, POINTER(c_void_p)]
+_lib.tacozip_reader_open_version.restype = c_int
+
+_lib.tacozip_reader_close.argtypes = [c_void_p]
+_lib.tacozip_reader_close.restype = None
+
+_lib.tacozip_reader_count.argtypes = [c_void_p]
+_lib.tacozip_reader_count.restype = c_uint64
+
+_lib.tacozip_reader_ghost.argtypes = [c_void_p, POINTER(TacoGhost)]
+_lib.tacozip_reader_ghost.restype = c_int
+
+_lib.tacozip_reader_entry.argtypes = [c_void_p, c_uint64, POINTER(TacoEntryInfo)]
+_lib.tacozip_reader_entry.restype = c_int
+
+_lib.tacozip_reader_find.argtypes = [c_void_p, c_char_p, POINTER(TacoEntryInfo)]
+_lib.tacozip_reader_find.restype = c_int
+
+_lib.tacozip_reader_read.argtypes = [
+    c_void_p, POINTER(TacoEntryInfo), c_uint64, c_void_p, c_size_t, POINTER(c_size_t)
+]
+_lib.tacozip_reader_read.restype = c_int
+
+_lib.tacozip_writer_add_file.argtypes = [c_void_p, c_char_p, c_char_p]
+_lib.tacozip_writer_add_file.restype = c_int
+
+_lib.tacozip_writer_add_meta_file.argtypes = [c_void_p, c_char_p, c_char_p, c_uint]
+_lib.tacozip_writer_add_meta_file.restype = c_int
+
+_lib.tacozip_writer_add_files.argtypes = [
+    c_void_p, POINTER(c_char_p), POINTER(c_char_p), c_size_t, POINTER(c_size_t)
+]
+_lib.tacozip_writer_add_files.restype = c_int
+
+_lib.tacozip_writer_add_slices.argtypes = [
+    c_void_p, POINTER(TacozipSlice), POINTER(c_char_p), c_size_t, POINTER(c_size_t)
+]
+_lib.tacozip_writer_add_slices.restype = c_int
+
+_lib.tacozip_dir_opts_init.argtypes = [POINTER(TacozipDirOpts)]
+_lib.tacozip_dir_opts_init.restype = None
+
+_lib.tacozip_writer_add_dir.argtypes = [
+    c_void_p, c_char_p, POINTER(TacozipDirOpts), POINTER(c_size_t)
+]
+_lib.tacozip_writer_add_dir.restype = c_int
+
+_lib.tacozip_create_from_dir.argtypes = [
+    c_char_p, c_char_p, POINTER(TacozipDirOpts),
+    POINTER(c_uint64), POINTER(c_uint64), c_size_t
+]
+_lib.tacozip_create_from_dir.restype = c_int
+
+_lib.tacozip_merge_opts_init.argtypes = [POINTER(TacozipMergeOpts)]
+_lib.tacozip_merge_opts_init.restype = None
+
+_lib.tacozip_merge.argtypes = [c_char_p, POINTER(c_char_p), c_size_t, POINTER(TacozipMergeOpts)]
+_lib.tacozip_merge.restype = c_int
+
+_lib.tacozip_split_opts_init.argtypes = [POINTER(TacozipSplitOpts)]
+_lib.tacozip_split_opts_init.restype = None
+
+_lib.tacozip_split.argtypes = [
+    c_char_p, c_char_p, c_uint64, POINTER(TacozipSplitOpts), POINTER(c_size_t)
+]
+_lib.tacozip_split.restype = c_int
+
+_lib.tacozip_writer_add_buffer.argtypes = [c_void_p, c_char_p, c_char_p, c_size_t]
+_lib.tacozip_writer_add_buffer.restype = c_int
+
+_lib.tacozip_writer_add_stream.argtypes = [c_void_p, c_char_p, READ_FN, c_void_p]
+_lib.tacozip_writer_add_stream.restype = c_int
+
+_lib.tacozip_writer_finish.argtypes = [c_void_p]
+_lib.tacozip_writer_finish.restype = c_int
+
+_lib.tacozip_writer_abort.argtypes = [c_void_p]
+_lib.tacozip_writer_abort.restype = None
+
 
 def _check_result(result: int):
     """Check C function result and raise exception if error."""
@@ -154,9 +476,456 @@ def update_ghost_multi(zip_path: str, meta_offsets: List[int], meta_lengths: Lis
     _check_result(result)
 
 
+def create_placed(zip_path: str, src_files: List[str], arc_files: List[str],
+                  meta_src_files: List[str], meta_arc_files: List[str],
+                  placement: str = "last"):
+    """Create an archive whose ghost slots point at the given metadata files.
+
+    The writer places the metadata entries ``"last"`` (just before the central
+    directory, so one tail read fetches both) or ``"first"`` (right after the
+    ghost) and fills slot i with the offset and length of metadata file i.
+    """
+    modes = {"last": TACOZIP_META_LAST, "first": TACOZIP_META_FIRST}
+    if placement not in modes:
+        raise ValueError("placement must be 'last' or 'first'")
+    if len(src_files) != len(arc_files) or len(meta_src_files) != len(meta_arc_files):
+        raise ValueError("source and archive name lists must have the same length")
+
+    src_array, src_bytes = _prepare_string_array(src_files)
+    arc_array, arc_bytes = _prepare_string_array(arc_files)
+    msrc_array, msrc_bytes = _prepare_string_array(meta_src_files)
+    marc_array, marc_bytes = _prepare_string_array(meta_arc_files)
+
+    result = _lib.tacozip_create_placed(
+        zip_path.encode('utf-8'), src_array, arc_array, len(src_files),
+        msrc_array, marc_array, len(meta_src_files), modes[placement]
+    )
+    _check_result(result)
+
+
+def _prepare_dir_opts(include: Optional[List[str]], exclude: Optional[List[str]],
+                      arc_prefix: Optional[str], sort: bool, threads: int,
+                      follow_symlinks: bool) -> Tuple[TacozipDirOpts, list]:
+    """Build a TacozipDirOpts; the second value keeps the C strings alive."""
+    opts = TacozipDirOpts()
+    _lib.tacozip_dir_opts_init(ctypes.byref(opts))
+    keep: list = []
+    if include:
+        arr, data = _prepare_string_array(include)
+        opts.include, opts.num_include = arr, len(include)
+        keep += [arr, data]
+    if exclude:
+        arr, data = _prepare_string_array(exclude)
+        opts.exclude, opts.num_exclude = arr, len(exclude)
+        keep += [arr, data]
+    if arc_prefix:
+        prefix = arc_prefix.encode('utf-8')
+        opts.arc_prefix = prefix
+        keep.append(prefix)
+    opts.sort = TACOZIP_SORT_PATH if sort else TACOZIP_SORT_NONE
+    opts.threads = threads
+    opts.follow_symlinks = 1 if follow_symlinks else 0
+    return opts, keep
+
+
+def create_from_dir(zip_path: str, root_dir: str,
+                    include: Optional[List[str]] = None,
+                    exclude: Optional[List[str]] = None,
+                    arc_prefix: Optional[str] = None,
+                    sort: bool = True, threads: int = 0,
+                    follow_symlinks: bool = False,
+                    meta_offsets: Optional[List[int]] = None,
+                    meta_lengths: Optional[List[int]] = None):
+    """
+    Create an archive from every regular file under ``root_dir``.
+
+    Archive names are the '/'-separated paths relative to ``root_dir``.
+    ``include``/``exclude`` take glob patterns ('*', '**', '?', '[...]');
+    a pattern with '/' matches the relative path, otherwise the base name.
+
+    Example:
+        >>> create_from_dir("data.taco.zip", "/data/tiles", include=["*.tif"])
+    """
+    opts, keep = _prepare_dir_opts(include, exclude, arc_prefix, sort, threads,
+                                   follow_symlinks)
+    result = _lib.tacozip_create_from_dir(
+        zip_path.encode('utf-8'), root_dir.encode('utf-8'), ctypes.byref(opts),
+        _prepare_uint64_array(meta_offsets or []),
+        _prepare_uint64_array(meta_lengths or []),
+        TACO_GHOST_MAX_ENTRIES
+    )
+    _check_result(result)
+
+
+def merge(zip_path: str, shard_paths: List[str], align: Optional[int] = None,
+          ghost_slack: int = 0, durability: Optional[int] = None):
+    """
+    Concatenate archives into a new one without extracting them.
+
+    Entry data is copied verbatim (shared, not copied, on filesystems that
+    clone extents) and only the central directory is rewritten. The shards'
+    ghost slots are collected, in shard order, into one new ghost.
+
+    Example:
+        >>> merge("all.taco.zip", ["part-0.taco.zip", "part-1.taco.zip"])
+    """
+    if not shard_paths:
+        raise ValueError("No shards to merge")
+    opts = TacozipMergeOpts()
+    _lib.tacozip_merge_opts_init(ctypes.byref(opts))
+    if align is not None:
+        opts.align = align
+    opts.ghost_slack = ghost_slack
+    if durability is not None:
+        opts.durability = durability
+    paths, _keep = _prepare_string_array(shard_paths)
+    _check_result(_lib.tacozip_merge(
+        zip_path.encode('utf-8'), paths, len(shard_paths), ctypes.byref(opts)
+    ))
+
+
+def split(zip_path: str, out_prefix: str, max_shard_size: int, threads: int = 0,
+          manifest_path: Optional[str] = None, durability: Optional[int] = None) -> int:
+    """
+    Cut an archive into shards of at most max_shard_size bytes.
+
+    Entries are copied whole and verbatim; shard i is written to
+    out_prefix + "%05d.zip" % i. Returns the number of shards written.
+
+    Example:
+        >>> split("all.taco.zip", "part-", 1 << 30, manifest_path="parts.json")
+    """
+    opts = TacozipSplitOpts()
+    _lib.tacozip_split_opts_init(ctypes.byref(opts))
+    opts.threads = threads
+    if manifest_path is not None:
+        opts.manifest_path = manifest_path.encode('utf-8')
+    if durability is not None:
+        opts.durability = durability
+    count = c_size_t(0)
+    _check_result(_lib.tacozip_split(
+        zip_path.encode('utf-8'), out_prefix.encode('utf-8'), max_shard_size,
+        ctypes.byref(opts), ctypes.byref(count)
+    ))
+    return count.value
+
+
+def _prepare_ghost(entries: List[tuple], checksums: bool = False) -> TacoGhost:
+    """Convert (offset, length[, inline bytes]) tuples to a TacoGhost.
+
+    With checksums the library stores a CRC-32 of each slot's bytes.
+    """
+    if len(entries) > TACO_GHOST_V2_MAX_SLOTS:
+        raise ValueError(f"Too many slots: {len(entries)} > {TACO_GHOST_V2_MAX_SLOTS}")
+    ghost = TacoGhost()
+    _lib.tacozip_ghost_init(ctypes.byref(ghost))
+    ghost.count = len(entries)
+    if checksums:
+        ghost.flags |= TACO_GHOST_F_SLOT_CRC
+    for i, entry in enumerate(entries):
+        ghost.slots[i].offset = entry[0]
+        ghost.slots[i].length = entry[1]
+    for i, entry in enumerate(entries):
+        if len(entry) > 2 and entry[2] is not None:
+            data = bytes(entry[2])
+            if _lib.tacozip_ghost_set_inline(ctypes.byref(ghost), i, data, len(data)) != TACOZ_OK:
+                raise ValueError(f"Slot {i}: inline data must match the slot length "
+                                 f"and fit in {TACO_GHOST_INLINE_MAX} bytes")
+    return ghost
+
+
+class UniformLayout(NamedTuple):
+    """Uniform-stride run recorded in a v2 ghost (``Writer(uniform_size=...)``)."""
+    base: int     # data offset of entry 0
+    stride: int
+    size: int     # data bytes of every entry
+    count: int
+
+    def offset(self, index: int) -> int:
+        """Data offset of entry ``index`` of the run."""
+        if not 0 <= index < self.count:
+            raise IndexError(index)
+        return self.base + index * self.stride
+
+
+class GhostInfo(NamedTuple):
+    """Everything a v2 ghost says about its archive."""
+    version: int
+    entries: List[tuple]
+    cd: Optional[Tuple[int, int, int]]   # (cd_offset, cd_size, cd_entries)
+    generation: int                      # bumped on every ghost write (0 for v1)
+    checksums: Optional[List[int]]       # CRC-32 per slot, if recorded
+    cd_sorted: bool = False              # central directory is in name order
+    uniform: Optional[UniformLayout] = None
+
+
+def _ghost_info(ghost: TacoGhost, with_inline: bool) -> GhostInfo:
+    cd = (ghost.cd_offset, ghost.cd_size, ghost.cd_entries) if ghost.cd_size else None
+    crcs = (list(ghost.slot_crc[:ghost.count])
+            if ghost.flags & TACO_GHOST_F_SLOT_CRC else None)
+    uniform = (UniformLayout(ghost.uniform_base, ghost.uniform_stride, ghost.uniform_size,
+                             ghost.uniform_count)
+               if ghost.flags & TACO_GHOST_F_UNIFORM else None)
+    return GhostInfo(ghost.version, _ghost_entries(ghost, with_inline), cd,
+                     ghost.generation, crcs, bool(ghost.flags & TACO_GHOST_F_CD_SORTED), uniform)
+
+
+def _ghost_entries(ghost: TacoGhost, with_inline: bool) -> List[tuple]:
+    """Valid slots as (offset, length) or (offset, length, inline bytes or None)."""
+    entries = []
+    for i in range(ghost.count):
+        slot = (ghost.slots[i].offset, ghost.slots[i].length)
+        if with_inline:
+            n, off = ghost.inline_len[i], ghost.inline_off[i]
+            slot += (bytes(ghost.inline_data[off:off + n]) if n else None,)
+        entries.append(slot)
+    return entries
+
+
+# Ghost v2 API functions
+def read_ghost_v2(zip_path: str, with_inline: bool = False) -> Tuple[int, List[tuple]]:
+    """
+    Read the ghost of an archive in either format.
+
+    Args:
+        with_inline: Return (offset, length, data) triples, where data holds
+            the slot's bytes when the ghost carries an inline copy, else None.
+
+    Returns:
+        (version, entries): ghost format (1 or 2) and the valid
+        (offset, length) slots.
+    """
+    ghost = TacoGhost()
+    result = _lib.tacozip_read_ghost_v2(zip_path.encode('utf-8'), ctypes.byref(ghost))
+    _check_result(result)
+    return ghost.version, _ghost_entries(ghost, with_inline)
+
+
+def read_ghost_info(zip_path: str, with_inline: bool = False) -> GhostInfo:
+    """
+    Read the ghost of an archive with its generation, checksums and
+    central directory location.
+    """
+    ghost = TacoGhost()
+    result = _lib.tacozip_read_ghost_v2(zip_path.encode('utf-8'), ctypes.byref(ghost))
+    _check_result(result)
+    return _ghost_info(ghost, with_inline)
+
+
+def update_ghost_v2(zip_path: str, entries: List[tuple], grow_slack: Optional[int] = None,
+                    checksums: bool = False):
+    """
+    Rewrite the ghost slots in place, keeping the archive's ghost format.
+
+    Entries are (offset, length) or (offset, length, data) to also store an
+    inline copy of the slot's bytes (v2 only). A v1 ghost holds at most 7
+    slots; a v2 ghost as many as fit in the size it was created with.
+
+    Args:
+        grow_slack: When the ghost does not fit, rewrite the archive with a v2
+            ghost and this many spare bytes (see rewrite_ghost) instead of
+            failing.
+        checksums: Store a CRC-32 of each slot's bytes (v2 only).
+    """
+    ghost = _prepare_ghost(entries, checksums)
+    result = _lib.tacozip_update_ghost_v2(zip_path.encode('utf-8'), ctypes.byref(ghost))
+    if result == TACOZ_ERR_PARAM and grow_slack is not None:
+        result = _lib.tacozip_rewrite_ghost(zip_path.encode('utf-8'), ctypes.byref(ghost),
+                                            grow_slack, TACOZIP_DURABLE_DEFAULT)
+    _check_result(result)
+
+
+def rewrite_ghost(zip_path: str, entries: List[tuple], slack: int = 0,
+                  checksums: bool = False, durability: Optional[int] = None):
+    """
+    Rewrite the archive around a v2 ghost with ``slack`` spare bytes.
+
+    Entry data is copied verbatim behind the new ghost; slot offsets that
+    point past the old ghost are shifted along with it. ``durability`` (a
+    ``TACOZIP_DURABLE_*`` level, default the build's) is what is flushed
+    before the new archive replaces the old one.
+    """
+    ghost = _prepare_ghost(entries, checksums)
+    if durability is None:
+        durability = TACOZIP_DURABLE_DEFAULT
+    result = _lib.tacozip_rewrite_ghost(zip_path.encode('utf-8'), ctypes.byref(ghost), slack,
+                                        durability)
+    _check_result(result)
+
+
+def parse_ghost_head(head: bytes, with_inline: bool = False) -> GhostInfo:
+    """
+    Decode the ghost from the first bytes of an archive.
+
+    Meant for remote readers: fetch TACO_GHOST_HEAD_MAX bytes, then the
+    central directory range reported here, without touching the tail.
+
+    A cached copy of slot metadata stays valid while the generation (or the
+    slot's checksum) is unchanged.
+
+    Returns:
+        GhostInfo; ``cd`` is None when the ghost does not record the central
+        directory (v1 ghosts).
+
+    Raises:
+        ValueError: If head is too short; the message gives the bytes needed.
+    """
+    ghost = TacoGhost()
+    result = _lib.tacozip_parse_ghost_head(head, len(head), ctypes.byref(ghost))
+    if result > 0:
+        raise ValueError(f"ghost needs {result} head bytes, got {len(head)}")
+    _check_result(result)
+    return _ghost_info(ghost, with_inline)
+
+
+class EntryInfo(NamedTuple):
+    """A central-directory record found by name."""
+    name: str
+    method: int
+    crc32: int
+    compressed_size: int
+    uncompressed_size: int
+    lfh_offset: int
+
+
+def _entry_info(e: TacoEntryInfo, name: Optional[str] = None) -> EntryInfo:
+    if name is None:
+        name = ctypes.string_at(e.name, e.name_len).decode('utf-8', 'surrogateescape')
+    return EntryInfo(name, e.method, e.crc32, e.compressed_size,
+                     e.uncompressed_size, e.lfh_offset)
+
+
+def _collect_entries(lister) -> List[EntryInfo]:
+    out: List[EntryInfo] = []
+
+    def _visit(user, entry):
+        out.append(_entry_info(entry.contents))
+        return 0
+
+    _check_result(lister(ENTRY_FN(_visit)))
+    return out
+
+
+def find_entry(zip_path: str, name: str) -> Optional[EntryInfo]:
+    """
+    Look up an entry by name without opening the archive through libzip.
+
+    Archives written with ``Writer(sort_cd=True)`` are searched by bisecting
+    the memory-mapped central directory; others are scanned.
+
+    Returns:
+        EntryInfo, or None if there is no such entry.
+    """
+    info = TacoEntryInfo()
+    result = _lib.tacozip_find_entry(zip_path.encode('utf-8'), name.encode('utf-8'),
+                                     ctypes.byref(info))
+    if result == TACOZ_ERR_NOT_FOUND:
+        return None
+    _check_result(result)
+    return _entry_info(info, name)
+
+
+def list_prefix(zip_path: str, prefix: str = "") -> List[EntryInfo]:
+    """List the entries whose names start with ``prefix``, in directory order.
+
+    With a sorted central directory only the matching run is read.
+    """
+    return _collect_entries(lambda fn: _lib.tacozip_list_prefix(
+        zip_path.encode('utf-8'), prefix.encode('utf-8'), fn, None))
+
+
+def cd_find(cd: bytes, name: str, sorted: bool = False) -> Optional[EntryInfo]:
+    """:func:`find_entry` on central-directory bytes fetched by the caller
+    (the ``cd`` range of :func:`parse_ghost_head`; pass its ``cd_sorted``)."""
+    info = TacoEntryInfo()
+    result = _lib.tacozip_cd_find(cd, len(cd), int(sorted), name.encode('utf-8'),
+                                  ctypes.byref(info))
+    if result == TACOZ_ERR_NOT_FOUND:
+        return None
+    _check_result(result)
+    return _entry_info(info, name)
+
+
+def cd_list_prefix(cd: bytes, prefix: str = "", sorted: bool = False) -> List[EntryInfo]:
+    """:func:`list_prefix` on central-directory bytes fetched by the caller."""
+    return _collect_entries(lambda fn: _lib.tacozip_cd_list_prefix(
+        cd, len(cd), int(sorted), prefix.encode('utf-8'), fn, None))
+
+
+def _index_result(result: int, hit: TacoIndexEntry) -> Optional[Tuple[int, int, int]]:
+    if result == TACOZ_ERR_NOT_FOUND:
+        return None
+    _check_result(result)
+    return hit.offset, hit.length, hit.crc32
+
+
+def find_indexed(zip_path: str, name: str, slot: int = 0) -> Optional[Tuple[int, int, int]]:
+    """
+    Resolve ``name`` through the name index referenced by ghost ``slot``
+    (see :meth:`Writer.add_name_index`) with a few small reads.
+
+    Returns:
+        ``(data_offset, length, crc32)``, or None if the name is not indexed.
+    """
+    hit = TacoIndexEntry()
+    return _index_result(_lib.tacozip_find_indexed(
+        zip_path.encode('utf-8'), slot, name.encode('utf-8'), ctypes.byref(hit)), hit)
+
+
+def name_index_find(index: bytes, index_offset: int, name: str) -> Optional[Tuple[int, int, int]]:
+    """
+    :func:`find_indexed` on name index bytes fetched by the caller from
+    ``index_offset`` (the ghost slot offset).
+    """
+    hit = TacoIndexEntry()
+    return _index_result(_lib.tacozip_name_index_find(
+        index, len(index), index_offset, name.encode('utf-8'), ctypes.byref(hit)), hit)
+
+
+def locate_by_id(zip_path: str, entry_id: int, slot: int = 0) -> Tuple[int, int]:
+    """
+    ``(data_offset, length)`` of entry ``entry_id`` (insertion order) through
+    the ID table referenced by ghost ``slot`` (see :meth:`Writer.add_id_table`).
+    """
+    offset, length = c_uint64(), c_uint64()
+    result = _lib.tacozip_locate_by_id(
+        zip_path.encode('utf-8'), slot, entry_id, ctypes.byref(offset), ctypes.byref(length)
+    )
+    _check_result(result)
+    return offset.value, length.value
+
+
+def read_by_id(zip_path: str, entry_id: int, slot: int = 0) -> bytes:
+    """Bytes of entry ``entry_id`` through the ID table at ghost ``slot``."""
+    _, length = locate_by_id(zip_path, entry_id, slot)
+    buf = ctypes.create_string_buffer(max(length, 1))
+    out_len = c_uint64()
+    result = _lib.tacozip_read_by_id(
+        zip_path.encode('utf-8'), slot, entry_id, buf, length, ctypes.byref(out_len)
+    )
+    _check_result(result)
+    return buf.raw[:out_len.value]
+
+
+def id_table_get(table: bytes, table_offset: int, entry_id: int) -> Tuple[int, int]:
+    """
+    :func:`locate_by_id` on ID table bytes fetched by the caller from
+    ``table_offset`` (the ghost slot offset).
+    """
+    offset, length = c_uint64(), c_uint64()
+    result = _lib.tacozip_id_table_get(
+        table, len(table), table_offset, entry_id, ctypes.byref(offset), ctypes.byref(length)
+    )
+    _check_result(result)
+    return offset.value, length.value
+
+
 def replace_file(zip_path: str, file_name: str, new_src_path: str):
     """
     Replace a specific file in an existing TACO archive.
+
+    Ghost slots are updated as put_file() does: a slot holding exactly the
+    old content follows it, other slots into the replaced file are cleared.
     
     Args:
         zip_path: Path to the existing archive
@@ -175,4 +944,453 @@ def replace_file(zip_path: str, file_name: str, new_src_path: str):
         new_src_path.encode('utf-8')
     )
     
-    _check_result(result)
\ No newline at end of file
+    _check_result(result)
+
+
+def remove_entries(zip_path: str, names: List[str]):
+    """
+    Remove entries from an archive by rewriting only its central directory.
+
+    The entries' data stays in the file as dead space; the cost depends on
+    the size of the directory, not of the archive.
+
+    Example:
+        >>> remove_entries("data.taco.zip", ["part1.parquet", "part2.parquet"])
+    """
+    if not names:
+        return
+    arr, _keep = _prepare_string_array(names)
+    _check_result(_lib.tacozip_remove_entries(zip_path.encode('utf-8'), arr, len(names)))
+
+
+def rename_entry(zip_path: str, old_name: str, new_name: str):
+    """
+    Rename an entry by rewriting only the central directory (and the local
+    header's name where it fits).
+
+    Example:
+        >>> rename_entry("data.taco.zip", "part1.parquet", "train/part1.parquet")
+    """
+    _check_result(_lib.tacozip_rename_entry(
+        zip_path.encode('utf-8'), old_name.encode('utf-8'), new_name.encode('utf-8')
+    ))
+
+
+def put_file(zip_path: str, arc_name: str, src_path: str):
+    """
+    Store a file as entry ``arc_name``, replacing it if present.
+
+    The data goes into the best-fitting hole left by earlier removals and
+    replacements, and is appended only when none is large enough, so
+    repeatedly re-rendered entries stop growing the archive.
+
+    Example:
+        >>> put_file("tiles.taco.zip", "z12/655/1583.tif", "/tmp/1583.tif")
+    """
+    _check_result(_lib.tacozip_put_file(
+        zip_path.encode('utf-8'), arc_name.encode('utf-8'), src_path.encode('utf-8')
+    ))
+
+
+class LogVersion(NamedTuple):
+    """One published directory of a log-structured archive."""
+    generation: int
+    cd_offset: int
+    cd_size: int
+    cd_entries: int     # records, the ghost's included
+    end: int            # file offset just past its tail
+
+
+def _log_version(v: TacozipLogVersion) -> LogVersion:
+    return LogVersion(v.generation, v.cd_offset, v.cd_size, v.cd_entries, v.end)
+
+
+def log_commit(zip_path: str, changes: Dict[str, Optional[str]],
+               durability: Optional[int] = None) -> LogVersion:
+    """
+    Append a new version of the archive: each name in ``changes`` gets the
+    contents of its source path, or leaves the directory if it maps to None.
+    With ``durability`` DATA or FULL the commit reaches the disk before the
+    ghost publishes it (default: the build's ``TACOZ_DURABILITY``).
+
+    Older versions stay readable with ``Reader(path, generation=...)``.
+
+    Example:
+        >>> v = log_commit("data.taco.zip", {"part3.parquet": "/tmp/p3.parquet"})
+        >>> v.generation
+        5
+    """
+    names = list(changes)
+    if not names:
+        raise ValueError("changes must not be empty")
+    version = TacozipLogVersion()
+    name_arr, _keep_names = _prepare_string_array(names)
+    src_bytes = [None if changes[n] is None else changes[n].encode('utf-8') for n in names]
+    src_arr = (c_char_p * len(names))(*src_bytes)
+    _check_result(_lib.tacozip_log_commit(
+        zip_path.encode('utf-8'), src_arr, name_arr, len(names),
+        TACOZIP_DURABLE_DEFAULT if durability is None else durability, ctypes.byref(version)
+    ))
+    return _log_version(version)
+
+
+def log_versions(zip_path: str) -> List[LogVersion]:
+    """The archive's published directories, newest first."""
+    out: List[LogVersion] = []
+
+    def _visit(user, version):
+        out.append(_log_version(version.contents))
+        return 0
+
+    _check_result(_lib.tacozip_log_versions(zip_path.encode('utf-8'), LOG_FN(_visit), None))
+    return out
+
+
+class CompactStats(NamedTuple):
+    """What compact() found and did."""
+    file_size: int      # archive size before the call
+    dead_bytes: int     # reclaimable bytes before the call
+    holes: int
+    largest_hole: int
+    bytes_moved: int
+    reclaimed: int      # bytes the file shrank by
+
+
+def compact(zip_path: str, budget: Optional[int] = None) -> CompactStats:
+    """
+    Reclaim space left by removed entries by sliding live data down.
+
+    At most ``budget`` bytes of entry data are moved per call (None = no
+    limit, 0 = only report fragmentation), so large archives can be compacted
+    a step at a time.
+
+    Example:
+        >>> while compact("data.taco.zip", 64 << 20).bytes_moved:
+        ...     pass
+    """
+    stats = TacozipCompactStats()
+    _check_result(_lib.tacozip_compact(
+        zip_path.encode('utf-8'), (1 << 64) - 1 if budget is None else budget,
+        ctypes.byref(stats)
+    ))
+    return CompactStats(stats.file_size, stats.dead_bytes, stats.holes,
+                        stats.largest_hole, stats.bytes_moved, stats.reclaimed)
+
+
+class Writer:
+    """
+    Incremental archive writer.
+
+    Entries are appended one at a time; only the central directory is kept in
+    memory. Use as a context manager: the archive is published on a clean exit
+    and discarded if the block raises. ``durability`` (a ``TACOZIP_DURABLE_*``
+    level) sets what is flushed before the archive appears under its name.
+
+    Example:
+        >>> with Writer("data.taco.zip") as w:
+        ...     w.add_file("/data/part1.parquet", "part1.parquet")
+        ...     w.add_buffer("meta.json", b'{"version": 1}')
+        ...     w.set_ghost([1000], [500])
+    """
+
+    def __init__(self, zip_path: str, buffer_size: int = 0,
+                 cd_mem_cap: Optional[int] = None,
+                 open_ahead: Optional[int] = None,
+                 ghost_slots: int = 0, ghost_inline: int = 0,
+                 ghost_slack: int = 0, sort_cd: bool = False,
+                 uniform_size: int = 0, uniform_align: int = 0,
+                 durability: Optional[int] = None):
+        opts = TacozipWriterOpts()
+        _lib.tacozip_writer_opts_init(ctypes.byref(opts))
+        if buffer_size:
+            opts.buffer_size = buffer_size
+        if cd_mem_cap is not None:
+            opts.cd_mem_cap = cd_mem_cap
+        if open_ahead is not None:
+            opts.open_ahead = open_ahead
+        opts.ghost_slots = ghost_slots
+        opts.ghost_inline = ghost_inline
+        opts.ghost_slack = ghost_slack
+        opts.sort_cd = int(sort_cd)
+        opts.uniform_size = uniform_size
+        opts.uniform_align = uniform_align
+        if durability is not None:
+            opts.durability = durability
+
+        handle = c_void_p()
+        _check_result(_lib.tacozip_writer_begin(
+            zip_path.encode('utf-8'), ctypes.byref(opts), ctypes.byref(handle)
+        ))
+        self._handle: Optional[c_void_p] = handle
+
+    def _live_handle(self) -> c_void_p:
+        if self._handle is None:
+            raise ValueError("Writer is already finished or aborted")
+        return self._handle
+
+    def set_ghost(self, meta_offsets: List[int], meta_lengths: List[int]):
+        """Set the ghost metadata entries (written on finish)."""
+        result = _lib.tacozip_writer_set_ghost(
+            self._live_handle(),
+            _prepare_uint64_array(meta_offsets), _prepare_uint64_array(meta_lengths),
+            TACO_GHOST_MAX_ENTRIES
+        )
+        _check_result(result)
+
+    def set_ghost_v2(self, entries: List[tuple], checksums: bool = False):
+        """Set the ghost slots as (offset, length) pairs.
+
+        Up to ``ghost_slots`` pairs for a v2 writer, 7 for a v1 writer. An
+        (offset, length, data) triple also stores the slot's bytes inline,
+        within the ``ghost_inline`` budget. With ``checksums`` the ghost also
+        records a CRC-32 of each slot's bytes, computed on finish.
+        """
+        result = _lib.tacozip_writer_set_ghost_v2(
+            self._live_handle(), ctypes.byref(_prepare_ghost(entries, checksums))
+        )
+        _check_result(result)
+
+    def add_file(self, src_path: str, arc_name: str):
+        """Append a file from disk as entry ``arc_name``."""
+        result = _lib.tacozip_writer_add_file(
+            self._live_handle(), src_path.encode('utf-8'), arc_name.encode('utf-8')
+        )
+        _check_result(result)
+
+    def add_meta_file(self, src_path: str, arc_name: str, slot: int):
+        """Append a metadata file and point ghost slot ``slot`` at its bytes.
+
+        Call after :meth:`set_ghost` / :meth:`set_ghost_v2`, which replace all slots.
+        """
+        result = _lib.tacozip_writer_add_meta_file(
+            self._live_handle(), src_path.encode('utf-8'), arc_name.encode('utf-8'), slot
+        )
+        _check_result(result)
+
+    def add_name_index(self, arc_name: str, slot: int):
+        """Append a perfect-hash name index over the entries added so far and
+        point ghost slot ``slot`` at it (see :func:`find_indexed`)."""
+        result = _lib.tacozip_writer_add_name_index(
+            self._live_handle(), arc_name.encode('utf-8'), slot
+        )
+        _check_result(result)
+
+    def add_id_table(self, arc_name: str, slot: int):
+        """Append an ID table over the entries added so far and point ghost
+        slot ``slot`` at it (see :func:`read_by_id`)."""
+        result = _lib.tacozip_writer_add_id_table(
+            self._live_handle(), arc_name.encode('utf-8'), slot
+        )
+        _check_result(result)
+
+    def add_files(self, src_files: List[str], arc_files: List[str]) -> int:
+        """Append several files in order, opening upcoming sources ahead of the copy.
+
+        Returns the number of entries added. On error the exception is raised
+        after the entries before the failing file have been added.
+        """
+        if len(src_files) != len(arc_files):
+            raise ValueError("src_files and arc_files must have the same length")
+        src_array, src_bytes = _prepare_string_array(src_files)
+        arc_array, arc_bytes = _prepare_string_array(arc_files)
+        added = c_size_t(0)
+        result = _lib.tacozip_writer_add_files(
+            self._live_handle(), src_array, arc_array, len(src_files), ctypes.byref(added)
+        )
+        _check_result(result)
+        return added.value
+
+    def add_slice(self, src_path: str, offset: int, length: int, arc_name: str,
+                  crc: Optional[int] = None):
+        """Append ``length`` bytes of ``src_path`` starting at ``offset``.
+
+        Passing the slice's CRC-32 (if already known) lets large slices be
+        copied in the kernel without being read by the writer.
+        """
+        self.add_slices([(src_path, offset, length, crc)], [arc_name])
+
+    def add_slices(self, slices: List[Tuple], arc_files: List[str]) -> int:
+        """Append ``(src_path, offset, length[, crc])`` slices in order.
+
+        Returns the number of entries added.
+        """
+        if len(slices) != len(arc_files):
+            raise ValueError("slices and arc_files must have the same length")
+        c_slices = (TacozipSlice * len(slices))()
+        keep = []
+        for c, sl in zip(c_slices, slices):
+            path = sl[0].encode('utf-8')
+            keep.append(path)
+            c.src_path, c.offset, c.length = path, sl[1], sl[2]
+            crc = sl[3] if len(sl) > 3 else None
+            if crc is not None:
+                c.crc32, c.has_crc = crc, 1
+        arc_array, arc_bytes = _prepare_string_array(arc_files)
+        added = c_size_t(0)
+        result = _lib.tacozip_writer_add_slices(
+            self._live_handle(), c_slices, arc_array, len(slices), ctypes.byref(added)
+        )
+        _check_result(result)
+        return added.value
+
+    def add_dir(self, root_dir: str, include: Optional[List[str]] = None,
+                exclude: Optional[List[str]] = None,
+                arc_prefix: Optional[str] = None, sort: bool = True,
+                threads: int = 0, follow_symlinks: bool = False) -> int:
+        """Append every regular file under ``root_dir``; see :func:`create_from_dir`.
+
+        Returns the number of entries added.
+        """
+        opts, keep = _prepare_dir_opts(include, exclude, arc_prefix, sort, threads,
+                                       follow_symlinks)
+        added = c_size_t(0)
+        result = _lib.tacozip_writer_add_dir(
+            self._live_handle(), root_dir.encode('utf-8'), ctypes.byref(opts),
+            ctypes.byref(added)
+        )
+        _check_result(result)
+        return added.value
+
+    def add_buffer(self, arc_name: str, data: bytes):
+        """Append in-memory bytes as entry ``arc_name``."""
+        result = _lib.tacozip_writer_add_buffer(
+            self._live_handle(), arc_name.encode('utf-8'), data, len(data)
+        )
+        _check_result(result)
+
+    def add_stream(self, arc_name: str, fileobj: BinaryIO):
+        """Append the remaining bytes of a binary file object as ``arc_name``."""
+        def _read(user, buf, cap):
+            try:
+                chunk = fileobj.read(cap)
+            except Exception:
+                return -1
+            if chunk:
+                ctypes.memmove(buf, chunk, len(chunk))
+            return len(chunk)
+
+        callback = READ_FN(_read)
+        result = _lib.tacozip_writer_add_stream(
+            self._live_handle(), arc_name.encode('utf-8'), callback, None
+        )
+        _check_result(result)
+
+    def finish(self):
+        """Write the central directory and publish the archive."""
+        handle = self._live_handle()
+        self._handle = None
+        _check_result(_lib.tacozip_writer_finish(handle))
+
+    def abort(self):
+        """Discard the archive being written."""
+        if self._handle is not None:
+            handle, self._handle = self._handle, None
+            _lib.tacozip_writer_abort(handle)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc, tb):
+        if exc_type is None:
+            self.finish()
+        else:
+            self.abort()
+        return False
+
+
+class Reader:
+    """
+    Shared read-only archive handle.
+
+    The central directory is read and indexed once; afterwards lookups and
+    reads do not modify the handle, so one Reader can serve many threads
+    (ctypes releases the GIL during each call).
+
+    With ``generation`` the handle reads the directory a log commit
+    published as that generation (0 = the newest) instead of the tail.
+
+    Example:
+        >>> with Reader("data.taco.zip") as r:
+        ...     data = r.read("part1.parquet")
+    """
+
+    def __init__(self, zip_path: str, generation: Optional[int] = None):
+        handle = c_void_p()
+        if generation is None:
+            result = _lib.tacozip_reader_open(zip_path.encode('utf-8'), ctypes.byref(handle))
+        else:
+            result = _lib.tacozip_reader_open_version(zip_path.encode('utf-8'), generation,
+                                                      ctypes.byref(handle))
+        _check_result(result)
+        self._handle: Optional[c_void_p] = handle
+
+    def _live_handle(self) -> c_void_p:
+        if self._handle is None:
+            raise ValueError("Reader is closed")
+        return self._handle
+
+    def __len__(self) -> int:
+        return _lib.tacozip_reader_count(self._live_handle())
+
+    def ghost(self, with_inline: bool = False) -> Optional[GhostInfo]:
+        """The archive's ghost, or None if it has none."""
+        ghost = TacoGhost()
+        result = _lib.tacozip_reader_ghost(self._live_handle(), ctypes.byref(ghost))
+        if result == TACOZ_ERR_INVALID_GHOST:
+            return None
+        _check_result(result)
+        return _ghost_info(ghost, with_inline)
+
+    def entry(self, index: int) -> EntryInfo:
+        """Entry ``index`` in directory order, not counting the ghost."""
+        info = TacoEntryInfo()
+        result = _lib.tacozip_reader_entry(self._live_handle(), index, ctypes.byref(info))
+        if result == TACOZ_ERR_NOT_FOUND:
+            raise IndexError(index)
+        _check_result(result)
+        return _entry_info(info)
+
+    def find(self, name: str) -> Optional[EntryInfo]:
+        """Look up an entry by name; None if there is no such entry."""
+        info = TacoEntryInfo()
+        result = _lib.tacozip_reader_find(self._live_handle(), name.encode('utf-8'),
+                                          ctypes.byref(info))
+        if result == TACOZ_ERR_NOT_FOUND:
+            return None
+        _check_result(result)
+        return _entry_info(info, name)
+
+    def read(self, entry, offset: int = 0, size: Optional[int] = None) -> bytes:
+        """Read ``size`` bytes (default: to the end) of a STORE entry from
+        ``offset``. ``entry`` is a name or an :class:`EntryInfo`."""
+        if isinstance(entry, str):
+            found = self.find(entry)
+            if found is None:
+                raise KeyError(entry)
+            entry = found
+        info = TacoEntryInfo()
+        info.method, info.crc32 = entry.method, entry.crc32
+        info.compressed_size = entry.compressed_size
+        info.uncompressed_size = entry.uncompressed_size
+        info.lfh_offset = entry.lfh_offset
+        if size is None:
+            size = max(entry.compressed_size - offset, 0)
+        buf = ctypes.create_string_buffer(max(size, 1))
+        got = c_size_t()
+        result = _lib.tacozip_reader_read(self._live_handle(), ctypes.byref(info), offset,
+                                          buf, size, ctypes.byref(got))
+        _check_result(result)
+        return buf.raw[:got.value]
+
+    def close(self):
+        """Release the handle; no thread may still be using it."""
+        if self._handle is not None:
+            handle, self._handle = self._handle, None
+            _lib.tacozip_reader_close(handle)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc, tb):
+        self.close()
+        return False
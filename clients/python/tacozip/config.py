@@ -7,6 +7,7 @@ TACOZ_ERR_LIBZIP = -2
 TACOZ_ERR_INVALID_GHOST = -3
 TACOZ_ERR_PARAM = -4
 TACOZ_ERR_NOT_FOUND = -5
+TACOZ_ERR_BUSY = -6
 
 # Error messages
 ERROR_MESSAGES = {
@@ -15,16 +16,29 @@ ERROR_MESSAGES = {
     TACOZ_ERR_INVALID_GHOST: "Ghost bytes malformed or unexpected",
     TACOZ_ERR_PARAM: "Invalid argument(s)",
     TACOZ_ERR_NOT_FOUND: "File not found in archive",
+    TACOZ_ERR_BUSY: "Ghost update in progress; read again",
 }
 
 # TACO Ghost constants
 TACO_GHOST_MAX_ENTRIES = 7
+TACO_GHOST_V2_MAX_SLOTS = 255
+TACO_GHOST_INLINE_MAX = 4096
+TACO_GHOST_F_SLOT_CRC = 0x1
+TACO_GHOST_F_CD_SORTED = 0x2
+TACO_GHOST_F_UNIFORM = 0x4
+TACO_GHOST_HEAD_MAX = 9356  # ghost LFH + largest v2 payload
 TACO_GHOST_SIZE = 160
 TACO_GHOST_NAME = "TACO_GHOST"
 TACO_GHOST_NAME_LEN = 10
 TACO_GHOST_EXTRA_ID = 0x7454
 TACO_GHOST_EXTRA_SIZE = 116
 
+# Durability levels (TacozipWriterOpts.durability and publishing calls)
+TACOZIP_DURABLE_DEFAULT = -1  # the build's TACOZ_DURABILITY
+TACOZIP_DURABLE_NONE = 0
+TACOZIP_DURABLE_DATA = 1
+TACOZIP_DURABLE_FULL = 2
+
 # Platform-specific library names
 LIBRARY_NAMES = {
     "linux": ["libtacozip.so"],
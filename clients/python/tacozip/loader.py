@@ -63,6 +63,9 @@ def self_check():
         'tacozip_read_ghost_multi',
         'tacozip_update_ghost_multi',
         'tacozip_replace_file',
+        'tacozip_writer_begin',
+        'tacozip_writer_add_file',
+        'tacozip_writer_finish',
     ]
     
     missing_functions = []
@@ -60,7 +60,8 @@ def mock_native_library():
         required_functions = [
             'tacozip_create', 'tacozip_read_ghost', 'tacozip_update_ghost',
             'tacozip_create_multi', 'tacozip_read_ghost_multi', 
-            'tacozip_update_ghost_multi', 'tacozip_replace_file'
+            'tacozip_update_ghost_multi', 'tacozip_replace_file',
+            'tacozip_writer_begin', 'tacozip_writer_add_file', 'tacozip_writer_finish'
         ]
         
         for func_name in required_functions:
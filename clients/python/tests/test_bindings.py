@@ -172,6 +172,246 @@ class TestBindings:
         # Verify function was called
         mock_lib.tacozip_update_ghost_multi.assert_called_once()
     
+    @patch('tacozip.bindings._lib')
+    def test_ghost_v2_round_trip(self, mock_lib):
+        """read_ghost_v2/update_ghost_v2 marshal more than 7 slots."""
+        stored = {}
+
+        def fake_update(path, ghost):
+            g = ghost._obj
+            stored['slots'] = [(g.slots[i].offset, g.slots[i].length) for i in range(g.count)]
+            return config.TACOZ_OK
+
+        def fake_read(path, ghost):
+            g = ghost._obj
+            g.version = 2
+            g.count = len(stored['slots'])
+            for i, (o, l) in enumerate(stored['slots']):
+                g.slots[i].offset, g.slots[i].length = o, l
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_update_ghost_v2.side_effect = fake_update
+        mock_lib.tacozip_read_ghost_v2.side_effect = fake_read
+
+        entries = [(1000 + i, i + 1) for i in range(20)]
+        bindings.update_ghost_v2("test.zip", entries)
+        assert bindings.read_ghost_v2("test.zip") == (2, entries)
+
+        with pytest.raises(ValueError):
+            bindings.update_ghost_v2("test.zip", [(0, 1)] * (config.TACO_GHOST_V2_MAX_SLOTS + 1))
+
+    @patch('tacozip.bindings._lib')
+    def test_parse_ghost_head(self, mock_lib):
+        """parse_ghost_head reports the central directory range or bytes needed."""
+        def fake_parse(head, length, ghost):
+            if length < 100:
+                return 100
+            g = ghost._obj
+            g.version, g.count = 2, 1
+            g.slots[0].offset, g.slots[0].length = 64, 8
+            g.cd_offset, g.cd_size, g.cd_entries = 5000, 300, 4
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_parse_ghost_head.side_effect = fake_parse
+
+        info = bindings.parse_ghost_head(b"\0" * 200)
+        assert (info.version, info.entries, info.cd) == (2, [(64, 8)], (5000, 300, 4))
+        with pytest.raises(ValueError, match="100"):
+            bindings.parse_ghost_head(b"\0" * 10)
+
+    @patch('tacozip.bindings._lib')
+    def test_read_ghost_info_uniform(self, mock_lib):
+        """A uniform-stride run is reported as a UniformLayout."""
+        def fake_read(path, ghost):
+            g = ghost._obj
+            g.version, g.flags = 2, config.TACO_GHOST_F_UNIFORM
+            g.uniform_base, g.uniform_stride = 4096, 8192
+            g.uniform_size, g.uniform_count = 5000, 3
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_read_ghost_v2.side_effect = fake_read
+        layout = bindings.read_ghost_info("test.zip").uniform
+        assert layout == (4096, 8192, 5000, 3)
+        assert layout.offset(2) == 4096 + 2 * 8192
+        with pytest.raises(IndexError):
+            layout.offset(3)
+
+    @patch('tacozip.bindings._lib')
+    def test_ghost_inline_copies(self, mock_lib):
+        """Inline slot bytes go through tacozip_ghost_set_inline and come back on read."""
+        calls = []
+
+        def fake_set_inline(ghost, slot, data, length):
+            calls.append((slot, data, length))
+            return config.TACOZ_OK
+
+        def fake_read(path, ghost):
+            g = ghost._obj
+            g.version, g.count = 2, 2
+            g.slots[0].offset, g.slots[0].length = 100, 3
+            g.slots[1].offset, g.slots[1].length = 5, 6
+            g.inline_len[0], g.inline_off[0], g.inline_used = 3, 0, 3
+            g.inline_data[0:3] = list(b"abc")
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_ghost_set_inline.side_effect = fake_set_inline
+        mock_lib.tacozip_update_ghost_v2.return_value = config.TACOZ_OK
+        mock_lib.tacozip_read_ghost_v2.side_effect = fake_read
+
+        bindings.update_ghost_v2("test.zip", [(100, 3, b"abc"), (5, 6)])
+        assert calls == [(0, b"abc", 3)]
+        assert bindings.read_ghost_v2("test.zip", with_inline=True) == \
+            (2, [(100, 3, b"abc"), (5, 6, None)])
+        assert bindings.read_ghost_v2("test.zip") == (2, [(100, 3), (5, 6)])
+
+        mock_lib.tacozip_ghost_set_inline.side_effect = None
+        mock_lib.tacozip_ghost_set_inline.return_value = config.TACOZ_ERR_PARAM
+        with pytest.raises(ValueError):
+            bindings.update_ghost_v2("test.zip", [(100, 4, b"abc")])
+
+    @patch('tacozip.bindings._lib')
+    def test_update_ghost_v2_grows_when_full(self, mock_lib):
+        """A full ghost falls back to a rewrite only when grow_slack is given."""
+        mock_lib.tacozip_update_ghost_v2.return_value = config.TACOZ_ERR_PARAM
+        mock_lib.tacozip_rewrite_ghost.return_value = config.TACOZ_OK
+
+        with pytest.raises(exceptions.TacozipError):
+            bindings.update_ghost_v2("test.zip", [(1, 2)])
+        mock_lib.tacozip_rewrite_ghost.assert_not_called()
+
+        bindings.update_ghost_v2("test.zip", [(1, 2)], grow_slack=4096)
+        args = mock_lib.tacozip_rewrite_ghost.call_args[0]
+        assert args[0] == b"test.zip"
+        assert args[2] == 4096
+
+    @patch('tacozip.bindings._lib')
+    def test_ghost_generation_and_checksums(self, mock_lib):
+        """checksums=True sets the flag; read_ghost_info reports generation and CRCs."""
+        seen = {}
+
+        def fake_update(path, ghost):
+            seen['flags'] = ghost._obj.flags
+            return config.TACOZ_OK
+
+        def fake_read(path, ghost):
+            g = ghost._obj
+            g.version, g.count, g.flags, g.generation = 2, 2, config.TACO_GHOST_F_SLOT_CRC, 7
+            g.slot_crc[0], g.slot_crc[1] = 0xDEADBEEF, 0x12345678
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_update_ghost_v2.side_effect = fake_update
+        mock_lib.tacozip_read_ghost_v2.side_effect = fake_read
+
+        bindings.update_ghost_v2("test.zip", [(1, 2), (3, 4)], checksums=True)
+        assert seen['flags'] & config.TACO_GHOST_F_SLOT_CRC
+        info = bindings.read_ghost_info("test.zip")
+        assert info.generation == 7
+        assert info.checksums == [0xDEADBEEF, 0x12345678]
+
+    @patch('tacozip.bindings._lib')
+    def test_create_placed(self, mock_lib):
+        """create_placed passes both file lists and maps the placement name."""
+        mock_lib.tacozip_create_placed.return_value = config.TACOZ_OK
+
+        bindings.create_placed("test.zip", ["a.bin"], ["a.bin"],
+                               ["m.parquet"], ["META/m.parquet"], placement="first")
+        args = mock_lib.tacozip_create_placed.call_args[0]
+        assert args[3] == 1 and args[6] == 1
+        assert args[5][0] == b"META/m.parquet"
+        assert args[7] == bindings.TACOZIP_META_FIRST
+
+        with pytest.raises(ValueError):
+            bindings.create_placed("test.zip", [], [], ["m"], ["m"], placement="middle")
+
+    @patch('tacozip.bindings._lib')
+    def test_find_entry_and_list_prefix(self, mock_lib):
+        """Lookups wrap entry records; a missing name gives None."""
+        names = [b"tiles/z12/0.bin", b"tiles/z12/1.bin"]
+
+        def fake_list(path, prefix, fn, user):
+            assert prefix == b"tiles/z12/"
+            for i, n in enumerate(names):
+                buf = ctypes.create_string_buffer(n)
+                e = bindings.TacoEntryInfo()
+                e.name = ctypes.cast(buf, ctypes.POINTER(ctypes.c_char))
+                e.name_len, e.lfh_offset, e.uncompressed_size = len(n), 100 * i, 7
+                fn(None, ctypes.pointer(e))
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_list_prefix.side_effect = fake_list
+        entries = bindings.list_prefix("test.zip", "tiles/z12/")
+        assert [e.name for e in entries] == ["tiles/z12/0.bin", "tiles/z12/1.bin"]
+        assert entries[1].lfh_offset == 100 and entries[1].uncompressed_size == 7
+
+        mock_lib.tacozip_find_entry.return_value = config.TACOZ_ERR_NOT_FOUND
+        assert bindings.find_entry("test.zip", "missing") is None
+
+    @patch('tacozip.bindings._lib')
+    def test_find_indexed(self, mock_lib):
+        """find_indexed returns (offset, length, crc) or None for unknown names."""
+        def fake_find(path, slot, name, hit):
+            if name != b"tiles/a.bin":
+                return config.TACOZ_ERR_NOT_FOUND
+            h = hit._obj
+            h.offset, h.length, h.crc32 = 4096, 10, 0xABCD
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_find_indexed.side_effect = fake_find
+        assert bindings.find_indexed("test.zip", "tiles/a.bin", slot=1) == (4096, 10, 0xABCD)
+        assert mock_lib.tacozip_find_indexed.call_args[0][1] == 1
+        assert bindings.find_indexed("test.zip", "missing") is None
+
+    @patch('tacozip.bindings._lib')
+    def test_read_by_id(self, mock_lib):
+        """read_by_id sizes the buffer from locate_by_id, then reads."""
+        def fake_locate(path, slot, entry_id, offset, length):
+            offset._obj.value, length._obj.value = 4096, 5
+            return config.TACOZ_OK
+
+        def fake_read(path, slot, entry_id, buf, cap, out_len):
+            assert cap == 5
+            ctypes.memmove(buf, b"hello", 5)
+            out_len._obj.value = 5
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_locate_by_id.side_effect = fake_locate
+        mock_lib.tacozip_read_by_id.side_effect = fake_read
+        assert bindings.locate_by_id("test.zip", 7, slot=1) == (4096, 5)
+        assert bindings.read_by_id("test.zip", 7, slot=1) == b"hello"
+        assert mock_lib.tacozip_read_by_id.call_args[0][1:3] == (1, 7)
+
+    @patch('tacozip.bindings._lib')
+    def test_reader_find_and_read(self, mock_lib):
+        """Reader resolves a name once, then reads from the offset it is given."""
+        def fake_open(path, handle):
+            handle._obj.value = 1234
+            return config.TACOZ_OK
+
+        def fake_find(handle, name, info):
+            if name != b"a.bin":
+                return config.TACOZ_ERR_NOT_FOUND
+            info._obj.compressed_size = info._obj.uncompressed_size = 5
+            info._obj.lfh_offset = 100
+            return config.TACOZ_OK
+
+        def fake_read(handle, info, offset, buf, size, got):
+            assert info._obj.lfh_offset == 100
+            data = b"hello"[offset:offset + size]
+            ctypes.memmove(buf, data, len(data))
+            got._obj.value = len(data)
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_reader_open.side_effect = fake_open
+        mock_lib.tacozip_reader_find.side_effect = fake_find
+        mock_lib.tacozip_reader_read.side_effect = fake_read
+        with bindings.Reader("test.zip") as r:
+            assert r.find("missing") is None
+            assert r.read("a.bin") == b"hello"
+            assert r.read(r.find("a.bin"), offset=1, size=3) == b"ell"
+        mock_lib.tacozip_reader_close.assert_called_once()
+        with pytest.raises(ValueError):
+            r.find("a.bin")
+
     @patch('tacozip.bindings._lib')
     def test_replace_file_function(self, mock_lib):
         """Test replace_file function."""
@@ -191,4 +431,265 @@ class TestBindings:
         with pytest.raises(exceptions.TacozipError) as exc_info:
             bindings.replace_file("test.zip", "old.txt", "new.txt")
         
-        assert exc_info.value.code == config.TACOZ_ERR_NOT_FOUND
\ No newline at end of file
+        assert exc_info.value.code == config.TACOZ_ERR_NOT_FOUND
+
+    @patch('tacozip.bindings._lib')
+    def test_remove_and_rename_entries(self, mock_lib):
+        """remove_entries passes every name; rename_entry raises on error."""
+        seen = []
+
+        def fake_remove(path, names, n):
+            seen.append((path, [names[i] for i in range(n)]))
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_remove_entries.side_effect = fake_remove
+        bindings.remove_entries("test.zip", ["a.txt", "b.txt"])
+        bindings.remove_entries("test.zip", [])
+        assert seen == [(b"test.zip", [b"a.txt", b"b.txt"])]
+
+        mock_lib.tacozip_rename_entry.return_value = config.TACOZ_ERR_PARAM
+        with pytest.raises(exceptions.TacozipError):
+            bindings.rename_entry("test.zip", "a.txt", "b.txt")
+        mock_lib.tacozip_rename_entry.assert_called_once_with(b"test.zip", b"a.txt", b"b.txt")
+
+    @patch('tacozip.bindings._lib')
+    def test_put_file(self, mock_lib):
+        """put_file encodes its arguments and raises on error."""
+        mock_lib.tacozip_put_file.return_value = config.TACOZ_OK
+        bindings.put_file("test.zip", "a.tif", "/tmp/a.tif")
+        mock_lib.tacozip_put_file.assert_called_once_with(b"test.zip", b"a.tif", b"/tmp/a.tif")
+
+        mock_lib.tacozip_put_file.return_value = config.TACOZ_ERR_PARAM
+        with pytest.raises(exceptions.TacozipError):
+            bindings.put_file("test.zip", "TACO_GHOST", "/tmp/a.tif")
+
+    @patch('tacozip.bindings._lib')
+    def test_log_commit_and_versions(self, mock_lib):
+        """log_commit passes None for removals; log_versions lists what it visits."""
+        seen = []
+
+        def fake_commit(path, srcs, names, n, durability, out):
+            seen.append([(names[i], srcs[i]) for i in range(n)])
+            assert durability == config.TACOZIP_DURABLE_DEFAULT
+            out._obj.generation = 7
+            return config.TACOZ_OK
+
+        def fake_versions(path, fn, user):
+            for gen in (7, 6):
+                v = bindings.TacozipLogVersion(generation=gen, cd_offset=100 * gen)
+                fn(None, ctypes.pointer(v))
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_log_commit.side_effect = fake_commit
+        mock_lib.tacozip_log_versions.side_effect = fake_versions
+        v = bindings.log_commit("test.zip", {"a.bin": "/tmp/a.bin", "b.bin": None})
+        assert v.generation == 7
+        assert seen == [[(b"a.bin", b"/tmp/a.bin"), (b"b.bin", None)]]
+        assert [x.generation for x in bindings.log_versions("test.zip")] == [7, 6]
+        with pytest.raises(ValueError):
+            bindings.log_commit("test.zip", {})
+
+    @patch('tacozip.bindings._lib')
+    def test_compact_returns_stats(self, mock_lib):
+        """compact maps None to an unlimited budget and returns the stats."""
+        budgets = []
+
+        def fake_compact(path, budget, stats):
+            budgets.append(budget)
+            stats._obj.dead_bytes = 100
+            stats._obj.bytes_moved = 40
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_compact.side_effect = fake_compact
+        st = bindings.compact("test.zip")
+        bindings.compact("test.zip", 0)
+        assert budgets == [(1 << 64) - 1, 0]
+        assert st.dead_bytes == 100 and st.bytes_moved == 40 and st.reclaimed == 0
+
+class TestWriter:
+    """Test the incremental Writer wrapper."""
+
+    @patch('tacozip.bindings._lib')
+    def test_writer_context_manager_finishes(self, mock_lib):
+        """Clean exit publishes the archive."""
+        mock_lib.tacozip_writer_begin.return_value = config.TACOZ_OK
+        mock_lib.tacozip_writer_add_file.return_value = config.TACOZ_OK
+        mock_lib.tacozip_writer_add_buffer.return_value = config.TACOZ_OK
+        mock_lib.tacozip_writer_set_ghost.return_value = config.TACOZ_OK
+        mock_lib.tacozip_writer_finish.return_value = config.TACOZ_OK
+
+        with bindings.Writer("test.zip", buffer_size=65536, cd_mem_cap=1 << 20) as w:
+            w.add_file("file1.txt", "arch1.txt")
+            w.add_buffer("meta.json", b"{}")
+            w.set_ghost([100], [200])
+
+        mock_lib.tacozip_writer_begin.assert_called_once()
+        mock_lib.tacozip_writer_add_file.assert_called_once()
+        mock_lib.tacozip_writer_add_buffer.assert_called_once()
+        mock_lib.tacozip_writer_finish.assert_called_once()
+        mock_lib.tacozip_writer_abort.assert_not_called()
+
+    @patch('tacozip.bindings._lib')
+    def test_writer_durability_option(self, mock_lib):
+        """durability is passed through the options struct."""
+        seen = []
+
+        def fake_begin(path, opts, handle):
+            seen.append(opts._obj.durability)
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_writer_begin.side_effect = fake_begin
+        bindings.Writer("test.zip", durability=config.TACOZIP_DURABLE_FULL)
+        assert seen == [config.TACOZIP_DURABLE_FULL]
+
+    @patch('tacozip.bindings._lib')
+    def test_writer_aborts_on_exception(self, mock_lib):
+        """An exception inside the block discards the archive."""
+        mock_lib.tacozip_writer_begin.return_value = config.TACOZ_OK
+
+        with pytest.raises(RuntimeError):
+            with bindings.Writer("test.zip"):
+                raise RuntimeError("boom")
+
+        mock_lib.tacozip_writer_abort.assert_called_once()
+        mock_lib.tacozip_writer_finish.assert_not_called()
+
+    @patch('tacozip.bindings._lib')
+    def test_writer_add_error_raises(self, mock_lib):
+        """Errors from the C writer surface as TacozipError."""
+        mock_lib.tacozip_writer_begin.return_value = config.TACOZ_OK
+        mock_lib.tacozip_writer_add_file.return_value = config.TACOZ_ERR_IO
+
+        w = bindings.Writer("test.zip")
+        with pytest.raises(exceptions.TacozipError) as exc_info:
+            w.add_file("missing.txt", "a.txt")
+        assert exc_info.value.code == config.TACOZ_ERR_IO
+
+        w.abort()
+        with pytest.raises(ValueError):
+            w.finish()
+
+    @patch('tacozip.bindings._lib')
+    def test_writer_add_files(self, mock_lib):
+        """add_files passes both lists and returns the added count."""
+        def fake_add_files(handle, src, arc, n, added):
+            added._obj.value = n
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_writer_begin.return_value = config.TACOZ_OK
+        mock_lib.tacozip_writer_add_files.side_effect = fake_add_files
+
+        w = bindings.Writer("test.zip", open_ahead=8)
+        assert w.add_files(["a.txt", "b.txt"], ["a", "b"]) == 2
+        args = mock_lib.tacozip_writer_add_files.call_args[0]
+        assert args[3] == 2
+
+        with pytest.raises(ValueError):
+            w.add_files(["a.txt"], ["a", "b"])
+
+    @patch('tacozip.bindings._lib')
+    def test_writer_add_slices(self, mock_lib):
+        """add_slices marshals ranges and marks which CRCs are known."""
+        seen = []
+
+        def fake_add_slices(handle, slices, arc, n, added):
+            for i in range(n):
+                s = slices[i]
+                seen.append((s.src_path, s.offset, s.length, s.crc32, s.has_crc, arc[i]))
+            added._obj.value = n
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_writer_begin.return_value = config.TACOZ_OK
+        mock_lib.tacozip_writer_add_slices.side_effect = fake_add_slices
+
+        w = bindings.Writer("test.zip")
+        assert w.add_slices([("blob.bin", 0, 10), ("blob.bin", 10, 20, 0xDEADBEEF)],
+                            ["a", "b"]) == 2
+        assert seen == [(b"blob.bin", 0, 10, 0, 0, b"a"),
+                        (b"blob.bin", 10, 20, 0xDEADBEEF, 1, b"b")]
+
+        with pytest.raises(ValueError):
+            w.add_slices([("blob.bin", 0, 1)], [])
+
+    @patch('tacozip.bindings._lib')
+    def test_merge_passes_shards(self, mock_lib):
+        """merge hands every shard path and the options to tacozip_merge."""
+        seen = []
+
+        def fake_merge(path, shards, n, opts):
+            seen.append((path, [shards[i] for i in range(n)], opts._obj.align))
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_merge.side_effect = fake_merge
+        bindings.merge("all.zip", ["a.zip", "b.zip"], align=1)
+        assert seen == [(b"all.zip", [b"a.zip", b"b.zip"], 1)]
+
+        with pytest.raises(ValueError):
+            bindings.merge("all.zip", [])
+
+    @patch('tacozip.bindings._lib')
+    def test_split_returns_count(self, mock_lib):
+        """split passes the bound and options and returns the shard count."""
+        seen = []
+
+        def fake_split(path, prefix, max_size, opts, count):
+            seen.append((path, prefix, max_size, opts._obj.threads, opts._obj.manifest_path))
+            count._obj.value = 3
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_split.side_effect = fake_split
+        n = bindings.split("all.zip", "part-", 1 << 20, threads=2, manifest_path="m.json")
+        assert n == 3
+        assert seen == [(b"all.zip", b"part-", 1 << 20, 2, b"m.json")]
+
+        mock_lib.tacozip_split.side_effect = None
+        mock_lib.tacozip_split.return_value = config.TACOZ_ERR_PARAM
+        with pytest.raises(exceptions.TacozipError):
+            bindings.split("all.zip", "part-", 0)
+
+    @patch('tacozip.bindings._lib')
+    def test_create_from_dir_passes_patterns(self, mock_lib):
+        """create_from_dir fills the dir options from keyword arguments."""
+        seen = {}
+
+        def fake_create(zip_path, root, opts, offs, lens, n):
+            o = opts._obj
+            seen['include'] = [o.include[i] for i in range(o.num_include)]
+            seen['exclude'] = [o.exclude[i] for i in range(o.num_exclude)]
+            seen['prefix'] = o.arc_prefix
+            seen['sort'] = o.sort
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_create_from_dir.side_effect = fake_create
+
+        bindings.create_from_dir("out.zip", "/data", include=["*.tif"],
+                                 exclude=["tmp/**"], arc_prefix="tiles/", sort=False)
+        assert seen == {'include': [b"*.tif"], 'exclude': [b"tmp/**"],
+                        'prefix': b"tiles/", 'sort': bindings.TACOZIP_SORT_NONE}
+
+        mock_lib.tacozip_create_from_dir.side_effect = None
+        mock_lib.tacozip_create_from_dir.return_value = config.TACOZ_ERR_IO
+        with pytest.raises(exceptions.TacozipError):
+            bindings.create_from_dir("out.zip", "/missing")
+
+    @patch('tacozip.bindings._lib')
+    def test_writer_add_stream_callback(self, mock_lib):
+        """add_stream feeds the file object through the read callback."""
+        import io
+        seen = []
+
+        def fake_add_stream(handle, name, callback, user):
+            buf = ctypes.create_string_buffer(8)
+            while True:
+                n = callback(None, ctypes.cast(buf, ctypes.c_void_p), 8)
+                if n <= 0:
+                    break
+                seen.append(buf.raw[:n])
+            return config.TACOZ_OK
+
+        mock_lib.tacozip_writer_begin.return_value = config.TACOZ_OK
+        mock_lib.tacozip_writer_add_stream.side_effect = fake_add_stream
+
+        w = bindings.Writer("test.zip")
+        w.add_stream("stream.bin", io.BytesIO(b"0123456789abcdef!"))
+        assert b"".join(seen) == b"0123456789abcdef!"
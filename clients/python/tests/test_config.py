@@ -14,6 +14,7 @@ class TestConfig:
         assert config.TACOZ_ERR_INVALID_GHOST == -3
         assert config.TACOZ_ERR_PARAM == -4
         assert config.TACOZ_ERR_NOT_FOUND == -5
+        assert config.TACOZ_ERR_BUSY == -6
     
     def test_ghost_constants(self):
         """Test TACO Ghost constants."""
@@ -30,6 +31,7 @@ class TestConfig:
         assert config.TACOZ_ERR_INVALID_GHOST in config.ERROR_MESSAGES
         assert config.TACOZ_ERR_PARAM in config.ERROR_MESSAGES
         assert config.TACOZ_ERR_NOT_FOUND in config.ERROR_MESSAGES
+        assert config.TACOZ_ERR_BUSY in config.ERROR_MESSAGES
         
         # Check messages are not empty
         for code, message in config.ERROR_MESSAGES.items():
@@ -106,7 +106,8 @@ class TestAbsoluteEdgeCases:
             config.TACOZ_ERR_LIBZIP,
             config.TACOZ_ERR_INVALID_GHOST,
             config.TACOZ_ERR_PARAM,
-            config.TACOZ_ERR_NOT_FOUND
+            config.TACOZ_ERR_NOT_FOUND,
+            config.TACOZ_ERR_BUSY
         ]
         
         for error_code in error_codes:
@@ -60,9 +60,21 @@ class TestIntegration:
             '__version__', '__author__', '__author_email__', '__description__',
             '__url__', '__license__', 'self_check', 'TACOZ_OK', 'TACOZ_ERR_IO',
             'TACOZ_ERR_LIBZIP', 'TACOZ_ERR_INVALID_GHOST', 'TACOZ_ERR_PARAM',
-            'TACOZ_ERR_NOT_FOUND', 'TACO_GHOST_MAX_ENTRIES', 'TacozipError',
+            'TACOZ_ERR_NOT_FOUND', 'TACOZ_ERR_BUSY', 'TACO_GHOST_MAX_ENTRIES', 'TACO_GHOST_V2_MAX_SLOTS',
+            'TACO_GHOST_INLINE_MAX', 'TACO_GHOST_F_SLOT_CRC', 'TACO_GHOST_F_CD_SORTED',
+            'TACO_GHOST_F_UNIFORM', 'TACO_GHOST_HEAD_MAX',
+            'TACOZIP_DURABLE_DEFAULT', 'TACOZIP_DURABLE_NONE', 'TACOZIP_DURABLE_DATA',
+            'TACOZIP_DURABLE_FULL',
+            'TacozipError',
             'create', 'read_ghost', 'update_ghost', 'create_multi',
-            'read_ghost_multi', 'update_ghost_multi', 'replace_file'
+            'read_ghost_multi', 'update_ghost_multi', 'create_placed', 'read_ghost_v2', 'read_ghost_info',
+            'update_ghost_v2', 'rewrite_ghost', 'parse_ghost_head', 'GhostInfo',
+            'UniformLayout',
+            'find_entry', 'list_prefix', 'cd_find', 'cd_list_prefix', 'EntryInfo',
+            'find_indexed', 'name_index_find', 'locate_by_id',
+            'read_by_id', 'id_table_get', 'replace_file', 'remove_entries', 'rename_entry',
+            'put_file', 'compact', 'CompactStats', 'log_commit', 'log_versions', 'LogVersion',
+            'create_from_dir', 'merge', 'split', 'Writer', 'Reader'
         }
         
         actual_exports = set(tacozip.__all__)
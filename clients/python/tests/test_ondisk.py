@@ -0,0 +1,311 @@
+# test_ondisk.py - native behaviour checked against real archives
+import ctypes
+import os
+import zipfile
+import pytest
+import tacozip
+from tacozip import bindings
+from tacozip.exceptions import TacozipError
+
+pytestmark = pytest.mark.skipif(not isinstance(bindings._lib, ctypes.CDLL),
+                                reason="native library not loaded")
+
+
+def payload(i, n):
+    return bytes((j * 7 + i) & 255 for j in range(n))
+
+
+@pytest.fixture
+def archive(tmp_path):
+    """Archive with entries t0..t3 of 1000-1300 bytes and a ghost."""
+    path = str(tmp_path / "a.taco.zip")
+    with tacozip.Writer(path, ghost_slots=4) as w:
+        w.set_ghost_v2([])
+        for i in range(4):
+            w.add_buffer(f"t{i}", payload(i, 1000 + 100 * i))
+    return path
+
+
+def check(path, expected):
+    """The archive passes zipfile's CRC check and holds exactly @expected."""
+    with zipfile.ZipFile(path) as z:
+        assert z.testzip() is None
+        names = [n for n in z.namelist() if n != "TACO_GHOST"]
+        assert sorted(names) == sorted(expected)
+        for name, data in expected.items():
+            if data is not None:
+                assert z.read(name) == data
+
+
+def data_offset(path, name):
+    """Offset of entry @name's data, past its local header."""
+    with zipfile.ZipFile(path) as z:
+        at = z.getinfo(name).header_offset
+    with open(path, "rb") as f:
+        f.seek(at + 26)
+        n, x = int.from_bytes(f.read(2), "little"), int.from_bytes(f.read(2), "little")
+    return at + 30 + n + x
+
+
+def read_at(path, offset, length):
+    with open(path, "rb") as f:
+        f.seek(offset)
+        return f.read(length)
+
+
+class TestLegacyGhost:
+    def twelve_slots(self, tmp_path):
+        path = str(tmp_path / "g.taco.zip")
+        with tacozip.Writer(path, ghost_slots=12, ghost_inline=64) as w:
+            w.set_ghost_v2([])
+            for i in range(12):
+                w.add_buffer(f"t{i}", payload(i, 10 + i))
+        entries = [(data_offset(path, f"t{i}"), 10 + i) for i in range(12)]
+        entries[1] += (payload(1, 11),)
+        tacozip.update_ghost_v2(path, entries, checksums=True)
+        return path, entries
+
+    def test_update_ghost_keeps_later_slots(self, tmp_path):
+        path, entries = self.twelve_slots(tmp_path)
+        tacozip.update_ghost(path, 5, 6)
+        info = tacozip.read_ghost_info(path, with_inline=True)
+        assert info.version == 2 and len(info.entries) == 12
+        assert info.entries[0] == (5, 6, None)
+        assert info.entries[1] == entries[1]
+        assert [e[:2] for e in info.entries[2:]] == entries[2:]
+        assert info.checksums is not None
+
+    def test_update_ghost_multi_keeps_later_slots(self, tmp_path):
+        path, entries = self.twelve_slots(tmp_path)
+        offsets = [e[0] for e in entries[:7]]
+        lengths = [e[1] for e in entries[:7]]
+        offsets[1], lengths[1] = 5, 6
+        tacozip.update_ghost_multi(path, offsets, lengths)
+        info = tacozip.read_ghost_info(path, with_inline=True)
+        assert info.entries[1] == (5, 6, None)
+        assert [e[:2] for e in info.entries[7:]] == entries[7:]
+        assert info.checksums is not None
+
+
+class TestReplace:
+    def test_replace_file_moves_and_clears_slots(self, tmp_path):
+        path = str(tmp_path / "r.taco.zip")
+        meta = tmp_path / "meta.json"
+        meta.write_bytes(b'{"v": 1}')
+        with tacozip.Writer(path, ghost_slots=2) as w:
+            w.set_ghost_v2([])
+            w.add_buffer("t0", payload(0, 1000))
+            w.add_meta_file(str(meta), "meta.json", 0)
+        inner = data_offset(path, "t0") + 200
+        tacozip.update_ghost_v2(path, [tacozip.read_ghost_v2(path)[1][0], (inner, 40)])
+
+        meta.write_bytes(b'{"v": 2, "more": true}')
+        tacozip.replace_file(path, "meta.json", str(meta))
+        new = tmp_path / "t0.bin"
+        new.write_bytes(payload(5, 1500))
+        tacozip.replace_file(path, "t0", str(new))
+
+        slots = tacozip.read_ghost_v2(path)[1]
+        assert slots[0] == (data_offset(path, "meta.json"), 22)
+        assert read_at(path, *slots[0]) == b'{"v": 2, "more": true}'
+        assert slots[1] == (0, 0)
+        check(path, {"t0": payload(5, 1500), "meta.json": b'{"v": 2, "more": true}'})
+
+
+class TestPutFile:
+    def test_put_file_reuses_the_best_hole(self, archive, tmp_path):
+        tacozip.remove_entries(archive, ["t1", "t2"])
+        size = os.path.getsize(archive)
+        src = tmp_path / "new.bin"
+        src.write_bytes(payload(7, 1050))
+        tacozip.put_file(archive, "n", str(src))
+        # t1's hole, right after t0's data, fits better than t2's larger one.
+        with zipfile.ZipFile(archive) as z:
+            assert z.getinfo("n").header_offset == data_offset(archive, "t0") + 1000
+        assert os.path.getsize(archive) <= size + 200
+        check(archive, {"t0": payload(0, 1000), "n": payload(7, 1050), "t3": payload(3, 1300)})
+
+    def test_repeated_replacement_reaches_a_steady_size(self, archive, tmp_path):
+        src = tmp_path / "tile.bin"
+        sizes = []
+        for i in range(20):
+            src.write_bytes(payload(i, 900 + (i % 3) * 100))
+            tacozip.put_file(archive, "t1", str(src))
+            sizes.append(os.path.getsize(archive))
+        assert max(sizes[10:]) == max(sizes[:10])
+        check(archive, {"t0": payload(0, 1000), "t1": payload(19, 1000),
+                        "t2": payload(2, 1200), "t3": payload(3, 1300)})
+
+
+class TestRemove:
+    def test_remove_keeps_other_entries(self, archive):
+        tacozip.remove_entries(archive, ["t1", "t3"])
+        check(archive, {"t0": payload(0, 1000), "t2": payload(2, 1200)})
+
+    def test_remove_missing_name_changes_nothing(self, archive):
+        with pytest.raises(TacozipError):
+            tacozip.remove_entries(archive, ["t0", "nope"])
+        check(archive, {f"t{i}": payload(i, 1000 + 100 * i) for i in range(4)})
+
+    def test_remove_clears_table_slots(self, tmp_path):
+        path = str(tmp_path / "x.taco.zip")
+        with tacozip.Writer(path, ghost_slots=2) as w:
+            w.set_ghost_v2([])
+            w.add_buffer("a", payload(0, 100))
+            w.add_buffer("b", payload(1, 100))
+            w.add_name_index("names.idx", 0)
+            w.add_id_table("ids.tbl", 1)
+        tacozip.remove_entries(path, ["a"])
+        assert tacozip.read_ghost_v2(path)[1] == [(0, 0), (0, 0)]
+        check(path, {"b": payload(1, 100), "names.idx": None, "ids.tbl": None})
+
+
+class TestRename:
+    def test_rename_longer_name(self, archive):
+        long_name = "a/much/longer/directory/name/for/entry/t1.bin"
+        tacozip.rename_entry(archive, "t1", long_name)
+        check(archive, {"t0": payload(0, 1000), long_name: payload(1, 1100),
+                        "t2": payload(2, 1200), "t3": payload(3, 1300)})
+        with zipfile.ZipFile(archive) as z:
+            info = z.getinfo(long_name)
+        with open(archive, "rb") as f:
+            f.seek(info.header_offset + 26)
+            name_len = int.from_bytes(f.read(2), "little")
+            f.seek(info.header_offset + 30)
+            assert f.read(name_len).decode() == long_name
+
+    def test_rename_keeps_id_table_slot(self, tmp_path):
+        path = str(tmp_path / "x.taco.zip")
+        with tacozip.Writer(path, ghost_slots=2) as w:
+            w.set_ghost_v2([])
+            w.add_buffer("a", payload(0, 100))
+            w.add_name_index("names.idx", 0)
+            w.add_id_table("ids.tbl", 1)
+        tacozip.rename_entry(path, "a", "b")
+        slots = tacozip.read_ghost_v2(path)[1]
+        assert slots[0] == (0, 0) and slots[1] != (0, 0)
+        assert tacozip.read_by_id(path, 0, slot=1) == payload(0, 100)
+
+    def test_rename_shorter_name(self, archive):
+        tacozip.rename_entry(archive, "t2", "x")
+        check(archive, {"t0": payload(0, 1000), "t1": payload(1, 1100),
+                        "x": payload(2, 1200), "t3": payload(3, 1300)})
+
+
+class TestCompact:
+    def test_compact_reclaims_removed_entries(self, archive):
+        tacozip.remove_entries(archive, ["t0", "t2"])
+        report = tacozip.compact(archive, budget=0)
+        assert report.holes == 2 and report.bytes_moved == 0
+        assert report.dead_bytes >= 1000 + 1200
+
+        size = os.path.getsize(archive)
+        done = tacozip.compact(archive)
+        assert done.reclaimed == report.dead_bytes
+        assert os.path.getsize(archive) == size - done.reclaimed
+        assert tacozip.compact(archive, budget=0).dead_bytes == 0
+        check(archive, {"t1": payload(1, 1100), "t3": payload(3, 1300)})
+
+    def test_compact_in_small_steps_moves_slots(self, tmp_path):
+        path = str(tmp_path / "c.taco.zip")
+        meta = tmp_path / "meta.json"
+        meta.write_bytes(b'{"k": "v"}')
+        with tacozip.Writer(path, ghost_slots=1) as w:
+            w.set_ghost_v2([])
+            for i in range(6):
+                w.add_buffer(f"t{i}", payload(i, 700))
+            w.add_meta_file(str(meta), "meta.json", 0)
+        tacozip.remove_entries(path, ["t0", "t2", "t4"])
+
+        steps = 0
+        while tacozip.compact(path, budget=1000).bytes_moved:
+            steps += 1
+        assert steps > 1
+        assert tacozip.compact(path, budget=0).dead_bytes == 0
+        slot = tacozip.read_ghost_v2(path)[1][0]
+        assert slot == (data_offset(path, "meta.json"), 10)
+        assert read_at(path, *slot) == b'{"k": "v"}'
+        check(path, {"t1": payload(1, 700), "t3": payload(3, 700), "t5": payload(5, 700),
+                     "meta.json": b'{"k": "v"}'})
+
+
+class TestLog:
+    def test_commits_keep_every_version_readable(self, archive, tmp_path):
+        start = tacozip.read_ghost_info(archive).generation
+        src = tmp_path / "new.bin"
+        src.write_bytes(payload(8, 800))
+        first = tacozip.log_commit(archive, {"t1": str(src), "t2": None})
+        src.write_bytes(payload(9, 900))
+        second = tacozip.log_commit(archive, {"t1": str(src), "n": str(src)},
+                                    durability=tacozip.TACOZIP_DURABLE_FULL)
+        assert start < first.generation < second.generation
+
+        versions = tacozip.log_versions(archive)
+        assert [v.generation for v in versions[:2]] == [second.generation, first.generation]
+        assert versions[0] == second
+        check(archive, {"t0": payload(0, 1000), "t1": payload(9, 900),
+                        "t3": payload(3, 1300), "n": payload(9, 900)})
+
+        with tacozip.Reader(archive, generation=first.generation) as r:
+            assert r.find("t2") is None and r.find("n") is None
+            assert r.read("t1") == payload(8, 800)
+        with tacozip.Reader(archive, generation=versions[-1].generation) as r:
+            assert r.read("t1") == payload(1, 1100)
+            assert r.read("t2") == payload(2, 1200)
+        with pytest.raises(TacozipError):
+            tacozip.Reader(archive, generation=second.generation + 1)
+
+    def test_torn_commit_is_ignored_and_overwritten(self, archive, tmp_path):
+        src = tmp_path / "new.bin"
+        src.write_bytes(payload(8, 800))
+        v = tacozip.log_commit(archive, {"t1": str(src)})
+        with open(archive, "ab") as f:
+            f.write(b"partial commit that never got published")
+        assert tacozip.log_versions(archive)[0] == v
+        with tacozip.Reader(archive, generation=v.generation) as r:
+            assert r.read("t1") == payload(8, 800)
+        src.write_bytes(payload(9, 900))
+        assert tacozip.log_commit(archive, {"t0": str(src)}).generation > v.generation
+        check(archive, {"t0": payload(9, 900), "t1": payload(8, 800),
+                        "t2": payload(2, 1200), "t3": payload(3, 1300)})
+
+
+class TestUniformRun:
+    def test_wrong_size_leaves_writer_usable(self, tmp_path):
+        path = str(tmp_path / "u.taco.zip")
+        with tacozip.Writer(path, ghost_slots=1, uniform_size=64) as w:
+            w.set_ghost_v2([])
+            w.add_buffer("a", payload(0, 64))
+            for size in (0, 10):
+                with pytest.raises(TacozipError):
+                    w.add_buffer("bad", payload(1, size))
+            w.add_buffer("b", payload(2, 64))
+        check(path, {"a": payload(0, 64), "b": payload(2, 64)})
+        assert tacozip.read_ghost_info(path).uniform.count == 2
+
+
+class TestMerge:
+    def shard(self, tmp_path, name, entries, sort_cd=False):
+        path = str(tmp_path / name)
+        with tacozip.Writer(path, ghost_slots=1, sort_cd=sort_cd) as w:
+            w.set_ghost_v2([])
+            for arc, data in entries:
+                w.add_buffer(arc, data)
+        return path
+
+    def test_merge_keeps_data_and_sorted_flag(self, tmp_path):
+        a = self.shard(tmp_path, "a.zip", [("a", payload(0, 500)), ("b", payload(1, 600))], True)
+        b = self.shard(tmp_path, "b.zip", [("c", payload(2, 700))], True)
+        out = str(tmp_path / "m.zip")
+        tacozip.merge(out, [a, b])
+        check(out, {"a": payload(0, 500), "b": payload(1, 600), "c": payload(2, 700)})
+        assert tacozip.read_ghost_info(out).cd_sorted
+
+    @pytest.mark.parametrize("order", [("a", "b"), ("z", "b")])
+    def test_merge_refuses_duplicate_names(self, tmp_path, order):
+        first = self.shard(tmp_path, "a.zip", [(order[0], b"1"), (order[1], b"2")])
+        second = self.shard(tmp_path, "b.zip", [("b", b"3")])
+        out = tmp_path / "m.zip"
+        with pytest.raises(TacozipError):
+            tacozip.merge(str(out), [first, second])
+        assert not out.exists()
@@ -9,14 +9,21 @@
  * ## Overview
  * - Always ZIP64: forces ZIP64 format regardless of file sizes for serialization consistency.
  * - STORE-only (method=0). No compression for maximum throughput.
- * - Uses libzip as the underlying ZIP implementation (no more custom ZIP code).
+ * - Archives are produced by a native streaming writer (see tacozip_writer_begin());
+ *   libzip is used to read and modify existing archives.
  * - A "TACO Ghost" entry is written first so its LFH appears at file start.
  *   This ghost **does** appear in the Central Directory as a normal file entry.
- * - Up to 7 (offset,length) metadata pairs for external indices stored in ghost payload.
+ * - Up to 7 (offset,length) metadata pairs for external indices stored in ghost payload,
+ *   or up to 255 with a v2 ghost (see taco_ghost_t).
  * - No filename normalization in C; callers must pass sanitized archive names.
  *
  * ## Threading
- * - Functions are not thread-safe on the same zip_path concurrently.
+ * - Functions are not thread-safe on the same zip_path concurrently, except
+ *   that ghost reads may run while tacozip_update_ghost_v2() (and the other
+ *   in-place ghost updates) rewrite the ghost: they retry instead of returning
+ *   torn metadata. Ghost writers serialize on an advisory fcntl lock.
+ * - A reader handle (tacozip_reader_open()) may be shared by any number of
+ *   threads for lookups and reads without locking.
  *
  * ## Large files
  * - Designed for large files: build with `_FILE_OFFSET_BITS=64`.
@@ -54,6 +61,14 @@
  *   
  *   // Replace a specific file in the archive
  *   rc = tacozip_replace_file("out.taco.zip", "a.bin", "/path/to/new_a.bin");
+ *
+ *   // Or build the archive incrementally
+ *   tacozip_writer_t *w = NULL;
+ *   rc = tacozip_writer_begin("out.taco.zip", NULL, &w);
+ *   rc = tacozip_writer_add_file(w, "/abs/a.bin", "a.bin");
+ *   rc = tacozip_writer_add_buffer(w, "meta.json", json, json_len);
+ *   rc = tacozip_writer_set_ghost(w, offsets, lengths, 7);
+ *   rc = tacozip_writer_finish(w);   // frees w
  * @endcode
  */
 
@@ -103,6 +118,121 @@ typedef struct {
     uint64_t length;  /**< Length in bytes of external metadata.      */
 } taco_meta_ptr_t;
 
+/*
+ * TACO Ghost v2 payload (little-endian, zero-padded to its stored size):
+ *
+ *  [0..3]   : magic "TGH2"
+ *  [4..5]   : uint16 version (2)
+ *  [6..7]   : uint16 header size (64)
+ *  [8..11]  : uint32 flags (TACO_GHOST_F_*)
+ *  [12..13] : uint16 slot count (0-255)
+ *  [14..15] : uint16 write sequence, odd while an in-place update is writing
+ *  [16..19] : uint32 payload size (bytes stored in the ghost entry)
+ *  [20..23] : uint32 used bytes (header through the inline region)
+ *  [24..27] : uint32 inline region offset (0 = none)
+ *  [28..31] : uint32 inline region size
+ *  [32..39] : uint64 central directory offset   (0 = unknown)
+ *  [40..47] : uint64 central directory size
+ *  [48..55] : uint64 central directory entries (ghost included)
+ *  [56..63] : uint64 generation, bumped on every write of the ghost
+ *  [64..95] : with TACO_GHOST_F_UNIFORM only (header size 96): uint64 data
+ *             offset of entry 0, uint64 stride, uint64 entry size and uint64
+ *             entry count of the uniform run
+ *  [hdr..]  : slot count pairs of uint64 (offset, length)
+ *  [crc]    : with TACO_GHOST_F_SLOT_CRC, slot count uint32 CRC-32 of each
+ *             slot's bytes, padded to 8 bytes
+ *  [inline] : records of uint8 slot, 3 reserved bytes, uint32 length and the
+ *             slot's bytes, each padded to 8 bytes
+ *
+ * A v1 payload starts with its count byte (0-7), so the first four bytes tell
+ * the formats apart. Readers locate the slot table through the header size
+ * field, so later header fields can be added without breaking them.
+ *
+ * With TACO_GHOST_F_CD_SORTED the central directory can be searched by
+ * bisection (tacozip_cd_find(), tacozip_cd_list_prefix()) without building a
+ * name table first.
+ *
+ * With TACO_GHOST_F_UNIFORM the first entries after the ghost all hold
+ * exactly the recorded entry size and entry i's data starts at
+ * base + i * stride (tacozip_uniform_locate()), so a reader of fixed-size
+ * records needs neither the central directory nor an index.
+ *
+ * The generation and slot checksums let readers validate cached metadata from
+ * the head read alone: an unchanged generation means nothing changed, and a
+ * slot whose CRC matches the cached copy need not be fetched again.
+ *
+ * In-place updates follow a seqlock: the writer makes the write sequence odd,
+ * rewrites the payload and makes it even again. A reader reads the sequence
+ * on its own, copies the payload, then reads the sequence once more. Unless
+ * the first read is even and matches both the copy's sequence and the last
+ * read, the copy may be torn and the reader reads again; readers never take
+ * a lock. A v1 payload keeps the same sequence in its padding bytes [2..3].
+ *
+ * The inline region optionally carries copies of small slot targets (a JSON
+ * document, a parquet footer), so readers get them with the ghost instead of
+ * issuing one more range request per slot. With the maximum of 255 slots and
+ * TACO_GHOST_INLINE_MAX inline bytes the ghost LFH plus payload stays around
+ * 8 KiB: still a single head read, after which a remote reader can fetch the
+ * central directory directly instead of probing the EOCD, ZIP64 locator and
+ * ZIP64 EOCD at the tail.
+ */
+
+#define TACO_GHOST_V2_MAGIC        "TGH2"
+#define TACO_GHOST_V2_VERSION      2u
+#define TACO_GHOST_V2_HEADER_SIZE  64u
+#define TACO_GHOST_V2_MAX_SLOTS    255u
+/** Header bytes added by the TACO_GHOST_F_UNIFORM layout fields. */
+#define TACO_GHOST_V2_UNIFORM_SIZE 32u
+/** Largest inline region (record headers included) in a v2 ghost. */
+#define TACO_GHOST_INLINE_MAX      4096u
+/** Payload bytes needed for a v2 ghost with @p slots slots. */
+#define TACO_GHOST_V2_SIZE(slots)  (TACO_GHOST_V2_HEADER_SIZE + 16u * (slots))
+/** Bytes of the slot checksum table for @p slots slots. */
+#define TACO_GHOST_V2_CRC_SIZE(slots) ((4u * (slots) + 7u) & ~7u)
+/** v2 flag: the ghost carries a CRC-32 per slot (taco_ghost_t::slot_crc). */
+#define TACO_GHOST_F_SLOT_CRC      0x1u
+/** v2 flag: central-directory records after the ghost's are in byte order of
+ *  their names (tacozip_writer_opts_t::sort_cd). Set only by the library. */
+#define TACO_GHOST_F_CD_SORTED     0x2u
+/** v2 flag: the ghost records a uniform-stride run of equally sized entries
+ *  (tacozip_writer_opts_t::uniform_size). Set only by the library. */
+#define TACO_GHOST_F_UNIFORM       0x4u
+/** Archive head bytes covering the ghost as written by this library
+ *  (LFH with its ZIP64 extra, plus the largest v2 payload). */
+#define TACO_GHOST_HEAD_MAX        (30u + TACO_GHOST_NAME_LEN + 20u + \
+                                    TACO_GHOST_V2_SIZE(TACO_GHOST_V2_MAX_SLOTS) + \
+                                    TACO_GHOST_V2_UNIFORM_SIZE + \
+                                    TACO_GHOST_V2_CRC_SIZE(TACO_GHOST_V2_MAX_SLOTS) + \
+                                    TACO_GHOST_INLINE_MAX)
+
+/** @brief Ghost contents in either format. Initialize with tacozip_ghost_init(). */
+typedef struct {
+    uint16_t version;   /**< 1 or 2; filled in by readers, ignored by writers. */
+    uint32_t flags;     /**< TACO_GHOST_F_* (v2). With TACO_GHOST_F_SLOT_CRC the
+                             library computes slot_crc from the archive bytes
+                             whenever it writes the ghost. */
+    uint16_t count;     /**< Number of valid slots. */
+    uint64_t cd_offset; /**< Central directory offset (0 = not recorded). Kept
+                             current by the library; ignored on write. */
+    uint64_t cd_size;   /**< Central directory size in bytes. */
+    uint64_t cd_entries;/**< Central directory records, ghost included. */
+    uint64_t generation;/**< 1 at creation, +1 on every ghost write (0 for v1).
+                             Maintained by the library; ignored on write. */
+    uint64_t uniform_base;  /**< With TACO_GHOST_F_UNIFORM: data offset of
+                                 entry 0. Library-maintained, like the rest. */
+    uint64_t uniform_stride;/**< Bytes from one entry's data to the next's. */
+    uint64_t uniform_size;  /**< Data bytes of every entry in the run. */
+    uint64_t uniform_count; /**< Entries in the run (the first ones added). */
+    taco_meta_entry_t slots[TACO_GHOST_V2_MAX_SLOTS];
+    uint32_t slot_crc[TACO_GHOST_V2_MAX_SLOTS]; /**< CRC-32 of each slot's bytes
+                             (with TACO_GHOST_F_SLOT_CRC). */
+    uint32_t inline_len[TACO_GHOST_V2_MAX_SLOTS]; /**< Inline copy size per
+                             slot (0 = none); equals the slot length. */
+    uint32_t inline_off[TACO_GHOST_V2_MAX_SLOTS]; /**< Copy offset in inline_data. */
+    uint32_t inline_used; /**< Bytes used in inline_data. */
+    unsigned char inline_data[TACO_GHOST_INLINE_MAX];
+} taco_ghost_t;
+
 
 /* Export / visibility macro */
 #if defined(_WIN32) || defined(__CYGWIN__)
@@ -130,7 +260,8 @@ enum {
     TACOZ_ERR_LIBZIP        = -2,  /**< libzip error. */
     TACOZ_ERR_INVALID_GHOST = -3,  /**< Ghost bytes malformed or unexpected. */
     TACOZ_ERR_PARAM         = -4,  /**< Invalid argument(s). */
-    TACOZ_ERR_NOT_FOUND     = -5   /**< File not found in archive. */
+    TACOZ_ERR_NOT_FOUND     = -5,  /**< File not found in archive. */
+    TACOZ_ERR_BUSY          = -6   /**< Ghost update in progress; read again. */
 };
 
 
@@ -138,9 +269,8 @@ enum {
  * @brief Replace a specific file in an existing TACO archive.
  *
  * This function finds a file by its archive name and replaces it with content
- * from a new source file. The TACO Ghost and other files remain unchanged.
- * The replacement file will use STORE method (no compression) like all other
- * files in the archive.
+ * from a new source file. Other files remain unchanged. The replacement file
+ * will use STORE method (no compression) like all other files in the archive.
  *
  * @param zip_path   Path to an existing archive created by this library.
  * @param file_name  Name of the file in the archive to replace (exact match).
@@ -150,7 +280,13 @@ enum {
  *
  * @note The file_name must match exactly as it was stored in the archive.
  * @note The new file will maintain the same archive name but with updated content.
- * @note This operation preserves the TACO Ghost and all metadata entries.
+ * @note Done in place by tacozip_put_file() (best-fitting hole, else the
+ *       end); archives it cannot map are rewritten through libzip.
+ * @note Ghost slots are updated as tacozip_put_file() describes: a slot that
+ *       held exactly the old content follows it, any other slot into the
+ *       replaced file is cleared to (0, 0), as are name index and ID table
+ *       slots. Releases up to 0.5.2 left the ghost unchanged, so such
+ *       slots kept pointing at offsets the rewrite had moved.
  */
 TACOZIP_EXPORT
 int tacozip_replace_file(const char *zip_path,
@@ -166,7 +302,9 @@ int tacozip_replace_file(const char *zip_path,
  * @brief Create a ZIP64 archive with a TACO Ghost supporting up to 7 metadata entries.
  *
  * This is the new primary API that supports multiple parquet metadata files.
- * Uses libzip backend with forced ZIP64 format and STORE compression.
+ * Thin wrapper over the incremental writer: forced ZIP64 format and STORE
+ * compression. Archive names are used verbatim and must be unique; the name
+ * TACO_GHOST is reserved.
  * 
  * @param zip_path     Output path for the archive.
  * @param src_files    Array of absolute or relative filesystem paths (N elements).
@@ -190,6 +328,37 @@ int tacozip_create_multi(const char *zip_path,
                         const uint64_t *meta_lengths,
                         size_t array_size);
 
+/** @brief Where tacozip_create_placed() puts the metadata entries. */
+enum {
+    TACOZIP_META_LAST  = 0,  /**< Just before the central directory (tail read). */
+    TACOZIP_META_FIRST = 1   /**< Right after the ghost (head read). */
+};
+
+/**
+ * @brief Create an archive whose ghost slots point at metadata entries that
+ *        the writer places and measures itself.
+ *
+ * Metadata file i becomes ghost slot i. With TACOZIP_META_LAST the metadata
+ * entries are written after the data files, so a reader's single speculative
+ * read of the archive tail returns the central directory and the metadata
+ * together; with TACOZIP_META_FIRST they follow the ghost and arrive with a
+ * read of the head. Up to 7 metadata files use a v1 ghost, more (up to
+ * TACO_GHOST_V2_MAX_SLOTS) a v2 ghost with one slot per file.
+ *
+ * @param num_files Number of data files; may be 0.
+ * @param num_meta  Number of metadata files; at least 1.
+ * @param placement TACOZIP_META_LAST or TACOZIP_META_FIRST.
+ */
+TACOZIP_EXPORT
+int tacozip_create_placed(const char *zip_path,
+                          const char * const *src_files,
+                          const char * const *arc_files,
+                          size_t num_files,
+                          const char * const *meta_src_files,
+                          const char * const *meta_arc_files,
+                          size_t num_meta,
+                          int placement);
+
 /**
  * @brief Read all metadata entries from the TACO Ghost.
  *
@@ -198,7 +367,8 @@ int tacozip_create_multi(const char *zip_path,
  * @return          TACOZ_OK on success; negative error code otherwise.
  *
  * @note The returned structure contains a count field indicating how many
- *       entries are valid (0-7).
+ *       entries are valid (0-7). A v2 ghost reports its first 7 slots; use
+ *       tacozip_read_ghost_v2() to get all of them and their inline copies.
  */
 TACOZIP_EXPORT
 int tacozip_read_ghost_multi(const char *zip_path, taco_meta_array_t *out);
@@ -214,6 +384,12 @@ int tacozip_read_ghost_multi(const char *zip_path, taco_meta_array_t *out);
  *
  * @note The function automatically detects how many entries are valid by counting
  *       non-zero pairs from the start of the arrays.
+ * @note A v2 ghost keeps its flags and any slots after the first 7. A slot
+ *       that changes loses its inline copy; unchanged slots keep theirs, and
+ *       slot checksums are recomputed. A v2 ghost ends at its last non-empty
+ *       slot rather than at the first empty one.
+ * @note Returns TACOZ_ERR_PARAM for a ghost with more than 7 slots that cannot
+ *       be rewritten in place, since the libzip fallback only holds 7.
  */
 TACOZIP_EXPORT
 int tacozip_update_ghost_multi(const char *zip_path,
@@ -222,6 +398,1002 @@ int tacozip_update_ghost_multi(const char *zip_path,
                               size_t array_size);
 
 
+/* ========================================================================== */
+/*                              Incremental writer                            */
+/* ========================================================================== */
+
+/** @brief Opaque streaming archive writer. */
+typedef struct tacozip_writer tacozip_writer_t;
+
+/**
+ * @brief Pull callback used by tacozip_writer_add_stream().
+ *
+ * @param user User pointer passed to tacozip_writer_add_stream().
+ * @param buf  Destination buffer.
+ * @param cap  Capacity of @p buf in bytes.
+ * @return     Bytes written to @p buf (0 = end of entry), or negative on error.
+ */
+typedef int64_t (*tacozip_read_fn)(void *user, void *buf, size_t cap);
+
+/** @brief How much of a finished archive is on stable storage before
+ *         tacozip_writer_finish() (or another publishing call) returns. */
+enum {
+    TACOZIP_DURABLE_DEFAULT = -1, /**< The build's default, TACOZ_DURABILITY
+                                       (CMake cache variable, 0 unless set). */
+    TACOZIP_DURABLE_NONE = 0,  /**< Left to the OS; fastest, for batch jobs. */
+    TACOZIP_DURABLE_DATA = 1,  /**< fdatasync() the archive before publishing it. */
+    TACOZIP_DURABLE_FULL = 2   /**< fsync() the archive, publish it, then fsync()
+                                    its directory so the new name survives too. */
+};
+
+/** @brief Writer options. Initialize with tacozip_writer_opts_init(). */
+typedef struct {
+    size_t buffer_size;  /**< Output/copy buffer in bytes (0 = TACOZ_COPY_BUFSZ). */
+    size_t cd_mem_cap;   /**< Resident central-directory budget in bytes before
+                              spilling to a scratch file beside the archive
+                              (default TACOZ_CD_MEM_CAP; 0 = never spill). */
+    unsigned open_ahead; /**< Sources tacozip_writer_add_files() keeps in flight
+                              through an io_uring OPENAT->READ->CLOSE pipeline
+                              (Linux); each holds a TACOZ_INGEST_BUFSZ buffer.
+                              Pays off with many cores and cold or networked
+                              storage; see bench/bench_ingest.c (default
+                              TACOZ_OPEN_AHEAD; 0 = synchronous per file). */
+    unsigned ghost_slots; /**< 0 = v1 ghost (7 slots, 116 bytes, readable by
+                              every tacozip version); otherwise a v2 ghost with
+                              room for this many slots (1-255). */
+    unsigned ghost_inline; /**< v2 only: bytes reserved in the ghost for inline
+                              slot copies (0-TACO_GHOST_INLINE_MAX, record
+                              headers included). Default 0. */
+    unsigned ghost_slack;  /**< v2 only: zeroed bytes reserved past the slots
+                              and inline copies so later updates can add to the
+                              ghost in place. The header's payload size minus
+                              used bytes gives the slack left. Default 0. */
+    int sort_cd;           /**< v2 only: write central-directory records in
+                              byte order of their names (the ghost's stays
+                              first) and set TACO_GHOST_F_CD_SORTED. The whole
+                              directory is then kept in memory; cd_mem_cap
+                              does not apply. Default 0 (insertion order). */
+    uint64_t uniform_size; /**< v2 only: every entry must hold exactly this
+                              many bytes (TACOZ_ERR_PARAM otherwise) and its
+                              data is placed at base + i * stride, aligned to
+                              uniform_align, with zero gaps before the LFHs.
+                              Entries added through add_meta_file(),
+                              add_name_index() or add_id_table() end the run;
+                              plain entries are refused after that. Names are
+                              limited to TACOZ_UNIFORM_NAME_MAX bytes. An
+                              entry of known size (0 included) is refused
+                              before anything is written, so the writer stays
+                              usable; a stream can only be checked at its
+                              end, and a wrong length there fails the writer.
+                              Default 0 (off). */
+    unsigned uniform_align; /**< Data alignment of a uniform run: a power of
+                              two up to 65536 (0 = TACOZ_UNIFORM_ALIGN, 4096). */
+    int durability;        /**< TACOZIP_DURABLE_* (default TACOZ_DURABILITY,
+                              TACOZIP_DURABLE_NONE unless built with
+                              -DTACOZ_DURABILITY=1 or 2). */
+} tacozip_writer_opts_t;
+
+/**
+ * @brief Fill @p opts with the default writer options.
+ */
+TACOZIP_EXPORT
+void tacozip_writer_opts_init(tacozip_writer_opts_t *opts);
+
+/**
+ * @brief Start a new archive at @p zip_path.
+ *
+ * The archive is streamed into an unnamed file in the directory of
+ * @p zip_path (O_TMPFILE on Linux; a hidden temporary name elsewhere) and only
+ * replaces it on tacozip_writer_finish(), so a crash leaves nothing behind
+ * for the filesystem to keep. The ghost is written first with no
+ * metadata entries; use tacozip_writer_set_ghost() at any point before finish.
+ * Only the central directory is kept in memory: about 30 bytes per entry plus
+ * the archive name, spilled to disk beyond tacozip_writer_opts_t::cd_mem_cap.
+ *
+ * @param zip_path Output path for the archive.
+ * @param opts     Options, or NULL for defaults.
+ * @param out      Receives the writer handle on success.
+ * @return         TACOZ_OK on success; negative error code otherwise.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_begin(const char *zip_path,
+                         const tacozip_writer_opts_t *opts,
+                         tacozip_writer_t **out);
+
+/**
+ * @brief Set the metadata entries stored in the ghost.
+ *
+ * Same semantics as tacozip_create_multi(): arrays of exactly 7 elements, count
+ * detected from the first (0,0) pair. May be called repeatedly; the last call
+ * before tacozip_writer_finish() wins, so offsets of entries written through
+ * this writer can be recorded once they are known.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_set_ghost(tacozip_writer_t *w,
+                             const uint64_t *meta_offsets,
+                             const uint64_t *meta_lengths,
+                             size_t array_size);
+
+/**
+ * @brief Set the ghost slots from a taco_ghost_t.
+ *
+ * A v2 writer accepts up to tacozip_writer_opts_t::ghost_slots slots plus
+ * inline copies within ghost_inline bytes; a v1 writer accepts up to 7 slots
+ * and no copies. Returns TACOZ_ERR_PARAM if the ghost does not fit.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_set_ghost_v2(tacozip_writer_t *w, const taco_ghost_t *ghost);
+
+/**
+ * @brief Append a file from the filesystem as entry @p arc_name.
+ *
+ * @return TACOZ_OK on success. If @p src_path cannot be opened the call fails
+ *         with TACOZ_ERR_IO and the writer stays usable; errors after data has
+ *         been emitted are sticky and make tacozip_writer_finish() fail.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_add_file(tacozip_writer_t *w, const char *src_path, const char *arc_name);
+
+/**
+ * @brief Append a metadata file and point ghost slot @p slot at its bytes.
+ *
+ * Like tacozip_writer_add_file(), then sets the slot to the entry's data
+ * offset and length (raising the ghost count to slot + 1 if needed). Call it
+ * after tacozip_writer_set_ghost*(), which replace every slot. Returns
+ * TACOZ_ERR_PARAM if @p slot is beyond the writer's ghost capacity.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_add_meta_file(tacozip_writer_t *w, const char *src_path,
+                                 const char *arc_name, unsigned slot);
+
+/**
+ * @brief Append a list of files in order, as if by tacozip_writer_add_file().
+ *
+ * With tacozip_writer_opts_t::open_ahead > 0 and io_uring available, upcoming
+ * sources are opened, stat'ed and (up to TACOZ_INGEST_BUFSZ) read and
+ * checksummed asynchronously while earlier ones are written; larger files are
+ * streamed. At most open_ahead files are open at once. Stops at the first
+ * failure.
+ *
+ * @param num_added Optional; receives how many entries were appended.
+ * @return TACOZ_OK on success; otherwise the error of the failing file.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_add_files(tacozip_writer_t *w,
+                             const char * const *src_files,
+                             const char * const *arc_files,
+                             size_t num_files,
+                             size_t *num_added);
+
+/** @brief A byte range of a source file, stored as one entry. */
+typedef struct {
+    const char *src_path;  /**< File holding the slice. */
+    uint64_t    offset;    /**< First byte of the slice within the file. */
+    uint64_t    length;    /**< Slice length in bytes. */
+    uint32_t    crc32;     /**< CRC-32 of the slice; used only if has_crc. */
+    int         has_crc;   /**< Non-zero if crc32 is known. */
+} tacozip_slice_t;
+
+/**
+ * @brief Append bytes [offset, offset + length) of a file as entry @p arc_name.
+ *
+ * When the CRC is supplied and the slice is at least TACOZ_COPY_RANGE_MIN
+ * bytes, the data is copied file-to-file in the kernel (copy_file_range on
+ * Linux, which can share extents on reflink-capable filesystems). Otherwise it
+ * is read once through the output buffer and checksummed on the way. A
+ * supplied CRC is trusted, not verified.
+ *
+ * @return TACOZ_ERR_PARAM if the range does not lie within the file.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_add_slice(tacozip_writer_t *w, const tacozip_slice_t *slice,
+                             const char *arc_name);
+
+/**
+ * @brief Append several slices in order. Consecutive slices of the same
+ *        src_path share one open descriptor. Stops at the first failure.
+ *
+ * @param num_added Optional; receives how many entries were appended.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_add_slices(tacozip_writer_t *w,
+                              const tacozip_slice_t *slices,
+                              const char * const *arc_files,
+                              size_t num_slices,
+                              size_t *num_added);
+
+/**
+ * @brief Append an in-memory buffer as entry @p arc_name.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_add_buffer(tacozip_writer_t *w, const char *arc_name,
+                              const void *data, size_t len);
+
+/**
+ * @brief Append an entry whose bytes are pulled from @p read_fn until it returns 0.
+ *
+ * The size does not need to be known up front; CRC and sizes are patched into
+ * the Local File Header once the stream ends.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_add_stream(tacozip_writer_t *w, const char *arc_name,
+                              tacozip_read_fn read_fn, void *user);
+
+/**
+ * @brief Write the ghost payload, central directory and EOCD records, then
+ *        atomically move the archive into place.
+ *
+ * Always releases @p w, on success and on failure.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_finish(tacozip_writer_t *w);
+
+/**
+ * @brief Discard a writer: the temporary file is removed and the target path
+ *        is left untouched. Releases @p w.
+ */
+TACOZIP_EXPORT
+void tacozip_writer_abort(tacozip_writer_t *w);
+
+
+/* ========================================================================== */
+/*                             DIRECTORY INGESTION                            */
+/* ========================================================================== */
+
+/** @brief Entry order for directory ingestion. */
+enum {
+    TACOZIP_SORT_PATH = 0,  /**< Byte order per path component (deterministic). */
+    TACOZIP_SORT_NONE = 1   /**< Walk order; cheapest, varies between runs. */
+};
+
+/**
+ * @brief Options for tacozip_writer_add_dir(). Initialize with tacozip_dir_opts_init().
+ *
+ * Patterns use '*' (within one path component), '**' (across components), '?'
+ * and '[...]'. A pattern containing '/' is matched against the path relative to
+ * the root, otherwise against the base name. Directories matching an exclude
+ * pattern are not descended into.
+ */
+typedef struct {
+    const char * const *include;  /**< Files to keep (NULL/0 = all regular files). */
+    size_t num_include;
+    const char * const *exclude;  /**< Files and directories to skip. */
+    size_t num_exclude;
+    const char *arc_prefix;       /**< Prepended verbatim to archive names (NULL = none). */
+    int sort;                     /**< TACOZIP_SORT_PATH (default) or TACOZIP_SORT_NONE. */
+    unsigned threads;             /**< Walker threads (0 = online CPUs, at most 8). */
+    int follow_symlinks;          /**< Include symlinks to regular files; symlinked
+                                       directories are never followed. */
+} tacozip_dir_opts_t;
+
+/**
+ * @brief Fill @p opts with the default directory options.
+ */
+TACOZIP_EXPORT
+void tacozip_dir_opts_init(tacozip_dir_opts_t *opts);
+
+/**
+ * @brief Append every regular file under @p root_dir.
+ *
+ * The tree is walked in parallel with openat()/fstatat() relative to open
+ * directory descriptors; archive names are the '/'-separated paths relative to
+ * @p root_dir (plus arc_prefix). The archive being written is skipped if it
+ * lives inside the tree. Stops at the first file that cannot be added.
+ *
+ * @param opts      Options, or NULL for defaults.
+ * @param num_added Optional; receives how many entries were appended.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_add_dir(tacozip_writer_t *w, const char *root_dir,
+                           const tacozip_dir_opts_t *opts, size_t *num_added);
+
+/**
+ * @brief Create an archive from a directory tree in one call.
+ *
+ * Same as tacozip_writer_begin() + tacozip_writer_set_ghost() +
+ * tacozip_writer_add_dir() + tacozip_writer_finish(); nothing is written to
+ * @p zip_path on failure.
+ */
+TACOZIP_EXPORT
+int tacozip_create_from_dir(const char *zip_path,
+                            const char *root_dir,
+                            const tacozip_dir_opts_t *opts,
+                            const uint64_t *meta_offsets,
+                            const uint64_t *meta_lengths,
+                            size_t array_size);
+
+
+/* ========================================================================== */
+/*                                  GHOST V2                                  */
+/* ========================================================================== */
+
+/**
+ * @brief Reset @p ghost to an empty v2 ghost.
+ */
+TACOZIP_EXPORT
+void tacozip_ghost_init(taco_ghost_t *ghost);
+
+/**
+ * @brief Attach an inline copy of slot @p slot's bytes to @p ghost.
+ *
+ * @p len must equal the slot length. Only v2 ghosts store copies, and they
+ * count toward the ghost's stored size (see tacozip_writer_opts_t::ghost_inline).
+ * Returns TACOZ_ERR_PARAM if the slot is out of range or already has a copy,
+ * or if the region would exceed TACO_GHOST_INLINE_MAX.
+ */
+TACOZIP_EXPORT
+int tacozip_ghost_set_inline(taco_ghost_t *ghost, unsigned slot,
+                             const void *data, uint32_t len);
+
+/**
+ * @brief Read the ghost of an archive, v1 or v2.
+ *
+ * The ghost LFH at byte 0 is read directly (one small read); archives whose
+ * ghost is not first fall back to libzip. out->version tells the format, and
+ * inline slot copies arrive with it (slot i's bytes are
+ * out->inline_data + out->inline_off[i] when out->inline_len[i] is non-zero).
+ *
+ * A read that overlaps an in-place update is retried; TACOZ_ERR_BUSY means
+ * the update did not finish in time (or its writer died; the next update
+ * repairs the ghost).
+ */
+TACOZIP_EXPORT
+int tacozip_read_ghost_v2(const char *zip_path, taco_ghost_t *out);
+
+/**
+ * @brief Decode the ghost from the first @p len bytes of an archive.
+ *
+ * For readers that fetch the head themselves (e.g. an HTTP range request of
+ * TACO_GHOST_HEAD_MAX bytes). With a v2 ghost, out->cd_offset/cd_size then
+ * give the single range holding the central directory.
+ *
+ * @return TACOZ_OK; a negative error code (TACOZ_ERR_BUSY if the head was
+ *         fetched mid-update: fetch it again); or, when @p len is too short,
+ *         the positive number of head bytes required.
+ */
+TACOZIP_EXPORT
+int tacozip_parse_ghost_head(const void *head, size_t len, taco_ghost_t *out);
+
+/**
+ * @brief Data offset of entry @p index of the uniform run recorded in
+ *        @p ghost (TACO_GHOST_F_UNIFORM): base + index * stride.
+ *
+ * @return TACOZ_OK, TACOZ_ERR_NOT_FOUND past the run, or TACOZ_ERR_PARAM if
+ *         the ghost records no uniform run.
+ */
+TACOZIP_EXPORT
+int tacozip_uniform_locate(const taco_ghost_t *ghost, uint64_t index, uint64_t *offset);
+
+/**
+ * @brief Rewrite the ghost slots in place, keeping the archive's ghost format.
+ *
+ * Only the ghost payload and its two CRC fields are written; no entry moves.
+ * A v1 ghost holds at most 7 slots and a v2 ghost as many as its stored size
+ * allows, including any slack reserved at creation
+ * (tacozip_writer_opts_t::ghost_slack). The central directory fields are
+ * taken from the archive, not from @p ghost. Returns TACOZ_ERR_PARAM when the
+ * new ghost does not fit; tacozip_rewrite_ghost() then makes room.
+ *
+ * Concurrent updates serialize on an exclusive fcntl lock on the archive;
+ * concurrent readers are never blocked (see the seqlock note on the v2
+ * layout). Checksums and the encoding are prepared before the write sequence
+ * goes odd, so the window readers retry over is three small writes.
+ */
+TACOZIP_EXPORT
+int tacozip_update_ghost_v2(const char *zip_path, const taco_ghost_t *ghost);
+
+/**
+ * @brief Rewrite the archive around a larger v2 ghost with @p slack spare bytes.
+ *
+ * The fallback for when tacozip_update_ghost_v2() runs out of room. Entry data
+ * is copied verbatim behind the new ghost (in-kernel where possible) and the
+ * central directory is re-emitted with shifted offsets; slot offsets in
+ * @p ghost that point past the old ghost are shifted by the same amount. The
+ * archive is replaced atomically. The ghost at byte 0 may be v1 or v2; the
+ * result is always v2. The source holds a shared writer lock while it is
+ * copied, so in-place updates wait instead of being lost.
+ *
+ * @param durability TACOZIP_DURABLE_* for publishing the new archive, as the
+ *                   writer option (TACOZIP_DURABLE_DEFAULT = build default).
+ */
+TACOZIP_EXPORT
+int tacozip_rewrite_ghost(const char *zip_path, const taco_ghost_t *ghost, uint32_t slack,
+                          int durability);
+
+
+/* ========================================================================== */
+/*                           CENTRAL DIRECTORY LOOKUP                         */
+/* ========================================================================== */
+
+/** @brief One central-directory record, as reported by the lookup functions. */
+typedef struct {
+    const char *name;              /**< Not NUL-terminated; valid during the call
+                                        only (NULL from tacozip_find_entry(),
+                                        until tacozip_reader_close() from a
+                                        reader handle). */
+    uint16_t    name_len;
+    uint16_t    method;            /**< 0 = STORE. */
+    uint32_t    crc32;
+    uint64_t    compressed_size;
+    uint64_t    uncompressed_size;
+    uint64_t    lfh_offset;        /**< Offset of the entry's local file header. */
+} taco_entry_info_t;
+
+/** @brief Visitor for prefix listings: return 0 to continue, non-zero to stop. */
+typedef int (*tacozip_entry_fn)(void *user, const taco_entry_info_t *entry);
+
+/**
+ * @brief Look up @p name in a central-directory image (e.g. a memory-mapped
+ *        or fetched ghost cd_offset/cd_size range).
+ *
+ * With @p sorted (the ghost has TACO_GHOST_F_CD_SORTED) the image is bisected
+ * by byte position, resynchronizing on record signatures, in O(log n) record
+ * parses and no allocation; otherwise it is scanned. The ghost record itself
+ * is never reported.
+ *
+ * @return TACOZ_OK, TACOZ_ERR_NOT_FOUND, or TACOZ_ERR_INVALID_GHOST if the
+ *         image is not a central directory.
+ */
+TACOZIP_EXPORT
+int tacozip_cd_find(const void *cd, size_t cd_len, int sorted,
+                    const char *name, taco_entry_info_t *out);
+
+/**
+ * @brief Visit every entry whose name starts with @p prefix, in directory order.
+ *
+ * With @p sorted only the matching run is visited after one bisection, so
+ * listing e.g. "tiles/z12/" costs the size of the answer rather than of the
+ * directory. An empty prefix lists everything but the ghost.
+ */
+TACOZIP_EXPORT
+int tacozip_cd_list_prefix(const void *cd, size_t cd_len, int sorted,
+                           const char *prefix, tacozip_entry_fn fn, void *user);
+
+/**
+ * @brief tacozip_cd_find() on an archive: the central directory is
+ *        memory-mapped and bisected when the ghost says it is sorted.
+ */
+TACOZIP_EXPORT
+int tacozip_find_entry(const char *zip_path, const char *name, taco_entry_info_t *out);
+
+/**
+ * @brief tacozip_cd_list_prefix() on an archive; see tacozip_find_entry().
+ */
+TACOZIP_EXPORT
+int tacozip_list_prefix(const char *zip_path, const char *prefix,
+                        tacozip_entry_fn fn, void *user);
+
+
+/* ========================================================================== */
+/*                                 NAME INDEX                                 */
+/* ========================================================================== */
+
+/*
+ * Name index entry layout (little-endian), written by
+ * tacozip_writer_add_name_index() and referenced by a ghost slot:
+ *
+ *  [0..3]   : magic "TNX1"
+ *  [4..5]   : uint16 version (1)
+ *  [6..7]   : uint16 header size (48)
+ *  [8..15]  : uint64 hash seed
+ *  [16..23] : uint64 indexed entries n
+ *  [24..31] : uint64 slot count m (> n)
+ *  [32..39] : uint64 bucket count b
+ *  [40..47] : reserved
+ *  [hdr..]  : b uint16 pilots, padded to 8 bytes
+ *  [slots]  : m records of uint64 fingerprint, uint64 back distance, uint64
+ *             size, uint32 CRC-32 and 4 reserved bytes; distance 0 marks an
+ *             empty slot
+ *
+ * H(s, seed) is 64-bit FNV-1a over the bytes of s, started from
+ * 0xcbf29ce484222325 ^ seed, then passed through M, the MurmurHash3 64-bit
+ * finalizer. For a name with h = H(name, seed):
+ *
+ *   bucket = ((h >> 32) * b) >> 32
+ *   slot   = (h ^ M(pilot[bucket])) % m
+ *
+ * and the slot holds the name iff its fingerprint equals
+ * H(name, seed ^ TACO_NAME_INDEX_FP_SALT). A lookup reads the header, one
+ * pilot and one slot, so a remote reader resolves a name with two dependent
+ * range requests once the header is cached; a name not in the index is
+ * rejected except with probability 2^-64.
+ *
+ * The back distance is the index's own data offset minus the entry's data
+ * offset, so the index stays valid when the entry region moves as a block
+ * (tacozip_rewrite_ghost()).
+ */
+
+#define TACO_NAME_INDEX_MAGIC       "TNX1"
+#define TACO_NAME_INDEX_VERSION     1u
+#define TACO_NAME_INDEX_HEADER_SIZE 48u
+#define TACO_NAME_INDEX_FP_SALT     0x9e3779b97f4a7c15ull
+
+/** @brief Where an indexed entry's bytes are. */
+typedef struct {
+    uint64_t offset;  /**< First data byte (past the local header). */
+    uint64_t length;  /**< Stored size (STORE: the entry size). */
+    uint32_t crc32;
+} taco_index_entry_t;
+
+/**
+ * @brief Append a name index over every entry added so far as entry
+ *        @p arc_name and point ghost slot @p slot at it.
+ *
+ * Building holds 8 bytes per entry plus the index itself (about 33 bytes per
+ * entry) in memory. Entries added after the index are not in it.
+ *
+ * @return TACOZ_ERR_PARAM if @p slot is beyond the ghost capacity or the
+ *         archive has duplicate names.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_add_name_index(tacozip_writer_t *w, const char *arc_name, unsigned slot);
+
+/**
+ * @brief Resolve @p name in a name index image (memory-mapped or fetched)
+ *        whose first byte is at archive offset @p index_offset (its ghost
+ *        slot offset).
+ *
+ * @return TACOZ_OK, TACOZ_ERR_NOT_FOUND, or TACOZ_ERR_INVALID_GHOST if the
+ *         image is not a name index.
+ */
+TACOZIP_EXPORT
+int tacozip_name_index_find(const void *index, size_t len, uint64_t index_offset,
+                            const char *name, taco_index_entry_t *out);
+
+/**
+ * @brief Resolve @p name through the name index at ghost slot @p slot of
+ *        an archive: one ghost read, then three small positioned reads.
+ */
+TACOZIP_EXPORT
+int tacozip_find_indexed(const char *zip_path, unsigned slot, const char *name,
+                         taco_index_entry_t *out);
+
+
+/* ========================================================================== */
+/*                                  ID TABLE                                  */
+/* ========================================================================== */
+
+/*
+ * ID table entry layout (little-endian), written by
+ * tacozip_writer_add_id_table() and referenced by a ghost slot:
+ *
+ *  [0..3]   : magic "TID1"
+ *  [4..5]   : uint16 version (1)
+ *  [6..7]   : uint16 header size (32)
+ *  [8..11]  : uint32 record size (16)
+ *  [12..15] : reserved
+ *  [16..23] : uint64 entry count n
+ *  [24..31] : reserved
+ *  [hdr..]  : n records of uint64 back distance and uint64 size
+ *
+ * Entry IDs are insertion order: the first entry added to the writer is
+ * ID 0 (the ghost is not counted). Record i lives at
+ * TACO_ID_TABLE_RECORD_OFFSET(i) from the table's slot offset, so a remote
+ * reader that has the ghost fetches one 16-byte range, then the data. The
+ * back distance is the table's data offset minus the entry's, as in the
+ * name index.
+ */
+
+#define TACO_ID_TABLE_MAGIC       "TID1"
+#define TACO_ID_TABLE_VERSION     1u
+#define TACO_ID_TABLE_HEADER_SIZE 32u
+#define TACO_ID_TABLE_RECORD_SIZE 16u
+#define TACO_ID_TABLE_RECORD_OFFSET(id) \
+    (TACO_ID_TABLE_HEADER_SIZE + (uint64_t)(id) * TACO_ID_TABLE_RECORD_SIZE)
+
+/**
+ * @brief Append an ID table over every entry added so far as entry
+ *        @p arc_name and point ghost slot @p slot at it.
+ *
+ * Entries added after the table (including the table itself) are not in it.
+ *
+ * @return TACOZ_ERR_PARAM if @p slot is beyond the ghost capacity.
+ */
+TACOZIP_EXPORT
+int tacozip_writer_add_id_table(tacozip_writer_t *w, const char *arc_name, unsigned slot);
+
+/**
+ * @brief Data offset and size of entry @p id in an ID table image
+ *        (memory-mapped or fetched) starting at archive offset @p table_offset.
+ *
+ * @return TACOZ_OK, TACOZ_ERR_NOT_FOUND if @p id is past the last entry, or
+ *         TACOZ_ERR_INVALID_GHOST if the image is not an ID table.
+ */
+TACOZIP_EXPORT
+int tacozip_id_table_get(const void *table, size_t len, uint64_t table_offset,
+                         uint64_t id, uint64_t *offset, uint64_t *length);
+
+/**
+ * @brief Data offset and size of entry @p id through the ID table at ghost
+ *        slot @p slot of an archive: one ghost read and one record read.
+ */
+TACOZIP_EXPORT
+int tacozip_locate_by_id(const char *zip_path, unsigned slot, uint64_t id,
+                         uint64_t *offset, uint64_t *length);
+
+/**
+ * @brief Read the bytes of entry @p id into @p buf.
+ *
+ * *out_len receives the entry size. If it exceeds @p cap nothing is read and
+ * TACOZ_ERR_PARAM is returned, so a NULL/0 buffer queries the size.
+ */
+TACOZIP_EXPORT
+int tacozip_read_by_id(const char *zip_path, unsigned slot, uint64_t id,
+                       void *buf, size_t cap, uint64_t *out_len);
+
+
+/* ========================================================================== */
+/*                                READER HANDLE                               */
+/* ========================================================================== */
+
+/*
+ * A reader handle opens an archive once for many lookups and reads. The
+ * central directory is mapped and indexed at open (bisected when sorted,
+ * otherwise hashed by name); after that the handle is immutable and entry
+ * data is read with positioned reads, so one handle can serve any number of
+ * threads at once. The archive must not be modified while a handle is open.
+ */
+
+/** @brief Opaque shared reader handle. */
+typedef struct tacozip_reader tacozip_reader_t;
+
+/**
+ * @brief Open @p zip_path for reading. The ghost is optional.
+ *
+ * Memory is 8 bytes per entry, plus 16 per entry for the name table of an
+ * unsorted central directory, on top of the mapped directory.
+ */
+TACOZIP_EXPORT
+int tacozip_reader_open(const char *zip_path, tacozip_reader_t **out);
+
+/** @brief Release a handle; no other thread may still be using it. NULL is a no-op. */
+TACOZIP_EXPORT
+void tacozip_reader_close(tacozip_reader_t *r);
+
+/** @brief Number of entries, not counting the ghost. */
+TACOZIP_EXPORT
+uint64_t tacozip_reader_count(const tacozip_reader_t *r);
+
+/**
+ * @brief The archive's ghost, as read at open.
+ *
+ * @return TACOZ_ERR_INVALID_GHOST if the archive has none.
+ */
+TACOZIP_EXPORT
+int tacozip_reader_ghost(const tacozip_reader_t *r, taco_ghost_t *out);
+
+/**
+ * @brief Entry @p index in directory order (the ghost excluded).
+ *
+ * @return TACOZ_OK or TACOZ_ERR_NOT_FOUND if @p index is out of range.
+ */
+TACOZIP_EXPORT
+int tacozip_reader_entry(const tacozip_reader_t *r, uint64_t index, taco_entry_info_t *out);
+
+/**
+ * @brief Look up @p name; the first record wins when a name repeats.
+ *
+ * @return TACOZ_OK or TACOZ_ERR_NOT_FOUND.
+ */
+TACOZIP_EXPORT
+int tacozip_reader_find(const tacozip_reader_t *r, const char *name, taco_entry_info_t *out);
+
+/**
+ * @brief Archive offset of the first data byte of entry @p e (one 30-byte
+ *        read of its local header). Cache it to read an entry in many pieces.
+ */
+TACOZIP_EXPORT
+int tacozip_reader_data_offset(const tacozip_reader_t *r, const taco_entry_info_t *e,
+                               uint64_t *offset);
+
+/**
+ * @brief Read up to @p len bytes of STORE entry @p e from byte @p offset of
+ *        its data. *out_len is short only at the end of the entry.
+ *
+ * @return TACOZ_ERR_PARAM if @p e is compressed.
+ */
+TACOZIP_EXPORT
+int tacozip_reader_read(const tacozip_reader_t *r, const taco_entry_info_t *e,
+                        uint64_t offset, void *buf, size_t len, size_t *out_len);
+
+
+/* ========================================================================== */
+/*                               MERGE AND SPLIT                              */
+/* ========================================================================== */
+
+/*
+ * Entry data does not depend on where it sits in the archive, so shards
+ * built in parallel can be joined without extracting them: each shard's
+ * entry region (everything between its ghost and its central directory) is
+ * copied verbatim with copy_file_range(), and only the directory records are
+ * re-emitted with shifted offsets. Each region keeps its offset modulo the
+ * block size in the output, so filesystems that clone extents (XFS, Btrfs,
+ * bcachefs) share the shards' blocks instead of copying them. Splitting is the
+ * reverse: runs of whole entries are copied out into self-contained shards.
+ */
+
+/** @brief Options for tacozip_merge(). Initialize with tacozip_merge_opts_init(). */
+typedef struct {
+    unsigned align;       /**< Each shard's entry region keeps its offset modulo
+                               this power of two (up to 65536), with zero gaps
+                               between shards (0 = TACOZ_MERGE_ALIGN, 4096;
+                               1 = packed). */
+    unsigned ghost_slack; /**< v2 ghost: zeroed bytes reserved past the slots,
+                               as tacozip_writer_opts_t::ghost_slack. */
+    int durability;       /**< TACOZIP_DURABLE_* (default TACOZ_DURABILITY). */
+} tacozip_merge_opts_t;
+
+/**
+ * @brief Fill @p opts with the default merge options.
+ */
+TACOZIP_EXPORT
+void tacozip_merge_opts_init(tacozip_merge_opts_t *opts);
+
+/**
+ * @brief Concatenate @p shard_paths into a new archive at @p zip_path.
+ *
+ * Entries keep the shards' order. The shards' ghosts are dropped and a new
+ * ghost collects their slots in shard order, each moved with the data it
+ * points at; inline copies are kept while they fit in TACO_GHOST_INLINE_MAX.
+ * Tables written by tacozip_writer_add_name_index() or add_id_table() stay
+ * valid for the entries of their shard. The ghost is v1 when every shard's
+ * is and at most 7 slots result, v2 otherwise; TACO_GHOST_F_CD_SORTED is set
+ * if the merged directory happens to be in strict name order. A name may
+ * appear only once across all shards: duplicates are caught as records are
+ * copied while the directory stays sorted, else by a name-hash pass over the
+ * finished directory. Shards need not have a ghost. Like the writer, nothing
+ * is written to @p zip_path on failure.
+ *
+ * @param opts Options, or NULL for defaults.
+ * @return TACOZ_ERR_PARAM if more than TACO_GHOST_V2_MAX_SLOTS slots result
+ *         or a name appears twice;
+ *         TACOZ_ERR_INVALID_GHOST if a shard's slot points outside its
+ *         entry region or its directory is malformed.
+ */
+TACOZIP_EXPORT
+int tacozip_merge(const char *zip_path, const char * const *shard_paths, size_t num_shards,
+                  const tacozip_merge_opts_t *opts);
+
+/** @brief Options for tacozip_split(). Initialize with tacozip_split_opts_init(). */
+typedef struct {
+    unsigned threads;          /**< Shards written at once (0 = online CPUs, at
+                                    most 8; Windows writes one at a time). */
+    const char *manifest_path; /**< Optional JSON manifest listing every shard's
+                                    path, entry count, size in bytes and first
+                                    and last entry names (NULL = none). */
+    int durability;            /**< TACOZIP_DURABLE_* for every shard and the
+                                    manifest (default TACOZ_DURABILITY). */
+} tacozip_split_opts_t;
+
+/**
+ * @brief Fill @p opts with the default split options.
+ */
+TACOZIP_EXPORT
+void tacozip_split_opts_init(tacozip_split_opts_t *opts);
+
+/**
+ * @brief Cut @p zip_path into archives of at most @p max_shard_size bytes.
+ *
+ * Entries are kept whole and in directory order; each one's local header and
+ * data are copied verbatim with copy_file_range(), so nothing is extracted.
+ * Shard i is written to @p out_prefix followed by i in at least five digits
+ * and ".zip" (prefix "train-" gives train-00000.zip, train-00001.zip, ...).
+ * An entry larger than the bound gets a shard of its own.
+ *
+ * Every shard gets a ghost in the source's format with the same slot count.
+ * A slot keeps pointing at its bytes in the shard that holds the entry
+ * containing them and is (0, 0) in the others; slots pointing at a name
+ * index or ID table are cleared everywhere and those tables are not copied,
+ * since they describe the whole archive. TACO_GHOST_F_CD_SORTED carries
+ * over; a uniform run does not. A source without a ghost gives shards with
+ * an empty v1 ghost. If any shard fails, the shards already written are
+ * removed.
+ *
+ * @param opts       Options, or NULL for defaults.
+ * @param num_shards Optional; receives the number of shards written.
+ */
+TACOZIP_EXPORT
+int tacozip_split(const char *zip_path, const char *out_prefix, uint64_t max_shard_size,
+                  const tacozip_split_opts_t *opts, size_t *num_shards);
+
+
+/* ========================================================================== */
+/*                              EDITING IN PLACE                              */
+/* ========================================================================== */
+
+/*
+ * Removing or renaming entries changes only the central directory: it is
+ * rebuilt from the old one, written over it at the tail under the writer
+ * lock, and the file is cut after the new end, so the cost follows the size
+ * of the directory rather than of the data. Removed entries' bytes stay
+ * where they were as dead space. A v2 ghost's directory fields and
+ * generation are refreshed in place; its slots keep pointing at their bytes,
+ * except that a slot holding a name index is cleared, since the index hashes
+ * the old names, and on removal so is one holding an ID table, which would
+ * still resolve the removed entries. tacozip_put_file() fills the dead space
+ * with new data and tacozip_compact() reclaims it. Reader handles opened
+ * earlier must be reopened after any of these, and none is atomic against a
+ * crash mid-write; use a rewrite when that matters.
+ */
+
+/**
+ * @brief Remove the entries named in @p names from the central directory.
+ *
+ * Every record with one of the names is dropped; their data stays in the
+ * file. Removing an entry of a uniform run clears TACO_GHOST_F_UNIFORM.
+ *
+ * @return TACOZ_OK; TACOZ_ERR_NOT_FOUND if a name is not in the archive
+ *         (nothing is changed); TACOZ_ERR_PARAM for the ghost's name.
+ */
+TACOZIP_EXPORT
+int tacozip_remove_entries(const char *zip_path, const char * const *names, size_t count);
+
+/**
+ * @brief Rename entry @p old_name to @p new_name.
+ *
+ * The directory record takes the new name; in a sorted directory
+ * (TACO_GHOST_F_CD_SORTED) it also moves to where the name sorts, so the
+ * directory stays sorted. The local header takes the new name in place when
+ * it fits in the header's name and extra fields, giving up optional local
+ * extras for room; leftover bytes become a padding extra field. Otherwise
+ * the local header and data are copied, like tacozip_put_file() data, to
+ * the best-fitting hole or the end of the live data, and the old copy
+ * becomes dead space. Ghost slots into a moved entry are handled as
+ * tacozip_put_file() handles a replaced one, and ID table slots are cleared.
+ *
+ * @return TACOZ_OK; TACOZ_ERR_NOT_FOUND if @p old_name is not in the archive;
+ *         TACOZ_ERR_PARAM if @p new_name is taken, empty or the ghost's name,
+ *         or if the entry would move and has a data descriptor (nothing is
+ *         changed).
+ */
+TACOZIP_EXPORT
+int tacozip_rename_entry(const char *zip_path, const char *old_name, const char *new_name);
+
+
+/** @brief Space accounting filled in by tacozip_compact(). */
+typedef struct {
+    uint64_t file_size;    /**< Archive size before the call. */
+    uint64_t dead_bytes;   /**< Bytes between live data that compaction can
+                                reclaim, before the call: removed entries and
+                                gaps, not the uniform run's alignment padding. */
+    uint64_t holes;        /**< Separate runs of dead bytes. */
+    uint64_t largest_hole; /**< Length of the longest run. */
+    uint64_t bytes_moved;  /**< Entry and slot bytes moved by this call. */
+    uint64_t reclaimed;    /**< Bytes the file shrank by. */
+} tacozip_compact_stats_t;
+
+/**
+ * @brief Reclaim dead space by sliding live data down over the holes before it.
+ *
+ * Live data is every entry plus every byte range a ghost slot points at.
+ * Front to back, each run of it is moved down to close the hole in front
+ * (copy_file_range() in steps of at most TACOZ_COMPACT_CHUNK), until the next
+ * move would take the total past @p budget bytes; then the directory is
+ * rewritten right after the live data with the new offsets and the ghost
+ * slots are rebased. Repeated calls with a small budget compact a little at
+ * a time. The ghost and a uniform run stay where they are. A name index or
+ * ID table slot is kept if all its entries moved with it and cleared
+ * otherwise.
+ *
+ * @param budget Most entry bytes to move (UINT64_MAX = no limit; 0 = only
+ *               fill in @p stats, under a shared lock).
+ * @param stats  Optional.
+ * @return TACOZ_OK; TACOZ_ERR_PARAM for entries with data descriptors or a
+ *         slot pointing past the entries.
+ */
+TACOZIP_EXPORT
+int tacozip_compact(const char *zip_path, uint64_t budget, tacozip_compact_stats_t *stats);
+
+/**
+ * @brief Store @p src_path as entry @p arc_name, replacing it if present,
+ *        reusing dead space before growing the file.
+ *
+ * The entry's local header and data go into the smallest hole that holds
+ * them (dead space left by removals, earlier replacements and moved
+ * directories, between the ghost or uniform run and the directory), or
+ * after the last live byte when none does. The entry being replaced stays
+ * intact until the new directory is written and becomes a hole for the next
+ * call, so tile re-renders reach a steady size instead of growing the file
+ * each time. A ghost slot that held exactly the old entry's data follows it
+ * to the new copy; a slot pointing anywhere else in it is cleared, as are
+ * name index and ID table slots. The record keeps its place in the
+ * directory; a new entry goes where its name sorts when the directory is
+ * sorted, else last. Replacing an entry of a uniform run clears
+ * TACO_GHOST_F_UNIFORM.
+ *
+ * @return TACOZ_OK; TACOZ_ERR_IO if @p src_path is not a readable regular
+ *         file; TACOZ_ERR_PARAM for the ghost's name, an empty name, or
+ *         entries with data descriptors.
+ */
+TACOZIP_EXPORT
+int tacozip_put_file(const char *zip_path, const char *arc_name, const char *src_path);
+
+
+/* ========================================================================== */
+/*                           LOG-STRUCTURED ARCHIVES                          */
+/* ========================================================================== */
+
+/*
+ * In log mode an archive only grows. Each tacozip_log_commit() appends the
+ * new entries' data, then a complete central directory and tail, and
+ * publishes them by updating the v2 ghost in place (seqlock): its directory
+ * fields move to the new directory and its generation is bumped. Nothing
+ * before the old tail is written, so every earlier directory, and the data
+ * it lists, stays readable as a snapshot of its generation; the EOCD comment
+ * of each commit's tail (a 28-byte "TLOG" record) links it to the previous
+ * one. Readers that go through the ghost (tacozip_reader_open_version(),
+ * tacozip_log_versions()) only ever see whole commits, even while a commit
+ * is being appended or after a crash in the middle of one, which the next
+ * commit overwrites. Tools that read the tail at the file end see the
+ * newest complete commit once it is written. Non-log edits (removing,
+ * renaming, tacozip_put_file(), compaction) rewrite the newest directory
+ * and reuse dead space, which ends the history at that point.
+ */
+
+/** @brief One published directory of a log-structured archive. */
+typedef struct {
+    uint64_t generation;  /**< Ghost generation it was published as. */
+    uint64_t cd_offset;   /**< Its central directory. */
+    uint64_t cd_size;
+    uint64_t cd_entries;  /**< Records, the ghost's included. */
+    uint64_t end;         /**< File offset just past its tail. */
+} tacozip_log_version_t;
+
+/** Callback for tacozip_log_versions(): 0 = continue, nonzero = stop (a
+ *  negative value is returned as the error). */
+typedef int (*tacozip_log_fn)(void *user, const tacozip_log_version_t *version);
+
+/**
+ * @brief Commit @p count changes as a new version of the archive.
+ *
+ * Entry arc_names[i] gets the contents of src_paths[i], replacing an entry
+ * of that name, or leaves the directory if src_paths[i] is NULL. The data
+ * is appended in name order, followed by the new directory, in which a
+ * replacement keeps the old record's place (sorted directories stay
+ * sorted; other new names go last). Ghost slots follow the entries they
+ * held, as with tacozip_put_file(); name index and ID table slots are
+ * cleared.
+ *
+ * @param durability TACOZIP_DURABLE_NONE leaves flushing to the OS; DATA or
+ *                   FULL sync the appended data and directory before the
+ *                   ghost update publishes them, then the ghost itself
+ *                   (TACOZIP_DURABLE_DEFAULT = build default).
+ * @param out Optional; receives the version just published.
+ * @return TACOZ_OK; TACOZ_ERR_PARAM without a v2 ghost, for a repeated,
+ *         empty or ghost name, or when a superseded entry has a data
+ *         descriptor, or for an unknown @p durability;
+ *         TACOZ_ERR_NOT_FOUND when removing a missing name.
+ */
+TACOZIP_EXPORT
+int tacozip_log_commit(const char *zip_path, const char * const *src_paths,
+                       const char * const *arc_names, size_t count, int durability,
+                       tacozip_log_version_t *out);
+
+/**
+ * @brief Visit the archive's published directories, newest first.
+ *
+ * The newest is the one the ghost names. The walk follows the "TLOG" links
+ * and ends with the directory the first commit superseded, or earlier
+ * where a non-log edit ended the history. An archive that was never
+ * committed to has one version.
+ */
+TACOZIP_EXPORT
+int tacozip_log_versions(const char *zip_path, tacozip_log_fn fn, void *user);
+
+/**
+ * @brief Open a reader on the directory published as @p generation
+ *        (0 = the newest), as tacozip_reader_open() does for the tail.
+ *
+ * The handle sees that snapshot however many commits follow.
+ * tacozip_reader_ghost() still returns the current ghost.
+ *
+ * @return TACOZ_OK; TACOZ_ERR_NOT_FOUND if no directory has that generation.
+ */
+TACOZIP_EXPORT
+int tacozip_reader_open_version(const char *zip_path, uint64_t generation,
+                                tacozip_reader_t **out);
+
+
 /* ========================================================================== */
 /*                               SINGLE-ENTRY API                             */
 /* ========================================================================== */
@@ -265,6 +1437,8 @@ int tacozip_read_ghost(const char *zip_path, taco_meta_ptr_t *out);
  * @param new_offset New metadata offset for first entry.
  * @param new_length New metadata length for first entry.
  * @return           TACOZ_OK on success; negative error code otherwise.
+ *
+ * @note Every other slot is kept, as described for tacozip_update_ghost_multi().
  */
 TACOZIP_EXPORT
 int tacozip_update_ghost(const char *zip_path,
@@ -290,8 +1464,9 @@ int tacozip_update_ghost(const char *zip_path,
  *    - Function will return TACOZ_ERR_PARAM if array_size != 7
  *    - Count is automatically computed, not passed by user
  *
- * 4) libzip Backend
- *    - All ZIP operations use libzip for robustness
+ * 4) Writer / libzip Backend
+ *    - Archives are created by the native streaming writer; reads and
+ *      modifications of existing archives use libzip
  *    - Always forces ZIP64 format regardless of file sizes
  *    - Always uses STORE method (no compression)
  *    - Ghost entry is included in central directory as normal entry
@@ -1,12 +1,12 @@
 /*
- * tacozip.c — ZIP64 (STORE-only) writer with libzip backend and TACO Ghost supporting up to 7 metadata entries.
+ * tacozip.c — ZIP64 (STORE-only) archives with a TACO Ghost supporting up to 7 metadata entries.
  *
- * This implementation replaces all custom ZIP code with libzip, while maintaining
- * the same API and ghost header concept. The ghost entry is now included in the
- * central directory as a normal file entry, but is physically first in the archive.
+ * Archive creation goes through the native streaming writer (tacozip_writer.c);
+ * reading and modifying existing archives uses libzip. The ghost entry is
+ * included in the central directory as a normal file entry, but is physically
+ * first in the archive.
  *
- * Key changes from custom implementation:
- *  - Uses libzip for all ZIP operations (no more manual ZIP structures)
+ * Key properties:
  *  - Always forces ZIP64 format regardless of file sizes
  *  - Always uses STORE method (no compression)
  *  - Ghost entry appears in central directory as normal entry
@@ -34,6 +34,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <limits.h>
 #include <string.h>
 #include <errno.h>
 
@@ -50,194 +51,7 @@
 /* libzip includes */
 #include <zip.h>
 
-/* ------------------------------- Tunables ---------------------------------- */
-/* These can be overridden at compile time (CMake passes -D… if desired). */
-#ifndef TACOZ_COPY_BUFSZ
-#define TACOZ_COPY_BUFSZ (1u << 20)    /* 1 MiB copy buffer */
-#endif
-#ifndef TACOZ_SET_UTF8_FLAG
-#define TACOZ_SET_UTF8_FLAG 0          /* set GP bit 11 if caller guarantees UTF-8 names */
-#endif
-
-/* -------------------------- Little-endian writers -------------------------- */
-static inline void le64(unsigned char *p, uint64_t v){
-    p[0] = (unsigned char)(v      );
-    p[1] = (unsigned char)(v >> 8 );
-    p[2] = (unsigned char)(v >> 16);
-    p[3] = (unsigned char)(v >> 24);
-    p[4] = (unsigned char)(v >> 32);
-    p[5] = (unsigned char)(v >> 40);
-    p[6] = (unsigned char)(v >> 48);
-    p[7] = (unsigned char)(v >> 56);
-}
-
-/* -------------------------- Little-endian readers -------------------------- */
-static inline uint64_t le64_read(const unsigned char *p) {
-    uint64_t v = 0;
-    for (int i = 0; i < 8; i++) v |= ((uint64_t)p[i]) << (8u * i);
-    return v;
-}
-
-/* ----------------------- Multi-parquet helper functions -------------------- */
-
-/**
- * @brief Count valid metadata entries by scanning until first (0,0) pair.
- * @param offsets Array of 7 offset values
- * @param lengths Array of 7 length values  
- * @return Number of valid entries (0-7)
- */
-static uint8_t count_valid_entries(const uint64_t *offsets, const uint64_t *lengths) {
-    for (size_t i = 0; i < TACO_GHOST_MAX_ENTRIES; i++) {
-        if (offsets[i] == 0 && lengths[i] == 0) {
-            return (uint8_t)i;  /* Found first (0,0) pair */
-        }
-    }
-    return TACO_GHOST_MAX_ENTRIES;  /* All 7 entries are valid */
-}
-
-/**
- * @brief Convert arrays to taco_meta_array_t structure.
- * @param offsets Input array of 7 offset values
- * @param lengths Input array of 7 length values
- * @param out Output structure
- */
-static void arrays_to_meta_struct(const uint64_t *offsets, const uint64_t *lengths, taco_meta_array_t *out) {
-    out->count = count_valid_entries(offsets, lengths);
-    for (size_t i = 0; i < TACO_GHOST_MAX_ENTRIES; i++) {
-        out->entries[i].offset = offsets[i];
-        out->entries[i].length = lengths[i];
-    }
-}
-
-/**
- * @brief Convert taco_meta_array_t structure to arrays.
- * @param meta Input structure
- * @param offsets Output array of 7 offset values
- * @param lengths Output array of 7 length values
- */
-static void meta_struct_to_arrays(const taco_meta_array_t *meta, uint64_t *offsets, uint64_t *lengths) {
-    for (size_t i = 0; i < TACO_GHOST_MAX_ENTRIES; i++) {
-        offsets[i] = meta->entries[i].offset;
-        lengths[i] = meta->entries[i].length;
-    }
-}
-
-/* ---------------------------- Ghost payload creator ------------------------ */
-/**
- * @brief Create ghost payload from metadata structure.
- * @param meta Input metadata structure
- * @param payload Output buffer (must be at least TACO_GHOST_PAYLOAD_SIZE bytes)
- */
-static void create_ghost_payload(const taco_meta_array_t *meta, unsigned char *payload) {
-    memset(payload, 0, TACO_GHOST_PAYLOAD_SIZE);
-    
-    /* Count byte + 3 padding bytes for alignment */
-    payload[0] = meta->count;
-    payload[1] = payload[2] = payload[3] = 0;  /* padding */
-
-    /* 7 pairs of (offset, length) - 112 bytes total */
-    unsigned char *pairs_start = payload + 4;
-    for (size_t i = 0; i < TACO_GHOST_MAX_ENTRIES; i++) {
-        le64(pairs_start + i * 16 + 0, meta->entries[i].offset);
-        le64(pairs_start + i * 16 + 8, meta->entries[i].length);
-    }
-}
-
-/* ---------------------------- Ghost payload parser ------------------------- */
-/**
- * @brief Parse ghost payload into metadata structure.
- * @param payload Input buffer (must be at least TACO_GHOST_PAYLOAD_SIZE bytes)
- * @param meta Output metadata structure
- * @return TACOZ_OK on success, TACOZ_ERR_INVALID_GHOST on error
- */
-static int parse_ghost_payload(const unsigned char *payload, taco_meta_array_t *meta) {
-    memset(meta, 0, sizeof(*meta));
-    
-    /* Read count byte */
-    meta->count = payload[0];
-    if (meta->count > TACO_GHOST_MAX_ENTRIES) return TACOZ_ERR_INVALID_GHOST;
-
-    /* Read all 7 pairs (even unused ones) */
-    const unsigned char *pairs_start = payload + 4;
-    for (size_t i = 0; i < TACO_GHOST_MAX_ENTRIES; i++) {
-        meta->entries[i].offset = le64_read(pairs_start + i * 16 + 0);
-        meta->entries[i].length = le64_read(pairs_start + i * 16 + 8);
-    }
-
-    return TACOZ_OK;
-}
-
-/* ----------------------- libzip helper functions --------------------------- */
-
-/**
- * @brief Add file to libzip archive with STORE method and ZIP64.
- * @param za libzip archive handle
- * @param src_path Source file path
- * @param arc_name Archive entry name
- * @return TACOZ_OK on success, error code on failure
- */
-static int add_file_to_archive(zip_t *za, const char *src_path, const char *arc_name) {
-    /* Create source from file */
-    zip_source_t *source = zip_source_file(za, src_path, 0, -1);
-    if (!source) {
-        return TACOZ_ERR_IO;
-    }
-
-    /* Add file to archive */
-    zip_int64_t index = zip_file_add(za, arc_name, source, ZIP_FL_OVERWRITE);
-    if (index < 0) {
-        zip_source_free(source);
-        return TACOZ_ERR_LIBZIP;
-    }
-
-    /* Force STORE method (no compression) */
-    if (zip_set_file_compression(za, (zip_uint64_t)index, ZIP_CM_STORE, 0) < 0) {
-        return TACOZ_ERR_LIBZIP;
-    }
-
-    /* Suppress unused parameter warnings for UTF-8 handling */
-    (void)index;
-
-    return TACOZ_OK;
-}
-
-/**
- * @brief Add ghost entry to libzip archive.
- * @param za libzip archive handle
- * @param meta Metadata structure for ghost payload
- * @return TACOZ_OK on success, error code on failure
- */
-static int add_ghost_to_archive(zip_t *za, const taco_meta_array_t *meta) {
-    /* Create ghost payload */
-    unsigned char *payload = malloc(TACO_GHOST_PAYLOAD_SIZE);
-    if (!payload) return TACOZ_ERR_IO;
-    
-    create_ghost_payload(meta, payload);
-
-    /* Create source from buffer */
-    zip_source_t *source = zip_source_buffer(za, payload, TACO_GHOST_PAYLOAD_SIZE, 1); /* 1 = freep */
-    if (!source) {
-        free(payload);
-        return TACOZ_ERR_LIBZIP;
-    }
-
-    /* Add ghost entry to archive */
-    zip_int64_t index = zip_file_add(za, TACO_GHOST_NAME, source, ZIP_FL_OVERWRITE);
-    if (index < 0) {
-        zip_source_free(source);
-        return TACOZ_ERR_LIBZIP;
-    }
-
-    /* Force STORE method (no compression) */
-    if (zip_set_file_compression(za, (zip_uint64_t)index, ZIP_CM_STORE, 0) < 0) {
-        return TACOZ_ERR_LIBZIP;
-    }
-
-    /* Suppress unused parameter warnings */
-    (void)index;
-
-    return TACOZ_OK;
-}
+#include "tacozip_internal.h"
 
 /* ========================================================================== */
 /*                            NEW MULTI-PARQUET API                          */
@@ -257,89 +71,130 @@ int tacozip_create_multi(const char *zip_path,
     if (!meta_offsets || !meta_lengths || array_size != TACO_GHOST_MAX_ENTRIES)
         return TACOZ_ERR_PARAM;
 
-    int error;
-    zip_t *za = zip_open(zip_path, ZIP_CREATE | ZIP_TRUNCATE, &error);
-    if (!za) {
-        return TACOZ_ERR_IO;
+    /* Validate every pair before touching the filesystem */
+    for (size_t i = 0; i < num_files; i++) {
+        if (!src_files[i] || !arc_files[i]) return TACOZ_ERR_PARAM;
     }
 
-    /* Convert arrays to metadata structure */
-    taco_meta_array_t meta = {0};
-    arrays_to_meta_struct(meta_offsets, meta_lengths, &meta);
+    tacozip_writer_t *w = NULL;
+    int rc = tacozip_writer_begin(zip_path, NULL, &w);
+    if (rc != TACOZ_OK) return rc;
+
+    rc = tacozip_writer_set_ghost(w, meta_offsets, meta_lengths, array_size);
+
+    /* Add every regular file; sources are opened ahead of the copy */
+    if (rc == TACOZ_OK)
+        rc = tacozip_writer_add_files(w, src_files, arc_files, num_files, NULL);
 
-    /* Add ghost entry first (so it appears at the beginning physically) */
-    int rc = add_ghost_to_archive(za, &meta);
     if (rc != TACOZ_OK) {
-        zip_close(za);
+        tacozip_writer_abort(w);
         return rc;
     }
 
-    /* Add each regular file */
+    /* Write the central directory and publish the archive */
+    return tacozip_writer_finish(w);
+}
+
+/** Add the metadata files, filling ghost slot i from file i. */
+static int add_meta_files(tacozip_writer_t *w,
+                          const char * const *meta_src_files,
+                          const char * const *meta_arc_files,
+                          size_t num_meta) {
+    int rc = TACOZ_OK;
+    for (size_t i = 0; i < num_meta && rc == TACOZ_OK; i++)
+        rc = tacozip_writer_add_meta_file(w, meta_src_files[i], meta_arc_files[i], (unsigned)i);
+    return rc;
+}
+
+int tacozip_create_placed(const char *zip_path,
+                          const char * const *src_files,
+                          const char * const *arc_files,
+                          size_t num_files,
+                          const char * const *meta_src_files,
+                          const char * const *meta_arc_files,
+                          size_t num_meta,
+                          int placement)
+{
+    if (!zip_path || (num_files && (!src_files || !arc_files)))
+        return TACOZ_ERR_PARAM;
+    if (!meta_src_files || !meta_arc_files || num_meta == 0 ||
+        num_meta > TACO_GHOST_V2_MAX_SLOTS)
+        return TACOZ_ERR_PARAM;
+    if (placement != TACOZIP_META_LAST && placement != TACOZIP_META_FIRST)
+        return TACOZ_ERR_PARAM;
     for (size_t i = 0; i < num_files; i++) {
-        if (!src_files[i] || !arc_files[i]) {
-            zip_close(za);
-            return TACOZ_ERR_PARAM;
-        }
-        
-        rc = add_file_to_archive(za, src_files[i], arc_files[i]);
-        if (rc != TACOZ_OK) {
-            zip_close(za);
-            return rc;
-        }
+        if (!src_files[i] || !arc_files[i]) return TACOZ_ERR_PARAM;
     }
-
-    /* Close and finalize the archive */
-    if (zip_close(za) < 0) {
-        return TACOZ_ERR_IO;
+    for (size_t i = 0; i < num_meta; i++) {
+        if (!meta_src_files[i] || !meta_arc_files[i]) return TACOZ_ERR_PARAM;
     }
 
-    return TACOZ_OK;
-}
+    /* Stay readable by v1 readers whenever the slots fit */
+    tacozip_writer_opts_t opts;
+    tacozip_writer_opts_init(&opts);
+    if (num_meta > TACO_GHOST_MAX_ENTRIES) opts.ghost_slots = (unsigned)num_meta;
 
-int tacozip_read_ghost_multi(const char *zip_path, taco_meta_array_t *out) {
-    if (!zip_path || !out) return TACOZ_ERR_PARAM;
-    
-    int error;
-    zip_t *za = zip_open(zip_path, ZIP_RDONLY, &error);
-    if (!za) {
-        return TACOZ_ERR_IO;
-    }
+    tacozip_writer_t *w = NULL;
+    int rc = tacozip_writer_begin(zip_path, &opts, &w);
+    if (rc != TACOZ_OK) return rc;
 
-    /* Find ghost entry */
-    zip_int64_t ghost_index = zip_name_locate(za, TACO_GHOST_NAME, 0);
-    if (ghost_index < 0) {
-        zip_close(za);
-        return TACOZ_ERR_INVALID_GHOST;
-    }
+    if (placement == TACOZIP_META_FIRST)
+        rc = add_meta_files(w, meta_src_files, meta_arc_files, num_meta);
+    if (rc == TACOZ_OK && num_files)
+        rc = tacozip_writer_add_files(w, src_files, arc_files, num_files, NULL);
+    if (rc == TACOZ_OK && placement == TACOZIP_META_LAST)
+        rc = add_meta_files(w, meta_src_files, meta_arc_files, num_meta);
 
-    /* Open ghost file */
-    zip_file_t *ghost_file = zip_fopen_index(za, (zip_uint64_t)ghost_index, 0);
-    if (!ghost_file) {
-        zip_close(za);
-        return TACOZ_ERR_LIBZIP;
+    if (rc != TACOZ_OK) {
+        tacozip_writer_abort(w);
+        return rc;
     }
+    return tacozip_writer_finish(w);
+}
 
-    /* Read ghost payload */
-    unsigned char payload[TACO_GHOST_PAYLOAD_SIZE];
-    zip_int64_t bytes_read = zip_fread(ghost_file, payload, sizeof(payload));
-    zip_fclose(ghost_file);
-    zip_close(za);
+int tacozip_create_from_dir(const char *zip_path,
+                            const char *root_dir,
+                            const tacozip_dir_opts_t *opts,
+                            const uint64_t *meta_offsets,
+                            const uint64_t *meta_lengths,
+                            size_t array_size)
+{
+    if (!zip_path || !root_dir) return TACOZ_ERR_PARAM;
 
-    if (bytes_read != sizeof(payload)) {
-        return TACOZ_ERR_INVALID_GHOST;
+    if (!meta_offsets || !meta_lengths || array_size != TACO_GHOST_MAX_ENTRIES)
+        return TACOZ_ERR_PARAM;
+
+    tacozip_writer_t *w = NULL;
+    int rc = tacozip_writer_begin(zip_path, NULL, &w);
+    if (rc != TACOZ_OK) return rc;
+
+    rc = tacozip_writer_set_ghost(w, meta_offsets, meta_lengths, array_size);
+
+    /* Walk and pack the tree without materializing path arrays for the caller */
+    if (rc == TACOZ_OK)
+        rc = tacozip_writer_add_dir(w, root_dir, opts, NULL);
+
+    if (rc != TACOZ_OK) {
+        tacozip_writer_abort(w);
+        return rc;
     }
 
-    /* Parse payload */
-    return parse_ghost_payload(payload, out);
+    return tacozip_writer_finish(w);
 }
 
-int tacozip_update_ghost_multi(const char *zip_path,
-                              const uint64_t *meta_offsets,
-                              const uint64_t *meta_lengths,
-                              size_t array_size) {
-    if (!zip_path || !meta_offsets || !meta_lengths || array_size != TACO_GHOST_MAX_ENTRIES)
-        return TACOZ_ERR_PARAM;
+int tacozip_read_ghost_multi(const char *zip_path, taco_meta_array_t *out) {
+    if (!zip_path || !out) return TACOZ_ERR_PARAM;
+
+    /* v2 ghosts with more than 7 slots report their first 7 here. */
+    taco_ghost_t g;
+    int rc = tacozip_read_ghost_v2(zip_path, &g);
+    if (rc != TACOZ_OK) return rc;
+    tacoz_ghost_to_meta(&g, out);
+    return TACOZ_OK;
+}
 
+/** Previous update path: libzip rewrites the archive with a new v1 payload. */
+static int update_ghost_libzip(const char *zip_path, const taco_meta_array_t *meta) {
     int error;
     zip_t *za = zip_open(zip_path, 0, &error);  /* Open for modification */
     if (!za) {
@@ -353,10 +208,6 @@ int tacozip_update_ghost_multi(const char *zip_path,
         return TACOZ_ERR_INVALID_GHOST;
     }
 
-    /* Convert arrays to metadata structure */
-    taco_meta_array_t meta = {0};
-    arrays_to_meta_struct(meta_offsets, meta_lengths, &meta);
-
     /* Create new ghost payload */
     unsigned char *payload = malloc(TACO_GHOST_PAYLOAD_SIZE);
     if (!payload) {
@@ -364,7 +215,7 @@ int tacozip_update_ghost_multi(const char *zip_path,
         return TACOZ_ERR_IO;
     }
     
-    create_ghost_payload(&meta, payload);
+    tacoz_create_ghost_payload(meta, payload);
 
     /* Create source from buffer for replacement */
     zip_source_t *source = zip_source_buffer(za, payload, TACO_GHOST_PAYLOAD_SIZE, 1); /* 1 = freep */
@@ -395,13 +246,81 @@ int tacozip_update_ghost_multi(const char *zip_path,
     return TACOZ_OK;
 }
 
-int tacozip_replace_file(const char *zip_path,
-                        const char *file_name,
-                        const char *new_src_path) {
-    if (!zip_path || !file_name || !new_src_path) {
-        return TACOZ_ERR_PARAM;
+/**
+ * @brief Replace the first @p n slots of the stored ghost, as the legacy
+ *        updaters do. A v2 ghost keeps its later slots, its flags and the
+ *        inline copies of slots that did not change.
+ */
+static int update_leading_slots(const char *zip_path,
+                                const uint64_t *offsets,
+                                const uint64_t *lengths,
+                                size_t n) {
+    taco_ghost_t g;
+    int rc = tacozip_read_ghost_v2(zip_path, &g);
+    if (rc != TACOZ_OK) return rc;
+
+    for (size_t i = 0; i < n; i++) {
+        if (g.slots[i].offset == offsets[i] && g.slots[i].length == lengths[i]) continue;
+        g.slots[i].offset = offsets[i];
+        g.slots[i].length = lengths[i];
+        g.inline_len[i] = 0;
     }
 
+    /* A v1 ghost counts the non-empty pairs from the start; a v2 ghost may
+     * hold empty slots, so it ends at its last non-empty one. */
+    uint64_t o[TACO_GHOST_MAX_ENTRIES], l[TACO_GHOST_MAX_ENTRIES];
+    for (size_t i = 0; i < TACO_GHOST_MAX_ENTRIES; i++) {
+        o[i] = g.slots[i].offset;
+        l[i] = g.slots[i].length;
+    }
+    if (g.version != 2) {
+        g.count = tacoz_count_valid_entries(o, l);
+    } else if (g.count <= TACO_GHOST_MAX_ENTRIES) {
+        g.count = 0;
+        for (size_t i = 0; i < TACO_GHOST_MAX_ENTRIES; i++)
+            if (o[i] || l[i]) g.count = (uint16_t)(i + 1);
+    }
+
+    /* In place when the ghost is where we wrote it; libzip otherwise, which
+     * only has room for 7 slots. */
+    rc = tacozip_update_ghost_v2(zip_path, &g);
+    if (rc == TACOZ_ERR_INVALID_GHOST) {
+        if (g.count > TACO_GHOST_MAX_ENTRIES) return TACOZ_ERR_PARAM;
+        taco_meta_array_t meta;
+        tacoz_arrays_to_meta(o, l, &meta);
+        rc = update_ghost_libzip(zip_path, &meta);
+    }
+    return rc;
+}
+
+int tacozip_update_ghost_multi(const char *zip_path,
+                              const uint64_t *meta_offsets,
+                              const uint64_t *meta_lengths,
+                              size_t array_size) {
+    if (!zip_path || !meta_offsets || !meta_lengths || array_size != TACO_GHOST_MAX_ENTRIES)
+        return TACOZ_ERR_PARAM;
+
+    return update_leading_slots(zip_path, meta_offsets, meta_lengths, TACO_GHOST_MAX_ENTRIES);
+}
+
+/**
+ * @brief Refresh the central directory fields of a v2 ghost after the archive
+ *        was rewritten. Archives without a native v2 ghost are left alone.
+ */
+static int sync_ghost_cd(const char *zip_path) {
+    taco_ghost_t g;
+    int rc = tacozip_read_ghost_v2(zip_path, &g);
+    if (rc != TACOZ_OK || g.version != 2) return TACOZ_OK;
+    rc = tacozip_update_ghost_v2(zip_path, &g);
+    return rc == TACOZ_ERR_INVALID_GHOST ? TACOZ_OK : rc;
+}
+
+/** Fallback for archives the native path cannot map (data descriptors,
+ *  foreign layouts): libzip rewrites the whole archive. */
+static int replace_file_libzip(const char *zip_path,
+                               const char *file_name,
+                               const char *new_src_path) {
+
     /* Verify the new source file exists and is readable */
     FILE *test_file = fopen(new_src_path, "rb");
     if (!test_file) {
@@ -453,9 +372,186 @@ int tacozip_replace_file(const char *zip_path,
         return TACOZ_ERR_IO;
     }
 
+    /* libzip rewrote the central directory; point the ghost at the new one. */
+    return sync_ghost_cd(zip_path);
+}
+
+int tacozip_replace_file(const char *zip_path,
+                        const char *file_name,
+                        const char *new_src_path) {
+    if (!zip_path || !file_name || !new_src_path) {
+        return TACOZ_ERR_PARAM;
+    }
+
+    /* In place, into the best-fitting hole; libzip when the layout is not ours. */
+    int rc = tacoz_put_file(zip_path, file_name, new_src_path, 1);
+    if (rc == TACOZ_ERR_PARAM || rc == TACOZ_ERR_INVALID_GHOST)
+        rc = replace_file_libzip(zip_path, file_name, new_src_path);
+    return rc;
+}
+
+/* ========================================================================== */
+/*                                  GHOST V2                                  */
+/* ========================================================================== */
+
+void tacozip_ghost_init(taco_ghost_t *ghost) {
+    if (!ghost) return;
+    memset(ghost, 0, sizeof(*ghost));
+    ghost->version = TACO_GHOST_V2_VERSION;
+}
+
+int tacozip_ghost_set_inline(taco_ghost_t *ghost, unsigned slot,
+                             const void *data, uint32_t len) {
+    if (!ghost || !data) return TACOZ_ERR_PARAM;
+    return tacoz_ghost_add_inline(ghost, slot, data, len);
+}
+
+int tacozip_parse_ghost_head(const void *head, size_t len, taco_ghost_t *out) {
+    if (!head || !out) return TACOZ_ERR_PARAM;
+
+    const unsigned char *p = (const unsigned char *)head;
+    tacoz_ghost_loc_t loc;
+    size_t need;
+    int rc = tacoz_ghost_lfh_parse(p, len, &loc, &need);
+    if (rc == TACOZ_ERR_PARAM) return (int)need;
+    if (rc != TACOZ_OK) return rc;
+
+    /* The header tells how much of the payload is meaningful. */
+    size_t avail = len - (size_t)loc.data_off;
+    if (avail > loc.size) avail = (size_t)loc.size;
+    need = tacoz_ghost_need(p + loc.data_off, avail);
+    if (need > loc.size) return TACOZ_ERR_INVALID_GHOST;
+    if (need > avail) return loc.data_off + need > INT_MAX ? TACOZ_ERR_INVALID_GHOST
+                                                           : (int)(loc.data_off + need);
+    return tacoz_ghost_decode(p + loc.data_off, avail, out);
+}
+
+/** Fallback for archives whose ghost is not the entry at byte 0. */
+static int read_ghost_libzip(const char *zip_path, taco_ghost_t *out) {
+    int error;
+    zip_t *za = zip_open(zip_path, ZIP_RDONLY, &error);
+    if (!za) {
+        return TACOZ_ERR_IO;
+    }
+
+    zip_stat_t st;
+    zip_int64_t ghost_index = zip_name_locate(za, TACO_GHOST_NAME, 0);
+    if (ghost_index < 0 || zip_stat_index(za, (zip_uint64_t)ghost_index, 0, &st) < 0 ||
+        !(st.valid & ZIP_STAT_SIZE) || st.size > UINT32_MAX) {
+        zip_close(za);
+        return TACOZ_ERR_INVALID_GHOST;
+    }
+
+    zip_file_t *ghost_file = zip_fopen_index(za, (zip_uint64_t)ghost_index, 0);
+    unsigned char *payload = malloc(st.size ? (size_t)st.size : 1);
+    if (!ghost_file || !payload) {
+        if (ghost_file) zip_fclose(ghost_file);
+        free(payload);
+        zip_close(za);
+        return ghost_file ? TACOZ_ERR_IO : TACOZ_ERR_LIBZIP;
+    }
+
+    zip_int64_t bytes_read = zip_fread(ghost_file, payload, st.size);
+    zip_fclose(ghost_file);
+    zip_close(za);
+
+    int rc = bytes_read == (zip_int64_t)st.size
+           ? tacoz_ghost_decode(payload, (size_t)st.size, out) : TACOZ_ERR_INVALID_GHOST;
+    free(payload);
+    return rc;
+}
+
+int tacozip_uniform_locate(const taco_ghost_t *ghost, uint64_t index, uint64_t *offset) {
+    if (!ghost || !offset || !(ghost->flags & TACO_GHOST_F_UNIFORM)) return TACOZ_ERR_PARAM;
+    if (index >= ghost->uniform_count) return TACOZ_ERR_NOT_FOUND;
+    *offset = ghost->uniform_base + index * ghost->uniform_stride;
     return TACOZ_OK;
 }
 
+int tacozip_read_ghost_v2(const char *zip_path, taco_ghost_t *out) {
+    if (!zip_path || !out) return TACOZ_ERR_PARAM;
+
+    int fd = tacoz_open_read(zip_path);
+    if (fd < 0) return TACOZ_ERR_IO;
+
+    tacoz_ghost_loc_t loc;
+    int rc = tacoz_ghost_locate(fd, &loc);
+    if (rc == TACOZ_OK) rc = tacoz_ghost_read(fd, &loc, out);
+    tacoz_close(fd);
+
+    if (rc == TACOZ_ERR_INVALID_GHOST) rc = read_ghost_libzip(zip_path, out);
+    return rc;
+}
+
+int tacoz_ghost_write(int fd, const taco_ghost_t *ghost, uint32_t drop_flags) {
+    tacoz_ghost_loc_t loc;
+    tacoz_tail_t tail;
+    uint64_t cdh_off = 0;
+    unsigned char *payload = NULL;
+    taco_ghost_t *g = malloc(sizeof(*g));
+
+    int rc = g ? tacoz_ghost_locate(fd, &loc) : TACOZ_ERR_IO;
+    if (rc == TACOZ_OK) rc = tacoz_read_tail(fd, &tail);
+    if (rc == TACOZ_OK) rc = tacoz_ghost_find_cdh(fd, &tail, &cdh_off);
+    if (rc == TACOZ_OK && (loc.size < 4 || loc.size > UINT32_MAX)) rc = TACOZ_ERR_INVALID_GHOST;
+    if (rc == TACOZ_OK && !(payload = malloc((size_t)loc.size))) rc = TACOZ_ERR_IO;
+
+    /* The stored format is kept: a v1 ghost stays v1, a v2 ghost keeps its size. */
+    size_t head = loc.size < TACOZ_GHOST_LAYOUT_HEAD ? (size_t)loc.size : TACOZ_GHOST_LAYOUT_HEAD;
+    size_t seq_at = 0;
+    uint16_t seq = 0;
+    if (rc == TACOZ_OK) rc = tacoz_pread_all(fd, payload, head, loc.data_off);
+    if (rc == TACOZ_OK) {
+        int version = memcmp(payload, TACO_GHOST_V2_MAGIC, 4) == 0 ? 2 : 1;
+        seq_at = TACOZ_GHOST_SEQ_OFF(payload);
+        if (seq_at + 2 > head) rc = TACOZ_ERR_INVALID_GHOST;
+        else seq = le16_read(payload + seq_at);
+        *g = *ghost;
+        g->cd_offset  = tail.cd_off;
+        g->cd_size    = tail.cd_size;
+        g->cd_entries = tail.entries;
+        g->generation = tacoz_ghost_generation(payload, head) + 1;
+        /* Directory order and entry layout are the archive's, not the
+         * caller's, to vouch for. */
+        tacoz_ghost_keep_layout(g, payload, head);
+        g->flags &= ~drop_flags;
+        if (rc == TACOZ_OK && version == 2) rc = tacoz_ghost_slot_crcs(fd, g);
+        if (rc == TACOZ_OK) rc = tacoz_ghost_encode(g, version, payload, (size_t)loc.size);
+    }
+
+    /* Seqlock write: the sequence goes odd, the payload is written, the
+     * sequence goes even; an odd sequence left by a dead writer is skipped
+     * past. Then the CRC in the LFH and in the central directory. */
+    if (rc == TACOZ_OK) {
+        unsigned char odd[2], even[2], crc[4];
+        le16(odd, (uint16_t)(seq + 1u + (seq & 1u)));
+        le16(even, (uint16_t)(seq + 2u + (seq & 1u)));
+        memcpy(payload + seq_at, odd, 2);
+        rc = tacoz_pwrite_all(fd, odd, 2, loc.data_off + seq_at);
+        if (rc == TACOZ_OK) rc = tacoz_pwrite_all(fd, payload, (size_t)loc.size, loc.data_off);
+        if (rc == TACOZ_OK) rc = tacoz_pwrite_all(fd, even, 2, loc.data_off + seq_at);
+        memcpy(payload + seq_at, even, 2);
+        le32(crc, tacoz_crc32(0, payload, (size_t)loc.size));
+        if (rc == TACOZ_OK) rc = tacoz_pwrite_all(fd, crc, 4, 14);
+        if (rc == TACOZ_OK) rc = tacoz_pwrite_all(fd, crc, 4, cdh_off + 16);
+    }
+
+    free(payload);
+    free(g);
+    return rc;
+}
+
+int tacozip_update_ghost_v2(const char *zip_path, const taco_ghost_t *ghost) {
+    if (!zip_path || !ghost) return TACOZ_ERR_PARAM;
+
+    int fd = tacoz_open_locked(zip_path);
+    if (fd < 0) return TACOZ_ERR_IO;
+
+    int rc = tacoz_ghost_write(fd, ghost, 0);
+    if (tacoz_close(fd) != 0 && rc == TACOZ_OK) rc = TACOZ_ERR_IO;
+    return rc;
+}
+
 /* ========================================================================== */
 /*                         LEGACY SINGLE-ENTRY API                           */
 /* ========================================================================== */
@@ -503,22 +599,7 @@ int tacozip_read_ghost(const char *zip_path, taco_meta_ptr_t *out) {
 
 int tacozip_update_ghost(const char *zip_path, uint64_t new_offset, uint64_t new_length) {
     if (!zip_path) return TACOZ_ERR_PARAM;
-    
-    /* Read current ghost state */
-    taco_meta_array_t meta = {0};
-    int rc = tacozip_read_ghost_multi(zip_path, &meta);
-    if (rc != TACOZ_OK) return rc;
-    
+
     /* Update first entry, preserve others */
-    meta.entries[0].offset = new_offset;
-    meta.entries[0].length = new_length;
-    
-    /* Recalculate count (in case first entry became 0,0) */
-    uint64_t offsets[TACO_GHOST_MAX_ENTRIES];
-    uint64_t lengths[TACO_GHOST_MAX_ENTRIES];
-    meta_struct_to_arrays(&meta, offsets, lengths);
-    meta.count = count_valid_entries(offsets, lengths);
-    
-    /* Use multi-updater */
-    return tacozip_update_ghost_multi(zip_path, offsets, lengths, TACO_GHOST_MAX_ENTRIES);
+    return update_leading_slots(zip_path, &new_offset, &new_length, 1);
 }
\ No newline at end of file
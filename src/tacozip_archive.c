@@ -0,0 +1,610 @@
+/*
+ * tacozip_archive.c — native parsing of the archive structure.
+ *
+ * Locates the end-of-central-directory records, walks central-directory
+ * records and finds the ghost at byte 0 using plain positioned reads, so
+ * ghost reads and in-place ghost updates do not need libzip (which would
+ * rewrite the whole archive to change 116 bytes). Also builds the records
+ * written when an archive is rewritten natively.
+ */
+
+/* Platform-specific feature detection */
+#if defined(__linux__) || defined(__gnu_linux__)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64  /* large-file I/O on POSIX */
+#endif
+
+#include "tacozip_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Holds the largest possible record (46 + 3 * 65535 bytes) with room to spare. */
+#define TACOZ_CD_SCAN_BUF (256u << 10)
+
+/* Longest tail that can hold the EOCD: the record plus a maximal comment. */
+#define TACOZ_TAIL_MAX    (TACOZ_EOCD_SIZE + 0xFFFFu)
+
+/* --------------------------------- Tail ------------------------------------ */
+
+int tacoz_read_tail(int fd, tacoz_tail_t *t) {
+    tacoz_filestat_t st;
+    if (tacoz_fstat(fd, &st) != TACOZ_OK) return TACOZ_ERR_IO;
+    return tacoz_read_tail_at(fd, st.size, t);
+}
+
+int tacoz_read_tail_at(int fd, uint64_t end, tacoz_tail_t *t) {
+    if (end < TACOZ_EOCD_SIZE) return TACOZ_ERR_INVALID_GHOST;
+
+    size_t n = end < TACOZ_TAIL_MAX ? (size_t)end : TACOZ_TAIL_MAX;
+    uint64_t base = end - n;
+    unsigned char *buf = malloc(n);
+    if (!buf) return TACOZ_ERR_IO;
+    if (tacoz_pread_all(fd, buf, n, base) != TACOZ_OK) {
+        free(buf);
+        return TACOZ_ERR_IO;
+    }
+
+    /* Scan backwards; our archives have no comment so the first hit is at the end. */
+    size_t at = n - TACOZ_EOCD_SIZE + 1;
+    int found = 0;
+    while (at-- > 0) {
+        if (le32_read(buf + at) == TACOZ_SIG_EOCD &&
+            at + TACOZ_EOCD_SIZE + le16_read(buf + at + 20) == n) {
+            found = 1;
+            break;
+        }
+    }
+    if (!found) {
+        free(buf);
+        return TACOZ_ERR_INVALID_GHOST;
+    }
+
+    const unsigned char *e = buf + at;
+    t->eocd_off = base + at;
+    t->entries  = le16_read(e + 10);
+    t->cd_size  = le32_read(e + 12);
+    t->cd_off   = le32_read(e + 16);
+    t->zip64    = 0;
+
+    /* A ZIP64 locator directly before the EOCD points at the ZIP64 record. */
+    unsigned char loc[TACOZ_EOCD64_LOC_SIZE];
+    int rc = TACOZ_OK;
+    if (t->eocd_off >= TACOZ_EOCD64_LOC_SIZE &&
+        tacoz_pread_all(fd, loc, sizeof(loc), t->eocd_off - TACOZ_EOCD64_LOC_SIZE) == TACOZ_OK &&
+        le32_read(loc) == TACOZ_SIG_EOCD64_LOC) {
+        unsigned char r[TACOZ_EOCD64_SIZE];
+        uint64_t off = le64_read(loc + 8);
+        if (tacoz_pread_all(fd, r, sizeof(r), off) != TACOZ_OK ||
+            le32_read(r) != TACOZ_SIG_EOCD64) {
+            rc = TACOZ_ERR_INVALID_GHOST;
+        } else {
+            t->zip64      = 1;
+            t->eocd64_off = off;
+            t->entries    = le64_read(r + 32);
+            t->cd_size    = le64_read(r + 40);
+            t->cd_off     = le64_read(r + 48);
+        }
+    }
+    free(buf);
+    if (rc == TACOZ_OK && t->cd_off + t->cd_size > end) rc = TACOZ_ERR_INVALID_GHOST;
+    return rc;
+}
+
+/* ------------------------------ Directory log ------------------------------ */
+
+int tacoz_log_record(int fd, const tacoz_tail_t *t, tacoz_log_rec_t *rec) {
+    unsigned char e[TACOZ_EOCD_SIZE + TACOZ_LOG_REC_SIZE];
+    if (tacoz_pread_all(fd, e, TACOZ_EOCD_SIZE, t->eocd_off) != TACOZ_OK) return TACOZ_ERR_IO;
+    if (le16_read(e + 20) != TACOZ_LOG_REC_SIZE) return 0;
+    if (tacoz_pread_all(fd, e + TACOZ_EOCD_SIZE, TACOZ_LOG_REC_SIZE,
+                        t->eocd_off + TACOZ_EOCD_SIZE) != TACOZ_OK)
+        return TACOZ_ERR_IO;
+
+    const unsigned char *p = e + TACOZ_EOCD_SIZE;
+    if (memcmp(p, TACOZ_LOG_MAGIC, 4) != 0) return 0;
+    rec->generation = le64_read(p + 4);
+    rec->prev_end   = le64_read(p + 12);
+    rec->prev_gen   = le64_read(p + 20);
+    return 1;
+}
+
+void tacoz_log_record_build(unsigned char *p, const tacoz_log_rec_t *rec) {
+    memcpy(p, TACOZ_LOG_MAGIC, 4);
+    le64(p +  4, rec->generation);
+    le64(p + 12, rec->prev_end);
+    le64(p + 20, rec->prev_gen);
+}
+
+int tacoz_log_head(int fd, const taco_ghost_t *g, tacoz_tail_t *t, uint64_t *end) {
+    /* The ghost names the last published directory, whose tail follows it;
+     * the file end may hold a commit still being written (or a torn one). */
+    unsigned char r[TACOZ_TAIL_SIZE];
+    if (g && g->version == 2 && g->cd_size &&
+        tacoz_pread_all(fd, r, sizeof(r), g->cd_offset + g->cd_size) == TACOZ_OK) {
+        const unsigned char *loc = r + TACOZ_EOCD64_SIZE, *e = loc + TACOZ_EOCD64_LOC_SIZE;
+        if (le32_read(r) == TACOZ_SIG_EOCD64 && le32_read(loc) == TACOZ_SIG_EOCD64_LOC &&
+            le32_read(e) == TACOZ_SIG_EOCD && le64_read(r + 48) == g->cd_offset &&
+            le64_read(r + 40) == g->cd_size) {
+            t->cd_off     = g->cd_offset;
+            t->cd_size    = g->cd_size;
+            t->entries    = le64_read(r + 32);
+            t->eocd64_off = g->cd_offset + g->cd_size;
+            t->eocd_off   = t->eocd64_off + TACOZ_EOCD64_SIZE + TACOZ_EOCD64_LOC_SIZE;
+            t->zip64      = 1;
+            *end = t->eocd_off + TACOZ_EOCD_SIZE + le16_read(e + 20);
+            return TACOZ_OK;
+        }
+    }
+
+    tacoz_filestat_t st;
+    if (tacoz_fstat(fd, &st) != TACOZ_OK) return TACOZ_ERR_IO;
+    *end = st.size;
+    return tacoz_read_tail_at(fd, st.size, t);
+}
+
+int tacoz_log_walk(int fd, const taco_ghost_t *g, tacozip_log_fn fn, void *user) {
+    tacoz_tail_t t;
+    uint64_t end;
+    int rc = tacoz_log_head(fd, g, &t, &end);
+    uint64_t gen = g && g->version == 2 ? g->generation : 0;
+
+    while (rc == TACOZ_OK) {
+        tacoz_log_rec_t rec;
+        int has = tacoz_log_record(fd, &t, &rec);
+        if (has < 0) return has;
+
+        tacozip_log_version_t v;
+        v.generation = has ? rec.generation : gen;
+        v.cd_offset  = t.cd_off;
+        v.cd_size    = t.cd_size;
+        v.cd_entries = t.entries;
+        v.end        = end;
+        int r = fn(user, &v);
+        if (r != 0) return r < 0 ? r : TACOZ_OK;
+
+        /* A directory before the first commit ends the chain, and so does
+         * one that a non-log edit has since overwritten. */
+        if (!has || rec.prev_end == 0 || rec.prev_end > t.cd_off) break;
+        gen = rec.prev_gen;
+        end = rec.prev_end;
+        rc = tacoz_read_tail_at(fd, end, &t);
+        if (rc == TACOZ_ERR_INVALID_GHOST) return TACOZ_OK;
+    }
+    return rc;
+}
+
+/* ---------------------------- Central directory ---------------------------- */
+
+/** Resolve 0xFFFFFFFF placeholders from the ZIP64 extra field (in order). */
+static void cdh_zip64(const unsigned char *x, size_t xlen, tacoz_cdh_t *c,
+                      int need_usize, int need_csize, int need_off) {
+    while (xlen >= 4) {
+        uint16_t id = le16_read(x), len = le16_read(x + 2);
+        if ((size_t)len + 4 > xlen) return;
+        if (id == TACOZ_ZIP64_EXTRA_ID) {
+            const unsigned char *p = x + 4, *end = x + 4 + len;
+            if (need_usize && p + 8 <= end) { c->usize   = le64_read(p); p += 8; }
+            if (need_csize && p + 8 <= end) { c->csize   = le64_read(p); p += 8; }
+            if (need_off   && p + 8 <= end) { c->lfh_off = le64_read(p); }
+            return;
+        }
+        x += 4 + len;
+        xlen -= 4 + (size_t)len;
+    }
+}
+
+int64_t tacoz_cdh_parse(const unsigned char *p, size_t avail, uint64_t off, tacoz_cdh_t *c) {
+    if (avail < TACOZ_CDH_SIZE) return 0;
+    if (le32_read(p) != TACOZ_SIG_CDH) return TACOZ_ERR_INVALID_GHOST;
+    uint16_t nlen = le16_read(p + 28), xlen = le16_read(p + 30), clen = le16_read(p + 32);
+    size_t rec = TACOZ_CDH_SIZE + (size_t)nlen + xlen + clen;
+    if (avail < rec) return 0;
+
+    c->cdh_off  = off;
+    c->rec_len  = (uint32_t)rec;
+    c->flags    = le16_read(p + 8);
+    c->method   = le16_read(p + 10);
+    c->dostime  = le32_read(p + 12);
+    c->crc      = le32_read(p + 16);
+    c->csize    = le32_read(p + 20);
+    c->usize    = le32_read(p + 24);
+    c->ext_attr = le32_read(p + 38);
+    c->lfh_off  = le32_read(p + 42);
+    c->name_len = nlen;
+    c->name     = (const char *)(p + TACOZ_CDH_SIZE);
+    c->raw      = p;
+    cdh_zip64(p + TACOZ_CDH_SIZE + nlen, xlen, c,
+              c->usize == 0xFFFFFFFFu, c->csize == 0xFFFFFFFFu, c->lfh_off == 0xFFFFFFFFu);
+    return (int64_t)rec;
+}
+
+int tacoz_cd_scan(int fd, const tacoz_tail_t *t, tacoz_cdh_visit_fn fn, void *ctx) {
+    unsigned char *buf = malloc(TACOZ_CD_SCAN_BUF);
+    if (!buf) return TACOZ_ERR_IO;
+
+    uint64_t pos = t->cd_off;             /* file offset of buf[0] */
+    uint64_t end = t->cd_off + t->cd_size;
+    size_t have = 0, at = 0;
+    int rc = TACOZ_OK;
+    while (pos + at < end) {
+        tacoz_cdh_t c;
+        int64_t r = tacoz_cdh_parse(buf + at, have - at, pos + at, &c);
+        if (r < 0) { rc = (int)r; break; }
+        if (r == 0) {
+            /* Refill, keeping the partial record at the front of the buffer. */
+            memmove(buf, buf + at, have - at);
+            pos += at;
+            have -= at;
+            at = 0;
+            uint64_t left = end - pos - have;
+            if (left == 0) { rc = TACOZ_ERR_INVALID_GHOST; break; }
+            size_t n = TACOZ_CD_SCAN_BUF - have;
+            if ((uint64_t)n > left) n = (size_t)left;
+            if (tacoz_pread_all(fd, buf + have, n, pos + have) != TACOZ_OK) { rc = TACOZ_ERR_IO; break; }
+            have += n;
+            continue;
+        }
+        at += (size_t)r;
+        int v = fn(ctx, &c);
+        if (v != 0) {
+            if (v < 0) rc = v;
+            break;
+        }
+    }
+    free(buf);
+    return rc;
+}
+
+/* ----------------------------- Emitting records ---------------------------- */
+
+size_t tacoz_cdh_rebuild(const tacoz_cdh_t *c, uint64_t lfh_off, unsigned char *out) {
+    const unsigned char *p = c->raw;
+    uint16_t xlen = le16_read(p + 30), clen = le16_read(p + 32);
+    const unsigned char *x = p + TACOZ_CDH_SIZE + c->name_len;
+
+    memcpy(out, p, TACOZ_CDH_SIZE + c->name_len);
+    if (le16_read(out + 6) < TACOZ_VERSION_ZIP64) le16(out + 6, TACOZ_VERSION_ZIP64);
+    le32(out + 16, c->crc);
+    le32(out + 20, 0xFFFFFFFFu);
+    le32(out + 24, 0xFFFFFFFFu);
+    le16(out + 34, 0);                    /* disk number start */
+    le32(out + 42, 0xFFFFFFFFu);
+
+    unsigned char *o = out + TACOZ_CDH_SIZE + c->name_len;
+    le16(o +  0, TACOZ_ZIP64_EXTRA_ID);
+    le16(o +  2, 24);
+    le64(o +  4, c->usize);
+    le64(o + 12, c->csize);
+    le64(o + 20, lfh_off);
+    o += TACOZ_CDH_EXTRA_SIZE;
+
+    /* Keep every other extra field as is. */
+    while (xlen >= 4) {
+        uint16_t id = le16_read(x), len = le16_read(x + 2);
+        if ((size_t)len + 4 > xlen) break;
+        if (id != TACOZ_ZIP64_EXTRA_ID) {
+            memcpy(o, x, (size_t)len + 4);
+            o += (size_t)len + 4;
+        }
+        x += 4 + len;
+        xlen -= (uint16_t)(4 + len);
+    }
+    size_t new_xlen = (size_t)(o - (out + TACOZ_CDH_SIZE + c->name_len));
+    if (new_xlen > 0xFFFFu) return 0;
+    le16(out + 30, (uint16_t)new_xlen);
+
+    memcpy(o, p + TACOZ_CDH_SIZE + c->name_len + le16_read(p + 30), clen);
+    return (size_t)(o + clen - out);
+}
+
+void tacoz_cdh_build(const tacoz_cd_entry_t *e, unsigned char *p) {
+    le32(p +  0, TACOZ_SIG_CDH);
+    le16(p +  4, TACOZ_MADE_BY_UNIX);
+    le16(p +  6, TACOZ_VERSION_ZIP64);
+    le16(p +  8, TACOZ_SET_UTF8_FLAG ? TACOZ_GPBIT_UTF8 : 0);
+    le16(p + 10, 0);                      /* method: STORE */
+    le32(p + 12, e->dostime);             /* DOS time, DOS date */
+    le32(p + 16, e->crc);
+    le32(p + 20, 0xFFFFFFFFu);
+    le32(p + 24, 0xFFFFFFFFu);
+    le16(p + 28, e->name_len);
+    le16(p + 30, TACOZ_CDH_EXTRA_SIZE);
+    le16(p + 32, 0);                      /* comment length */
+    le16(p + 34, 0);                      /* disk number start */
+    le16(p + 36, 0);                      /* internal attributes */
+    le32(p + 38, e->mode << 16);          /* external attributes (UNIX mode) */
+    le32(p + 42, 0xFFFFFFFFu);            /* LFH offset lives in the ZIP64 extra */
+    memcpy(p + TACOZ_CDH_SIZE, e->name, e->name_len);
+
+    unsigned char *x = p + TACOZ_CDH_SIZE + e->name_len;
+    le16(x +  0, TACOZ_ZIP64_EXTRA_ID);
+    le16(x +  2, 24);
+    le64(x +  4, e->size);
+    le64(x + 12, e->size);
+    le64(x + 20, e->lfh_off);
+}
+
+void tacoz_lfh_build(unsigned char *p, const char *name, uint16_t name_len, uint32_t dostime,
+                     uint64_t size) {
+    le32(p +  0, TACOZ_SIG_LFH);
+    le16(p +  4, TACOZ_VERSION_ZIP64);
+    le16(p +  6, TACOZ_SET_UTF8_FLAG ? TACOZ_GPBIT_UTF8 : 0);
+    le16(p +  8, 0);                      /* method: STORE */
+    le32(p + 10, dostime);
+    le32(p + 14, 0);
+    le32(p + 18, 0xFFFFFFFFu);
+    le32(p + 22, 0xFFFFFFFFu);
+    le16(p + 26, name_len);
+    le16(p + 28, TACOZ_LFH_EXTRA_SIZE);
+    memcpy(p + TACOZ_LFH_SIZE, name, name_len);
+
+    unsigned char *x = p + TACOZ_LFH_SIZE + name_len;
+    le16(x + 0, TACOZ_ZIP64_EXTRA_ID);
+    le16(x + 2, 16);
+    le64(x + 4, size);
+    le64(x + 12, size);
+}
+
+void tacoz_ghost_lfh_build(unsigned char *p, uint32_t dostime, uint64_t size) {
+    tacoz_lfh_build(p, TACO_GHOST_NAME, TACO_GHOST_NAME_LEN, dostime, size);
+}
+
+uint32_t tacoz_dostime(int64_t t) {
+    time_t tt = (time_t)t;
+    struct tm tmv;
+#ifdef _WIN32
+    int ok = localtime_s(&tmv, &tt) == 0;
+#else
+    int ok = localtime_r(&tt, &tmv) != NULL;
+#endif
+    if (!ok || tmv.tm_year < 80) return TACOZ_DOS_EPOCH;
+    uint32_t dtime = (uint32_t)((tmv.tm_hour << 11) | (tmv.tm_min << 5) | (tmv.tm_sec / 2));
+    uint32_t ddate = (uint32_t)(((tmv.tm_year - 80) << 9) | ((tmv.tm_mon + 1) << 5) | tmv.tm_mday);
+    return dtime | ddate << 16;
+}
+
+void tacoz_tail_build(unsigned char *p, uint64_t entries, uint64_t cd_size,
+                      uint64_t cd_off, uint64_t eocd64_off) {
+    le32(p +  0, TACOZ_SIG_EOCD64);
+    le64(p +  4, TACOZ_EOCD64_SIZE - 12);
+    le16(p + 12, TACOZ_MADE_BY_UNIX);
+    le16(p + 14, TACOZ_VERSION_ZIP64);
+    le32(p + 16, 0);                      /* this disk */
+    le32(p + 20, 0);                      /* disk with CD */
+    le64(p + 24, entries);
+    le64(p + 32, entries);
+    le64(p + 40, cd_size);
+    le64(p + 48, cd_off);
+
+    p += TACOZ_EOCD64_SIZE;
+    le32(p +  0, TACOZ_SIG_EOCD64_LOC);
+    le32(p +  4, 0);
+    le64(p +  8, eocd64_off);
+    le32(p + 16, 1);                      /* total disks */
+
+    p += TACOZ_EOCD64_LOC_SIZE;
+    le32(p +  0, TACOZ_SIG_EOCD);
+    le16(p +  4, 0);
+    le16(p +  6, 0);
+    le16(p +  8, 0xFFFFu);
+    le16(p + 10, 0xFFFFu);
+    le32(p + 12, 0xFFFFFFFFu);
+    le32(p + 16, 0xFFFFFFFFu);
+    le16(p + 20, 0);                      /* comment length */
+}
+
+/* ---------------------------------- Ghost ---------------------------------- */
+
+int tacoz_ghost_lfh_parse(const unsigned char *p, size_t len, tacoz_ghost_loc_t *loc,
+                          size_t *need) {
+    *need = TACOZ_LFH_SIZE;
+    if (len < TACOZ_LFH_SIZE) return TACOZ_ERR_PARAM;
+    if (le32_read(p) != TACOZ_SIG_LFH) return TACOZ_ERR_INVALID_GHOST;
+
+    uint16_t flags = le16_read(p + 6), method = le16_read(p + 8);
+    uint16_t nlen = le16_read(p + 26), xlen = le16_read(p + 28);
+    *need = TACOZ_LFH_SIZE + (size_t)nlen + xlen;
+    if (len < *need) return TACOZ_ERR_PARAM;
+
+    /* STORE, sizes in the header (no data descriptor), named TACO_GHOST. */
+    if (method != 0 || (flags & 0x0008u) || nlen != TACO_GHOST_NAME_LEN ||
+        memcmp(p + TACOZ_LFH_SIZE, TACO_GHOST_NAME, TACO_GHOST_NAME_LEN) != 0)
+        return TACOZ_ERR_INVALID_GHOST;
+
+    tacoz_cdh_t c;
+    memset(&c, 0, sizeof(c));
+    c.usize = le32_read(p + 22);
+    c.csize = le32_read(p + 18);
+    cdh_zip64(p + TACOZ_LFH_SIZE + nlen, xlen, &c,
+              c.usize == 0xFFFFFFFFu, c.csize == 0xFFFFFFFFu, 0);
+    if (c.usize != c.csize || c.usize == 0xFFFFFFFFu) return TACOZ_ERR_INVALID_GHOST;
+
+    loc->data_off = *need;
+    loc->size = c.usize;
+    loc->crc = le32_read(p + 14);
+    return TACOZ_OK;
+}
+
+int tacoz_ghost_locate(int fd, tacoz_ghost_loc_t *loc) {
+    unsigned char fixed[TACOZ_LFH_SIZE];
+    if (tacoz_pread_all(fd, fixed, sizeof(fixed), 0) != TACOZ_OK) return TACOZ_ERR_INVALID_GHOST;
+    if (le32_read(fixed) != TACOZ_SIG_LFH) return TACOZ_ERR_INVALID_GHOST;
+
+    size_t need = TACOZ_LFH_SIZE + (size_t)le16_read(fixed + 26) + le16_read(fixed + 28);
+    unsigned char *head = malloc(need);
+    if (!head) return TACOZ_ERR_IO;
+    int rc = tacoz_pread_all(fd, head, need, 0) == TACOZ_OK
+           ? tacoz_ghost_lfh_parse(head, need, loc, &need) : TACOZ_ERR_INVALID_GHOST;
+    free(head);
+    return rc;
+}
+
+/** One attempt at the payload; TACOZ_ERR_BUSY if it overlapped an update. */
+static int read_payload_once(int fd, const tacoz_ghost_loc_t *loc, taco_ghost_t *out) {
+    /* The sequence is read on its own first: the copy below may take its
+     * leading bytes from the payload before an update and its sequence from
+     * the one after, so the copy's sequence alone cannot vouch for it. */
+    unsigned char pre[TACOZ_GHOST_SEQ_OFF_V2 + 2];
+    int sequenced = loc->size >= sizeof(pre);
+    size_t at = 0;
+    if (sequenced) {
+        int rc = tacoz_pread_all(fd, pre, sizeof(pre), loc->data_off);
+        if (rc != TACOZ_OK) return rc;
+        at = TACOZ_GHOST_SEQ_OFF(pre);
+        if (le16_read(pre + at) & 1u) return TACOZ_ERR_BUSY;
+    }
+
+    /* One read covers any v2 slot table and inline region; only slack beyond
+     * them is skipped. */
+    const size_t max = TACO_GHOST_V2_SIZE(TACO_GHOST_V2_MAX_SLOTS) + TACO_GHOST_INLINE_MAX;
+    size_t n = loc->size < max ? (size_t)loc->size : max;
+    unsigned char *buf = malloc(n ? n : 1);
+    if (!buf) return TACOZ_ERR_IO;
+
+    int rc = tacoz_pread_all(fd, buf, n, loc->data_off);
+    if (rc == TACOZ_OK) {
+        size_t need = tacoz_ghost_need(buf, n);
+        if (need > loc->size) rc = TACOZ_ERR_INVALID_GHOST;
+        else if (need > n) {
+            unsigned char *more = realloc(buf, need);
+            if (!more) rc = TACOZ_ERR_IO;
+            else {
+                buf = more;
+                rc = tacoz_pread_all(fd, buf + n, need - n, loc->data_off + n);
+                n = need;
+            }
+        }
+    }
+
+    /* The copy is whole if the even sequence read before it is the one it
+     * holds and still the file's after it was taken. */
+    if (rc == TACOZ_OK && sequenced) {
+        unsigned char post[2];
+        if (TACOZ_GHOST_SEQ_OFF(buf) != at || memcmp(pre + at, buf + at, 2) != 0)
+            rc = TACOZ_ERR_BUSY;
+        else rc = tacoz_pread_all(fd, post, sizeof(post), loc->data_off + at);
+        if (rc == TACOZ_OK && memcmp(post, pre + at, sizeof(post)) != 0) rc = TACOZ_ERR_BUSY;
+    }
+    if (rc == TACOZ_OK) rc = tacoz_ghost_decode(buf, n, out);
+    free(buf);
+    return rc;
+}
+
+int tacoz_ghost_read(int fd, const tacoz_ghost_loc_t *loc, taco_ghost_t *out) {
+    int rc = read_payload_once(fd, loc, out);
+    for (unsigned i = 0; rc == TACOZ_ERR_BUSY && i < TACOZ_GHOST_READ_RETRIES; i++) {
+        tacoz_backoff(i);
+        rc = read_payload_once(fd, loc, out);
+    }
+    return rc;
+}
+
+static int find_ghost_cdh(void *ctx, const tacoz_cdh_t *c) {
+    uint64_t *out = (uint64_t *)ctx;
+    if (c->lfh_off == 0 && c->name_len == TACO_GHOST_NAME_LEN &&
+        memcmp(c->name, TACO_GHOST_NAME, TACO_GHOST_NAME_LEN) == 0) {
+        *out = c->cdh_off;
+        return 1;
+    }
+    return 0;
+}
+
+int tacoz_ghost_find_cdh(int fd, const tacoz_tail_t *t, uint64_t *cdh_off) {
+    *cdh_off = UINT64_MAX;
+    int rc = tacoz_cd_scan(fd, t, find_ghost_cdh, cdh_off);
+    if (rc != TACOZ_OK) return rc;
+    return *cdh_off == UINT64_MAX ? TACOZ_ERR_INVALID_GHOST : TACOZ_OK;
+}
+
+int tacoz_slot_is_table(int fd, const taco_meta_entry_t *slot, int *is_table) {
+    unsigned char magic[4];
+    *is_table = 0;
+    if (slot->length < sizeof(magic)) return TACOZ_OK;
+    int rc = tacoz_pread_all(fd, magic, sizeof(magic), slot->offset);
+    if (rc == TACOZ_OK && memcmp(magic, TACO_NAME_INDEX_MAGIC, 4) == 0)
+        *is_table = TACOZ_TABLE_NAMES;
+    else if (rc == TACOZ_OK && memcmp(magic, TACO_ID_TABLE_MAGIC, 4) == 0)
+        *is_table = TACOZ_TABLE_IDS;
+    return rc;
+}
+
+int tacoz_table_scan(int fd, const taco_meta_entry_t *slot, tacoz_table_visit_fn fn, void *ctx) {
+    tacoz_view_t v;
+    int rc = tacoz_view_open(fd, slot->offset, slot->length, &v);
+    if (rc != TACOZ_OK) return rc;
+
+    /* Layouts as documented in tacozip.h; both store back distances. */
+    const unsigned char *p = v.data;
+    uint64_t first = 0, count = 0, stride = 0, back_at = 0;
+    if (v.len >= TACO_NAME_INDEX_HEADER_SIZE && memcmp(p, TACO_NAME_INDEX_MAGIC, 4) == 0 &&
+        le64_read(p + 32) <= UINT32_MAX) {
+        first   = le16_read(p + 6) + ((2 * le64_read(p + 32) + 7) & ~7ull);
+        count   = le64_read(p + 24);
+        stride  = 32;
+        back_at = 8;
+    } else if (v.len >= TACO_ID_TABLE_HEADER_SIZE && memcmp(p, TACO_ID_TABLE_MAGIC, 4) == 0) {
+        first   = le16_read(p + 6);
+        count   = le64_read(p + 16);
+        stride  = le32_read(p + 8);
+    } else {
+        rc = TACOZ_ERR_INVALID_GHOST;
+    }
+    if (rc == TACOZ_OK && (stride < back_at + 8 || first > v.len || count > (v.len - first) / stride))
+        rc = TACOZ_ERR_INVALID_GHOST;
+
+    for (uint64_t i = 0; rc == TACOZ_OK && i < count; i++) {
+        uint64_t back = le64_read(p + first + i * stride + back_at);
+        if (back == 0) continue;  /* empty name-index slot */
+        if (back > slot->offset) {
+            rc = TACOZ_ERR_INVALID_GHOST;
+            break;
+        }
+        int r = fn(ctx, slot->offset - back);
+        if (r < 0) rc = r;
+        if (r != 0) break;
+    }
+    tacoz_view_close(&v);
+    return rc;
+}
+
+int tacoz_ghost_slot_crcs(int fd, taco_ghost_t *g) {
+    if (!(g->flags & TACO_GHOST_F_SLOT_CRC)) return TACOZ_OK;
+
+    tacoz_filestat_t st;
+    if (tacoz_fstat(fd, &st) != TACOZ_OK) return TACOZ_ERR_IO;
+
+    unsigned char *buf = NULL;
+    int rc = TACOZ_OK;
+    for (size_t i = 0; rc == TACOZ_OK && i < g->count; i++) {
+        const taco_meta_entry_t *slot = &g->slots[i];
+        if (g->inline_len[i]) {
+            g->slot_crc[i] = tacoz_crc32(0, g->inline_data + g->inline_off[i], g->inline_len[i]);
+            continue;
+        }
+        if (slot->offset > st.size || slot->length > st.size - slot->offset) {
+            rc = TACOZ_ERR_PARAM;  /* slot points outside the archive */
+            break;
+        }
+        if (!buf && slot->length && !(buf = malloc(TACOZ_CD_SCAN_BUF))) {
+            rc = TACOZ_ERR_IO;
+            break;
+        }
+        uint32_t crc = 0;
+        for (uint64_t at = 0; rc == TACOZ_OK && at < slot->length; ) {
+            size_t n = slot->length - at < TACOZ_CD_SCAN_BUF ? (size_t)(slot->length - at)
+                                                           : TACOZ_CD_SCAN_BUF;
+            rc = tacoz_pread_all(fd, buf, n, slot->offset + at);
+            crc = tacoz_crc32(crc, buf, n);
+            at += n;
+        }
+        g->slot_crc[i] = crc;
+    }
+    free(buf);
+    return rc;
+}
@@ -0,0 +1,326 @@
+/*
+ * tacozip_cdstore.c — compact central-directory store for the native writer.
+ *
+ * Entries are kept struct-of-arrays in fixed-capacity chunks: fixed-width
+ * columns (LFH offset, size, CRC, mode, DOS time, name length) plus one name
+ * arena per chunk, about 30 bytes + the name per entry. Once resident chunks
+ * exceed the memory cap, full chunks are spilled to an anonymous scratch file
+ * beside the archive and streamed back one at a time when the central
+ * directory is serialized, so peak memory is the cap plus one chunk.
+ */
+
+#include "tacozip_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CHUNK_ENTRIES   16384u
+#define CHUNK_FIXED     (CHUNK_ENTRIES * (8u + 8u + 4u + 4u + 4u + 2u))
+#define NAMES_INITIAL   (256u * 1024u)
+
+typedef struct {
+    uint32_t  n;
+    uint64_t *lfh_off;
+    uint64_t *size;
+    uint32_t *crc;
+    uint32_t *mode;
+    uint32_t *dostime;
+    uint16_t *name_len;
+    char     *names;          /* name bytes back to back, insertion order */
+    size_t    names_len;
+    size_t    names_cap;
+    int       spilled;
+    uint64_t  spill_off;      /* position of the chunk in the scratch file */
+} cd_chunk_t;
+
+struct tacoz_cdstore {
+    cd_chunk_t *chunks;
+    size_t      nchunks;
+    size_t      chunks_cap;
+
+    uint64_t    count;
+    uint64_t    cd_size;      /* serialized central-directory bytes */
+
+    size_t      mem_cap;      /* 0 = never spill */
+    size_t      resident;     /* bytes held by resident chunks */
+    char       *spill_near;   /* scratch file is created beside this path */
+    int         spill_fd;
+    uint64_t    spill_end;
+
+    cd_chunk_t  scratch;      /* reload buffer for spilled chunks */
+    size_t      scratch_names_cap;
+};
+
+/* ------------------------------ Chunk memory ------------------------------- */
+
+static int chunk_alloc_fixed(cd_chunk_t *c) {
+    unsigned char *p = malloc(CHUNK_FIXED);
+    if (!p) return TACOZ_ERR_IO;
+    c->lfh_off  = (uint64_t *)(void *)p;  p += CHUNK_ENTRIES * 8u;
+    c->size     = (uint64_t *)(void *)p;  p += CHUNK_ENTRIES * 8u;
+    c->crc      = (uint32_t *)(void *)p;  p += CHUNK_ENTRIES * 4u;
+    c->mode     = (uint32_t *)(void *)p;  p += CHUNK_ENTRIES * 4u;
+    c->dostime  = (uint32_t *)(void *)p;  p += CHUNK_ENTRIES * 4u;
+    c->name_len = (uint16_t *)(void *)p;
+    return TACOZ_OK;
+}
+
+static void chunk_release(cd_chunk_t *c) {
+    free(c->lfh_off);   /* start of the fixed block */
+    free(c->names);
+    c->lfh_off = NULL;
+    c->names = NULL;
+}
+
+static size_t chunk_footprint(const cd_chunk_t *c) {
+    return CHUNK_FIXED + c->names_cap;
+}
+
+/* --------------------------------- Spilling -------------------------------- */
+
+static int spill_chunk(tacoz_cdstore_t *s, cd_chunk_t *c) {
+    if (s->spill_fd < 0) {
+        s->spill_fd = tacoz_open_scratch(s->spill_near);
+        if (s->spill_fd < 0) return TACOZ_ERR_IO;
+    }
+
+    const size_t n = c->n;
+    const struct { const void *p; size_t len; } cols[] = {
+        { c->lfh_off,  n * 8u },
+        { c->size,     n * 8u },
+        { c->crc,      n * 4u },
+        { c->mode,     n * 4u },
+        { c->dostime,  n * 4u },
+        { c->name_len, n * 2u },
+        { c->names,    c->names_len },
+    };
+
+    uint64_t off = s->spill_end;
+    for (size_t i = 0; i < sizeof(cols) / sizeof(cols[0]); i++) {
+        if (cols[i].len == 0) continue;
+        int rc = tacoz_pwrite_all(s->spill_fd, cols[i].p, cols[i].len, off);
+        if (rc != TACOZ_OK) return rc;
+        off += cols[i].len;
+    }
+
+    s->resident -= chunk_footprint(c);
+    c->spill_off = s->spill_end;
+    c->spilled = 1;
+    s->spill_end = off;
+    chunk_release(c);
+    return TACOZ_OK;
+}
+
+/** Load a spilled chunk into the shared scratch chunk. */
+static int reload_chunk(tacoz_cdstore_t *s, const cd_chunk_t *c, const cd_chunk_t **out) {
+    cd_chunk_t *r = &s->scratch;
+    if (!r->lfh_off && chunk_alloc_fixed(r) != TACOZ_OK) return TACOZ_ERR_IO;
+    if (s->scratch_names_cap < c->names_len) {
+        char *p = realloc(r->names, c->names_len);
+        if (!p) return TACOZ_ERR_IO;
+        r->names = p;
+        s->scratch_names_cap = c->names_len;
+    }
+
+    const size_t n = c->n;
+    const struct { void *p; size_t len; } cols[] = {
+        { r->lfh_off,  n * 8u },
+        { r->size,     n * 8u },
+        { r->crc,      n * 4u },
+        { r->mode,     n * 4u },
+        { r->dostime,  n * 4u },
+        { r->name_len, n * 2u },
+        { r->names,    c->names_len },
+    };
+
+    uint64_t off = c->spill_off;
+    for (size_t i = 0; i < sizeof(cols) / sizeof(cols[0]); i++) {
+        if (cols[i].len == 0) continue;
+        int rc = tacoz_pread_all(s->spill_fd, cols[i].p, cols[i].len, off);
+        if (rc != TACOZ_OK) return rc;
+        off += cols[i].len;
+    }
+
+    r->n = c->n;
+    r->names_len = c->names_len;
+    *out = r;
+    return TACOZ_OK;
+}
+
+/* ------------------------------- Public (lib) ------------------------------ */
+
+int tacoz_cdstore_create(size_t mem_cap, const char *spill_near, tacoz_cdstore_t **out) {
+    tacoz_cdstore_t *s = calloc(1, sizeof(*s));
+    if (!s) return TACOZ_ERR_IO;
+    s->spill_near = malloc(strlen(spill_near) + 1);
+    if (!s->spill_near) {
+        free(s);
+        return TACOZ_ERR_IO;
+    }
+    strcpy(s->spill_near, spill_near);
+    s->mem_cap = mem_cap;
+    s->spill_fd = -1;
+    *out = s;
+    return TACOZ_OK;
+}
+
+static int start_chunk(tacoz_cdstore_t *s) {
+    /* Over budget: push every full resident chunk out before growing again. */
+    if (s->mem_cap && s->resident + CHUNK_FIXED + NAMES_INITIAL > s->mem_cap) {
+        for (size_t i = 0; i < s->nchunks; i++) {
+            if (s->chunks[i].spilled) continue;
+            int rc = spill_chunk(s, &s->chunks[i]);
+            if (rc != TACOZ_OK) return rc;
+        }
+    }
+
+    if (s->nchunks == s->chunks_cap) {
+        size_t cap = s->chunks_cap ? s->chunks_cap * 2 : 64;
+        cd_chunk_t *p = realloc(s->chunks, cap * sizeof(*p));
+        if (!p) return TACOZ_ERR_IO;
+        s->chunks = p;
+        s->chunks_cap = cap;
+    }
+
+    cd_chunk_t *c = &s->chunks[s->nchunks];
+    memset(c, 0, sizeof(*c));
+    if (chunk_alloc_fixed(c) != TACOZ_OK) return TACOZ_ERR_IO;
+    s->nchunks++;
+    s->resident += CHUNK_FIXED;
+    return TACOZ_OK;
+}
+
+int tacoz_cdstore_push(tacoz_cdstore_t *s, const tacoz_cd_entry_t *e) {
+    cd_chunk_t *c = s->nchunks ? &s->chunks[s->nchunks - 1] : NULL;
+    if (!c || c->n == CHUNK_ENTRIES) {
+        int rc = start_chunk(s);
+        if (rc != TACOZ_OK) return rc;
+        c = &s->chunks[s->nchunks - 1];
+    }
+
+    if (c->names_cap - c->names_len < e->name_len) {
+        size_t cap = c->names_cap ? c->names_cap : NAMES_INITIAL;
+        while (cap - c->names_len < e->name_len) cap *= 2;
+        char *p = realloc(c->names, cap);
+        if (!p) return TACOZ_ERR_IO;
+        s->resident += cap - c->names_cap;
+        c->names = p;
+        c->names_cap = cap;
+    }
+
+    uint32_t i = c->n++;
+    c->lfh_off[i]  = e->lfh_off;
+    c->size[i]     = e->size;
+    c->crc[i]      = e->crc;
+    c->mode[i]     = e->mode;
+    c->dostime[i]  = e->dostime;
+    c->name_len[i] = e->name_len;
+    memcpy(c->names + c->names_len, e->name, e->name_len);
+    c->names_len += e->name_len;
+
+    s->count++;
+    s->cd_size += TACOZ_CDH_SIZE + e->name_len + TACOZ_CDH_EXTRA_SIZE;
+    return TACOZ_OK;
+}
+
+uint64_t tacoz_cdstore_count(const tacoz_cdstore_t *s) {
+    return s->count;
+}
+
+uint64_t tacoz_cdstore_cd_size(const tacoz_cdstore_t *s) {
+    return s->cd_size;
+}
+
+size_t tacoz_cdstore_resident(const tacoz_cdstore_t *s) {
+    return s->resident;
+}
+
+int tacoz_cdstore_foreach(tacoz_cdstore_t *s, tacoz_cd_visit_fn fn, void *ctx) {
+    for (size_t ci = 0; ci < s->nchunks; ci++) {
+        const cd_chunk_t *c = &s->chunks[ci];
+        if (c->spilled) {
+            int rc = reload_chunk(s, c, &c);
+            if (rc != TACOZ_OK) return rc;
+        }
+
+        size_t name_off = 0;
+        for (uint32_t i = 0; i < c->n; i++) {
+            tacoz_cd_entry_t e;
+            e.lfh_off  = c->lfh_off[i];
+            e.size     = c->size[i];
+            e.crc      = c->crc[i];
+            e.mode     = c->mode[i];
+            e.dostime  = c->dostime[i];
+            e.name_len = c->name_len[i];
+            e.name     = c->names + name_off;
+            name_off  += e.name_len;
+
+            int rc = fn(ctx, &e);
+            if (rc != TACOZ_OK) return rc;
+        }
+    }
+    return TACOZ_OK;
+}
+
+typedef struct {
+    const char *name;
+    uint32_t    chunk;
+    uint32_t    index;
+    uint16_t    name_len;
+} name_ref_t;
+
+static int name_ref_cmp(const void *a, const void *b) {
+    const name_ref_t *x = (const name_ref_t *)a, *y = (const name_ref_t *)b;
+    size_t n = x->name_len < y->name_len ? x->name_len : y->name_len;
+    int c = memcmp(x->name, y->name, n);
+    if (c != 0) return c;
+    return (x->name_len > y->name_len) - (x->name_len < y->name_len);
+}
+
+int tacoz_cdstore_foreach_sorted(tacoz_cdstore_t *s, tacoz_cd_visit_fn fn, void *ctx) {
+    if (s->count > SIZE_MAX / sizeof(name_ref_t)) return TACOZ_ERR_IO;
+    for (size_t ci = 0; ci < s->nchunks; ci++)
+        if (s->chunks[ci].spilled) return TACOZ_ERR_PARAM;
+
+    name_ref_t *refs = malloc((size_t)s->count * sizeof(*refs) + 1);
+    if (!refs) return TACOZ_ERR_IO;
+    size_t k = 0;
+    for (size_t ci = 0; ci < s->nchunks; ci++) {
+        const cd_chunk_t *c = &s->chunks[ci];
+        size_t name_off = 0;
+        for (uint32_t i = 0; i < c->n; i++, k++) {
+            refs[k].name = c->names + name_off;
+            refs[k].chunk = (uint32_t)ci;
+            refs[k].index = i;
+            refs[k].name_len = c->name_len[i];
+            name_off += c->name_len[i];
+        }
+    }
+    qsort(refs, k, sizeof(*refs), name_ref_cmp);
+
+    int rc = TACOZ_OK;
+    for (size_t j = 0; j < k && rc == TACOZ_OK; j++) {
+        const cd_chunk_t *c = &s->chunks[refs[j].chunk];
+        uint32_t i = refs[j].index;
+        tacoz_cd_entry_t e;
+        e.lfh_off  = c->lfh_off[i];
+        e.size     = c->size[i];
+        e.crc      = c->crc[i];
+        e.mode     = c->mode[i];
+        e.dostime  = c->dostime[i];
+        e.name_len = refs[j].name_len;
+        e.name     = refs[j].name;
+        rc = fn(ctx, &e);
+    }
+    free(refs);
+    return rc;
+}
+
+void tacoz_cdstore_free(tacoz_cdstore_t *s) {
+    if (!s) return;
+    for (size_t i = 0; i < s->nchunks; i++) chunk_release(&s->chunks[i]);
+    chunk_release(&s->scratch);
+    if (s->spill_fd >= 0) tacoz_close(s->spill_fd);
+    free(s->chunks);
+    free(s->spill_near);
+    free(s);
+}
@@ -0,0 +1,648 @@
+/*
+ * tacozip_dirwalk.c — directory-tree ingestion for tacozip_writer_add_dir().
+ *
+ * POSIX builds walk the tree with a small pool of threads. Every lookup is
+ * relative to an already open directory descriptor (openat/fstatat), so the
+ * kernel never re-resolves full paths. Subdirectories excluded by a pattern
+ * are pruned without being opened. The collected relative paths are sorted
+ * (byte order per path component, '/' before any other byte, which is a
+ * depth-first order) and then opened for the writer through a stack of
+ * directory descriptors that follows the sorted order. Windows builds walk
+ * single-threaded with FindFirstFile and open full paths.
+ */
+
+/* Platform-specific feature detection */
+#if defined(__linux__) || defined(__gnu_linux__)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#elif defined(__APPLE__) || defined(__MACH__)
+#ifndef _DARWIN_C_SOURCE
+#define _DARWIN_C_SOURCE  /* d_type, fdopendir */
+#endif
+#endif
+
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64  /* large-file I/O on POSIX */
+#endif
+
+#include "tacozip_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+#define ARENA_BLOCK   (1u << 20)
+#define MAX_THREADS   64u
+#define QUEUE_FD_CAP  256u   /* queued subdirectories kept open; others reopened */
+
+/* --------------------------------- Patterns -------------------------------- */
+
+/* Match a bracket expression at *pp against c; advances *pp past ']'. */
+static int match_class(const char **pp, char c) {
+    const char *p = *pp + 1;
+    int negate = (*p == '!' || *p == '^');
+    if (negate) p++;
+    int hit = 0;
+    const char *start = p;
+    while (*p && (*p != ']' || p == start)) {
+        if (p[1] == '-' && p[2] && p[2] != ']') {
+            if ((unsigned char)c >= (unsigned char)p[0] &&
+                (unsigned char)c <= (unsigned char)p[2]) hit = 1;
+            p += 3;
+        } else {
+            if (c == *p) hit = 1;
+            p++;
+        }
+    }
+    if (*p != ']') return -1;  /* unterminated: treat '[' literally */
+    *pp = p + 1;
+    return hit != negate;
+}
+
+/**
+ * Glob match: '*' matches within one path component, '**' across components,
+ * '?' one non-'/' byte, '[...]' a byte class. Everything else is literal.
+ */
+static int glob_match(const char *p, const char *s) {
+    while (*p) {
+        if (p[0] == '*' && p[1] == '*') {
+            p += 2;
+            if (*p == '/') p++;  /* "**" + "/" also matches zero directories */
+            for (;;) {
+                if (glob_match(p, s)) return 1;
+                if (!*s) return 0;
+                s++;
+            }
+        }
+        if (*p == '*') {
+            p++;
+            for (;;) {
+                if (glob_match(p, s)) return 1;
+                if (!*s || *s == '/') return 0;
+                s++;
+            }
+        }
+        if (!*s) return 0;
+        if (*p == '?') {
+            if (*s == '/') return 0;
+        } else if (*p == '[') {
+            const char *q = p;
+            int r = match_class(&q, *s);
+            if (r >= 0) {
+                if (!r || *s == '/') return 0;
+                p = q;
+                s++;
+                continue;
+            }
+            if (*s != '[') return 0;
+        } else if (*p != *s) {
+            return 0;
+        }
+        p++;
+        s++;
+    }
+    return *s == '\0';
+}
+
+/* Patterns containing '/' match the whole relative path, others the basename. */
+static int any_match(const char * const *pats, size_t n, const char *rel) {
+    const char *base = strrchr(rel, '/');
+    base = base ? base + 1 : rel;
+    for (size_t i = 0; i < n; i++) {
+        if (!pats[i]) continue;
+        if (glob_match(pats[i], strchr(pats[i], '/') ? rel : base)) return 1;
+    }
+    return 0;
+}
+
+/* ---------------------------------- Lists ---------------------------------- */
+
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t used;
+    size_t cap;
+    char   data[];
+} arena_block_t;
+
+typedef struct {
+    arena_block_t *blocks;
+    char   **paths;
+    size_t   n;
+    size_t   cap;
+} path_list_t;
+
+static char *list_add(path_list_t *l, const char *a, const char *b) {
+    size_t la = strlen(a), lb = strlen(b);
+    size_t need = la + (la ? 1 : 0) + lb + 1;
+
+    arena_block_t *blk = l->blocks;
+    if (!blk || blk->cap - blk->used < need) {
+        size_t cap = need > ARENA_BLOCK ? need : ARENA_BLOCK;
+        blk = malloc(sizeof(*blk) + cap);
+        if (!blk) return NULL;
+        blk->next = l->blocks;
+        blk->used = 0;
+        blk->cap = cap;
+        l->blocks = blk;
+    }
+    if (l->n == l->cap) {
+        size_t cap = l->cap ? l->cap * 2 : 1024;
+        char **p = realloc(l->paths, cap * sizeof(*p));
+        if (!p) return NULL;
+        l->paths = p;
+        l->cap = cap;
+    }
+
+    char *s = blk->data + blk->used;
+    memcpy(s, a, la);
+    if (la) s[la++] = '/';
+    memcpy(s + la, b, lb + 1);
+    blk->used += need;
+    l->paths[l->n++] = s;
+    return s;
+}
+
+static void list_free(path_list_t *l) {
+    while (l->blocks) {
+        arena_block_t *next = l->blocks->next;
+        free(l->blocks);
+        l->blocks = next;
+    }
+    free(l->paths);
+    memset(l, 0, sizeof(*l));
+}
+
+/* Take over src's storage (arena blocks and path pointers) into dst. */
+static int list_merge(path_list_t *dst, path_list_t *src) {
+    if (dst->cap - dst->n < src->n) {
+        size_t cap = dst->n + src->n;
+        char **p = realloc(dst->paths, cap * sizeof(*p));
+        if (!p) return TACOZ_ERR_IO;
+        dst->paths = p;
+        dst->cap = cap;
+    }
+    if (src->n) memcpy(dst->paths + dst->n, src->paths, src->n * sizeof(*src->paths));
+    dst->n += src->n;
+
+    arena_block_t **tail = &dst->blocks;
+    while (*tail) tail = &(*tail)->next;
+    *tail = src->blocks;
+    src->blocks = NULL;
+    free(src->paths);
+    memset(src, 0, sizeof(*src));
+    return TACOZ_OK;
+}
+
+/* Component-wise byte order: '/' sorts before every other byte. */
+static int path_cmp(const void *a, const void *b) {
+    const unsigned char *x = *(const unsigned char * const *)a;
+    const unsigned char *y = *(const unsigned char * const *)b;
+    while (*x && *x == *y) { x++; y++; }
+    unsigned cx = *x == '/' ? 1u : (*x ? (unsigned)*x + 1u : 0u);
+    unsigned cy = *y == '/' ? 1u : (*y ? (unsigned)*y + 1u : 0u);
+    return (cx > cy) - (cx < cy);
+}
+
+/* ------------------------------- Directory list ----------------------------- */
+
+struct tacoz_dirlist {
+    char        *root;
+    path_list_t  files;
+#ifndef _WIN32
+    int          dir_fd[256];    /* open directories along the current path */
+    const char  *dir_path;       /* relative path dir_fd[depth] refers to   */
+    size_t       dir_path_len;
+    unsigned     depth;
+#endif
+};
+
+size_t tacoz_dirlist_count(const tacoz_dirlist_t *l) {
+    return l->files.n;
+}
+
+const char *tacoz_dirlist_path(const tacoz_dirlist_t *l, size_t i) {
+    return l->files.paths[i];
+}
+
+#ifndef _WIN32
+
+/* --------------------------------- POSIX walk ------------------------------- */
+
+typedef struct walk_item {
+    struct walk_item *next;
+    int   fd;                    /* open directory, or -1: reopen from root  */
+    char  rel[];                 /* relative path, "" for the root           */
+} walk_item_t;
+
+typedef struct {
+    const tacozip_dir_opts_t *opts;
+    int              root_fd;
+    dev_t            skip_dev;   /* output file being written, if inside root */
+    ino_t            skip_ino;
+    int              have_skip;
+
+    pthread_mutex_t  mu;
+    pthread_cond_t   cv;
+    walk_item_t     *queue;
+    unsigned         queued_fds;
+    unsigned         active;
+    int              err;
+
+    path_list_t      out;        /* merged results, guarded by mu */
+} walk_ctx_t;
+
+static int push_dir(walk_ctx_t *c, int parent_fd, const char *rel, const char *name) {
+    size_t n = strlen(rel) + 1 + strlen(name) + 1;
+    walk_item_t *it = malloc(sizeof(*it) + n);
+    if (!it) return TACOZ_ERR_IO;
+    if (*rel) {
+        strcpy(it->rel, rel);
+        strcat(it->rel, "/");
+        strcat(it->rel, name);
+    } else {
+        strcpy(it->rel, name);
+    }
+
+    pthread_mutex_lock(&c->mu);
+    int keep_fd = c->queued_fds < QUEUE_FD_CAP;
+    if (keep_fd) c->queued_fds++;
+    pthread_mutex_unlock(&c->mu);
+
+    it->fd = -1;
+    if (keep_fd) {
+        it->fd = openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+        if (it->fd < 0) {
+            pthread_mutex_lock(&c->mu);
+            c->queued_fds--;
+            pthread_mutex_unlock(&c->mu);
+            free(it);
+            return TACOZ_ERR_IO;
+        }
+    }
+
+    pthread_mutex_lock(&c->mu);
+    it->next = c->queue;
+    c->queue = it;
+    pthread_cond_signal(&c->cv);
+    pthread_mutex_unlock(&c->mu);
+    return TACOZ_OK;
+}
+
+static int scan_dir(walk_ctx_t *c, walk_item_t *it, path_list_t *local) {
+    const tacozip_dir_opts_t *o = c->opts;
+    int fd = it->fd;
+    if (fd < 0) {
+        fd = *it->rel ? openat(c->root_fd, it->rel, O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW)
+                      : dup(c->root_fd);
+        if (fd < 0) return TACOZ_ERR_IO;
+    }
+    DIR *d = fdopendir(fd);
+    if (!d) {
+        close(fd);
+        return TACOZ_ERR_IO;
+    }
+
+    int rc = TACOZ_OK;
+    struct dirent *de;
+    for (errno = 0; rc == TACOZ_OK && (de = readdir(d)) != NULL; errno = 0) {
+        const char *name = de->d_name;
+        if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2]))) continue;
+
+        int is_dir = 0, is_reg = 0;
+        struct stat sb;
+        int have_sb = 0;
+#ifdef DT_UNKNOWN
+        if (de->d_type == DT_DIR) is_dir = 1;
+        else if (de->d_type == DT_REG) is_reg = 1;
+        else if (de->d_type == DT_UNKNOWN || (de->d_type == DT_LNK && o->follow_symlinks))
+#endif
+        {
+            int flags = o->follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW;
+            if (fstatat(dirfd(d), name, &sb, flags) != 0) continue;  /* vanished */
+            have_sb = 1;
+            is_reg = S_ISREG(sb.st_mode);
+            /* Symlinked directories are never descended into (no cycles). */
+            is_dir = S_ISDIR(sb.st_mode) && !(o->follow_symlinks &&
+                     fstatat(dirfd(d), name, &sb, AT_SYMLINK_NOFOLLOW) == 0 && S_ISLNK(sb.st_mode));
+        }
+
+        if (is_dir) {
+            char *rel = list_add(local, it->rel, name);  /* temporary, for matching */
+            if (!rel) { rc = TACOZ_ERR_IO; break; }
+            local->n--;
+            int skip = any_match(o->exclude, o->num_exclude, rel);
+            if (!skip) rc = push_dir(c, dirfd(d), it->rel, name);
+            continue;
+        }
+        if (!is_reg) continue;
+
+        if (c->have_skip && (ino_t)de->d_ino == c->skip_ino) {
+            if (!have_sb && fstatat(dirfd(d), name, &sb, AT_SYMLINK_NOFOLLOW) == 0) have_sb = 1;
+            if (have_sb && sb.st_dev == c->skip_dev && sb.st_ino == c->skip_ino) continue;
+        }
+
+        char *rel = list_add(local, it->rel, name);
+        if (!rel) { rc = TACOZ_ERR_IO; break; }
+        if ((o->num_include && !any_match(o->include, o->num_include, rel)) ||
+            any_match(o->exclude, o->num_exclude, rel)) {
+            local->n--;  /* arena bytes are reclaimed with the list */
+        }
+    }
+    if (rc == TACOZ_OK && errno != 0) rc = TACOZ_ERR_IO;
+    closedir(d);
+    return rc;
+}
+
+static void *walk_worker(void *arg) {
+    walk_ctx_t *c = (walk_ctx_t *)arg;
+    path_list_t local;
+    memset(&local, 0, sizeof(local));
+
+    pthread_mutex_lock(&c->mu);
+    for (;;) {
+        while (!c->queue && c->active > 0 && !c->err) pthread_cond_wait(&c->cv, &c->mu);
+        if (!c->queue || c->err) break;
+
+        walk_item_t *it = c->queue;
+        c->queue = it->next;
+        if (it->fd >= 0) c->queued_fds--;
+        c->active++;
+        pthread_mutex_unlock(&c->mu);
+
+        int rc = scan_dir(c, it, &local);
+        free(it);
+
+        pthread_mutex_lock(&c->mu);
+        c->active--;
+        if (rc != TACOZ_OK && !c->err) c->err = rc;
+        if ((!c->queue && c->active == 0) || c->err) pthread_cond_broadcast(&c->cv);
+    }
+    pthread_cond_broadcast(&c->cv);
+    if (list_merge(&c->out, &local) != TACOZ_OK && !c->err) c->err = TACOZ_ERR_IO;
+    pthread_mutex_unlock(&c->mu);
+    list_free(&local);
+    return NULL;
+}
+
+static unsigned walk_threads(const tacozip_dir_opts_t *o) {
+    unsigned n = o->threads;
+    if (n == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n = cpus > 0 ? (unsigned)cpus : 1u;
+        if (n > 8) n = 8;  /* metadata walks stop scaling well before this */
+    }
+    return n > MAX_THREADS ? MAX_THREADS : n;
+}
+
+int tacoz_dirwalk(const char *root, const tacozip_dir_opts_t *opts, int skip_fd,
+                  tacoz_dirlist_t **out) {
+    tacoz_dirlist_t *l = calloc(1, sizeof(*l));
+    if (!l) return TACOZ_ERR_IO;
+    l->root = malloc(strlen(root) + 1);
+    if (!l->root) {
+        free(l);
+        return TACOZ_ERR_IO;
+    }
+    strcpy(l->root, root);
+    l->dir_fd[0] = -1;
+
+    walk_ctx_t c;
+    memset(&c, 0, sizeof(c));
+    c.opts = opts;
+    c.root_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (c.root_fd < 0) {
+        tacoz_dirlist_free(l);
+        return TACOZ_ERR_IO;
+    }
+    struct stat sb;
+    if (skip_fd >= 0 && fstat(skip_fd, &sb) == 0) {
+        c.skip_dev = sb.st_dev;
+        c.skip_ino = sb.st_ino;
+        c.have_skip = 1;
+    }
+    pthread_mutex_init(&c.mu, NULL);
+    pthread_cond_init(&c.cv, NULL);
+
+    walk_item_t *first = calloc(1, sizeof(*first) + 1);
+    int rc = first ? TACOZ_OK : TACOZ_ERR_IO;
+    if (first) {
+        first->fd = -1;
+        c.queue = first;
+    }
+
+    pthread_t tid[MAX_THREADS];
+    unsigned nthreads = walk_threads(opts), started = 0;
+    for (; rc == TACOZ_OK && started + 1 < nthreads; started++) {
+        if (pthread_create(&tid[started], NULL, walk_worker, &c) != 0) break;
+    }
+    if (rc == TACOZ_OK) walk_worker(&c);  /* the caller is a walker too */
+    for (unsigned i = 0; i < started; i++) pthread_join(tid[i], NULL);
+    if (rc == TACOZ_OK) rc = c.err;
+
+    while (c.queue) {  /* left over after an error */
+        walk_item_t *it = c.queue;
+        c.queue = it->next;
+        if (it->fd >= 0) close(it->fd);
+        free(it);
+    }
+    pthread_cond_destroy(&c.cv);
+    pthread_mutex_destroy(&c.mu);
+
+    l->files = c.out;
+    l->dir_fd[0] = c.root_fd;
+    l->dir_path = "";
+    if (rc != TACOZ_OK) {
+        tacoz_dirlist_free(l);
+        return rc;
+    }
+
+    if (opts->sort == TACOZIP_SORT_PATH && l->files.n > 1)
+        qsort(l->files.paths, l->files.n, sizeof(*l->files.paths), path_cmp);
+    *out = l;
+    return TACOZ_OK;
+}
+
+/* Length of the directory part of rel ("a/b/c.txt" -> 3). */
+static size_t dir_len(const char *rel) {
+    const char *slash = strrchr(rel, '/');
+    return slash ? (size_t)(slash - rel) : 0;
+}
+
+/* Leading components shared by a[0:alen] and b[0:blen]; *end = where they stop. */
+static unsigned common_components(const char *a, size_t alen, const char *b, size_t blen,
+                                  size_t *end) {
+    unsigned n = 0;
+    size_t i = 0;
+    *end = 0;
+    while (i < alen && i < blen) {
+        size_t j = i;
+        while (j < alen && j < blen && a[j] == b[j] && a[j] != '/') j++;
+        int a_done = j == alen || a[j] == '/';
+        int b_done = j == blen || b[j] == '/';
+        if (!a_done || !b_done) break;
+        n++;
+        *end = j;
+        i = j + 1;
+    }
+    return n;
+}
+
+int tacoz_dirlist_open(tacoz_dirlist_t *l, size_t i, int *fd, tacoz_filestat_t *st) {
+    const char *rel = l->files.paths[i];
+    size_t dlen = dir_len(rel);
+
+    /* Keep the directories shared with the previous file open; pop the rest. */
+    size_t pos;
+    unsigned keep = common_components(l->dir_path, l->dir_path_len, rel, dlen, &pos);
+    while (l->depth > keep) close(l->dir_fd[l->depth--]);
+    if (keep) pos++;
+
+    /* Descend component by component, each openat() relative to its parent. */
+    char name[4096];
+    while (pos < dlen) {
+        const char *slash = memchr(rel + pos, '/', dlen - pos);
+        size_t clen = slash ? (size_t)(slash - (rel + pos)) : dlen - pos;
+        if (clen >= sizeof(name) || l->depth + 1 >= sizeof(l->dir_fd) / sizeof(l->dir_fd[0]))
+            return TACOZ_ERR_IO;
+        memcpy(name, rel + pos, clen);
+        name[clen] = '\0';
+        int dfd = openat(l->dir_fd[l->depth], name, O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+        if (dfd < 0) return TACOZ_ERR_IO;
+        l->dir_fd[++l->depth] = dfd;
+        pos += clen + 1;
+    }
+    l->dir_path = rel;
+    l->dir_path_len = dlen;
+
+    const char *base = rel + (dlen ? dlen + 1 : 0);
+    do {
+        *fd = openat(l->dir_fd[l->depth], base, O_RDONLY | O_CLOEXEC);
+    } while (*fd < 0 && errno == EINTR);
+    if (*fd < 0) return TACOZ_ERR_IO;
+    if (tacoz_fstat(*fd, st) != TACOZ_OK) {
+        close(*fd);
+        *fd = -1;
+        return TACOZ_ERR_IO;
+    }
+    return TACOZ_OK;
+}
+
+void tacoz_dirlist_free(tacoz_dirlist_t *l) {
+    if (!l) return;
+    if (l->dir_fd[0] >= 0) {
+        for (unsigned d = l->depth; d > 0; d--) close(l->dir_fd[d]);
+        close(l->dir_fd[0]);
+    }
+    list_free(&l->files);
+    free(l->root);
+    free(l);
+}
+
+#else  /* _WIN32 */
+
+/* -------------------------------- Windows walk ------------------------------ */
+
+static int walk_win(const char *root, const char *rel, const tacozip_dir_opts_t *o,
+                    path_list_t *files) {
+    size_t n = strlen(root) + 1 + strlen(rel) + 3;
+    char *pattern = malloc(n);
+    if (!pattern) return TACOZ_ERR_IO;
+    strcpy(pattern, root);
+    if (*rel) {
+        strcat(pattern, "\\");
+        strcat(pattern, rel);
+    }
+    strcat(pattern, "\\*");
+
+    WIN32_FIND_DATAA fd;
+    HANDLE h = FindFirstFileA(pattern, &fd);
+    free(pattern);
+    if (h == INVALID_HANDLE_VALUE) return TACOZ_ERR_IO;
+
+    int rc = TACOZ_OK;
+    do {
+        const char *name = fd.cFileName;
+        if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2]))) continue;
+        /* Reparse points (symlinks, junctions) are skipped unless followed files. */
+        int is_link = (fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+        int is_dir = (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        if (is_link && (is_dir || !o->follow_symlinks)) continue;
+
+        char *path = list_add(files, rel, name);
+        if (!path) { rc = TACOZ_ERR_IO; break; }
+        files->n--;
+        if (is_dir) {
+            if (any_match(o->exclude, o->num_exclude, path)) continue;
+            rc = walk_win(root, path, o, files);
+        } else if ((!o->num_include || any_match(o->include, o->num_include, path)) &&
+                   !any_match(o->exclude, o->num_exclude, path)) {
+            files->n++;
+        }
+    } while (rc == TACOZ_OK && FindNextFileA(h, &fd));
+    FindClose(h);
+    return rc;
+}
+
+int tacoz_dirwalk(const char *root, const tacozip_dir_opts_t *opts, int skip_fd,
+                  tacoz_dirlist_t **out) {
+    (void)skip_fd;  /* the temp file is locked for writing; opening it fails */
+    tacoz_dirlist_t *l = calloc(1, sizeof(*l));
+    if (!l) return TACOZ_ERR_IO;
+    l->root = malloc(strlen(root) + 1);
+    if (!l->root) {
+        free(l);
+        return TACOZ_ERR_IO;
+    }
+    strcpy(l->root, root);
+
+    int rc = walk_win(root, "", opts, &l->files);
+    if (rc != TACOZ_OK) {
+        tacoz_dirlist_free(l);
+        return rc;
+    }
+    if (opts->sort == TACOZIP_SORT_PATH && l->files.n > 1)
+        qsort(l->files.paths, l->files.n, sizeof(*l->files.paths), path_cmp);
+    *out = l;
+    return TACOZ_OK;
+}
+
+int tacoz_dirlist_open(tacoz_dirlist_t *l, size_t i, int *fd, tacoz_filestat_t *st) {
+    const char *rel = l->files.paths[i];
+    char *full = malloc(strlen(l->root) + 1 + strlen(rel) + 1);
+    if (!full) return TACOZ_ERR_IO;
+    strcpy(full, l->root);
+    strcat(full, "/");
+    strcat(full, rel);
+    *fd = tacoz_open_read(full);
+    free(full);
+    if (*fd < 0) return TACOZ_ERR_IO;
+    if (tacoz_fstat(*fd, st) != TACOZ_OK) {
+        tacoz_close(*fd);
+        *fd = -1;
+        return TACOZ_ERR_IO;
+    }
+    return TACOZ_OK;
+}
+
+void tacoz_dirlist_free(tacoz_dirlist_t *l) {
+    if (!l) return;
+    list_free(&l->files);
+    free(l->root);
+    free(l);
+}
+
+#endif /* _WIN32 */
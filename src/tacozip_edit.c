@@ -0,0 +1,1061 @@
+/*
+ * tacozip_edit.c — in-place edits of an existing archive.
+ *
+ * Removing or renaming an entry changes what the central directory says,
+ * not the entry data, so neither needs a rewrite: the new directory is built
+ * in memory from the mapped old one, written over it at the tail, and the
+ * file is cut to its new end, all under the writer lock. Removed entries'
+ * data stays behind as dead space. The ghost is then refreshed in place.
+ * The one exception is a new name too long for the entry's local header:
+ * that entry is copied to free space as a put would place it.
+ *
+ * Compaction reclaims that space later, a bounded number of bytes at a time:
+ * live extents slide down over the holes before them, front to back, and the
+ * directory and ghost are rewritten with the shifted offsets.
+ *
+ * Until then new and replacement data goes into that space: each put takes
+ * the best-fitting hole and appends at the end of the live data only when
+ * none is large enough.
+ *
+ * Log commits never write before the current tail: new data, a full new
+ * directory and a tail whose EOCD comment links back to the previous one are
+ * appended, and the in-place ghost update publishes them, so every earlier
+ * directory remains a readable snapshot.
+ */
+
+#include "tacozip_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int            fd;
+    tacoz_tail_t   tail;
+    tacoz_view_t   cd;
+    taco_ghost_t  *ghost;     /* stored ghost, or NULL if the archive has none */
+    unsigned char *out;       /* new directory image                           */
+    size_t         out_len;
+    uint64_t       entries;   /* records in out, ghost included                */
+    uint64_t       ghost_end; /* first byte after the ghost payload (0 = none)  */
+    uint64_t       end;       /* EDIT_LOG: first byte after the head's tail     */
+    int            durability;/* log commits: TACOZIP_DURABLE_* to sync with    */
+} edit_t;
+
+typedef struct {
+    const char *name;
+    size_t      len;
+    int         found;
+} edit_name_t;
+
+static int is_ghost(const tacoz_cdh_t *c) {
+    return c->lfh_off == 0 && c->name_len == TACO_GHOST_NAME_LEN &&
+           memcmp(c->name, TACO_GHOST_NAME, TACO_GHOST_NAME_LEN) == 0;
+}
+
+/** Byte order of names, shorter first on a common prefix (as the writer sorts). */
+static int name_cmp(const char *a, size_t alen, const char *b, size_t blen) {
+    int r = memcmp(a, b, alen < blen ? alen : blen);
+    if (r != 0) return r;
+    return (alen > blen) - (alen < blen);
+}
+
+static int edit_name_cmp(const void *a, const void *b) {
+    const edit_name_t *x = (const edit_name_t *)a, *y = (const edit_name_t *)b;
+    return name_cmp(x->name, x->len, y->name, y->len);
+}
+
+static void edit_close(edit_t *e) {
+    tacoz_view_close(&e->cd);
+    if (e->fd >= 0) tacoz_close(e->fd);
+    free(e->ghost);
+    free(e->out);
+}
+
+enum {
+    EDIT_READ,   /* shared lock                                         */
+    EDIT_WRITE,  /* writer lock                                         */
+    EDIT_LOG     /* writer lock, directory the ghost names (log head)   */
+};
+
+/** Lock the archive as @p mode says, map its directory and read its ghost,
+ *  if any; room is made for a directory @p grow bytes larger. */
+static int edit_open(edit_t *e, const char *zip_path, size_t grow, int mode) {
+    memset(e, 0, sizeof(*e));
+    e->fd = mode != EDIT_READ ? tacoz_open_locked(zip_path) : tacoz_open_read(zip_path);
+    if (e->fd < 0) return TACOZ_ERR_IO;
+    if (mode == EDIT_READ && tacoz_lock(e->fd, 0) != TACOZ_OK) return TACOZ_ERR_IO;
+
+    tacoz_ghost_loc_t loc;
+    e->ghost = malloc(sizeof(*e->ghost));
+    int rc = e->ghost ? tacoz_ghost_locate(e->fd, &loc) : TACOZ_ERR_IO;
+    if (rc == TACOZ_OK) rc = tacoz_ghost_read(e->fd, &loc, e->ghost);
+    if (rc == TACOZ_OK) e->ghost_end = loc.data_off + loc.size;
+    if (rc == TACOZ_ERR_INVALID_GHOST) {
+        free(e->ghost);
+        e->ghost = NULL;
+        rc = TACOZ_OK;
+    }
+    if (rc == TACOZ_OK && mode == EDIT_LOG) rc = tacoz_log_head(e->fd, e->ghost, &e->tail, &e->end);
+    else if (rc == TACOZ_OK) rc = tacoz_read_tail(e->fd, &e->tail);
+    if (rc == TACOZ_OK) rc = tacoz_view_open(e->fd, e->tail.cd_off, e->tail.cd_size, &e->cd);
+    if (rc == TACOZ_OK && !(e->out = malloc(e->cd.len + grow + 1))) rc = TACOZ_ERR_IO;
+    return rc;
+}
+
+/** Parse the record at @p off of the old directory; returns its length or 0. */
+static size_t rec_at(const edit_t *e, size_t off, tacoz_cdh_t *c) {
+    if (off >= e->cd.len) return 0;
+    int64_t n = tacoz_cdh_parse(e->cd.data + off, e->cd.len - off, off, c);
+    return n > 0 ? (size_t)n : 0;
+}
+
+static void emit_raw(edit_t *e, const unsigned char *p, size_t n) {
+    memcpy(e->out + e->out_len, p, n);
+    e->out_len += n;
+    e->entries++;
+}
+
+static void emit(edit_t *e, const tacoz_cdh_t *c) {
+    emit_raw(e, c->raw, c->rec_len);
+}
+
+/** Clear the slots flagged in @p clear and repack the remaining inline copies. */
+static void clear_slots(taco_ghost_t *g, const int *clear) {
+    uint32_t off[TACO_GHOST_V2_MAX_SLOTS], len[TACO_GHOST_V2_MAX_SLOTS];
+    unsigned char keep[TACO_GHOST_INLINE_MAX];
+    memcpy(off, g->inline_off, sizeof(off));
+    memcpy(len, g->inline_len, sizeof(len));
+    memcpy(keep, g->inline_data, g->inline_used);
+
+    for (unsigned i = 0; i < g->count; i++) {
+        if (!clear[i]) continue;
+        g->slots[i].offset = g->slots[i].length = 0;
+        len[i] = 0;
+    }
+    memset(g->inline_len, 0, sizeof(g->inline_len));
+    memset(g->inline_off, 0, sizeof(g->inline_off));
+    g->inline_used = 0;
+    for (unsigned i = 0; i < g->count; i++)
+        if (len[i]) (void)tacoz_ghost_add_inline(g, i, keep + off[i], len[i]);
+}
+
+/**
+ * Clear the ghost slots that point at a table of a TACOZ_TABLE_* kind in
+ * @p kinds. A name index hashes the directory's names, so a rename makes it
+ * stale; an ID table holds no names, only back distances to entry data, and
+ * goes stale only when entries leave or their data moves.
+ */
+static int drop_tables(edit_t *e, int kinds) {
+    int clear[TACO_GHOST_V2_MAX_SLOTS] = {0};
+    for (unsigned i = 0; i < e->ghost->count; i++) {
+        int rc = tacoz_slot_is_table(e->fd, &e->ghost->slots[i], &clear[i]);
+        if (rc != TACOZ_OK) return rc;
+        clear[i] &= kinds;
+    }
+    clear_slots(e->ghost, clear);
+    return TACOZ_OK;
+}
+
+/** Write the new directory at @p cd_off, followed by a tail carrying log
+ *  record @p log if given, cut the file after it and refresh the ghost,
+ *  dropping @p drop_flags from its layout. */
+static int edit_commit(edit_t *e, uint64_t cd_off, uint32_t drop_flags,
+                       const tacoz_log_rec_t *log) {
+    tacoz_view_close(&e->cd);
+
+    uint64_t end = cd_off + e->out_len;
+    unsigned char t[TACOZ_TAIL_SIZE + TACOZ_LOG_REC_SIZE];
+    size_t t_len = TACOZ_TAIL_SIZE;
+    tacoz_tail_build(t, e->entries, e->out_len, cd_off, end);
+    if (log) {
+        le16(t + TACOZ_TAIL_SIZE - 2, TACOZ_LOG_REC_SIZE);  /* EOCD comment length */
+        tacoz_log_record_build(t + TACOZ_TAIL_SIZE, log);
+        t_len += TACOZ_LOG_REC_SIZE;
+    }
+    int rc = tacoz_pwrite_all(e->fd, e->out, e->out_len, cd_off);
+    if (rc == TACOZ_OK) rc = tacoz_pwrite_all(e->fd, t, t_len, end);
+    if (rc == TACOZ_OK) rc = tacoz_truncate(e->fd, end + t_len);
+    /* A log commit is published by the ghost; with durability on, what it
+     * will point at reaches the disk first, then the ghost itself. */
+    int sync = log && e->durability != TACOZIP_DURABLE_NONE;
+    if (rc == TACOZ_OK && sync) rc = tacoz_sync(e->fd, e->durability);
+    if (rc == TACOZ_OK && e->ghost) rc = tacoz_ghost_write(e->fd, e->ghost, drop_flags);
+    if (rc == TACOZ_OK && sync) rc = tacoz_sync(e->fd, e->durability);
+    return rc;
+}
+
+int tacozip_remove_entries(const char *zip_path, const char * const *names, size_t count) {
+    if (!zip_path || (!names && count)) return TACOZ_ERR_PARAM;
+    if (count == 0) return TACOZ_OK;
+    if (count > SIZE_MAX / sizeof(edit_name_t)) return TACOZ_ERR_PARAM;
+
+    edit_name_t *want = malloc(count * sizeof(*want));
+    if (!want) return TACOZ_ERR_IO;
+    for (size_t i = 0; i < count; i++) {
+        if (!names[i] || strcmp(names[i], TACO_GHOST_NAME) == 0) {
+            free(want);
+            return TACOZ_ERR_PARAM;
+        }
+        want[i].name = names[i];
+        want[i].len = strlen(names[i]);
+        want[i].found = 0;
+    }
+    qsort(want, count, sizeof(*want), edit_name_cmp);
+    size_t n = 1;
+    for (size_t i = 1; i < count; i++)
+        if (edit_name_cmp(&want[n - 1], &want[i]) != 0) want[n++] = want[i];
+
+    edit_t e;
+    int rc = edit_open(&e, zip_path, 0, EDIT_WRITE);
+
+    /* An entry of a uniform run that leaves the directory breaks the run. */
+    uint64_t run_end = 0;
+    if (e.ghost && (e.ghost->flags & TACO_GHOST_F_UNIFORM))
+        run_end = e.ghost->uniform_base + e.ghost->uniform_count * e.ghost->uniform_stride;
+    uint32_t drop = 0;
+
+    size_t off = 0;
+    for (uint64_t i = 0; rc == TACOZ_OK && i < e.tail.entries; i++) {
+        tacoz_cdh_t c;
+        size_t len = rec_at(&e, off, &c);
+        if (len == 0) {
+            rc = TACOZ_ERR_INVALID_GHOST;
+            break;
+        }
+        off += len;
+        edit_name_t key = {c.name, c.name_len, 0};
+        edit_name_t *hit = is_ghost(&c) ? NULL : bsearch(&key, want, n, sizeof(*want), edit_name_cmp);
+        if (!hit) {
+            emit(&e, &c);
+            continue;
+        }
+        hit->found = 1;
+        if (c.lfh_off < run_end) drop |= TACO_GHOST_F_UNIFORM;
+    }
+    for (size_t i = 0; rc == TACOZ_OK && i < n; i++)
+        if (!want[i].found) rc = TACOZ_ERR_NOT_FOUND;
+
+    if (rc == TACOZ_OK && e.ghost) rc = drop_tables(&e, TACOZ_TABLE_NAMES | TACOZ_TABLE_IDS);
+    if (rc == TACOZ_OK) rc = edit_commit(&e, e.tail.cd_off, drop, NULL);
+    edit_close(&e);
+    free(want);
+    return rc;
+}
+
+/** Whether @p used of @p room bytes leave no gap, or one a padding field fills. */
+static int fits(size_t used, size_t room) {
+    return used <= room && (used == room || room - used >= TACOZ_PAD_EXTRA_MIN);
+}
+
+/** Copy the extra fields @p x (@p len bytes) to @p o, leaving out padding and,
+ *  past @p keep 0, other fields; past @p keep 1 also ZIP64. Returns bytes. */
+static size_t pack_extras(unsigned char *o, const unsigned char *x, size_t len, int keep) {
+    size_t used = 0;
+    while (len >= 4) {
+        size_t n = 4 + (size_t)le16_read(x + 2);
+        if (n > len) break;
+        uint16_t id = le16_read(x);
+        if (id != TACOZ_PAD_EXTRA_ID &&
+            (keep == 0 || (keep == 1 && id == TACOZ_ZIP64_EXTRA_ID))) {
+            memcpy(o + used, x, n);
+            used += n;
+        }
+        x += n;
+        len -= n;
+    }
+    return used;
+}
+
+/**
+ * The local header of @p c under @p name, in a new buffer *@p out of
+ * *@p out_len bytes. It keeps its place when the name fits in the old name
+ * and extra fields, whose total length is fixed by the data behind them:
+ * extras are given up as needed, first all but ZIP64, then ZIP64 when the
+ * sizes fit the header itself, and leftover bytes become a growth-hint
+ * padding field. Otherwise *@p moved is set: the header keeps every extra
+ * but padding and goes, with the data, wherever the caller places them.
+ */
+static int renamed_lfh(int fd, const tacoz_cdh_t *c, const char *name, size_t len,
+                       unsigned char **out, size_t *out_len, int *moved) {
+    unsigned char h[TACOZ_LFH_SIZE];
+    int rc = tacoz_pread_all(fd, h, sizeof(h), c->lfh_off);
+    if (rc != TACOZ_OK) return rc;
+    if (le32_read(h) != TACOZ_SIG_LFH) return TACOZ_ERR_INVALID_GHOST;
+    size_t name_len = le16_read(h + 26), room = name_len + le16_read(h + 28);
+
+    /* Header, new name and extras, then the old name and extras. */
+    unsigned char *buf = malloc(TACOZ_LFH_SIZE + len + 2 * room + 1);
+    if (!buf) return TACOZ_ERR_IO;
+    unsigned char *o = buf + TACOZ_LFH_SIZE, *old = o + len + room;
+    rc = tacoz_pread_all(fd, old, room, c->lfh_off + TACOZ_LFH_SIZE);
+    memcpy(buf, h, sizeof(h));
+    memcpy(o, name, len);
+
+    int small = !(le16_read(h + 6) & TACOZ_GPBIT_DESCRIPTOR) &&
+                c->csize < 0xFFFFFFFFu && c->usize < 0xFFFFFFFFu;
+    size_t used = 0;
+    int keep, fit = 0;
+    for (keep = 0; len <= room && keep <= (small ? 2 : 1); keep++) {
+        used = len + pack_extras(o + len, old + name_len, room - name_len, keep);
+        if ((fit = fits(used, room))) break;
+    }
+    if (rc == TACOZ_OK && fit) {
+        if (keep == 2) {
+            le32(buf + 18, (uint32_t)c->csize);
+            le32(buf + 22, (uint32_t)c->usize);
+        }
+        if (used < room) {
+            size_t pad = room - used;
+            le16(o + used, TACOZ_PAD_EXTRA_ID);
+            le16(o + used + 2, (uint16_t)(pad - 4));
+            le16(o + used + 4, TACOZ_PAD_EXTRA_SIG);
+            le16(o + used + 6, (uint16_t)(pad - TACOZ_PAD_EXTRA_MIN));
+            memset(o + used + TACOZ_PAD_EXTRA_MIN, 0, pad - TACOZ_PAD_EXTRA_MIN);
+        }
+        used = room;
+    } else if (rc == TACOZ_OK) {
+        used = len + pack_extras(o + len, old + name_len, room - name_len, 0);
+        *moved = 1;
+    }
+    if (rc != TACOZ_OK) {
+        free(buf);
+        return rc;
+    }
+    le16(buf + 26, (uint16_t)len);
+    le16(buf + 28, (uint16_t)(used - len));
+    *out = buf;
+    *out_len = TACOZ_LFH_SIZE + used;
+    return TACOZ_OK;
+}
+
+/** Record @p c under @p name, its local header at @p lfh_off: the fixed part,
+ *  the new name, then the old extras and comment, re-emitted with a ZIP64
+ *  offset if the header moved. Returns a new buffer of *@p n bytes, or NULL. */
+static unsigned char *renamed_rec(const tacoz_cdh_t *c, const char *name, size_t len,
+                                  uint64_t lfh_off, size_t *n) {
+    size_t tail = c->rec_len - TACOZ_CDH_SIZE - c->name_len;
+    *n = TACOZ_CDH_SIZE + len + tail;
+    unsigned char *r = malloc(*n);
+    if (!r) return NULL;
+    memcpy(r, c->raw, TACOZ_CDH_SIZE);
+    le16(r + 28, (uint16_t)len);
+    memcpy(r + TACOZ_CDH_SIZE, name, len);
+    memcpy(r + TACOZ_CDH_SIZE + len, c->raw + TACOZ_CDH_SIZE + c->name_len, tail);
+    if (lfh_off == c->lfh_off) return r;
+
+    tacoz_cdh_t m;
+    unsigned char *out = malloc(TACOZ_CDH_REBUILD_MAX(*n));
+    int parsed = out && tacoz_cdh_parse(r, *n, c->cdh_off, &m) > 0;
+    *n = parsed ? tacoz_cdh_rebuild(&m, lfh_off, out) : 0;
+    free(r);
+    if (*n == 0) {
+        free(out);
+        return NULL;
+    }
+    return out;
+}
+
+/* ------------------------------- Compaction -------------------------------- */
+
+typedef struct {
+    uint64_t start, end;  /* live bytes [start, end): entries and slot targets */
+    int64_t  delta;       /* move applied by this compaction (<= 0)          */
+} unit_t;
+
+typedef struct {
+    edit_t   e;
+    unit_t  *unit;        /* sorted by start, disjoint                        */
+    size_t   n;
+    uint64_t pinned;      /* the ghost and a uniform run end here; never moved */
+} compact_t;
+
+static int unit_cmp(const void *a, const void *b) {
+    const unit_t *x = (const unit_t *)a, *y = (const unit_t *)b;
+    return (x->start > y->start) - (x->start < y->start);
+}
+
+/** The move applied to the unit holding @p off (0 outside every unit). */
+static int64_t delta_of(const compact_t *k, uint64_t off) {
+    size_t lo = 0, hi = k->n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (k->unit[mid].start <= off) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo && off < k->unit[lo - 1].end ? k->unit[lo - 1].delta : 0;
+}
+
+/** The bytes entry @p c occupies: its local header and data. */
+static int entry_extent(const edit_t *e, const tacoz_cdh_t *c, unit_t *u) {
+    unsigned char lfh[TACOZ_LFH_SIZE];
+    int rc = tacoz_pread_all(e->fd, lfh, sizeof(lfh), c->lfh_off);
+    if (rc != TACOZ_OK) return rc;
+    if (le32_read(lfh) != TACOZ_SIG_LFH) return TACOZ_ERR_INVALID_GHOST;
+    if (le16_read(lfh + 6) & TACOZ_GPBIT_DESCRIPTOR) return TACOZ_ERR_PARAM;
+    u->start = c->lfh_off;
+    u->end = c->lfh_off + TACOZ_LFH_SIZE + le16_read(lfh + 26) + le16_read(lfh + 28) + c->csize;
+    u->delta = 0;
+    return u->end > e->tail.cd_off ? TACOZ_ERR_INVALID_GHOST : TACOZ_OK;
+}
+
+/** One unit per entry and per slot target, merged where they overlap. The
+ *  entry whose local header is at @p skip (0 = none) is left out. */
+static int collect_units(compact_t *k, uint64_t skip) {
+    edit_t *e = &k->e;
+    taco_ghost_t *g = e->ghost;
+    uint64_t cap = e->tail.entries + TACO_GHOST_V2_MAX_SLOTS;
+    if (cap > SIZE_MAX / sizeof(*k->unit)) return TACOZ_ERR_IO;
+    k->unit = malloc((size_t)cap * sizeof(*k->unit));
+    if (!k->unit) return TACOZ_ERR_IO;
+
+    size_t off = 0;
+    for (uint64_t i = 0; i < e->tail.entries; i++) {
+        tacoz_cdh_t c;
+        size_t len = rec_at(e, off, &c);
+        if (len == 0) return TACOZ_ERR_INVALID_GHOST;
+        off += len;
+        if (is_ghost(&c) || (skip && c.lfh_off == skip)) continue;
+        int rc = entry_extent(e, &c, &k->unit[k->n++]);
+        if (rc != TACOZ_OK) return rc;
+    }
+    for (unsigned i = 0; g && i < g->count; i++) {
+        const taco_meta_entry_t *s = &g->slots[i];
+        if (s->length == 0) continue;
+        if (s->offset > e->tail.cd_off || s->length > e->tail.cd_off - s->offset)
+            return TACOZ_ERR_PARAM;  /* past the entry region: nothing to move it with */
+        k->unit[k->n].start = s->offset;
+        k->unit[k->n].end = s->offset + s->length;
+        k->unit[k->n++].delta = 0;
+    }
+
+    qsort(k->unit, k->n, sizeof(*k->unit), unit_cmp);
+    size_t m = 0;
+    for (size_t i = 0; i < k->n; i++) {
+        if (m && k->unit[i].start < k->unit[m - 1].end) {
+            if (k->unit[i].end > k->unit[m - 1].end) k->unit[m - 1].end = k->unit[i].end;
+        } else {
+            k->unit[m++] = k->unit[i];
+        }
+    }
+    k->n = m;
+
+    /* A uniform run keeps its stride and alignment, so it stays put. */
+    k->pinned = e->ghost_end;
+    if (g && (g->flags & TACO_GHOST_F_UNIFORM) && g->uniform_count) {
+        uint64_t run_end = g->uniform_base + (g->uniform_count - 1) * g->uniform_stride +
+                           g->uniform_size;
+        if (run_end > k->pinned) k->pinned = run_end;
+    }
+    return TACOZ_OK;
+}
+
+/** Holes between the pinned prefix and the directory. */
+static void count_holes(const compact_t *k, tacozip_compact_stats_t *st) {
+    uint64_t at = k->pinned;
+    for (size_t i = 0; i <= k->n; i++) {
+        uint64_t start = i < k->n ? k->unit[i].start : k->e.tail.cd_off;
+        if (start > at) {
+            uint64_t hole = start - at;
+            st->dead_bytes += hole;
+            st->holes++;
+            if (hole > st->largest_hole) st->largest_hole = hole;
+        }
+        if (i < k->n && k->unit[i].end > at) at = k->unit[i].end;
+    }
+}
+
+/** Assign moves front to back while @p budget lasts; returns the new end of
+ *  the entry region, where the directory goes. */
+static uint64_t plan_moves(compact_t *k, uint64_t budget, uint64_t *moved) {
+    uint64_t cursor = k->pinned;
+    for (size_t i = 0; i < k->n; i++) {
+        unit_t *u = &k->unit[i];
+        if (u->start <= cursor) {
+            if (u->end > cursor) cursor = u->end;
+            continue;
+        }
+        uint64_t len = u->end - u->start;
+        if (len > budget - *moved) return k->unit[k->n - 1].end;
+        u->delta = -(int64_t)(u->start - cursor);
+        *moved += len;
+        cursor += len;
+    }
+    return cursor;
+}
+
+typedef struct {
+    const compact_t *k;
+    int64_t          delta;
+    int              split;
+} table_check_t;
+
+static int table_visit(void *ctx, uint64_t data_off) {
+    table_check_t *t = (table_check_t *)ctx;
+    if (delta_of(t->k, data_off) == t->delta) return 0;
+    t->split = 1;
+    return 1;
+}
+
+/**
+ * Rebase the ghost's slots. A name index or ID table stores distances from
+ * itself to its entries, so it survives only if all of them move with it;
+ * otherwise its slot is cleared. Runs before any data moves.
+ */
+static int rebase_slots(compact_t *k) {
+    taco_ghost_t *g = k->e.ghost;
+    int clear[TACO_GHOST_V2_MAX_SLOTS] = {0};
+    for (unsigned i = 0; i < g->count; i++) {
+        taco_meta_entry_t *s = &g->slots[i];
+        if (s->length == 0) continue;
+        int table;
+        int rc = tacoz_slot_is_table(k->e.fd, s, &table);
+        table_check_t t = {k, delta_of(k, s->offset), 0};
+        if (rc == TACOZ_OK && table) rc = tacoz_table_scan(k->e.fd, s, table_visit, &t);
+        if (rc == TACOZ_ERR_INVALID_GHOST) t.split = 1;  /* unreadable: drop it */
+        else if (rc != TACOZ_OK) return rc;
+        clear[i] = t.split;
+        s->offset += (uint64_t)t.delta;
+    }
+    clear_slots(g, clear);
+    return TACOZ_OK;
+}
+
+/** Slide the planned units down, merging neighbours that move together. */
+static int move_units(const compact_t *k) {
+    for (size_t i = 0; i < k->n; ) {
+        const unit_t *u = &k->unit[i];
+        size_t j = i + 1;
+        while (j < k->n && k->unit[j].delta == u->delta && k->unit[j].start == k->unit[j - 1].end)
+            j++;
+        if (u->delta != 0) {
+            int rc = tacoz_move_down(k->e.fd, u->start, u->start + (uint64_t)u->delta,
+                                     k->unit[j - 1].end - u->start);
+            if (rc != TACOZ_OK) return rc;
+        }
+        i = j;
+    }
+    return TACOZ_OK;
+}
+
+/** The directory with every moved entry's local header offset shifted. */
+static int rebuild_cd(compact_t *k) {
+    edit_t *e = &k->e;
+    if (e->tail.entries > (SIZE_MAX - e->cd.len) / TACOZ_CDH_EXTRA_SIZE) return TACOZ_ERR_IO;
+    free(e->out);
+    e->out = malloc(e->cd.len + (size_t)e->tail.entries * TACOZ_CDH_EXTRA_SIZE + 1);
+    if (!e->out) return TACOZ_ERR_IO;
+
+    size_t off = 0;
+    for (uint64_t i = 0; i < e->tail.entries; i++) {
+        tacoz_cdh_t c;
+        off += rec_at(e, off, &c);
+        int64_t delta = is_ghost(&c) ? 0 : delta_of(k, c.lfh_off);
+        if (delta == 0) {
+            emit(e, &c);
+            continue;
+        }
+        size_t n = tacoz_cdh_rebuild(&c, c.lfh_off + (uint64_t)delta, e->out + e->out_len);
+        if (n == 0) return TACOZ_ERR_INVALID_GHOST;
+        e->out_len += n;
+        e->entries++;
+    }
+    return TACOZ_OK;
+}
+
+int tacozip_compact(const char *zip_path, uint64_t budget, tacozip_compact_stats_t *stats) {
+    if (!zip_path) return TACOZ_ERR_PARAM;
+    tacozip_compact_stats_t st;
+    memset(&st, 0, sizeof(st));
+
+    compact_t k;
+    memset(&k, 0, sizeof(k));
+    tacoz_filestat_t fs;
+    int rc = edit_open(&k.e, zip_path, 0, budget ? EDIT_WRITE : EDIT_READ);
+    if (rc == TACOZ_OK) rc = tacoz_fstat(k.e.fd, &fs);
+    if (rc == TACOZ_OK) {
+        st.file_size = fs.size;
+        rc = collect_units(&k, 0);
+    }
+    if (rc == TACOZ_OK) count_holes(&k, &st);
+
+    uint64_t cd_off = 0;
+    if (rc == TACOZ_OK && budget) cd_off = plan_moves(&k, budget, &st.bytes_moved);
+    if (rc == TACOZ_OK && budget && (st.bytes_moved || cd_off < k.e.tail.cd_off)) {
+        if (k.e.ghost) rc = rebase_slots(&k);
+        if (rc == TACOZ_OK) rc = rebuild_cd(&k);
+        if (rc == TACOZ_OK) rc = move_units(&k);
+        if (rc == TACOZ_OK) rc = edit_commit(&k.e, cd_off, 0, NULL);
+        if (rc == TACOZ_OK) rc = tacoz_fstat(k.e.fd, &fs);
+        if (rc == TACOZ_OK) st.reclaimed = st.file_size - fs.size;
+    } else {
+        st.bytes_moved = 0;
+    }
+
+    edit_close(&k.e);
+    free(k.unit);
+    if (stats) *stats = st;
+    return rc;
+}
+
+/* --------------------------- Free-space placement --------------------------- */
+
+/* The free-extent map is the complement of the live units: every byte between
+ * the pinned prefix and the directory that no entry or slot target covers.
+ * It is rebuilt from the directory on each call, so it never goes stale. */
+
+/** Best fit: the start of the smallest free extent of at least @p need bytes
+ *  that keeps clear of @p busy; UINT64_MAX if none is large enough. */
+static uint64_t best_hole(const compact_t *k, uint64_t need, const unit_t *busy) {
+    uint64_t best = UINT64_MAX, best_len = UINT64_MAX, at = k->pinned;
+    for (size_t i = 0; i <= k->n; i++) {
+        uint64_t start = i < k->n ? k->unit[i].start : k->e.tail.cd_off;
+        /* The gap [at, start) less the busy range: what lies before it and after. */
+        uint64_t lo[2] = {at, busy->end > at ? busy->end : at};
+        uint64_t hi[2] = {busy->start < start ? busy->start : start, start};
+        for (int j = 0; j < 2; j++) {
+            if (hi[j] <= lo[j] || hi[j] - lo[j] < need || hi[j] - lo[j] >= best_len) continue;
+            best = lo[j];
+            best_len = hi[j] - lo[j];
+        }
+        if (i < k->n && k->unit[i].end > at) at = k->unit[i].end;
+    }
+    return best;
+}
+
+/** Where @p need bytes go: the best-fitting hole, else the end of the live
+ *  data. *@p cd_off is set to where the directory follows whatever ends last. */
+static uint64_t place(const compact_t *k, uint64_t need, const unit_t *busy, uint64_t *cd_off) {
+    uint64_t end = k->pinned;
+    if (k->n && k->unit[k->n - 1].end > end) end = k->unit[k->n - 1].end;
+    uint64_t at = best_hole(k, need, busy);
+    if (at == UINT64_MAX) at = end > busy->end ? end : busy->end;
+    *cd_off = at + need > end ? at + need : end;
+    return at;
+}
+
+/**
+ * Let go of the ghost's hold on the entry being replaced (@p old, occupying
+ * @p busy): a slot that held exactly its data is flagged in @p follow to move
+ * with it, any other slot into it is cleared (inline copies go either way).
+ * Replacing a member of a uniform run breaks the run.
+ */
+static void release_slots(edit_t *e, const tacoz_cdh_t *old, const unit_t *busy,
+                          int *follow, uint32_t *drop) {
+    taco_ghost_t *g = e->ghost;
+    uint64_t data = busy->end - old->csize;
+    int clear[TACO_GHOST_V2_MAX_SLOTS] = {0};
+    for (unsigned i = 0; i < g->count; i++) {
+        const taco_meta_entry_t *s = &g->slots[i];
+        if (s->length == 0 || s->offset >= busy->end || s->offset + s->length <= busy->start)
+            continue;
+        follow[i] = s->offset == data && s->length == old->csize;
+        clear[i] = 1;
+    }
+    clear_slots(g, clear);
+
+    if ((g->flags & TACO_GHOST_F_UNIFORM) &&
+        busy->start < g->uniform_base + g->uniform_count * g->uniform_stride) {
+        g->flags &= ~TACO_GHOST_F_UNIFORM;
+        *drop |= TACO_GHOST_F_UNIFORM;
+    }
+}
+
+/** Append the record of @p ne to the new directory; returns its offset there. */
+static size_t emit_new(edit_t *e, const tacoz_cd_entry_t *ne) {
+    size_t at = e->out_len;
+    tacoz_cdh_build(ne, e->out + at);
+    e->out_len += TACOZ_CDH_TOTAL(ne->name_len);
+    e->entries++;
+    return at;
+}
+
+/** Write the local header of @p ne and its @p src bytes at ne->lfh_off,
+ *  checksumming on the way; the CRC goes to *@p crc. */
+static int put_data(int fd, int src, const tacoz_cd_entry_t *ne, uint32_t *crc) {
+    size_t hdr = TACOZ_LFH_TOTAL(ne->name_len);
+    size_t cap = ne->size < TACOZ_COPY_BUFSZ ? (size_t)ne->size : TACOZ_COPY_BUFSZ;
+    unsigned char *buf = malloc(cap > hdr ? cap : hdr);
+    if (!buf) return TACOZ_ERR_IO;
+
+    int rc = TACOZ_OK;
+    *crc = 0;
+    for (uint64_t done = 0; rc == TACOZ_OK && done < ne->size; ) {
+        size_t n = ne->size - done < cap ? (size_t)(ne->size - done) : cap;
+        rc = tacoz_pread_all(src, buf, n, done);
+        if (rc == TACOZ_OK) rc = tacoz_pwrite_all(fd, buf, n, ne->lfh_off + hdr + done);
+        *crc = tacoz_crc32(*crc, buf, n);
+        done += n;
+    }
+    if (rc == TACOZ_OK) {
+        tacoz_lfh_build(buf, ne->name, ne->name_len, ne->dostime, ne->size);
+        le32(buf + 14, *crc);
+        rc = tacoz_pwrite_all(fd, buf, hdr, ne->lfh_off);
+    }
+    free(buf);
+    return rc;
+}
+
+int tacoz_put_file(const char *zip_path, const char *arc_name, const char *src_path,
+                   int must_exist) {
+    if (!zip_path || !arc_name || !src_path) return TACOZ_ERR_PARAM;
+    size_t name_len = strlen(arc_name);
+    if (name_len == 0 || name_len > 0xFFFFu || strcmp(arc_name, TACO_GHOST_NAME) == 0)
+        return TACOZ_ERR_PARAM;
+
+    compact_t k;
+    memset(&k, 0, sizeof(k));
+    edit_t *e = &k.e;
+    int rc = edit_open(e, zip_path, TACOZ_CDH_TOTAL(name_len), EDIT_WRITE);
+    tacoz_filestat_t st;
+    int src = rc == TACOZ_OK ? tacoz_open_read(src_path) : -1;
+    if (rc == TACOZ_OK && (src < 0 || tacoz_fstat(src, &st) != TACOZ_OK || !st.is_regular))
+        rc = TACOZ_ERR_IO;
+
+    /* The entry being replaced, if the name is taken. */
+    tacoz_cdh_t c, old;
+    size_t off = 0, from = SIZE_MAX;
+    for (uint64_t i = 0; rc == TACOZ_OK && i < e->tail.entries; i++) {
+        size_t len = rec_at(e, off, &c);
+        if (len == 0) {
+            rc = TACOZ_ERR_INVALID_GHOST;
+            break;
+        }
+        if (!is_ghost(&c) && name_cmp(c.name, c.name_len, arc_name, name_len) == 0) {
+            from = off;
+            old = c;
+        }
+        off += len;
+    }
+    if (rc == TACOZ_OK && from == SIZE_MAX && must_exist) rc = TACOZ_ERR_NOT_FOUND;
+
+    /* Its bytes stay live until the new directory is in place, so they are
+     * kept out of the map for this call and are free for the next one. */
+    unit_t busy = {0, 0, 0};
+    int follow[TACO_GHOST_V2_MAX_SLOTS] = {0};
+    uint32_t drop = 0;
+    if (rc == TACOZ_OK && from != SIZE_MAX) rc = entry_extent(e, &old, &busy);
+    if (rc == TACOZ_OK && e->ghost) rc = drop_tables(e, TACOZ_TABLE_NAMES | TACOZ_TABLE_IDS);
+    if (rc == TACOZ_OK && e->ghost && from != SIZE_MAX) release_slots(e, &old, &busy, follow, &drop);
+    if (rc == TACOZ_OK) rc = collect_units(&k, from != SIZE_MAX ? old.lfh_off : 0);
+
+    tacoz_cd_entry_t ne;
+    uint64_t cd_off = 0;
+    if (rc == TACOZ_OK) {
+        ne.lfh_off  = place(&k, TACOZ_LFH_TOTAL(name_len) + st.size, &busy, &cd_off);
+        ne.size     = st.size;
+        ne.crc      = 0;
+        ne.mode     = st.mode;
+        ne.dostime  = tacoz_dostime(st.mtime);
+        ne.name_len = (uint16_t)name_len;
+        ne.name     = arc_name;
+    }
+
+    /* The new record takes the old one's place, or where its name sorts. */
+    size_t rec = SIZE_MAX;
+    int sorted = e->ghost && (e->ghost->flags & TACO_GHOST_F_CD_SORTED);
+    off = 0;
+    for (uint64_t i = 0; rc == TACOZ_OK && i < e->tail.entries; i++) {
+        off += rec_at(e, off, &c);
+        if (c.cdh_off == from) {
+            rec = emit_new(e, &ne);
+            continue;
+        }
+        if (sorted && rec == SIZE_MAX && from == SIZE_MAX && !is_ghost(&c) &&
+            name_cmp(c.name, c.name_len, arc_name, name_len) > 0)
+            rec = emit_new(e, &ne);
+        emit(e, &c);
+    }
+    if (rc == TACOZ_OK && rec == SIZE_MAX) rec = emit_new(e, &ne);
+
+    uint32_t crc;
+    if (rc == TACOZ_OK) rc = put_data(e->fd, src, &ne, &crc);
+    if (rc == TACOZ_OK) {
+        le32(e->out + rec + 16, crc);
+        for (unsigned i = 0; e->ghost && i < e->ghost->count; i++) {
+            if (!follow[i]) continue;
+            e->ghost->slots[i].offset = ne.lfh_off + TACOZ_LFH_TOTAL(name_len);
+            e->ghost->slots[i].length = ne.size;
+        }
+        rc = edit_commit(e, cd_off, drop, NULL);
+    }
+
+    if (src >= 0) tacoz_close(src);
+    edit_close(e);
+    free(k.unit);
+    return rc;
+}
+
+int tacozip_put_file(const char *zip_path, const char *arc_name, const char *src_path) {
+    return tacoz_put_file(zip_path, arc_name, src_path, 0);
+}
+
+int tacozip_rename_entry(const char *zip_path, const char *old_name, const char *new_name) {
+    if (!zip_path || !old_name || !new_name) return TACOZ_ERR_PARAM;
+    size_t old_len = strlen(old_name), new_len = strlen(new_name);
+    if (new_len == 0 || new_len > 0xFFFFu || strcmp(old_name, TACO_GHOST_NAME) == 0 ||
+        strcmp(new_name, TACO_GHOST_NAME) == 0)
+        return TACOZ_ERR_PARAM;
+
+    compact_t k;
+    memset(&k, 0, sizeof(k));
+    edit_t *e = &k.e;
+    int rc = edit_open(e, zip_path, new_len + TACOZ_CDH_EXTRA_SIZE, EDIT_WRITE);
+    int sorted = e->ghost && (e->ghost->flags & TACO_GHOST_F_CD_SORTED);
+
+    /* First pass: find the entry and make sure the new name is free. */
+    size_t off = 0, from = SIZE_MAX;
+    tacoz_cdh_t c, src;
+    for (uint64_t i = 0; rc == TACOZ_OK && i < e->tail.entries; i++) {
+        size_t len = rec_at(e, off, &c);
+        if (len == 0) {
+            rc = TACOZ_ERR_INVALID_GHOST;
+            break;
+        }
+        if (!is_ghost(&c)) {
+            if (name_cmp(c.name, c.name_len, new_name, new_len) == 0)
+                rc = strcmp(old_name, new_name) == 0 ? TACOZ_OK : TACOZ_ERR_PARAM;
+            if (from == SIZE_MAX && name_cmp(c.name, c.name_len, old_name, old_len) == 0) {
+                from = off;
+                src = c;
+            }
+        }
+        off += len;
+    }
+    if (rc == TACOZ_OK && from == SIZE_MAX) rc = TACOZ_ERR_NOT_FOUND;
+    if (rc != TACOZ_OK || strcmp(old_name, new_name) == 0) {
+        edit_close(e);
+        return rc;
+    }
+
+    /* A header the new name does not fit moves with its data to the best
+     * hole or the end, as a put would place them. */
+    unsigned char *lfh = NULL, *rec = NULL;
+    size_t lfh_len = 0, rec_len = 0;
+    int moved = 0, follow[TACO_GHOST_V2_MAX_SLOTS] = {0};
+    uint32_t drop = 0;
+    uint64_t lfh_off = src.lfh_off, cd_off = e->tail.cd_off;
+    unit_t busy;
+    rc = renamed_lfh(e->fd, &src, new_name, new_len, &lfh, &lfh_len, &moved);
+    if (rc == TACOZ_OK && e->ghost)
+        rc = drop_tables(e, moved ? TACOZ_TABLE_NAMES | TACOZ_TABLE_IDS : TACOZ_TABLE_NAMES);
+    if (rc == TACOZ_OK && moved) rc = entry_extent(e, &src, &busy);
+    if (rc == TACOZ_OK && moved && e->ghost) release_slots(e, &src, &busy, follow, &drop);
+    if (rc == TACOZ_OK && moved) rc = collect_units(&k, src.lfh_off);
+    if (rc == TACOZ_OK && moved) lfh_off = place(&k, lfh_len + src.csize, &busy, &cd_off);
+    if (rc == TACOZ_OK && !(rec = renamed_rec(&src, new_name, new_len, lfh_off, &rec_len)))
+        rc = TACOZ_ERR_IO;
+
+    /* Second pass: copy the records, the renamed one where its new name
+     * sorts when the directory is sorted, else where it was. */
+    int placed = 0;
+    off = 0;
+    for (uint64_t i = 0; rc == TACOZ_OK && i < e->tail.entries; i++) {
+        off += rec_at(e, off, &c);
+        if (c.cdh_off == from) {
+            if (!sorted) {
+                emit_raw(e, rec, rec_len);
+                placed = 1;
+            }
+            continue;
+        }
+        if (sorted && !placed && !is_ghost(&c) &&
+            name_cmp(c.name, c.name_len, new_name, new_len) > 0) {
+            emit_raw(e, rec, rec_len);
+            placed = 1;
+        }
+        emit(e, &c);
+    }
+    if (rc == TACOZ_OK && !placed) emit_raw(e, rec, rec_len);
+
+    /* A moved entry is copied before the directory points at it; one that
+     * stays gets its header rewritten after. */
+    if (rc == TACOZ_OK && moved) {
+        rc = tacoz_pwrite_all(e->fd, lfh, lfh_len, lfh_off);
+        if (rc == TACOZ_OK)
+            rc = tacoz_move_down(e->fd, busy.end - src.csize, lfh_off + lfh_len, src.csize);
+        for (unsigned i = 0; e->ghost && i < e->ghost->count; i++) {
+            if (!follow[i]) continue;
+            e->ghost->slots[i].offset = lfh_off + lfh_len;
+            e->ghost->slots[i].length = src.csize;
+        }
+    }
+    if (rc == TACOZ_OK) rc = edit_commit(e, cd_off, drop, NULL);
+    if (rc == TACOZ_OK && !moved) rc = tacoz_pwrite_all(e->fd, lfh, lfh_len, lfh_off);
+    free(lfh);
+    free(rec);
+    edit_close(e);
+    free(k.unit);
+    return rc;
+}
+
+/* --------------------------- Append-only commits ---------------------------- */
+
+typedef struct {
+    const char      *src;    /* NULL: the entry leaves the directory */
+    tacoz_cd_entry_t ne;     /* name; placement, size and CRC once written */
+    int              found;
+} log_item_t;
+
+static int log_item_cmp(const void *a, const void *b) {
+    const log_item_t *x = (const log_item_t *)a, *y = (const log_item_t *)b;
+    return name_cmp(x->ne.name, x->ne.name_len, y->ne.name, y->ne.name_len);
+}
+
+static log_item_t *log_find(log_item_t *it, size_t n, const tacoz_cdh_t *c) {
+    log_item_t key;
+    key.ne.name = c->name;
+    key.ne.name_len = c->name_len;
+    return bsearch(&key, it, n, sizeof(*it), log_item_cmp);
+}
+
+/** Append the data of every item with a source at @p *pos, in name order. */
+static int log_append(int fd, log_item_t *it, size_t n, uint64_t *pos) {
+    for (size_t i = 0; i < n; i++) {
+        if (!it[i].src) continue;
+        tacoz_filestat_t st;
+        int src = tacoz_open_read(it[i].src);
+        int rc = src >= 0 && tacoz_fstat(src, &st) == TACOZ_OK && st.is_regular
+               ? TACOZ_OK : TACOZ_ERR_IO;
+        if (rc == TACOZ_OK) {
+            it[i].ne.lfh_off = *pos;
+            it[i].ne.size    = st.size;
+            it[i].ne.mode    = st.mode;
+            it[i].ne.dostime = tacoz_dostime(st.mtime);
+            rc = put_data(fd, src, &it[i].ne, &it[i].ne.crc);
+        }
+        if (src >= 0) tacoz_close(src);
+        if (rc != TACOZ_OK) return rc;
+        *pos += TACOZ_LFH_TOTAL(it[i].ne.name_len) + it[i].ne.size;
+    }
+    return TACOZ_OK;
+}
+
+/**
+ * The directory of the new version: the old records minus those the commit
+ * supersedes, plus the committed ones, which take the old record's place,
+ * or merge in name order when the directory is sorted. New names go last
+ * otherwise.
+ */
+static void log_directory(edit_t *e, log_item_t *it, size_t n) {
+    int sorted = (e->ghost->flags & TACO_GHOST_F_CD_SORTED) != 0;
+    size_t next = 0, off = 0;
+    for (uint64_t i = 0; i < e->tail.entries; i++) {
+        tacoz_cdh_t c;
+        off += rec_at(e, off, &c);
+        if (is_ghost(&c)) {
+            emit(e, &c);
+            continue;
+        }
+        for (; sorted && next < n &&
+               name_cmp(it[next].ne.name, it[next].ne.name_len, c.name, c.name_len) < 0; next++)
+            if (it[next].src) emit_new(e, &it[next].ne);
+        log_item_t *hit = log_find(it, n, &c);
+        if (!hit) emit(e, &c);
+        else if (!sorted && hit->src) emit_new(e, &hit->ne);
+    }
+    for (size_t i = sorted ? next : 0; i < n; i++)
+        if (it[i].src && (sorted || !it[i].found)) emit_new(e, &it[i].ne);
+}
+
+int tacozip_log_commit(const char *zip_path, const char * const *src_paths,
+                       const char * const *arc_names, size_t count, int durability,
+                       tacozip_log_version_t *out) {
+    if (durability == TACOZIP_DURABLE_DEFAULT) durability = TACOZ_DURABILITY;
+    if (!zip_path || (count && (!src_paths || !arc_names)) ||
+        durability < TACOZIP_DURABLE_NONE || durability > TACOZIP_DURABLE_FULL)
+        return TACOZ_ERR_PARAM;
+    if (count == 0) return TACOZ_OK;
+    if (count > SIZE_MAX / sizeof(log_item_t)) return TACOZ_ERR_PARAM;
+
+    log_item_t *it = calloc(count, sizeof(*it));
+    if (!it) return TACOZ_ERR_IO;
+    size_t grow = 0;
+    int rc = TACOZ_OK;
+    for (size_t i = 0; rc == TACOZ_OK && i < count; i++) {
+        size_t len = arc_names[i] ? strlen(arc_names[i]) : 0;
+        if (len == 0 || len > 0xFFFFu || strcmp(arc_names[i], TACO_GHOST_NAME) == 0 ||
+            grow > SIZE_MAX - TACOZ_CDH_TOTAL(len)) {
+            rc = TACOZ_ERR_PARAM;
+            break;
+        }
+        it[i].src = src_paths[i];
+        it[i].ne.name = arc_names[i];
+        it[i].ne.name_len = (uint16_t)len;
+        grow += TACOZ_CDH_TOTAL(len);
+    }
+    qsort(it, count, sizeof(*it), log_item_cmp);
+    for (size_t i = 1; rc == TACOZ_OK && i < count; i++)
+        if (log_item_cmp(&it[i - 1], &it[i]) == 0) rc = TACOZ_ERR_PARAM;
+    if (rc != TACOZ_OK) {
+        free(it);
+        return rc;
+    }
+
+    edit_t e;
+    rc = edit_open(&e, zip_path, grow, EDIT_LOG);
+    e.durability = durability;
+    if (rc == TACOZ_OK && (!e.ghost || e.ghost->version != 2)) rc = TACOZ_ERR_PARAM;
+
+    /* Superseded entries let go of the ghost's slots; a slot that held one's
+     * data exactly moves to the new copy. */
+    size_t target[TACO_GHOST_V2_MAX_SLOTS];
+    for (unsigned s = 0; s < TACO_GHOST_V2_MAX_SLOTS; s++) target[s] = SIZE_MAX;
+    uint32_t drop = 0;
+    size_t off = 0;
+    for (uint64_t i = 0; rc == TACOZ_OK && i < e.tail.entries; i++) {
+        tacoz_cdh_t c;
+        size_t len = rec_at(&e, off, &c);
+        if (len == 0) {
+            rc = TACOZ_ERR_INVALID_GHOST;
+            break;
+        }
+        off += len;
+        log_item_t *hit = is_ghost(&c) ? NULL : log_find(it, count, &c);
+        if (!hit) continue;
+        hit->found = 1;
+
+        unit_t busy;
+        int follow[TACO_GHOST_V2_MAX_SLOTS] = {0};
+        rc = entry_extent(&e, &c, &busy);
+        if (rc == TACOZ_OK) release_slots(&e, &c, &busy, follow, &drop);
+        for (unsigned s = 0; s < TACO_GHOST_V2_MAX_SLOTS; s++)
+            if (follow[s]) target[s] = (size_t)(hit - it);
+    }
+    for (size_t i = 0; rc == TACOZ_OK && i < count; i++)
+        if (!it[i].src && !it[i].found) rc = TACOZ_ERR_NOT_FOUND;
+    if (rc == TACOZ_OK) rc = drop_tables(&e, TACOZ_TABLE_NAMES | TACOZ_TABLE_IDS);
+
+    /* New data and directory go after the head's tail; nothing before it is
+     * written, so every older directory stays as it was. */
+    uint64_t cd_off = e.end;
+    if (rc == TACOZ_OK) rc = log_append(e.fd, it, count, &cd_off);
+
+    tacoz_log_rec_t log, prev;
+    if (rc == TACOZ_OK) {
+        int has = tacoz_log_record(e.fd, &e.tail, &prev);
+        if (has < 0) rc = has;
+        log.generation = e.ghost->generation + 1;  /* what tacoz_ghost_write() stores */
+        log.prev_end   = e.end;
+        log.prev_gen   = has > 0 ? prev.generation : e.ghost->generation;
+    }
+    if (rc == TACOZ_OK) {
+        log_directory(&e, it, count);
+        for (unsigned s = 0; s < e.ghost->count; s++) {
+            const log_item_t *t = target[s] != SIZE_MAX ? &it[target[s]] : NULL;
+            if (!t || !t->src) continue;
+            e.ghost->slots[s].offset = t->ne.lfh_off + TACOZ_LFH_TOTAL(t->ne.name_len);
+            e.ghost->slots[s].length = t->ne.size;
+        }
+        rc = edit_commit(&e, cd_off, drop, &log);
+    }
+    if (rc == TACOZ_OK && out) {
+        out->generation = log.generation;
+        out->cd_offset  = cd_off;
+        out->cd_size    = e.out_len;
+        out->cd_entries = e.entries;
+        out->end        = cd_off + e.out_len + TACOZ_TAIL_SIZE + TACOZ_LOG_REC_SIZE;
+    }
+
+    edit_close(&e);
+    free(it);
+    return rc;
+}
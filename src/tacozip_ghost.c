@@ -0,0 +1,338 @@
+/*
+ * tacozip_ghost.c — TACO Ghost payload encoding and decoding.
+ *
+ * Shared by the libzip-backed entry points in tacozip.c and by the native
+ * streaming writer in tacozip_writer.c.
+ */
+
+#include "tacozip_internal.h"
+#include <string.h>
+
+/* ----------------------- Multi-parquet helper functions -------------------- */
+
+/**
+ * @brief Count valid metadata entries by scanning until first (0,0) pair.
+ * @param offsets Array of 7 offset values
+ * @param lengths Array of 7 length values
+ * @return Number of valid entries (0-7)
+ */
+uint8_t tacoz_count_valid_entries(const uint64_t *offsets, const uint64_t *lengths) {
+    for (size_t i = 0; i < TACO_GHOST_MAX_ENTRIES; i++) {
+        if (offsets[i] == 0 && lengths[i] == 0) {
+            return (uint8_t)i;  /* Found first (0,0) pair */
+        }
+    }
+    return TACO_GHOST_MAX_ENTRIES;  /* All 7 entries are valid */
+}
+
+/**
+ * @brief Convert arrays to taco_meta_array_t structure.
+ * @param offsets Input array of 7 offset values
+ * @param lengths Input array of 7 length values
+ * @param out Output structure
+ */
+void tacoz_arrays_to_meta(const uint64_t *offsets, const uint64_t *lengths, taco_meta_array_t *out) {
+    out->count = tacoz_count_valid_entries(offsets, lengths);
+    for (size_t i = 0; i < TACO_GHOST_MAX_ENTRIES; i++) {
+        out->entries[i].offset = offsets[i];
+        out->entries[i].length = lengths[i];
+    }
+}
+
+/**
+ * @brief Convert taco_meta_array_t structure to arrays.
+ * @param meta Input structure
+ * @param offsets Output array of 7 offset values
+ * @param lengths Output array of 7 length values
+ */
+void tacoz_meta_to_arrays(const taco_meta_array_t *meta, uint64_t *offsets, uint64_t *lengths) {
+    for (size_t i = 0; i < TACO_GHOST_MAX_ENTRIES; i++) {
+        offsets[i] = meta->entries[i].offset;
+        lengths[i] = meta->entries[i].length;
+    }
+}
+
+/* ---------------------------- Ghost payload creator ------------------------ */
+/**
+ * @brief Create ghost payload from metadata structure.
+ * @param meta Input metadata structure
+ * @param payload Output buffer (must be at least TACO_GHOST_PAYLOAD_SIZE bytes)
+ */
+void tacoz_create_ghost_payload(const taco_meta_array_t *meta, unsigned char *payload) {
+    memset(payload, 0, TACO_GHOST_PAYLOAD_SIZE);
+
+    /* Count byte + 3 padding bytes for alignment */
+    payload[0] = meta->count;
+    payload[1] = payload[2] = payload[3] = 0;  /* padding */
+
+    /* 7 pairs of (offset, length) - 112 bytes total */
+    unsigned char *pairs_start = payload + 4;
+    for (size_t i = 0; i < TACO_GHOST_MAX_ENTRIES; i++) {
+        le64(pairs_start + i * 16 + 0, meta->entries[i].offset);
+        le64(pairs_start + i * 16 + 8, meta->entries[i].length);
+    }
+}
+
+/* ---------------------------- Ghost payload parser ------------------------- */
+/**
+ * @brief Parse ghost payload into metadata structure.
+ * @param payload Input buffer (must be at least TACO_GHOST_PAYLOAD_SIZE bytes)
+ * @param meta Output metadata structure
+ * @return TACOZ_OK on success, TACOZ_ERR_INVALID_GHOST on error
+ */
+int tacoz_parse_ghost_payload(const unsigned char *payload, taco_meta_array_t *meta) {
+    memset(meta, 0, sizeof(*meta));
+
+    /* Read count byte */
+    meta->count = payload[0];
+    if (meta->count > TACO_GHOST_MAX_ENTRIES) return TACOZ_ERR_INVALID_GHOST;
+
+    /* Read all 7 pairs (even unused ones) */
+    const unsigned char *pairs_start = payload + 4;
+    for (size_t i = 0; i < TACO_GHOST_MAX_ENTRIES; i++) {
+        meta->entries[i].offset = le64_read(pairs_start + i * 16 + 0);
+        meta->entries[i].length = le64_read(pairs_start + i * 16 + 8);
+    }
+
+    return TACOZ_OK;
+}
+
+/* ------------------------------- Ghost v2 ---------------------------------- */
+
+void tacoz_ghost_from_meta(const taco_meta_array_t *meta, taco_ghost_t *g) {
+    memset(g, 0, sizeof(*g));
+    g->version = 1;
+    g->count = meta->count;
+    for (size_t i = 0; i < meta->count && i < TACO_GHOST_MAX_ENTRIES; i++)
+        g->slots[i] = meta->entries[i];
+}
+
+void tacoz_ghost_to_meta(const taco_ghost_t *g, taco_meta_array_t *meta) {
+    memset(meta, 0, sizeof(*meta));
+    size_t n = g->count < TACO_GHOST_MAX_ENTRIES ? g->count : TACO_GHOST_MAX_ENTRIES;
+    meta->count = (uint8_t)n;
+    for (size_t i = 0; i < n; i++) meta->entries[i] = g->slots[i];
+}
+
+/** Inline record header: uint8 slot, 3 reserved bytes, uint32 length. */
+#define TACOZ_INLINE_REC_HDR 8u
+#define TACOZ_INLINE_REC(len) (TACOZ_INLINE_REC_HDR + (((size_t)(len) + 7u) & ~(size_t)7u))
+
+/** @brief Encoded size of the inline region of @p g (0 when it has no copies). */
+size_t tacoz_ghost_inline_size(const taco_ghost_t *g) {
+    size_t n = 0;
+    for (size_t i = 0; i < g->count; i++)
+        if (g->inline_len[i]) n += TACOZ_INLINE_REC(g->inline_len[i]);
+    return n;
+}
+
+/** @brief Bytes of the slot checksum table of @p g (0 without TACO_GHOST_F_SLOT_CRC). */
+static size_t crc_table_size(const taco_ghost_t *g) {
+    return (g->flags & TACO_GHOST_F_SLOT_CRC) ? TACO_GHOST_V2_CRC_SIZE(g->count) : 0;
+}
+
+/** @brief v2 header bytes of @p g (the uniform fields extend it). */
+static size_t header_size(const taco_ghost_t *g) {
+    return TACO_GHOST_V2_HEADER_SIZE + ((g->flags & TACO_GHOST_F_UNIFORM) ? TACO_GHOST_V2_UNIFORM_SIZE : 0);
+}
+
+size_t tacoz_ghost_used(const taco_ghost_t *g, int version) {
+    return version == 1 ? TACO_GHOST_PAYLOAD_SIZE
+                        : header_size(g) + 16u * (size_t)g->count + crc_table_size(g) +
+                          tacoz_ghost_inline_size(g);
+}
+
+void tacoz_ghost_keep_layout(taco_ghost_t *g, const unsigned char *head, size_t len) {
+    g->flags &= ~TACOZ_GHOST_LAYOUT_FLAGS;
+    g->uniform_base = g->uniform_stride = g->uniform_size = g->uniform_count = 0;
+    if (len < 12 || memcmp(head, TACO_GHOST_V2_MAGIC, 4) != 0) return;
+
+    uint32_t flags = le32_read(head + 8) & TACOZ_GHOST_LAYOUT_FLAGS;
+    if ((flags & TACO_GHOST_F_UNIFORM) &&
+        (len < TACO_GHOST_V2_HEADER_SIZE + TACO_GHOST_V2_UNIFORM_SIZE ||
+         le16_read(head + 6) < TACO_GHOST_V2_HEADER_SIZE + TACO_GHOST_V2_UNIFORM_SIZE))
+        flags &= ~TACO_GHOST_F_UNIFORM;
+    g->flags |= flags;
+    if (flags & TACO_GHOST_F_UNIFORM) {
+        g->uniform_base   = le64_read(head + 64);
+        g->uniform_stride = le64_read(head + 72);
+        g->uniform_size   = le64_read(head + 80);
+        g->uniform_count  = le64_read(head + 88);
+    }
+}
+
+uint64_t tacoz_ghost_generation(const unsigned char *buf, size_t len) {
+    if (len < TACO_GHOST_V2_HEADER_SIZE || memcmp(buf, TACO_GHOST_V2_MAGIC, 4) != 0) return 0;
+    return le64_read(buf + 56);
+}
+
+int tacoz_ghost_add_inline(taco_ghost_t *g, unsigned slot, const void *data, uint32_t len) {
+    if (slot >= g->count || len == 0 || len != g->slots[slot].length ||
+        g->inline_len[slot] != 0)
+        return TACOZ_ERR_PARAM;
+    if (tacoz_ghost_inline_size(g) + TACOZ_INLINE_REC(len) > TACO_GHOST_INLINE_MAX)
+        return TACOZ_ERR_PARAM;
+
+    memcpy(g->inline_data + g->inline_used, data, len);
+    g->inline_off[slot] = g->inline_used;
+    g->inline_len[slot] = len;
+    g->inline_used += len;
+    return TACOZ_OK;
+}
+
+/**
+ * @brief Encode @p g into exactly @p size bytes (the stored payload size).
+ * @return TACOZ_OK, or TACOZ_ERR_PARAM if the slots do not fit.
+ */
+int tacoz_ghost_encode(const taco_ghost_t *g, int version, unsigned char *buf, size_t size) {
+    if (g->count > TACO_GHOST_V2_MAX_SLOTS) return TACOZ_ERR_PARAM;
+
+    if (version == 1) {
+        if (size != TACO_GHOST_PAYLOAD_SIZE || g->count > TACO_GHOST_MAX_ENTRIES)
+            return TACOZ_ERR_PARAM;
+        taco_meta_array_t meta;
+        tacoz_ghost_to_meta(g, &meta);
+        tacoz_create_ghost_payload(&meta, buf);
+        return TACOZ_OK;
+    }
+
+    size_t inl = tacoz_ghost_inline_size(g);
+    size_t used = tacoz_ghost_used(g, 2);
+    size_t hdr = header_size(g);
+    if (used > size || size > UINT32_MAX || inl > TACO_GHOST_INLINE_MAX) return TACOZ_ERR_PARAM;
+
+    memset(buf, 0, size);
+    memcpy(buf, TACO_GHOST_V2_MAGIC, 4);
+    le16(buf +  4, TACO_GHOST_V2_VERSION);
+    le16(buf +  6, (uint16_t)hdr);
+    le32(buf +  8, g->flags);
+    le16(buf + 12, g->count);
+    le32(buf + 16, (uint32_t)size);
+    le32(buf + 20, (uint32_t)used);
+    le32(buf + 24, inl ? (uint32_t)(hdr + 16u * g->count + crc_table_size(g)) : 0);
+    le32(buf + 28, (uint32_t)inl);
+    le64(buf + 32, g->cd_offset);
+    le64(buf + 40, g->cd_size);
+    le64(buf + 48, g->cd_entries);
+    le64(buf + 56, g->generation);
+    if (g->flags & TACO_GHOST_F_UNIFORM) {
+        le64(buf + 64, g->uniform_base);
+        le64(buf + 72, g->uniform_stride);
+        le64(buf + 80, g->uniform_size);
+        le64(buf + 88, g->uniform_count);
+    }
+
+    unsigned char *slot = buf + hdr;
+    for (size_t i = 0; i < g->count; i++, slot += 16) {
+        le64(slot + 0, g->slots[i].offset);
+        le64(slot + 8, g->slots[i].length);
+    }
+
+    /* Checksums, then inline copies in slot order, follow the slot table. */
+    if (g->flags & TACO_GHOST_F_SLOT_CRC)
+        for (size_t i = 0; i < g->count; i++) le32(slot + 4 * i, g->slot_crc[i]);
+    unsigned char *rec = slot + crc_table_size(g);
+    for (size_t i = 0; i < g->count; i++) {
+        uint32_t len = g->inline_len[i];
+        if (!len) continue;
+        if (len != g->slots[i].length || (size_t)g->inline_off[i] + len > g->inline_used ||
+            g->inline_used > TACO_GHOST_INLINE_MAX)
+            return TACOZ_ERR_PARAM;
+        rec[0] = (unsigned char)i;
+        le32(rec + 4, len);
+        memcpy(rec + TACOZ_INLINE_REC_HDR, g->inline_data + g->inline_off[i], len);
+        rec += TACOZ_INLINE_REC(len);
+    }
+    return TACOZ_OK;
+}
+
+/** Decode the inline region at @p p (@p n bytes) into @p g. */
+static int decode_inline(const unsigned char *p, size_t n, taco_ghost_t *g) {
+    if (n > TACO_GHOST_INLINE_MAX) return TACOZ_ERR_INVALID_GHOST;
+    size_t at = 0;
+    while (at < n) {
+        if (n - at < TACOZ_INLINE_REC_HDR) return TACOZ_ERR_INVALID_GHOST;
+        unsigned slot = p[at];
+        uint32_t len = le32_read(p + at + 4);
+        if (slot >= g->count || len == 0 || len != g->slots[slot].length ||
+            g->inline_len[slot] != 0 || TACOZ_INLINE_REC(len) > n - at)
+            return TACOZ_ERR_INVALID_GHOST;
+        memcpy(g->inline_data + g->inline_used, p + at + TACOZ_INLINE_REC_HDR, len);
+        g->inline_off[slot] = g->inline_used;
+        g->inline_len[slot] = len;
+        g->inline_used += len;
+        at += TACOZ_INLINE_REC(len);
+    }
+    return TACOZ_OK;
+}
+
+/** @brief Bytes of a payload needed to decode it (header must be present for v2). */
+size_t tacoz_ghost_need(const unsigned char *buf, size_t len) {
+    if (len < 4) return TACO_GHOST_V2_HEADER_SIZE;
+    if (memcmp(buf, TACO_GHOST_V2_MAGIC, 4) != 0) return TACO_GHOST_PAYLOAD_SIZE;
+    if (len < TACO_GHOST_V2_HEADER_SIZE) return TACO_GHOST_V2_HEADER_SIZE;
+    return le32_read(buf + 20);
+}
+
+/**
+ * @brief Decode a v1 or v2 payload; @p len may be less than the stored size
+ *        as long as it covers tacoz_ghost_need() bytes.
+ */
+int tacoz_ghost_decode(const unsigned char *buf, size_t len, taco_ghost_t *g) {
+    memset(g, 0, sizeof(*g));
+
+    if (len >= 4 && memcmp(buf, TACO_GHOST_V2_MAGIC, 4) == 0) {
+        if (len < TACO_GHOST_V2_HEADER_SIZE) return TACOZ_ERR_INVALID_GHOST;
+        uint16_t version = le16_read(buf + 4);
+        uint16_t hdr     = le16_read(buf + 6);
+        uint16_t count   = le16_read(buf + 12);
+        uint32_t used    = le32_read(buf + 20);
+        if (version != TACO_GHOST_V2_VERSION || hdr < TACO_GHOST_V2_HEADER_SIZE ||
+            count > TACO_GHOST_V2_MAX_SLOTS || used > len ||
+            (uint64_t)hdr + 16u * (uint64_t)count > used)
+            return TACOZ_ERR_INVALID_GHOST;
+
+        if (le16_read(buf + TACOZ_GHOST_SEQ_OFF_V2) & 1u) return TACOZ_ERR_BUSY;
+
+        g->version = 2;
+        g->flags = le32_read(buf + 8);
+        g->count = count;
+        g->cd_offset  = le64_read(buf + 32);
+        g->cd_size    = le64_read(buf + 40);
+        g->cd_entries = le64_read(buf + 48);
+        g->generation = le64_read(buf + 56);
+        if (g->flags & TACO_GHOST_F_UNIFORM) {
+            if (hdr < TACO_GHOST_V2_HEADER_SIZE + TACO_GHOST_V2_UNIFORM_SIZE)
+                return TACOZ_ERR_INVALID_GHOST;
+            g->uniform_base   = le64_read(buf + 64);
+            g->uniform_stride = le64_read(buf + 72);
+            g->uniform_size   = le64_read(buf + 80);
+            g->uniform_count  = le64_read(buf + 88);
+        }
+        const unsigned char *slot = buf + hdr;
+        for (size_t i = 0; i < count; i++, slot += 16) {
+            g->slots[i].offset = le64_read(slot + 0);
+            g->slots[i].length = le64_read(slot + 8);
+        }
+        if (g->flags & TACO_GHOST_F_SLOT_CRC) {
+            if ((uint64_t)hdr + 16u * count + crc_table_size(g) > used)
+                return TACOZ_ERR_INVALID_GHOST;
+            for (size_t i = 0; i < count; i++) g->slot_crc[i] = le32_read(slot + 4 * i);
+        }
+
+        uint32_t inl_off = le32_read(buf + 24), inl_size = le32_read(buf + 28);
+        if (inl_size == 0) return TACOZ_OK;
+        if (inl_off < (uint64_t)hdr + 16u * count + crc_table_size(g) ||
+            (uint64_t)inl_off + inl_size > used)
+            return TACOZ_ERR_INVALID_GHOST;
+        return decode_inline(buf + inl_off, inl_size, g);
+    }
+
+    if (len < TACO_GHOST_PAYLOAD_SIZE) return TACOZ_ERR_INVALID_GHOST;
+    if (le16_read(buf + TACOZ_GHOST_SEQ_OFF_V1) & 1u) return TACOZ_ERR_BUSY;
+    taco_meta_array_t meta;
+    int rc = tacoz_parse_ghost_payload(buf, &meta);
+    if (rc != TACOZ_OK) return rc;
+    tacoz_ghost_from_meta(&meta, g);
+    return TACOZ_OK;
+}
@@ -0,0 +1,142 @@
+/*
+ * tacozip_idtable.c — entry-ID offset tables.
+ *
+ * The table locates the data and gives the size of every entry in insertion
+ * order, in fixed-width records, so entry i is found by arithmetic: one
+ * record read, then the data read. See "ID table entry layout" in tacozip.h.
+ */
+
+#include "tacozip_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* -------------------------------- Building --------------------------------- */
+
+typedef struct {
+    unsigned char *rec;
+    uint64_t       base;  /* data offset of the table itself */
+} fill_t;
+
+static int fill_visit(void *ctx, const tacoz_cd_entry_t *e) {
+    fill_t *f = (fill_t *)ctx;
+    le64(f->rec + 0, f->base - (e->lfh_off + TACOZ_LFH_TOTAL(e->name_len)));
+    le64(f->rec + 8, e->size);
+    f->rec += TACO_ID_TABLE_RECORD_SIZE;
+    return TACOZ_OK;
+}
+
+int tacoz_idtable_build(tacoz_cdstore_t *cd, uint64_t base,
+                        unsigned char **out, size_t *out_len) {
+    *out = NULL;
+    *out_len = 0;
+
+    uint64_t n = tacoz_cdstore_count(cd);
+    if (n > (SIZE_MAX - TACO_ID_TABLE_HEADER_SIZE) / TACO_ID_TABLE_RECORD_SIZE) return TACOZ_ERR_IO;
+    size_t len = TACO_ID_TABLE_HEADER_SIZE + (size_t)n * TACO_ID_TABLE_RECORD_SIZE;
+
+    unsigned char *buf = calloc(1, len);
+    if (!buf) return TACOZ_ERR_IO;
+    memcpy(buf, TACO_ID_TABLE_MAGIC, 4);
+    le16(buf + 4, TACO_ID_TABLE_VERSION);
+    le16(buf + 6, TACO_ID_TABLE_HEADER_SIZE);
+    le32(buf + 8, TACO_ID_TABLE_RECORD_SIZE);
+    le64(buf + 16, n);
+
+    fill_t f = { buf + TACO_ID_TABLE_HEADER_SIZE, base };
+    int rc = tacoz_cdstore_foreach(cd, fill_visit, &f);
+    if (rc != TACOZ_OK) {
+        free(buf);
+        return rc;
+    }
+    *out = buf;
+    *out_len = len;
+    return TACOZ_OK;
+}
+
+/* -------------------------------- Lookups ---------------------------------- */
+
+static int parse_hdr(const unsigned char *p, size_t len, uint64_t *count) {
+    if (len < TACO_ID_TABLE_HEADER_SIZE || memcmp(p, TACO_ID_TABLE_MAGIC, 4) != 0 ||
+        le16_read(p + 4) != TACO_ID_TABLE_VERSION ||
+        le16_read(p + 6) != TACO_ID_TABLE_HEADER_SIZE ||
+        le32_read(p + 8) != TACO_ID_TABLE_RECORD_SIZE)
+        return TACOZ_ERR_INVALID_GHOST;
+    *count = le64_read(p + 16);
+    return TACOZ_OK;
+}
+
+/** Decode record @p r of a table whose data starts at @p base. */
+static int record(const unsigned char *r, uint64_t base, uint64_t *offset, uint64_t *length) {
+    uint64_t back = le64_read(r);
+    if (back == 0 || back > base) return TACOZ_ERR_INVALID_GHOST;
+    *offset = base - back;
+    *length = le64_read(r + 8);
+    return TACOZ_OK;
+}
+
+int tacozip_id_table_get(const void *table, size_t len, uint64_t table_offset,
+                         uint64_t id, uint64_t *offset, uint64_t *length) {
+    if (!table || !offset || !length) return TACOZ_ERR_PARAM;
+    const unsigned char *p = (const unsigned char *)table;
+    uint64_t n;
+    int rc = parse_hdr(p, len, &n);
+    if (rc != TACOZ_OK) return rc;
+    if (id >= n) return TACOZ_ERR_NOT_FOUND;
+    if (id >= (len - TACO_ID_TABLE_HEADER_SIZE) / TACO_ID_TABLE_RECORD_SIZE)
+        return TACOZ_ERR_INVALID_GHOST;  /* truncated image */
+
+    return record(p + TACO_ID_TABLE_RECORD_OFFSET(id), table_offset, offset, length);
+}
+
+/** Record @p id of the table at ghost slot @p slot of an open archive. */
+static int locate(const char *zip_path, int fd, unsigned slot, uint64_t id,
+                  uint64_t *offset, uint64_t *length) {
+    taco_ghost_t *g = malloc(sizeof(*g));
+    if (!g) return TACOZ_ERR_IO;
+    int rc = tacozip_read_ghost_v2(zip_path, g);
+    uint64_t base = 0, size = 0;
+    if (rc == TACOZ_OK && slot >= g->count) rc = TACOZ_ERR_PARAM;
+    if (rc == TACOZ_OK) {
+        base = g->slots[slot].offset;
+        size = g->slots[slot].length;
+    }
+    free(g);
+    if (rc != TACOZ_OK) return rc;
+
+    /* The count is checked against the slot length, so the header need not
+     * be read first: one record read per lookup. */
+    unsigned char rec[TACO_ID_TABLE_RECORD_SIZE];
+    if (size < TACO_ID_TABLE_HEADER_SIZE) return TACOZ_ERR_INVALID_GHOST;
+    if (id >= (size - TACO_ID_TABLE_HEADER_SIZE) / TACO_ID_TABLE_RECORD_SIZE)
+        return TACOZ_ERR_NOT_FOUND;
+    rc = tacoz_pread_all(fd, rec, sizeof(rec), base + TACO_ID_TABLE_RECORD_OFFSET(id));
+    return rc == TACOZ_OK ? record(rec, base, offset, length) : rc;
+}
+
+int tacozip_locate_by_id(const char *zip_path, unsigned slot, uint64_t id,
+                         uint64_t *offset, uint64_t *length) {
+    if (!zip_path || !offset || !length || slot >= TACO_GHOST_V2_MAX_SLOTS) return TACOZ_ERR_PARAM;
+    int fd = tacoz_open_read(zip_path);
+    if (fd < 0) return TACOZ_ERR_IO;
+    int rc = locate(zip_path, fd, slot, id, offset, length);
+    tacoz_close(fd);
+    return rc;
+}
+
+int tacozip_read_by_id(const char *zip_path, unsigned slot, uint64_t id,
+                       void *buf, size_t cap, uint64_t *out_len) {
+    if (!zip_path || !out_len || (!buf && cap) || slot >= TACO_GHOST_V2_MAX_SLOTS)
+        return TACOZ_ERR_PARAM;
+    int fd = tacoz_open_read(zip_path);
+    if (fd < 0) return TACOZ_ERR_IO;
+
+    uint64_t offset = 0, length = 0;
+    int rc = locate(zip_path, fd, slot, id, &offset, &length);
+    if (rc == TACOZ_OK) {
+        *out_len = length;
+        if (length > cap) rc = TACOZ_ERR_PARAM;
+        else rc = tacoz_pread_all(fd, buf, (size_t)length, offset);
+    }
+    tacoz_close(fd);
+    return rc;
+}
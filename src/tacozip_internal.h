@@ -0,0 +1,482 @@
+/*
+ * tacozip_internal.h — private helpers shared by the tacozip translation units.
+ *
+ * Nothing here is part of the public ABI. Symbols are prefixed `tacoz_` and are
+ * hidden by -fvisibility=hidden in shared builds.
+ */
+#ifndef TACOZIP_INTERNAL_H
+#define TACOZIP_INTERNAL_H
+
+#include "tacozip.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/* ------------------------------- Tunables ---------------------------------- */
+/* These can be overridden at compile time (CMake passes -D… if desired). */
+#ifndef TACOZ_COPY_BUFSZ
+#define TACOZ_COPY_BUFSZ (1u << 20)    /* 1 MiB copy buffer */
+#endif
+#ifndef TACOZ_CD_MEM_CAP
+#define TACOZ_CD_MEM_CAP (256u << 20)  /* 256 MiB resident central directory */
+#endif
+#ifndef TACOZ_OPEN_AHEAD
+#define TACOZ_OPEN_AHEAD 0u            /* sources in flight in add_files (0 = sync) */
+#endif
+#ifndef TACOZ_INGEST_BUFSZ
+#define TACOZ_INGEST_BUFSZ (128u << 10) /* io_uring read slot; larger files are streamed */
+#endif
+#ifndef TACOZ_COPY_RANGE_MIN
+#define TACOZ_COPY_RANGE_MIN (256u << 10) /* smallest slice copied in-kernel */
+#endif
+#ifndef TACOZ_UNIFORM_ALIGN
+#define TACOZ_UNIFORM_ALIGN 4096u      /* default data alignment of a uniform run */
+#endif
+#ifndef TACOZ_UNIFORM_NAME_MAX
+#define TACOZ_UNIFORM_NAME_MAX 256u    /* longest name in a uniform-stride run */
+#endif
+#ifndef TACOZ_GHOST_READ_RETRIES
+#define TACOZ_GHOST_READ_RETRIES 200u  /* ghost reads retried while an update is in flight */
+#endif
+#ifndef TACOZ_DURABILITY
+#define TACOZ_DURABILITY TACOZIP_DURABLE_NONE /* what TACOZIP_DURABLE_DEFAULT means */
+#endif
+#ifndef TACOZ_MERGE_ALIGN
+#define TACOZ_MERGE_ALIGN 4096u        /* block size shard regions keep when merged */
+#endif
+#ifndef TACOZ_COMPACT_CHUNK
+#define TACOZ_COMPACT_CHUNK (8u << 20)  /* largest single step when sliding entries down */
+#endif
+#ifndef TACOZ_HAVE_COPY_FILE_RANGE
+#define TACOZ_HAVE_COPY_FILE_RANGE 0   /* set by CMake when copy_file_range() exists */
+#endif
+#ifndef TACOZ_HAVE_IO_URING
+#define TACOZ_HAVE_IO_URING 0          /* set by CMake when <linux/io_uring.h> works */
+#endif
+#ifndef TACOZ_SET_UTF8_FLAG
+#define TACOZ_SET_UTF8_FLAG 0          /* set GP bit 11 if caller guarantees UTF-8 names */
+#endif
+
+/** Largest uniform_align (keeps the zero gap before each LFH small). */
+#define TACOZ_UNIFORM_ALIGN_MAX (1u << 16)
+
+/* ----------------------------- ZIP record layout --------------------------- */
+#define TACOZ_SIG_LFH          0x04034b50u
+#define TACOZ_SIG_CDH          0x02014b50u
+#define TACOZ_SIG_EOCD64       0x06064b50u
+#define TACOZ_SIG_EOCD64_LOC   0x07064b50u
+#define TACOZ_SIG_EOCD         0x06054b50u
+
+#define TACOZ_LFH_SIZE         30u     /* fixed part of a Local File Header      */
+#define TACOZ_CDH_SIZE         46u     /* fixed part of a Central Directory Hdr  */
+#define TACOZ_EOCD64_SIZE      56u
+#define TACOZ_EOCD64_LOC_SIZE  20u
+#define TACOZ_EOCD_SIZE        22u
+
+#define TACOZ_ZIP64_EXTRA_ID   0x0001u
+#define TACOZ_PAD_EXTRA_ID     0xa220u /* growth hint: sig, pad value, zeros   */
+#define TACOZ_PAD_EXTRA_SIG    0xa028u
+#define TACOZ_PAD_EXTRA_MIN    8u
+#define TACOZ_LFH_EXTRA_SIZE   20u     /* id+len + usize + csize                 */
+#define TACOZ_CDH_EXTRA_SIZE   28u     /* id+len + usize + csize + lfh offset    */
+
+#define TACOZ_VERSION_ZIP64    45u     /* "version needed" for ZIP64             */
+#define TACOZ_MADE_BY_UNIX     ((3u << 8) | TACOZ_VERSION_ZIP64)
+#define TACOZ_GPBIT_UTF8       (1u << 11)
+
+#define TACOZ_GPBIT_DESCRIPTOR (1u << 3)  /* sizes and CRC follow the data    */
+
+/** Mode recorded for entries that do not come from a file (buffers, the ghost). */
+#define TACOZ_DEFAULT_MODE     0100644u
+/** DOS time | date << 16 of 1980-01-01 00:00, the earliest DOS timestamp. */
+#define TACOZ_DOS_EPOCH        (((1u << 5) | 1u) << 16)
+
+/** Bytes from an entry's LFH to its first data byte (fixed for our writer). */
+#define TACOZ_LFH_TOTAL(name_len) (TACOZ_LFH_SIZE + (name_len) + TACOZ_LFH_EXTRA_SIZE)
+
+/* -------------------------- Little-endian writers -------------------------- */
+static inline void le16(unsigned char *p, uint16_t v){
+    p[0] = (unsigned char)(v     );
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static inline void le32(unsigned char *p, uint32_t v){
+    p[0] = (unsigned char)(v      );
+    p[1] = (unsigned char)(v >> 8 );
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static inline void le64(unsigned char *p, uint64_t v){
+    p[0] = (unsigned char)(v      );
+    p[1] = (unsigned char)(v >> 8 );
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+    p[4] = (unsigned char)(v >> 32);
+    p[5] = (unsigned char)(v >> 40);
+    p[6] = (unsigned char)(v >> 48);
+    p[7] = (unsigned char)(v >> 56);
+}
+
+/* -------------------------- Little-endian readers -------------------------- */
+static inline uint16_t le16_read(const unsigned char *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t le32_read(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t le64_read(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= ((uint64_t)p[i]) << (8u * i);
+    return v;
+}
+
+/* ------------------------------ Ghost payload ------------------------------ */
+/* Implemented in tacozip_ghost.c. */
+
+uint8_t tacoz_count_valid_entries(const uint64_t *offsets, const uint64_t *lengths);
+void tacoz_arrays_to_meta(const uint64_t *offsets, const uint64_t *lengths,
+                          taco_meta_array_t *out);
+void tacoz_meta_to_arrays(const taco_meta_array_t *meta,
+                          uint64_t *offsets, uint64_t *lengths);
+void tacoz_create_ghost_payload(const taco_meta_array_t *meta, unsigned char *payload);
+int  tacoz_parse_ghost_payload(const unsigned char *payload, taco_meta_array_t *meta);
+
+void   tacoz_ghost_from_meta(const taco_meta_array_t *meta, taco_ghost_t *g);
+void   tacoz_ghost_to_meta(const taco_ghost_t *g, taco_meta_array_t *meta);
+/** Encoded bytes of @p g in format @p version (1 or 2). */
+size_t tacoz_ghost_inline_size(const taco_ghost_t *g);
+size_t tacoz_ghost_used(const taco_ghost_t *g, int version);
+/** Where the write sequence lives in an encoded payload of at least 4 bytes:
+ *  the v2 reserved header field or the v1 padding after the count byte. */
+#define TACOZ_GHOST_SEQ_OFF(buf) \
+    (memcmp((buf), TACO_GHOST_V2_MAGIC, 4) == 0 ? TACOZ_GHOST_SEQ_OFF_V2 : TACOZ_GHOST_SEQ_OFF_V1)
+#define TACOZ_GHOST_SEQ_OFF_V1 2u
+#define TACOZ_GHOST_SEQ_OFF_V2 14u
+
+/** Generation of an encoded v2 payload (0 for v1 or a short buffer). */
+uint64_t tacoz_ghost_generation(const unsigned char *buf, size_t len);
+int    tacoz_ghost_add_inline(taco_ghost_t *g, unsigned slot, const void *data, uint32_t len);
+/** Flags describing the archive layout rather than the slots; only the
+ *  library sets them, and ghost updates carry them over from the archive. */
+#define TACOZ_GHOST_LAYOUT_FLAGS (TACO_GHOST_F_CD_SORTED | TACO_GHOST_F_UNIFORM)
+/** Archive payload bytes tacoz_ghost_keep_layout() looks at. */
+#define TACOZ_GHOST_LAYOUT_HEAD  (TACO_GHOST_V2_HEADER_SIZE + TACO_GHOST_V2_UNIFORM_SIZE)
+/** Replace the layout flags and uniform fields of @p g with those of the
+ *  encoded payload head @p head (cleared for v1 or a short head). */
+void   tacoz_ghost_keep_layout(taco_ghost_t *g, const unsigned char *head, size_t len);
+/** Encode into exactly @p size bytes; TACOZ_ERR_PARAM if @p g does not fit. */
+int    tacoz_ghost_encode(const taco_ghost_t *g, int version, unsigned char *buf, size_t size);
+/** Leading payload bytes tacoz_ghost_decode() needs, judged from the first @p len. */
+size_t tacoz_ghost_need(const unsigned char *buf, size_t len);
+/** Decode a v1 or v2 payload (format auto-detected). */
+int    tacoz_ghost_decode(const unsigned char *buf, size_t len, taco_ghost_t *g);
+
+/* --------------------------- Central-directory store ------------------------ */
+/* Implemented in tacozip_cdstore.c. */
+
+/** One central-directory entry as stored by the writer. */
+typedef struct {
+    uint64_t    lfh_off;
+    uint64_t    size;      /**< STORE: compressed == uncompressed. */
+    uint32_t    crc;
+    uint32_t    mode;      /**< POSIX st_mode, stored in external attributes. */
+    uint32_t    dostime;   /**< DOS time | (DOS date << 16). */
+    uint16_t    name_len;
+    const char *name;      /**< Not NUL-terminated. */
+} tacoz_cd_entry_t;
+
+typedef struct tacoz_cdstore tacoz_cdstore_t;
+typedef int (*tacoz_cd_visit_fn)(void *ctx, const tacoz_cd_entry_t *e);
+
+int      tacoz_cdstore_create(size_t mem_cap, const char *spill_near, tacoz_cdstore_t **out);
+int      tacoz_cdstore_push(tacoz_cdstore_t *s, const tacoz_cd_entry_t *e);
+uint64_t tacoz_cdstore_count(const tacoz_cdstore_t *s);
+uint64_t tacoz_cdstore_cd_size(const tacoz_cdstore_t *s);
+size_t   tacoz_cdstore_resident(const tacoz_cdstore_t *s);
+int      tacoz_cdstore_foreach(tacoz_cdstore_t *s, tacoz_cd_visit_fn fn, void *ctx);
+/** Visit entries in byte order of their names. Needs every chunk resident
+ *  (TACOZ_ERR_PARAM if any was spilled). */
+int      tacoz_cdstore_foreach_sorted(tacoz_cdstore_t *s, tacoz_cd_visit_fn fn, void *ctx);
+void     tacoz_cdstore_free(tacoz_cdstore_t *s);
+
+/* ------------------------------- Name index --------------------------------- */
+/* Implemented in tacozip_nameidx.c. */
+
+/** H(name, seed) of the name index layout in tacozip.h. */
+uint64_t tacoz_name_hash(const char *name, size_t len, uint64_t seed);
+/** Encode a name index over every entry in @p cd into a malloc'ed buffer
+ *  that will be stored at archive offset @p base. */
+int      tacoz_nameidx_build(tacoz_cdstore_t *cd, uint64_t base,
+                             unsigned char **out, size_t *out_len);
+
+/* -------------------------------- ID table ---------------------------------- */
+/* Implemented in tacozip_idtable.c. */
+
+/** Encode an ID table over every entry in @p cd into a malloc'ed buffer
+ *  that will be stored at archive offset @p base. */
+int      tacoz_idtable_build(tacoz_cdstore_t *cd, uint64_t base,
+                             unsigned char **out, size_t *out_len);
+
+/* ------------------------------- io_uring ring ----------------------------- */
+/* Implemented in tacozip_uring.c. tacoz_uring_create() fails when io_uring is
+ * not compiled in or refused by the kernel; callers then use plain syscalls. */
+
+typedef struct tacoz_uring tacoz_uring_t;
+
+int  tacoz_uring_create(unsigned entries, tacoz_uring_t **out);
+void tacoz_uring_free(tacoz_uring_t *r);
+
+#if TACOZ_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+/** Register @p n fixed buffers (IORING_REGISTER_BUFFERS). */
+int  tacoz_uring_register_buffers(tacoz_uring_t *r, const struct iovec *iov, unsigned n);
+/** Register a sparse table of @p n fixed-file slots for direct descriptors. */
+int  tacoz_uring_register_files(tacoz_uring_t *r, unsigned n);
+/** Free submission-queue entries. */
+unsigned tacoz_uring_sq_space(const tacoz_uring_t *r);
+
+/** Next free SQE (zeroed), or NULL when the submission queue is full. */
+struct io_uring_sqe *tacoz_uring_sqe(tacoz_uring_t *r);
+/** Publish queued SQEs; optionally block until @p wait_nr completions exist. */
+int  tacoz_uring_submit(tacoz_uring_t *r, unsigned wait_nr);
+/** Pop one completion: 1 = got one, 0 = none ready (wait == 0), <0 = error. */
+int  tacoz_uring_cqe(tacoz_uring_t *r, int wait, uint64_t *user_data, int32_t *res);
+#endif
+
+/* ----------------------------- Portable file I/O --------------------------- */
+/* Implemented in tacozip_io.c. Descriptors are plain ints on every platform
+ * (CRT descriptors on Windows). All helpers retry on EINTR and short I/O. */
+
+typedef struct {
+    uint64_t size;        /**< File size in bytes.                    */
+    int64_t  mtime;       /**< Modification time (seconds since epoch). */
+    uint32_t mode;        /**< POSIX st_mode (type + permission bits). */
+    int      is_regular;  /**< Non-zero for regular files.            */
+} tacoz_filestat_t;
+
+int      tacoz_open_read(const char *path);
+int      tacoz_open_rw(const char *path);
+int      tacoz_create_excl(const char *path);
+int      tacoz_create_temp_beside(const char *path, char **tmp_out);
+/** A new file in the directory of @p path for tacoz_publish(): unnamed
+ *  (*tmp_out = NULL) where the platform allows, else a temporary name. */
+int      tacoz_create_unnamed(const char *path, char **tmp_out);
+/** Sync @p fd as @p durability asks, close it and make it @p path
+ *  atomically. @p tmp_path is its name, or NULL if it has none; on failure
+ *  the caller removes it. */
+int      tacoz_publish(int fd, const char *tmp_path, const char *path, int durability);
+/** fdatasync() @p fd, or fsync() for TACOZIP_DURABLE_FULL. */
+int      tacoz_sync(int fd, int durability);
+int      tacoz_open_scratch(const char *near_path);
+int      tacoz_close(int fd);
+int64_t  tacoz_read(int fd, void *buf, size_t n);
+int      tacoz_write_all(int fd, const void *buf, size_t n);
+int      tacoz_pread_all(int fd, void *buf, size_t n, uint64_t off);
+int      tacoz_pwrite_all(int fd, const void *buf, size_t n, uint64_t off);
+int      tacoz_fstat(int fd, tacoz_filestat_t *st);
+int      tacoz_truncate(int fd, uint64_t size);
+/** Block until this descriptor holds the archive's writer lock, shared or
+ *  @p exclusive (an exclusive lock needs a writable descriptor). The lock
+ *  belongs to the open file, so it also excludes other threads of this
+ *  process where the platform allows; closing the descriptor releases it. */
+int      tacoz_lock(int fd, int exclusive);
+/** tacoz_open_rw() plus the exclusive writer lock, on the file @p path names
+ *  once the lock is held. */
+int      tacoz_open_locked(const char *path);
+/** Wait before retry @p attempt of an optimistic read: yield, then sleep. */
+void     tacoz_backoff(unsigned attempt);
+/** Copy @p n bytes from @p in_fd at @p in_off to the current position of
+ *  @p out_fd in the kernel. Returns bytes copied (short when the platform or
+ *  filesystem cannot continue; the caller copies the rest), or -1 on error. */
+int64_t  tacoz_copy_range(int in_fd, uint64_t in_off, int out_fd, uint64_t n);
+/** Copy @p n bytes like tacoz_copy_range(), finishing with plain reads and
+ *  writes when the kernel path stops short. */
+int      tacoz_copy_fd(int in_fd, uint64_t in_off, int out_fd, uint64_t n);
+/** Move @p n bytes of @p fd from @p from to @p to, front to back in steps
+ *  of at most TACOZ_COMPACT_CHUNK; steps clear of their destination are
+ *  copied in the kernel, overlapping ones through a buffer. Overlapping
+ *  ranges may only move down. */
+int      tacoz_move_down(int fd, uint64_t from, uint64_t to, uint64_t n);
+/** A read-only view of a file range: memory-mapped on POSIX, a heap copy
+ *  where mmap is unavailable. */
+typedef struct {
+    const unsigned char *data;
+    size_t               len;
+    void                *base;      /* mapping or allocation to release */
+    size_t               base_len;
+    int                  mapped;
+} tacoz_view_t;
+
+int      tacoz_view_open(int fd, uint64_t off, uint64_t len, tacoz_view_t *v);
+void     tacoz_view_close(tacoz_view_t *v);
+int      tacoz_rename_replace(const char *from, const char *to);
+int      tacoz_unlink(const char *path);
+uint32_t tacoz_crc32(uint32_t crc, const void *buf, size_t n);
+
+/* ---------------------------- Archive structure ----------------------------- */
+/* Implemented in tacozip_archive.c. Positioned reads only; no libzip. */
+
+typedef struct {
+    uint64_t cd_off;
+    uint64_t cd_size;
+    uint64_t entries;
+    uint64_t eocd_off;
+    uint64_t eocd64_off;   /**< Valid when zip64. */
+    int      zip64;
+} tacoz_tail_t;
+
+/** One parsed central-directory record; name points into a scan buffer. */
+typedef struct {
+    uint64_t    cdh_off;
+    uint64_t    lfh_off;
+    uint64_t    csize;
+    uint64_t    usize;
+    uint32_t    crc;
+    uint32_t    dostime;
+    uint32_t    ext_attr;
+    uint32_t    rec_len;
+    uint16_t    flags;
+    uint16_t    method;
+    uint16_t    name_len;
+    const char *name;
+    const unsigned char *raw;  /**< The whole record; valid during the visit. */
+} tacoz_cdh_t;
+
+/** Visitor for tacoz_cd_scan(): 0 = continue, 1 = stop, <0 = stop with error. */
+typedef int (*tacoz_cdh_visit_fn)(void *ctx, const tacoz_cdh_t *c);
+
+/** Where the ghost payload lives (LFH at byte 0). */
+typedef struct {
+    uint64_t data_off;
+    uint64_t size;         /**< Stored payload bytes. */
+    uint32_t crc;
+} tacoz_ghost_loc_t;
+
+int tacoz_read_tail(int fd, tacoz_tail_t *t);
+/** tacoz_read_tail() for the archive as it was when the file ended at @p end. */
+int tacoz_read_tail_at(int fd, uint64_t end, tacoz_tail_t *t);
+int tacoz_cd_scan(int fd, const tacoz_tail_t *t, tacoz_cdh_visit_fn fn, void *ctx);
+/** Parse the record at @p p (@p avail bytes, file offset @p off). Returns its
+ *  length, 0 if @p avail is short, or a negative error if it is no record. */
+int64_t tacoz_cdh_parse(const unsigned char *p, size_t avail, uint64_t off, tacoz_cdh_t *c);
+/** Parse the ghost LFH from the first @p len bytes of an archive. Returns
+ *  TACOZ_ERR_PARAM with *need set when more bytes are required. */
+int tacoz_ghost_lfh_parse(const unsigned char *p, size_t len, tacoz_ghost_loc_t *loc,
+                          size_t *need);
+int tacoz_ghost_locate(int fd, tacoz_ghost_loc_t *loc);
+/** Read and decode the payload at @p loc, retrying while an in-place update
+ *  is in progress (seqlock; see tacozip_update_ghost_v2()). */
+int tacoz_ghost_read(int fd, const tacoz_ghost_loc_t *loc, taco_ghost_t *out);
+int tacoz_ghost_find_cdh(int fd, const tacoz_tail_t *t, uint64_t *cdh_off);
+/** Fill g->slot_crc from the bytes each slot points at in @p fd (inline
+ *  copies are used when present). No-op without TACO_GHOST_F_SLOT_CRC. */
+int tacoz_ghost_slot_crcs(int fd, taco_ghost_t *g);
+/** Table kinds tacoz_slot_is_table() reports. */
+enum { TACOZ_TABLE_NAMES = 1, TACOZ_TABLE_IDS = 2 };
+/** Whether @p slot points at a name index or ID table, which describe the
+ *  whole directory and go stale when entries leave it; *@p is_table is its
+ *  TACOZ_TABLE_* kind, or 0. */
+int tacoz_slot_is_table(int fd, const taco_meta_entry_t *slot, int *is_table);
+/** Visitor for tacoz_table_scan(): 0 = continue, 1 = stop, <0 = stop with error. */
+typedef int (*tacoz_table_visit_fn)(void *ctx, uint64_t data_off);
+/** Call @p fn with the data offset of every entry the name index or ID table
+ *  at @p slot resolves to. */
+int tacoz_table_scan(int fd, const taco_meta_entry_t *slot, tacoz_table_visit_fn fn, void *ctx);
+/** Store @p ghost in place on @p fd, which holds the writer lock, with the
+ *  directory fields of the current tail, a bumped generation and the stored
+ *  layout flags minus @p drop_flags (seqlock; implemented in tacozip.c). */
+int tacoz_ghost_write(int fd, const taco_ghost_t *ghost, uint32_t drop_flags);
+/** tacozip_put_file(); with @p must_exist, TACOZ_ERR_NOT_FOUND rather than a
+ *  new entry (implemented in tacozip_edit.c). */
+int tacoz_put_file(const char *zip_path, const char *arc_name, const char *src_path,
+                   int must_exist);
+
+/* Directory log: every tacozip_log_commit() tail carries this record as the
+ * EOCD comment, linking it to the tail of the directory it superseded. */
+#define TACOZ_LOG_MAGIC    "TLOG"
+#define TACOZ_LOG_REC_SIZE 28u   /* magic + generation + prev_end + prev_gen */
+
+typedef struct {
+    uint64_t generation;  /**< Ghost generation this directory was published as. */
+    uint64_t prev_end;    /**< File size before the commit (end of the previous tail). */
+    uint64_t prev_gen;    /**< Generation of the previous directory. */
+} tacoz_log_rec_t;
+
+/** Read the log record of tail @p t: 1 if it has one, 0 if not, <0 on error. */
+int  tacoz_log_record(int fd, const tacoz_tail_t *t, tacoz_log_rec_t *rec);
+void tacoz_log_record_build(unsigned char *p, const tacoz_log_rec_t *rec);
+/** The tail of the newest published directory (the one ghost @p g names,
+ *  else the file's) and the offset just past it. */
+int  tacoz_log_head(int fd, const taco_ghost_t *g, tacoz_tail_t *t, uint64_t *end);
+/** Visit the published directories newest first; see tacozip_log_versions(). */
+int  tacoz_log_walk(int fd, const taco_ghost_t *g, tacozip_log_fn fn, void *user);
+
+/** Bytes tacoz_cdh_build() writes for a name of @p name_len bytes. */
+#define TACOZ_CDH_TOTAL(name_len) (TACOZ_CDH_SIZE + (name_len) + TACOZ_CDH_EXTRA_SIZE)
+/** Serialize @p e as a STORE record with a ZIP64 extra, as the writer emits it. */
+void   tacoz_cdh_build(const tacoz_cd_entry_t *e, unsigned char *out);
+/** LFH (STORE, ZIP64 sizes) for @p size bytes of data into
+ *  TACOZ_LFH_TOTAL(@p name_len) bytes, as the writer emits it; the CRC is left 0. */
+void   tacoz_lfh_build(unsigned char *out, const char *name, uint16_t name_len,
+                       uint32_t dostime, uint64_t size);
+/** tacoz_lfh_build() for the ghost. */
+void   tacoz_ghost_lfh_build(unsigned char *out, uint32_t dostime, uint64_t size);
+/** DOS time | date << 16 of @p t in local time; TACOZ_DOS_EPOCH before 1980. */
+uint32_t tacoz_dostime(int64_t t);
+
+/** ZIP64 EOCD + locator + classic EOCD, as written after our central directory. */
+#define TACOZ_TAIL_SIZE (TACOZ_EOCD64_SIZE + TACOZ_EOCD64_LOC_SIZE + TACOZ_EOCD_SIZE)
+void   tacoz_tail_build(unsigned char *p, uint64_t entries, uint64_t cd_size,
+                        uint64_t cd_off, uint64_t eocd64_off);
+
+/** Upper bound of tacoz_cdh_rebuild() output for a record of @p rec_len bytes. */
+#define TACOZ_CDH_REBUILD_MAX(rec_len) ((size_t)(rec_len) + TACOZ_CDH_EXTRA_SIZE)
+/** Re-emit record @p c (c->raw) with its LFH at @p lfh_off and c's sizes and
+ *  CRC, all 64-bit values in a fresh ZIP64 extra. Returns the new length, or 0
+ *  if the extras would overflow. */
+size_t tacoz_cdh_rebuild(const tacoz_cdh_t *c, uint64_t lfh_off, unsigned char *out);
+
+/* ------------------------------- Source pool -------------------------------- */
+/* Implemented in tacozip_srcpool.c. Feeds a list of source files in order,
+ * keeping at most `window` of them in flight ahead of the consumer. With
+ * io_uring, small files arrive already read and checksummed. */
+
+typedef struct tacoz_srcpool tacoz_srcpool_t;
+
+typedef struct {
+    int              fd;    /**< Descriptor to stream from (caller closes), or -1. */
+    const void      *data;  /**< Whole body when fd == -1; valid until the next call. */
+    size_t           len;
+    uint32_t         crc;   /**< CRC-32 of data when fd == -1.             */
+    tacoz_filestat_t st;
+} tacoz_src_t;
+
+int  tacoz_srcpool_create(unsigned window, const char * const *paths, size_t count,
+                          tacoz_srcpool_t **out);
+/** Take the next source, either buffered or as an open descriptor. */
+int  tacoz_srcpool_next(tacoz_srcpool_t *p, tacoz_src_t *src);
+void tacoz_srcpool_free(tacoz_srcpool_t *p);
+
+/* ------------------------------ Directory walk ------------------------------ */
+/* Implemented in tacozip_dirwalk.c. Collects the regular files under a root
+ * (filtered and sorted per tacozip_dir_opts_t), then opens them in list order.
+ * Files that are the same inode as @p skip_fd (the archive being written) are
+ * left out. */
+
+typedef struct tacoz_dirlist tacoz_dirlist_t;
+
+int         tacoz_dirwalk(const char *root, const tacozip_dir_opts_t *opts, int skip_fd,
+                          tacoz_dirlist_t **out);
+size_t      tacoz_dirlist_count(const tacoz_dirlist_t *l);
+/** Path relative to the root, '/'-separated. */
+const char *tacoz_dirlist_path(const tacoz_dirlist_t *l, size_t i);
+/** Open entry @p i; cheapest when called in increasing order. */
+int         tacoz_dirlist_open(tacoz_dirlist_t *l, size_t i, int *fd, tacoz_filestat_t *st);
+void        tacoz_dirlist_free(tacoz_dirlist_t *l);
+
+#endif /* TACOZIP_INTERNAL_H */
@@ -0,0 +1,638 @@
+/*
+ * tacozip_io.c — small portable file I/O layer used by the native writer.
+ *
+ * POSIX builds map straight onto open/read/pwrite; Windows builds use the CRT
+ * descriptor API, reading at an offset through ReadFile and emulating
+ * positioned writes with _lseeki64.
+ */
+
+/* Platform-specific feature detection */
+#if defined(__linux__) || defined(__gnu_linux__)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#elif defined(__APPLE__) || defined(__MACH__)
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64  /* large-file I/O on POSIX */
+#endif
+
+#include "tacozip_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <process.h>
+#include <windows.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+#include <zlib.h>
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/* Largest single read/write request issued to the OS. */
+#ifdef _WIN32
+#define TACOZ_IO_CHUNK ((size_t)INT_MAX & ~(size_t)4095)
+#else
+#define TACOZ_IO_CHUNK ((size_t)1 << 30)
+#endif
+
+int tacoz_open_read(const char *path) {
+#ifdef _WIN32
+    return _open(path, _O_RDONLY | _O_BINARY);
+#else
+    int fd;
+    do {
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    return fd;
+#endif
+}
+
+int tacoz_open_rw(const char *path) {
+#ifdef _WIN32
+    return _open(path, _O_RDWR | _O_BINARY);
+#else
+    int fd;
+    do {
+        fd = open(path, O_RDWR | O_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    return fd;
+#endif
+}
+
+static int create_excl_flags(const char *path, int scratch) {
+#ifdef _WIN32
+    int flags = _O_RDWR | _O_CREAT | _O_EXCL | _O_BINARY;
+    if (scratch) flags |= _O_TEMPORARY;  /* deleted on close */
+    return _open(path, flags, _S_IREAD | _S_IWRITE);
+#else
+    (void)scratch;
+    /* 0666 so the caller's umask decides the final permissions, like fopen(). */
+    return open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC | O_BINARY, 0666);
+#endif
+}
+
+int tacoz_create_excl(const char *path) {
+    return create_excl_flags(path, 0);
+}
+
+/** Write "<path>.XXXXXX" into @p tmp (strlen(path) + 8 bytes). */
+static void temp_name(char *tmp, const char *path, size_t n, unsigned long *seed) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    memcpy(tmp, path, n);
+    tmp[n] = '.';
+    for (int i = 0; i < 6; i++) {
+        *seed = *seed * 1103515245ul + 12345ul;
+        tmp[n + 1 + i] = alphabet[(*seed >> 16) % (sizeof(alphabet) - 1)];
+    }
+    tmp[n + 7] = '\0';
+}
+
+static unsigned long temp_seed(uintptr_t salt) {
+    return (unsigned long)time(NULL) ^ ((unsigned long)getpid() << 16)
+         ^ (unsigned long)salt;
+}
+
+static int create_temp_beside(const char *path, char **tmp_out, int scratch) {
+    size_t n = strlen(path);
+    char *tmp = malloc(n + 8);
+    if (!tmp) return -1;
+
+    unsigned long seed = temp_seed((uintptr_t)tmp);
+    for (int attempt = 0; attempt < 100; attempt++) {
+        temp_name(tmp, path, n, &seed);
+        int fd = create_excl_flags(tmp, scratch);
+        if (fd >= 0) {
+            *tmp_out = tmp;
+            return fd;
+        }
+        if (errno != EEXIST) break;
+    }
+    free(tmp);
+    return -1;
+}
+
+int tacoz_create_temp_beside(const char *path, char **tmp_out) {
+    return create_temp_beside(path, tmp_out, 0);
+}
+
+#ifndef _WIN32
+/** Directory part of @p path ("." when it has none); malloc'd. */
+static char *dir_of(const char *path) {
+    const char *slash = strrchr(path, '/');
+    size_t n = !slash ? 1 : slash == path ? 1 : (size_t)(slash - path);
+    char *dir = malloc(n + 1);
+    if (!dir) return NULL;
+    memcpy(dir, slash ? path : ".", n);
+    dir[n] = '\0';
+    return dir;
+}
+#endif
+
+#if defined(O_TMPFILE) && !defined(_WIN32)
+/** An unnamed regular file in the directory of @p path, or -1 where the
+ *  filesystem has no O_TMPFILE. */
+static int open_unnamed(const char *path) {
+    char *dir = dir_of(path);
+    if (!dir) return -1;
+    int fd;
+    do {
+        fd = open(dir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0666);
+    } while (fd < 0 && errno == EINTR);
+    free(dir);
+    return fd;
+}
+#endif
+
+int tacoz_create_unnamed(const char *path, char **tmp_out) {
+    *tmp_out = NULL;
+#if defined(O_TMPFILE) && !defined(_WIN32)
+    /* Publishing links the file back in through /proc/self/fd. */
+    if (access("/proc/self/fd", X_OK) == 0) {
+        int fd = open_unnamed(path);
+        if (fd >= 0) return fd;
+    }
+#endif
+    return tacoz_create_temp_beside(path, tmp_out);
+}
+
+int tacoz_open_scratch(const char *near_path) {
+#if defined(O_TMPFILE) && !defined(_WIN32)
+    int unnamed = open_unnamed(near_path);
+    if (unnamed >= 0) return unnamed;
+#endif
+    char *tmp = NULL;
+    int fd = create_temp_beside(near_path, &tmp, 1);
+    if (fd < 0) return -1;
+#ifndef _WIN32
+    unlink(tmp);  /* anonymous from here on; space is freed on close */
+#endif
+    free(tmp);
+    return fd;
+}
+
+int tacoz_close(int fd) {
+#ifdef _WIN32
+    return _close(fd);
+#else
+    return close(fd);
+#endif
+}
+
+int64_t tacoz_read(int fd, void *buf, size_t n) {
+    if (n > TACOZ_IO_CHUNK) n = TACOZ_IO_CHUNK;
+#ifdef _WIN32
+    return (int64_t)_read(fd, buf, (unsigned int)n);
+#else
+    ssize_t r;
+    do {
+        r = read(fd, buf, n);
+    } while (r < 0 && errno == EINTR);
+    return (int64_t)r;
+#endif
+}
+
+int tacoz_write_all(int fd, const void *buf, size_t n) {
+    const unsigned char *p = (const unsigned char *)buf;
+    while (n > 0) {
+        size_t chunk = n > TACOZ_IO_CHUNK ? TACOZ_IO_CHUNK : n;
+#ifdef _WIN32
+        int w = _write(fd, p, (unsigned int)chunk);
+#else
+        ssize_t w = write(fd, p, chunk);
+        if (w < 0 && errno == EINTR) continue;
+#endif
+        if (w <= 0) return TACOZ_ERR_IO;
+        p += w;
+        n -= (size_t)w;
+    }
+    return TACOZ_OK;
+}
+
+int tacoz_pread_all(int fd, void *buf, size_t n, uint64_t off) {
+    unsigned char *p = (unsigned char *)buf;
+#ifdef _WIN32
+    /* An OVERLAPPED offset leaves no shared file position behind, so
+     * concurrent reads on one descriptor stay independent (reader handles). */
+    HANDLE h = (HANDLE)_get_osfhandle(fd);
+    if (h == INVALID_HANDLE_VALUE) return TACOZ_ERR_IO;
+    while (n > 0) {
+        OVERLAPPED ov;
+        DWORD got = 0;
+        memset(&ov, 0, sizeof(ov));
+        ov.Offset     = (DWORD)(off & 0xffffffffu);
+        ov.OffsetHigh = (DWORD)(off >> 32);
+        if (!ReadFile(h, p, (DWORD)(n > TACOZ_IO_CHUNK ? TACOZ_IO_CHUNK : n), &got, &ov) || got == 0)
+            return TACOZ_ERR_IO;
+        p += got;
+        n -= (size_t)got;
+        off += got;
+    }
+    return TACOZ_OK;
+#else
+    while (n > 0) {
+        ssize_t r = pread(fd, p, n > TACOZ_IO_CHUNK ? TACOZ_IO_CHUNK : n, (off_t)off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return TACOZ_ERR_IO;  /* error or unexpected EOF */
+        p += r;
+        n -= (size_t)r;
+        off += (uint64_t)r;
+    }
+    return TACOZ_OK;
+#endif
+}
+
+int tacoz_pwrite_all(int fd, const void *buf, size_t n, uint64_t off) {
+    const unsigned char *p = (const unsigned char *)buf;
+#ifdef _WIN32
+    __int64 saved = _lseeki64(fd, 0, SEEK_CUR);
+    if (saved < 0 || _lseeki64(fd, (__int64)off, SEEK_SET) < 0) return TACOZ_ERR_IO;
+    int rc = tacoz_write_all(fd, p, n);
+    if (_lseeki64(fd, saved, SEEK_SET) < 0) return TACOZ_ERR_IO;
+    return rc;
+#else
+    while (n > 0) {
+        ssize_t w = pwrite(fd, p, n > TACOZ_IO_CHUNK ? TACOZ_IO_CHUNK : n, (off_t)off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return TACOZ_ERR_IO;
+        p += w;
+        n -= (size_t)w;
+        off += (uint64_t)w;
+    }
+    return TACOZ_OK;
+#endif
+}
+
+int tacoz_fstat(int fd, tacoz_filestat_t *st) {
+#ifdef _WIN32
+    struct _stat64 sb;
+    if (_fstat64(fd, &sb) != 0) return TACOZ_ERR_IO;
+    st->is_regular = (sb.st_mode & _S_IFMT) == _S_IFREG;
+    st->mode = st->is_regular ? 0100644u : (uint32_t)sb.st_mode;
+#else
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) return TACOZ_ERR_IO;
+    st->is_regular = S_ISREG(sb.st_mode);
+    st->mode = (uint32_t)sb.st_mode;
+#endif
+    st->size = (uint64_t)sb.st_size;
+    st->mtime = (int64_t)sb.st_mtime;
+    return TACOZ_OK;
+}
+
+int tacoz_truncate(int fd, uint64_t size) {
+#ifdef _WIN32
+    return _chsize_s(fd, (__int64)size) == 0 ? TACOZ_OK : TACOZ_ERR_IO;
+#else
+    int r;
+    do {
+        r = ftruncate(fd, (off_t)size);
+    } while (r != 0 && errno == EINTR);
+    return r == 0 ? TACOZ_OK : TACOZ_ERR_IO;
+#endif
+}
+
+#ifdef _WIN32
+/* Windows byte-range locks are mandatory, so lock a byte no archive reaches
+ * rather than the data readers need. */
+static void lock_range(OVERLAPPED *ov) {
+    memset(ov, 0, sizeof(*ov));
+    ov->Offset     = 0xFFFFFFFEu;
+    ov->OffsetHigh = 0xFFFFFFFFu;
+}
+#else
+/* Open-file-description locks where available: per descriptor rather than
+ * per process, so threads exclude each other and closing an unrelated
+ * descriptor of the same file does not drop the lock. */
+static int lock_cmd(int fd, struct flock *fl) {
+#ifdef F_OFD_SETLKW
+    for (;;) {
+        if (fcntl(fd, F_OFD_SETLKW, fl) == 0) return 0;
+        if (errno == EINTR) continue;
+        if (errno != EINVAL) return -1;
+        break;  /* kernel without OFD locks */
+    }
+#endif
+    for (;;) {
+        if (fcntl(fd, F_SETLKW, fl) == 0) return 0;
+        if (errno != EINTR) return -1;
+    }
+}
+#endif
+
+int tacoz_lock(int fd, int exclusive) {
+#ifdef _WIN32
+    HANDLE h = (HANDLE)_get_osfhandle(fd);
+    OVERLAPPED ov;
+    lock_range(&ov);
+    if (h == INVALID_HANDLE_VALUE ||
+        !LockFileEx(h, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, 1, 0, &ov))
+        return TACOZ_ERR_IO;
+    return TACOZ_OK;
+#else
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = (short)(exclusive ? F_WRLCK : F_RDLCK);
+    fl.l_whence = SEEK_SET;  /* l_start = l_len = 0: the whole file */
+    return lock_cmd(fd, &fl) == 0 ? TACOZ_OK : TACOZ_ERR_IO;
+#endif
+}
+
+int tacoz_open_locked(const char *path) {
+    /* A rewrite may rename a new archive over @p path while we wait; the
+     * lock only counts if it is on the file the path names afterwards. */
+    for (int attempt = 0; attempt < 8; attempt++) {
+        int fd = tacoz_open_rw(path);
+        if (fd < 0) return -1;
+        if (tacoz_lock(fd, 1) != TACOZ_OK) {
+            tacoz_close(fd);
+            return -1;
+        }
+#ifdef _WIN32
+        return fd;  /* a file open here cannot be replaced by rename */
+#else
+        struct stat a, b;
+        if (fstat(fd, &a) == 0 && stat(path, &b) == 0 &&
+            a.st_dev == b.st_dev && a.st_ino == b.st_ino)
+            return fd;
+        tacoz_close(fd);
+#endif
+    }
+    return -1;
+}
+
+void tacoz_backoff(unsigned attempt) {
+#ifdef _WIN32
+    Sleep(attempt < 16 ? 0 : 1);
+#else
+    if (attempt < 16) {
+        sched_yield();
+        return;
+    }
+    struct timespec ts = { 0, 1000000L };  /* 1 ms */
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+#endif
+}
+
+int64_t tacoz_copy_range(int in_fd, uint64_t in_off, int out_fd, uint64_t n) {
+#if TACOZ_HAVE_COPY_FILE_RANGE
+    uint64_t done = 0;
+    while (done < n) {
+        uint64_t left = n - done;
+        loff_t off = (loff_t)(in_off + done);
+        ssize_t r = copy_file_range(in_fd, &off, out_fd, NULL,
+                                    left > TACOZ_IO_CHUNK ? TACOZ_IO_CHUNK : (size_t)left, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) {
+            /* Old kernel, cross-device or unsupported filesystem: fall back. */
+            if (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)
+                break;
+            return -1;
+        }
+        if (r == 0) break;  /* EOF; the caller's read reports the short file */
+        done += (uint64_t)r;
+    }
+    return (int64_t)done;
+#else
+    (void)in_fd; (void)in_off; (void)out_fd; (void)n;
+    return 0;
+#endif
+}
+
+int tacoz_copy_fd(int in_fd, uint64_t in_off, int out_fd, uint64_t n) {
+    int64_t done = tacoz_copy_range(in_fd, in_off, out_fd, n);
+    if (done < 0) return TACOZ_ERR_IO;
+    if ((uint64_t)done == n) return TACOZ_OK;
+
+    size_t cap = n - (uint64_t)done < TACOZ_COPY_BUFSZ ? (size_t)(n - (uint64_t)done)
+                                                       : TACOZ_COPY_BUFSZ;
+    unsigned char *buf = malloc(cap);
+    if (!buf) return TACOZ_ERR_IO;
+    int rc = TACOZ_OK;
+    for (uint64_t at = (uint64_t)done; rc == TACOZ_OK && at < n; ) {
+        size_t k = n - at < cap ? (size_t)(n - at) : cap;
+        rc = tacoz_pread_all(in_fd, buf, k, in_off + at);
+        if (rc == TACOZ_OK) rc = tacoz_write_all(out_fd, buf, k);
+        at += k;
+    }
+    free(buf);
+    return rc;
+}
+
+int tacoz_move_down(int fd, uint64_t from, uint64_t to, uint64_t n) {
+    size_t cap = n < TACOZ_COMPACT_CHUNK ? (size_t)n : TACOZ_COMPACT_CHUNK;
+    unsigned char *buf = NULL;
+    int rc = TACOZ_OK;
+    for (uint64_t at = 0; rc == TACOZ_OK && at < n; ) {
+        size_t k = n - at < TACOZ_COMPACT_CHUNK ? (size_t)(n - at) : TACOZ_COMPACT_CHUNK;
+#if TACOZ_HAVE_COPY_FILE_RANGE
+        if (to > from || k <= from - to) {
+            loff_t in = (loff_t)(from + at), out = (loff_t)(to + at);
+            ssize_t r = copy_file_range(fd, &in, fd, &out, k, 0);
+            if (r > 0) {
+                at += (uint64_t)r;
+                continue;
+            }
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0 && errno != ENOSYS && errno != EXDEV && errno != EINVAL &&
+                errno != EOPNOTSUPP) {
+                rc = TACOZ_ERR_IO;
+                break;
+            }
+        }
+#endif
+        if (!buf && !(buf = malloc(cap))) {
+            rc = TACOZ_ERR_IO;
+            break;
+        }
+        /* The whole step is read before any of it is written. */
+        rc = tacoz_pread_all(fd, buf, k, from + at);
+        if (rc == TACOZ_OK) rc = tacoz_pwrite_all(fd, buf, k, to + at);
+        at += k;
+    }
+    free(buf);
+    return rc;
+}
+
+int tacoz_view_open(int fd, uint64_t off, uint64_t len, tacoz_view_t *v) {
+    memset(v, 0, sizeof(*v));
+    if (len > SIZE_MAX) return TACOZ_ERR_IO;
+    if (len == 0) return TACOZ_OK;
+#ifndef _WIN32
+    /* mmap offsets must be page aligned; map from the page holding @p off. */
+    long page = sysconf(_SC_PAGESIZE);
+    uint64_t skip = page > 0 ? off % (uint64_t)page : 0;
+    if (len + skip <= SIZE_MAX) {
+        void *p = mmap(NULL, (size_t)(len + skip), PROT_READ, MAP_PRIVATE, fd, (off_t)(off - skip));
+        if (p != MAP_FAILED) {
+            v->base = p;
+            v->base_len = (size_t)(len + skip);
+            v->data = (const unsigned char *)p + skip;
+            v->len = (size_t)len;
+            v->mapped = 1;
+            return TACOZ_OK;
+        }
+    }
+#endif
+    /* No mmap (Windows, or a filesystem that refuses it): read a copy. */
+    unsigned char *buf = malloc((size_t)len);
+    if (!buf) return TACOZ_ERR_IO;
+    if (tacoz_pread_all(fd, buf, (size_t)len, off) != TACOZ_OK) {
+        free(buf);
+        return TACOZ_ERR_IO;
+    }
+    v->base = buf;
+    v->data = buf;
+    v->len = (size_t)len;
+    return TACOZ_OK;
+}
+
+void tacoz_view_close(tacoz_view_t *v) {
+#ifndef _WIN32
+    if (v->mapped) {
+        munmap(v->base, v->base_len);
+        memset(v, 0, sizeof(*v));
+        return;
+    }
+#endif
+    free(v->base);
+    memset(v, 0, sizeof(*v));
+}
+
+int tacoz_rename_replace(const char *from, const char *to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) ? TACOZ_OK : TACOZ_ERR_IO;
+#else
+    return rename(from, to) == 0 ? TACOZ_OK : TACOZ_ERR_IO;
+#endif
+}
+
+int tacoz_sync(int fd, int durability) {
+#ifdef _WIN32
+    (void)durability;
+    return _commit(fd) == 0 ? TACOZ_OK : TACOZ_ERR_IO;
+#elif defined(__APPLE__)
+#ifdef F_FULLFSYNC
+    /* fsync() on macOS stops at the drive cache. */
+    if (durability == TACOZIP_DURABLE_FULL && fcntl(fd, F_FULLFSYNC) == 0) return TACOZ_OK;
+#endif
+    (void)durability;
+    return fsync(fd) == 0 ? TACOZ_OK : TACOZ_ERR_IO;
+#else
+    int r;
+    do {
+        r = durability == TACOZIP_DURABLE_FULL ? fsync(fd) : fdatasync(fd);
+    } while (r != 0 && errno == EINTR);
+    return r == 0 ? TACOZ_OK : TACOZ_ERR_IO;
+#endif
+}
+
+#ifndef _WIN32
+/** fsync() the directory holding @p path so a rename into it is durable. */
+static int sync_dir(const char *path) {
+    char *dir = dir_of(path);
+    if (!dir) return TACOZ_ERR_IO;
+    int fd = open(dir, O_RDONLY | O_CLOEXEC);
+    free(dir);
+    if (fd < 0) return TACOZ_ERR_IO;
+    int rc = tacoz_sync(fd, TACOZIP_DURABLE_FULL);
+    close(fd);
+    return rc;
+}
+#endif
+
+#if defined(O_TMPFILE) && !defined(_WIN32)
+/** Link unnamed @p fd in under a fresh temporary name beside @p path. */
+static int link_unnamed(int fd, const char *path, char **tmp_out) {
+    char proc[32];
+    snprintf(proc, sizeof(proc), "/proc/self/fd/%d", fd);
+    size_t n = strlen(path);
+    char *tmp = malloc(n + 8);
+    if (!tmp) return TACOZ_ERR_IO;
+
+    unsigned long seed = temp_seed((uintptr_t)tmp);
+    for (int attempt = 0; attempt < 100; attempt++) {
+        temp_name(tmp, path, n, &seed);
+        if (linkat(AT_FDCWD, proc, AT_FDCWD, tmp, AT_SYMLINK_FOLLOW) == 0) {
+            *tmp_out = tmp;
+            return TACOZ_OK;
+        }
+        if (errno != EEXIST) break;
+    }
+    free(tmp);
+    return TACOZ_ERR_IO;
+}
+#endif
+
+int tacoz_publish(int fd, const char *tmp_path, const char *path, int durability) {
+    int rc = durability != TACOZIP_DURABLE_NONE ? tacoz_sync(fd, durability) : TACOZ_OK;
+
+    /* linkat() cannot replace an existing file, so an unnamed archive gets a
+     * temporary name for the instant before the rename. */
+    char *named = NULL;
+#if defined(O_TMPFILE) && !defined(_WIN32)
+    if (rc == TACOZ_OK && !tmp_path) {
+        rc = link_unnamed(fd, path, &named);
+        tmp_path = named;
+    }
+#endif
+    if (tacoz_close(fd) != 0 && rc == TACOZ_OK) rc = TACOZ_ERR_IO;
+    if (rc == TACOZ_OK && !tmp_path) rc = TACOZ_ERR_IO;
+
+#ifdef _WIN32
+    if (rc == TACOZ_OK) {
+        DWORD flags = MOVEFILE_REPLACE_EXISTING;
+        if (durability == TACOZIP_DURABLE_FULL) flags |= MOVEFILE_WRITE_THROUGH;
+        if (!MoveFileExA(tmp_path, path, flags)) rc = TACOZ_ERR_IO;
+    }
+#else
+    if (rc == TACOZ_OK) rc = tacoz_rename_replace(tmp_path, path);
+    if (rc == TACOZ_OK && durability == TACOZIP_DURABLE_FULL) rc = sync_dir(path);
+#endif
+    if (rc != TACOZ_OK && named) tacoz_unlink(named);
+    free(named);
+    return rc;
+}
+
+int tacoz_unlink(const char *path) {
+#ifdef _WIN32
+    return _unlink(path) == 0 ? TACOZ_OK : TACOZ_ERR_IO;
+#else
+    return unlink(path) == 0 ? TACOZ_OK : TACOZ_ERR_IO;
+#endif
+}
+
+uint32_t tacoz_crc32(uint32_t crc, const void *buf, size_t n) {
+    const unsigned char *p = (const unsigned char *)buf;
+    /* zlib's crc32() takes a uInt length; feed it in bounded chunks. */
+    while (n > 0) {
+        uInt chunk = (uInt)(n > TACOZ_IO_CHUNK ? TACOZ_IO_CHUNK : n);
+        crc = (uint32_t)crc32((uLong)crc, p, chunk);
+        p += chunk;
+        n -= chunk;
+    }
+    return crc;
+}
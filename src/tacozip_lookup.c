@@ -0,0 +1,195 @@
+/*
+ * tacozip_lookup.c — name lookups on a central-directory image.
+ *
+ * A sorted directory (TACO_GHOST_F_CD_SORTED) is bisected by byte position:
+ * from the midpoint, the first "PK\1\2" whose record parses and ends exactly
+ * at the next signature (or at the end of the image) is taken as a record
+ * boundary, and the last few records are walked one by one. Nothing is
+ * allocated, so a lookup in a memory-mapped directory of millions of entries
+ * touches only a few dozen pages. Unsorted directories are scanned.
+ */
+
+#include "tacozip_internal.h"
+#include <string.h>
+
+/* Below this many bytes a bisection step costs more than walking records. */
+#define TACOZ_BISECT_MIN 512u
+
+typedef struct {
+    const unsigned char *p;
+    size_t               len;
+} cd_image_t;
+
+/** Parse the record at @p off; returns its length, or 0 if there is none. */
+static size_t rec_at(const cd_image_t *cd, size_t off, tacoz_cdh_t *c) {
+    if (off >= cd->len) return 0;
+    int64_t r = tacoz_cdh_parse(cd->p + off, cd->len - off, off, c);
+    return r > 0 ? (size_t)r : 0;
+}
+
+/** Like rec_at(), but only if the record is followed by another or the end. */
+static size_t rec_checked(const cd_image_t *cd, size_t off, tacoz_cdh_t *c) {
+    size_t n = rec_at(cd, off, c);
+    if (n == 0) return 0;
+    size_t end = off + n;
+    if (end == cd->len) return n;
+    return cd->len - end >= 4 && le32_read(cd->p + end) == TACOZ_SIG_CDH ? n : 0;
+}
+
+/** First record boundary in [from, to), or @p to if there is none. */
+static size_t resync(const cd_image_t *cd, size_t from, size_t to, tacoz_cdh_t *c) {
+    while (from < to) {
+        const unsigned char *hit = memchr(cd->p + from, 'P', to - from);
+        if (!hit) break;
+        from = (size_t)(hit - cd->p);
+        if (rec_checked(cd, from, c)) return from;
+        from++;
+    }
+    return to;
+}
+
+/** Byte order of names, shorter first on a common prefix (as the writer sorts). */
+static int name_cmp(const tacoz_cdh_t *c, const char *key, size_t klen) {
+    size_t n = c->name_len < klen ? c->name_len : klen;
+    int r = memcmp(c->name, key, n);
+    if (r != 0) return r;
+    return (c->name_len > klen) - (c->name_len < klen);
+}
+
+static int has_prefix(const tacoz_cdh_t *c, const char *prefix, size_t plen) {
+    return c->name_len >= plen && memcmp(c->name, prefix, plen) == 0;
+}
+
+/** Offset of the first record after the ghost's (which is first when present). */
+static int first_entry(const cd_image_t *cd, size_t *start) {
+    tacoz_cdh_t c;
+    *start = 0;
+    if (cd->len == 0) return TACOZ_OK;
+    size_t n = rec_at(cd, 0, &c);
+    if (n == 0) return TACOZ_ERR_INVALID_GHOST;
+    if (c.name_len == TACO_GHOST_NAME_LEN && memcmp(c.name, TACO_GHOST_NAME, TACO_GHOST_NAME_LEN) == 0)
+        *start = n;
+    return TACOZ_OK;
+}
+
+/** First record at or after @p lo whose name is not below @p key (sorted image). */
+static size_t lower_bound(const cd_image_t *cd, size_t lo, const char *key, size_t klen) {
+    size_t hi = cd->len;
+    tacoz_cdh_t c;
+    while (hi - lo > TACOZ_BISECT_MIN) {
+        size_t r = resync(cd, lo + (hi - lo) / 2, hi, &c);
+        if (r == hi) break;
+        if (name_cmp(&c, key, klen) < 0) lo = r + c.rec_len;
+        else hi = r;
+    }
+
+    size_t n;
+    while (lo < hi && (n = rec_at(cd, lo, &c)) != 0 && name_cmp(&c, key, klen) < 0) lo += n;
+    return lo;
+}
+
+static void entry_info(const tacoz_cdh_t *c, taco_entry_info_t *e) {
+    e->name              = c->name;
+    e->name_len          = c->name_len;
+    e->method            = c->method;
+    e->crc32             = c->crc;
+    e->compressed_size   = c->csize;
+    e->uncompressed_size = c->usize;
+    e->lfh_offset        = c->lfh_off;
+}
+
+int tacozip_cd_find(const void *cd, size_t cd_len, int sorted,
+                    const char *name, taco_entry_info_t *out) {
+    if ((!cd && cd_len) || !name || !out) return TACOZ_ERR_PARAM;
+
+    cd_image_t img = { (const unsigned char *)cd, cd_len };
+    size_t at, n, klen = strlen(name);
+    tacoz_cdh_t c;
+    int rc = first_entry(&img, &at);
+    if (rc != TACOZ_OK) return rc;
+
+    if (sorted) {
+        at = lower_bound(&img, at, name, klen);
+        if (rec_at(&img, at, &c) == 0 || name_cmp(&c, name, klen) != 0) return TACOZ_ERR_NOT_FOUND;
+        entry_info(&c, out);
+        return TACOZ_OK;
+    }
+
+    for (; at < cd_len; at += n) {
+        if ((n = rec_at(&img, at, &c)) == 0) return TACOZ_ERR_INVALID_GHOST;
+        if (name_cmp(&c, name, klen) == 0) {
+            entry_info(&c, out);
+            return TACOZ_OK;
+        }
+    }
+    return TACOZ_ERR_NOT_FOUND;
+}
+
+int tacozip_cd_list_prefix(const void *cd, size_t cd_len, int sorted,
+                           const char *prefix, tacozip_entry_fn fn, void *user) {
+    if ((!cd && cd_len) || !prefix || !fn) return TACOZ_ERR_PARAM;
+
+    cd_image_t img = { (const unsigned char *)cd, cd_len };
+    size_t at, n, plen = strlen(prefix);
+    tacoz_cdh_t c;
+    int rc = first_entry(&img, &at);
+    if (rc != TACOZ_OK) return rc;
+    if (sorted) at = lower_bound(&img, at, prefix, plen);
+
+    for (; at < cd_len; at += n) {
+        if ((n = rec_at(&img, at, &c)) == 0) return TACOZ_ERR_INVALID_GHOST;
+        if (!has_prefix(&c, prefix, plen)) {
+            if (sorted) break;  /* past the matching run */
+            continue;
+        }
+        taco_entry_info_t e;
+        entry_info(&c, &e);
+        if (fn(user, &e) != 0) break;
+    }
+    return TACOZ_OK;
+}
+
+/** Map the central directory of @p zip_path and tell whether it is sorted. */
+static int open_cd(const char *zip_path, tacoz_view_t *v, int *sorted) {
+    int fd = tacoz_open_read(zip_path);
+    if (fd < 0) return TACOZ_ERR_IO;
+
+    tacoz_tail_t tail;
+    tacoz_ghost_loc_t loc;
+    unsigned char head[12];
+    *sorted = 0;
+    int rc = tacoz_read_tail(fd, &tail);
+    if (rc == TACOZ_OK && tacoz_ghost_locate(fd, &loc) == TACOZ_OK && loc.size >= sizeof(head) &&
+        tacoz_pread_all(fd, head, sizeof(head), loc.data_off) == TACOZ_OK &&
+        memcmp(head, TACO_GHOST_V2_MAGIC, 4) == 0)
+        *sorted = (le32_read(head + 8) & TACO_GHOST_F_CD_SORTED) != 0;
+    if (rc == TACOZ_OK) rc = tacoz_view_open(fd, tail.cd_off, tail.cd_size, v);
+    tacoz_close(fd);  /* a mapping outlives its descriptor */
+    return rc;
+}
+
+int tacozip_find_entry(const char *zip_path, const char *name, taco_entry_info_t *out) {
+    if (!zip_path || !name || !out) return TACOZ_ERR_PARAM;
+
+    tacoz_view_t v;
+    int sorted;
+    int rc = open_cd(zip_path, &v, &sorted);
+    if (rc != TACOZ_OK) return rc;
+    rc = tacozip_cd_find(v.data, v.len, sorted, name, out);
+    out->name = NULL;  /* pointed into the mapping */
+    tacoz_view_close(&v);
+    return rc;
+}
+
+int tacozip_list_prefix(const char *zip_path, const char *prefix,
+                        tacozip_entry_fn fn, void *user) {
+    if (!zip_path || !prefix || !fn) return TACOZ_ERR_PARAM;
+
+    tacoz_view_t v;
+    int sorted;
+    int rc = open_cd(zip_path, &v, &sorted);
+    if (rc != TACOZ_OK) return rc;
+    rc = tacozip_cd_list_prefix(v.data, v.len, sorted, prefix, fn, user);
+    tacoz_view_close(&v);
+    return rc;
+}
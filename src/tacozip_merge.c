@@ -0,0 +1,352 @@
+/*
+ * tacozip_merge.c — joining archives without rewriting entry data.
+ *
+ * Each shard contributes its entry region (past its ghost, up to its central
+ * directory) verbatim, copied in-kernel; regions keep their block offset so
+ * that cloning filesystems share rather than copy them. Only the directory
+ * records are re-emitted with shifted offsets, after one new ghost at byte 0
+ * that collects the shards' slots.
+ */
+
+/* Platform-specific feature detection */
+#if defined(__linux__) || defined(__gnu_linux__)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64  /* large-file I/O on POSIX */
+#endif
+
+#include "tacozip_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Central-directory output is batched into writes of about this size. */
+#define TACOZ_MERGE_CD_BUF (256u << 10)
+
+typedef struct {
+    int          fd;
+    tacoz_tail_t tail;
+    uint64_t     body;       /* first byte past the shard's ghost (0 if none) */
+    uint64_t     pad;        /* zeros written before the region              */
+    uint64_t     delta;      /* output offset minus shard offset (mod 2^64)  */
+    int          has_ghost;
+} shard_t;
+
+typedef struct {
+    int            fd;
+    unsigned char *buf;
+    size_t         len;
+    uint64_t       pos;      /* output offset of buf[0]                      */
+    uint64_t       entries;
+    const shard_t *shard;
+    char          *last;     /* previous name, for the sort check            */
+    size_t         last_len;
+    int            sorted;   /* every name so far in byte order              */
+} merge_cd_t;
+
+static int cd_flush(merge_cd_t *m) {
+    int rc = tacoz_write_all(m->fd, m->buf, m->len);
+    m->pos += m->len;
+    m->len = 0;
+    return rc;
+}
+
+static int name_cmp(const char *a, size_t alen, const char *b, size_t blen) {
+    int c = memcmp(a, b, alen < blen ? alen : blen);
+    if (c != 0) return c;
+    return (alen > blen) - (alen < blen);
+}
+
+static int merge_cdh(void *ctx, const tacoz_cdh_t *c) {
+    merge_cd_t *m = (merge_cd_t *)ctx;
+    const shard_t *s = m->shard;
+    if (s->has_ghost && c->lfh_off == 0 && c->name_len == TACO_GHOST_NAME_LEN &&
+        memcmp(c->name, TACO_GHOST_NAME, TACO_GHOST_NAME_LEN) == 0)
+        return 0;  /* replaced by the merged ghost */
+    if (c->lfh_off < s->body || c->lfh_off >= s->tail.cd_off) return TACOZ_ERR_INVALID_GHOST;
+
+    if (TACOZ_MERGE_CD_BUF - m->len < TACOZ_CDH_REBUILD_MAX(c->rec_len) &&
+        cd_flush(m) != TACOZ_OK)
+        return TACOZ_ERR_IO;
+    size_t n = tacoz_cdh_rebuild(c, c->lfh_off + s->delta, m->buf + m->len);
+    if (n == 0) return TACOZ_ERR_INVALID_GHOST;
+    m->len += n;
+    m->entries++;
+
+    if (m->sorted) {
+        int cmp = m->entries > 1 ? name_cmp(m->last, m->last_len, c->name, c->name_len) : -1;
+        if (cmp == 0) return TACOZ_ERR_PARAM;  /* the same name twice */
+        if (cmp > 0) m->sorted = 0;
+        memcpy(m->last, c->name, c->name_len);
+        m->last_len = c->name_len;
+    }
+    return 0;
+}
+
+typedef struct {
+    uint64_t hash;
+    size_t   off;   /* record offset in the directory */
+} name_key_t;
+
+static int name_key_cmp(const void *a, const void *b) {
+    const name_key_t *x = (const name_key_t *)a, *y = (const name_key_t *)b;
+    if (x->hash != y->hash) return (x->hash > y->hash) - (x->hash < y->hash);
+    return (x->off > y->off) - (x->off < y->off);
+}
+
+/**
+ * Whether two of the @p entries records of the directory at @p cd_off share
+ * a name: names are hashed, and only records whose hashes collide are
+ * compared. The directory is read back from @p fd, so nothing but the keys
+ * is held in memory.
+ */
+static int find_duplicate(int fd, uint64_t cd_off, uint64_t cd_size, uint64_t entries,
+                          int *dup) {
+    *dup = 0;
+    if (entries > SIZE_MAX / sizeof(name_key_t)) return TACOZ_ERR_IO;
+    tacoz_view_t v;
+    int rc = tacoz_view_open(fd, cd_off, cd_size, &v);
+    if (rc != TACOZ_OK) return rc;
+    name_key_t *k = malloc((size_t)entries * sizeof(*k) + 1);
+    if (!k) rc = TACOZ_ERR_IO;
+
+    size_t off = 0;
+    tacoz_cdh_t a, b;
+    for (uint64_t i = 0; rc == TACOZ_OK && i < entries; i++) {
+        int64_t n = tacoz_cdh_parse(v.data + off, v.len - off, cd_off + off, &a);
+        if (n <= 0) {
+            rc = TACOZ_ERR_INVALID_GHOST;
+            break;
+        }
+        k[i].hash = tacoz_name_hash(a.name, a.name_len, 0);
+        k[i].off = off;
+        off += (size_t)n;
+    }
+    if (rc == TACOZ_OK) qsort(k, (size_t)entries, sizeof(*k), name_key_cmp);
+    for (uint64_t i = 1; rc == TACOZ_OK && !*dup && i < entries; i++) {
+        for (uint64_t j = i; !*dup && j-- > 0 && k[j].hash == k[i].hash; ) {
+            (void)tacoz_cdh_parse(v.data + k[i].off, v.len - k[i].off, 0, &a);
+            (void)tacoz_cdh_parse(v.data + k[j].off, v.len - k[j].off, 0, &b);
+            *dup = name_cmp(a.name, a.name_len, b.name, b.name_len) == 0;
+        }
+    }
+    free(k);
+    tacoz_view_close(&v);
+    return rc;
+}
+
+/** Open shard @p path and find its entry region; add its slots to @p g. */
+static int open_shard(const char *path, shard_t *s, taco_ghost_t *g, taco_ghost_t *sg,
+                      size_t *slot_shard, size_t index, int *v2, uint32_t *dostime) {
+    s->fd = tacoz_open_read(path);
+    if (s->fd < 0) return TACOZ_ERR_IO;
+    int rc = tacoz_lock(s->fd, 0);
+    if (rc != TACOZ_OK) return rc;
+
+    tacoz_ghost_loc_t loc;
+    rc = tacoz_ghost_locate(s->fd, &loc);
+    if (rc == TACOZ_OK) rc = tacoz_ghost_read(s->fd, &loc, sg);
+    if (rc == TACOZ_OK) {
+        s->has_ghost = 1;
+        s->body = loc.data_off + loc.size;
+    } else if (rc == TACOZ_ERR_INVALID_GHOST) {
+        rc = TACOZ_OK;  /* a plain ZIP64 archive: its entries start at 0 */
+    }
+    if (rc == TACOZ_OK) rc = tacoz_read_tail(s->fd, &s->tail);
+    if (rc != TACOZ_OK) return rc;
+    if (s->tail.cd_off < s->body) return TACOZ_ERR_INVALID_GHOST;
+    if (!s->has_ghost) return TACOZ_OK;
+
+    unsigned char t[4];
+    rc = tacoz_pread_all(s->fd, t, sizeof(t), 10);
+    if (rc != TACOZ_OK) return rc;
+    if (le32_read(t) > *dostime) *dostime = le32_read(t);  /* date in the high half */
+
+    if (sg->version == 2) *v2 = 1;
+    if (sg->flags & TACO_GHOST_F_SLOT_CRC) g->flags |= TACO_GHOST_F_SLOT_CRC;
+    for (size_t i = 0; i < sg->count; i++) {
+        const taco_meta_entry_t *e = &sg->slots[i];
+        if ((e->offset || e->length) &&
+            (e->offset < s->body || e->offset > s->tail.cd_off ||
+             e->length > s->tail.cd_off - e->offset))
+            return TACOZ_ERR_INVALID_GHOST;
+        if (g->count >= TACO_GHOST_V2_MAX_SLOTS) return TACOZ_ERR_PARAM;
+
+        unsigned slot = g->count++;
+        g->slots[slot] = *e;
+        slot_shard[slot] = index;
+        /* Inline copies are a cache: drop what no longer fits. */
+        if (sg->inline_len[i])
+            (void)tacoz_ghost_add_inline(g, slot, sg->inline_data + sg->inline_off[i],
+                                         sg->inline_len[i]);
+    }
+    return TACOZ_OK;
+}
+
+static int write_zeros(int fd, const unsigned char *zeros, uint64_t n) {
+    return n ? tacoz_write_all(fd, zeros, (size_t)n) : TACOZ_OK;
+}
+
+/** Build the merged archive into @p out_fd. */
+static int merge_into(int out_fd, shard_t *shards, size_t n, const char * const *paths,
+                      const tacozip_merge_opts_t *o, taco_ghost_t *g, taco_ghost_t *sg) {
+    size_t *slot_shard = malloc(TACO_GHOST_V2_MAX_SLOTS * sizeof(*slot_shard));
+    if (!slot_shard) return TACOZ_ERR_IO;
+
+    int v2 = 0, rc = TACOZ_OK;
+    uint32_t dostime = TACOZ_DOS_EPOCH;
+    for (size_t i = 0; rc == TACOZ_OK && i < n; i++)
+        rc = open_shard(paths[i], &shards[i], g, sg, slot_shard, i, &v2, &dostime);
+    if (g->count > TACO_GHOST_MAX_ENTRIES) v2 = 1;
+    if (!v2) {
+        g->flags = 0;
+        memset(g->inline_len, 0, sizeof(g->inline_len));
+        g->inline_used = 0;
+    }
+    uint64_t size = tacoz_ghost_used(g, v2 ? 2 : 1) + (v2 ? o->ghost_slack : 0);
+    if (rc == TACOZ_OK && size > UINT32_MAX) rc = TACOZ_ERR_PARAM;
+
+    /* Place every region, then move the slots with their shard's data. */
+    uint64_t align = o->align ? o->align : TACOZ_MERGE_ALIGN;
+    uint64_t pos = TACOZ_LFH_TOTAL(TACO_GHOST_NAME_LEN) + size;
+    for (size_t i = 0; rc == TACOZ_OK && i < n; i++) {
+        shard_t *s = &shards[i];
+        s->pad = (s->body - pos) & (align - 1);
+        pos += s->pad;
+        s->delta = pos - s->body;
+        pos += s->tail.cd_off - s->body;
+    }
+    for (size_t i = 0; i < g->count; i++)
+        if (g->slots[i].offset || g->slots[i].length)
+            g->slots[i].offset += shards[slot_shard[i]].delta;
+    free(slot_shard);
+
+    unsigned char lfh[TACOZ_LFH_TOTAL(TACO_GHOST_NAME_LEN)];
+    tacoz_ghost_lfh_build(lfh, dostime, size);
+    unsigned char *payload = calloc(1, (size_t)size);
+    unsigned char *zeros = calloc(1, (size_t)align);
+    if (rc == TACOZ_OK && (!payload || !zeros)) rc = TACOZ_ERR_IO;
+    if (rc == TACOZ_OK) rc = tacoz_write_all(out_fd, lfh, sizeof(lfh));
+    if (rc == TACOZ_OK) rc = tacoz_write_all(out_fd, payload, (size_t)size);
+    for (size_t i = 0; rc == TACOZ_OK && i < n; i++) {
+        rc = write_zeros(out_fd, zeros, shards[i].pad);
+        if (rc == TACOZ_OK)
+            rc = tacoz_copy_fd(shards[i].fd, shards[i].body, out_fd,
+                               shards[i].tail.cd_off - shards[i].body);
+    }
+    free(zeros);
+
+    /* Directory: the new ghost's record, then every shard's in order. */
+    merge_cd_t m;
+    memset(&m, 0, sizeof(m));
+    m.fd = out_fd;
+    m.pos = pos;
+    m.sorted = 1;
+    m.buf = malloc(TACOZ_MERGE_CD_BUF);
+    m.last = malloc(0x10000u);
+    if (rc == TACOZ_OK && (!m.buf || !m.last)) rc = TACOZ_ERR_IO;
+    if (rc == TACOZ_OK) {
+        tacoz_cd_entry_t e;
+        e.lfh_off  = 0;
+        e.size     = size;
+        e.crc      = 0;  /* patched with the payload */
+        e.mode     = TACOZ_DEFAULT_MODE;
+        e.dostime  = dostime;
+        e.name_len = TACO_GHOST_NAME_LEN;
+        e.name     = TACO_GHOST_NAME;
+        tacoz_cdh_build(&e, m.buf);
+        m.len = TACOZ_CDH_TOTAL(TACO_GHOST_NAME_LEN);
+    }
+    for (size_t i = 0; rc == TACOZ_OK && i < n; i++) {
+        m.shard = &shards[i];
+        rc = tacoz_cd_scan(shards[i].fd, &shards[i].tail, merge_cdh, &m);
+    }
+    if (rc == TACOZ_OK) rc = cd_flush(&m);
+
+    /* A sorted directory was checked record by record; any other is checked
+     * by name hash before the tail makes it an archive. */
+    uint64_t cd_off = pos, entries = m.entries + 1;
+    if (rc == TACOZ_OK && !m.sorted) {
+        int dup;
+        rc = find_duplicate(out_fd, cd_off, m.pos - cd_off, entries, &dup);
+        if (rc == TACOZ_OK && dup) rc = TACOZ_ERR_PARAM;
+    }
+    if (rc == TACOZ_OK) {
+        unsigned char t[TACOZ_TAIL_SIZE];
+        tacoz_tail_build(t, entries, m.pos - cd_off, cd_off, m.pos);
+        rc = tacoz_write_all(out_fd, t, sizeof(t));
+    }
+
+    /* The directory is final: fill in the ghost and both CRCs. */
+    if (rc == TACOZ_OK) {
+        g->cd_offset = cd_off;
+        g->cd_size = m.pos - cd_off;
+        g->cd_entries = entries;
+        g->generation = 1;
+        if (v2 && m.sorted) g->flags |= TACO_GHOST_F_CD_SORTED;
+        rc = tacoz_ghost_slot_crcs(out_fd, g);
+        if (rc == TACOZ_OK) rc = tacoz_ghost_encode(g, v2 ? 2 : 1, payload, (size_t)size);
+    }
+    if (rc == TACOZ_OK) {
+        unsigned char crc[4];
+        le32(crc, tacoz_crc32(0, payload, (size_t)size));
+        rc = tacoz_pwrite_all(out_fd, payload, (size_t)size, sizeof(lfh));
+        if (rc == TACOZ_OK) rc = tacoz_pwrite_all(out_fd, crc, 4, 14);
+        if (rc == TACOZ_OK) rc = tacoz_pwrite_all(out_fd, crc, 4, cd_off + 16);
+    }
+    free(m.buf);
+    free(m.last);
+    free(payload);
+    return rc;
+}
+
+void tacozip_merge_opts_init(tacozip_merge_opts_t *opts) {
+    if (!opts) return;
+    memset(opts, 0, sizeof(*opts));
+    opts->align = TACOZ_MERGE_ALIGN;
+    opts->ghost_slack = 0;
+    opts->durability = TACOZ_DURABILITY;
+}
+
+int tacozip_merge(const char *zip_path, const char * const *shard_paths, size_t num_shards,
+                  const tacozip_merge_opts_t *opts) {
+    tacozip_merge_opts_t o;
+    if (opts) o = *opts;
+    else tacozip_merge_opts_init(&o);
+    if (!zip_path || !shard_paths || num_shards == 0 || num_shards > SIZE_MAX / sizeof(shard_t) ||
+        o.align > TACOZ_UNIFORM_ALIGN_MAX || (o.align & (o.align - 1)) ||
+        o.durability < TACOZIP_DURABLE_NONE || o.durability > TACOZIP_DURABLE_FULL)
+        return TACOZ_ERR_PARAM;
+    for (size_t i = 0; i < num_shards; i++)
+        if (!shard_paths[i]) return TACOZ_ERR_PARAM;
+
+    shard_t *shards = calloc(num_shards, sizeof(*shards));
+    taco_ghost_t *g = malloc(sizeof(*g)), *sg = malloc(sizeof(*sg));
+    if (!shards || !g || !sg) {
+        free(shards);
+        free(g);
+        free(sg);
+        return TACOZ_ERR_IO;
+    }
+    for (size_t i = 0; i < num_shards; i++) shards[i].fd = -1;
+    tacozip_ghost_init(g);
+
+    char *tmp = NULL;
+    int out_fd = tacoz_create_unnamed(zip_path, &tmp);
+    int rc = out_fd < 0 ? TACOZ_ERR_IO : merge_into(out_fd, shards, num_shards, shard_paths,
+                                                    &o, g, sg);
+    if (rc == TACOZ_OK) rc = tacoz_publish(out_fd, tmp, zip_path, o.durability);
+    else if (out_fd >= 0) tacoz_close(out_fd);
+    if (rc != TACOZ_OK && tmp) tacoz_unlink(tmp);
+
+    for (size_t i = 0; i < num_shards; i++)
+        if (shards[i].fd >= 0) tacoz_close(shards[i].fd);
+    free(tmp);
+    free(shards);
+    free(g);
+    free(sg);
+    return rc;
+}
@@ -0,0 +1,301 @@
+/*
+ * tacozip_nameidx.c — perfect-hash name index entries.
+ *
+ * The index maps every entry name to its data location, size and CRC through a
+ * hash-and-displace perfect hash (PTHash style): names are split into buckets
+ * of about TACOZ_NAMEIDX_BUCKET keys, and each bucket gets a 16-bit pilot
+ * that scatters its keys into free slots of a table slightly larger than the
+ * key set. Buckets are placed largest first, so the pilot search stays short
+ * until the table is nearly full. A reader needs the pilot and the slot: two
+ * small reads, no table to build. See "Name index entry layout" in tacozip.h.
+ */
+
+#include "tacozip_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef TACOZ_NAMEIDX_BUCKET
+#define TACOZ_NAMEIDX_BUCKET 4u    /* average keys per bucket */
+#endif
+
+#define SLOT_SIZE    32u
+#define MAX_PILOT    0xFFFFu
+#define MAX_RESEEDS  8
+
+/* ------------------------------- Hashing ----------------------------------- */
+
+/** MurmurHash3 64-bit finalizer. */
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t tacoz_name_hash(const char *name, size_t len, uint64_t seed) {
+    const unsigned char *p = (const unsigned char *)name;
+    uint64_t h = 0xcbf29ce484222325ull ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return mix64(h);
+}
+
+static uint64_t bucket_of(uint64_t h, uint64_t buckets) {
+    return ((h >> 32) * buckets) >> 32;
+}
+
+static uint64_t slot_of(uint64_t h, uint16_t pilot, uint64_t slots) {
+    return (h ^ mix64(pilot)) % slots;
+}
+
+static size_t pilots_size(uint64_t buckets) {
+    return (size_t)((2u * buckets + 7u) & ~(uint64_t)7u);
+}
+
+/* -------------------------------- Building --------------------------------- */
+
+typedef struct {
+    uint64_t *h;
+    uint64_t  n;
+    uint64_t  seed;
+} hash_pass_t;
+
+static int hash_visit(void *ctx, const tacoz_cd_entry_t *e) {
+    hash_pass_t *p = (hash_pass_t *)ctx;
+    p->h[p->n++] = tacoz_name_hash(e->name, e->name_len, p->seed);
+    return TACOZ_OK;
+}
+
+/** Find a pilot for every bucket. TACOZ_ERR_PARAM if some bucket has none
+ *  (equal hashes); the caller then retries with another seed. */
+static int place(const uint64_t *h, uint64_t n, uint64_t m, uint64_t b, uint16_t *pilots) {
+    uint32_t *count = calloc((size_t)b + 1, sizeof(*count));
+    uint64_t *first = malloc(((size_t)b + 1) * sizeof(*first));
+    uint32_t *keys  = malloc((size_t)n * sizeof(*keys) + 1);
+    uint64_t *taken = calloc((size_t)((m + 63) / 64), sizeof(*taken));
+    int rc = count && first && keys && taken ? TACOZ_OK : TACOZ_ERR_IO;
+
+    /* Group key indices by bucket (counting sort). */
+    uint32_t largest = 0;
+    if (rc == TACOZ_OK) {
+        for (uint64_t i = 0; i < n; i++) count[bucket_of(h[i], b)]++;
+        first[0] = 0;
+        for (uint64_t k = 0; k < b; k++) {
+            first[k + 1] = first[k] + count[k];
+            if (count[k] > largest) largest = count[k];
+        }
+        memset(count, 0, (size_t)b * sizeof(*count));
+        for (uint64_t i = 0; i < n; i++) {
+            uint64_t k = bucket_of(h[i], b);
+            keys[first[k] + count[k]++] = (uint32_t)i;
+        }
+    }
+
+    uint64_t pos[64];
+    for (uint32_t size = largest; rc == TACOZ_OK && size > 0; size--) {
+        for (uint64_t k = 0; rc == TACOZ_OK && k < b; k++) {
+            if (count[k] != size) continue;
+            if (size > sizeof(pos) / sizeof(pos[0])) { rc = TACOZ_ERR_PARAM; break; }
+
+            const uint32_t *ks = keys + first[k];
+            uint32_t pilot = 0;
+            for (; pilot <= MAX_PILOT; pilot++) {
+                uint32_t j = 0;
+                for (; j < size; j++) {
+                    uint64_t s = slot_of(h[ks[j]], (uint16_t)pilot, m);
+                    if (taken[s / 64] & (1ull << (s % 64))) break;
+                    uint32_t q = 0;
+                    while (q < j && pos[q] != s) q++;
+                    if (q < j) break;
+                    pos[j] = s;
+                }
+                if (j == size) break;
+            }
+            if (pilot > MAX_PILOT) { rc = TACOZ_ERR_PARAM; break; }
+            for (uint32_t j = 0; j < size; j++) taken[pos[j] / 64] |= 1ull << (pos[j] % 64);
+            pilots[k] = (uint16_t)pilot;
+        }
+    }
+
+    free(count);
+    free(first);
+    free(keys);
+    free(taken);
+    return rc;
+}
+
+typedef struct {
+    unsigned char  *slots;
+    const uint64_t *h;
+    const uint16_t *pilots;
+    uint64_t        i, m, b, seed;
+    uint64_t        base;  /* data offset of the index itself */
+} fill_pass_t;
+
+static int fill_visit(void *ctx, const tacoz_cd_entry_t *e) {
+    fill_pass_t *f = (fill_pass_t *)ctx;
+    uint64_t h = f->h[f->i++];
+    uint64_t s = slot_of(h, f->pilots[bucket_of(h, f->b)], f->m);
+    unsigned char *r = f->slots + s * SLOT_SIZE;
+    le64(r +  0, tacoz_name_hash(e->name, e->name_len, f->seed ^ TACO_NAME_INDEX_FP_SALT));
+    le64(r +  8, f->base - (e->lfh_off + TACOZ_LFH_TOTAL(e->name_len)));
+    le64(r + 16, e->size);
+    le32(r + 24, e->crc);
+    le32(r + 28, 0);
+    return TACOZ_OK;
+}
+
+int tacoz_nameidx_build(tacoz_cdstore_t *cd, uint64_t base,
+                        unsigned char **out, size_t *out_len) {
+    *out = NULL;
+    *out_len = 0;
+
+    uint64_t n = tacoz_cdstore_count(cd);
+    if (n > UINT32_MAX) return TACOZ_ERR_PARAM;
+    uint64_t m = n + n / 32 + 1;                       /* ~97% load */
+    uint64_t b = n / TACOZ_NAMEIDX_BUCKET + 1;
+    if (m > (SIZE_MAX - TACO_NAME_INDEX_HEADER_SIZE - pilots_size(b)) / SLOT_SIZE)
+        return TACOZ_ERR_IO;
+    size_t len = TACO_NAME_INDEX_HEADER_SIZE + pilots_size(b) + (size_t)m * SLOT_SIZE;
+
+    unsigned char *buf = calloc(1, len);
+    uint64_t *h = malloc((size_t)n * sizeof(*h) + 1);
+    int rc = buf && h ? TACOZ_OK : TACOZ_ERR_IO;
+    uint16_t *pilots = NULL;
+    if (rc == TACOZ_OK && !(pilots = calloc((size_t)b, sizeof(*pilots)))) rc = TACOZ_ERR_IO;
+
+    /* Equal hashes for distinct names are vanishingly rare; a new seed fixes
+     * them. Duplicate names never separate and end in TACOZ_ERR_PARAM. */
+    uint64_t seed = 0x7461636f7a6970ull;               /* "tacozip" */
+    for (int attempt = 0; rc == TACOZ_OK; attempt++) {
+        hash_pass_t hp = { h, 0, seed };
+        rc = tacoz_cdstore_foreach(cd, hash_visit, &hp);
+        if (rc == TACOZ_OK) rc = place(h, n, m, b, pilots);
+        if (rc != TACOZ_ERR_PARAM || attempt + 1 == MAX_RESEEDS) break;
+        seed = mix64(seed + 1);
+        rc = TACOZ_OK;
+    }
+
+    if (rc == TACOZ_OK) {
+        memcpy(buf, TACO_NAME_INDEX_MAGIC, 4);
+        le16(buf + 4, TACO_NAME_INDEX_VERSION);
+        le16(buf + 6, TACO_NAME_INDEX_HEADER_SIZE);
+        le64(buf + 8, seed);
+        le64(buf + 16, n);
+        le64(buf + 24, m);
+        le64(buf + 32, b);
+        for (uint64_t k = 0; k < b; k++) le16(buf + TACO_NAME_INDEX_HEADER_SIZE + 2 * k, pilots[k]);
+
+        fill_pass_t fp = { buf + TACO_NAME_INDEX_HEADER_SIZE + pilots_size(b), h, pilots, 0, m, b, seed, base };
+        rc = tacoz_cdstore_foreach(cd, fill_visit, &fp);
+    }
+
+    free(h);
+    free(pilots);
+    if (rc != TACOZ_OK) {
+        free(buf);
+        return rc;
+    }
+    *out = buf;
+    *out_len = len;
+    return TACOZ_OK;
+}
+
+/* -------------------------------- Lookups ---------------------------------- */
+
+typedef struct {
+    uint64_t seed, n, m, b;
+    uint64_t pilots_off;  /* offset of the pilot table (header size) */
+    uint64_t slots_off;   /* offset of the slot table */
+} index_hdr_t;
+
+static int parse_hdr(const unsigned char *p, size_t len, index_hdr_t *x) {
+    if (len < TACO_NAME_INDEX_HEADER_SIZE || memcmp(p, TACO_NAME_INDEX_MAGIC, 4) != 0 ||
+        le16_read(p + 4) != TACO_NAME_INDEX_VERSION)
+        return TACOZ_ERR_INVALID_GHOST;
+    x->pilots_off = le16_read(p + 6);
+    x->seed = le64_read(p + 8);
+    x->n    = le64_read(p + 16);
+    x->m    = le64_read(p + 24);
+    x->b    = le64_read(p + 32);
+    if (x->pilots_off < TACO_NAME_INDEX_HEADER_SIZE || x->m == 0 || x->b == 0 ||
+        x->b > UINT32_MAX || x->m > UINT64_MAX / SLOT_SIZE)
+        return TACOZ_ERR_INVALID_GHOST;
+    x->slots_off = x->pilots_off + pilots_size(x->b);
+    return TACOZ_OK;
+}
+
+static int slot_match(const index_hdr_t *x, const unsigned char *r, uint64_t base,
+                      const char *name, size_t len, taco_index_entry_t *out) {
+    uint64_t back = le64_read(r + 8);
+    if (back == 0 ||
+        le64_read(r) != tacoz_name_hash(name, len, x->seed ^ TACO_NAME_INDEX_FP_SALT))
+        return TACOZ_ERR_NOT_FOUND;
+    if (back > base) return TACOZ_ERR_INVALID_GHOST;
+    out->offset = base - back;
+    out->length = le64_read(r + 16);
+    out->crc32  = le32_read(r + 24);
+    return TACOZ_OK;
+}
+
+int tacozip_name_index_find(const void *index, size_t len, uint64_t index_offset,
+                            const char *name, taco_index_entry_t *out) {
+    if (!index || !name || !out) return TACOZ_ERR_PARAM;
+    const unsigned char *p = (const unsigned char *)index;
+    index_hdr_t x;
+    int rc = parse_hdr(p, len, &x);
+    if (rc != TACOZ_OK) return rc;
+
+    size_t nlen = strlen(name);
+    uint64_t h = tacoz_name_hash(name, nlen, x.seed);
+    uint64_t po = x.pilots_off + 2 * bucket_of(h, x.b);
+    if (po + 2 > len) return TACOZ_ERR_INVALID_GHOST;
+    uint64_t so = x.slots_off + slot_of(h, le16_read(p + po), x.m) * SLOT_SIZE;
+    if (so + SLOT_SIZE > len) return TACOZ_ERR_INVALID_GHOST;
+    return slot_match(&x, p + so, index_offset, name, nlen, out);
+}
+
+int tacozip_find_indexed(const char *zip_path, unsigned slot, const char *name,
+                         taco_index_entry_t *out) {
+    if (!zip_path || !name || !out || slot >= TACO_GHOST_V2_MAX_SLOTS) return TACOZ_ERR_PARAM;
+
+    taco_ghost_t *g = malloc(sizeof(*g));
+    if (!g) return TACOZ_ERR_IO;
+    int rc = tacozip_read_ghost_v2(zip_path, g);
+    uint64_t base = 0, size = 0;
+    if (rc == TACOZ_OK && slot >= g->count) rc = TACOZ_ERR_PARAM;
+    if (rc == TACOZ_OK) {
+        base = g->slots[slot].offset;
+        size = g->slots[slot].length;
+    }
+    free(g);
+    if (rc != TACOZ_OK) return rc;
+
+    int fd = tacoz_open_read(zip_path);
+    if (fd < 0) return TACOZ_ERR_IO;
+
+    /* Header, pilot, slot: three small positioned reads. */
+    unsigned char hdr[TACO_NAME_INDEX_HEADER_SIZE], pilot[2], rec[SLOT_SIZE];
+    index_hdr_t x;
+    size_t nlen = strlen(name);
+    uint64_t h = 0, po = 0, so = 0;
+    rc = size < sizeof(hdr) ? TACOZ_ERR_INVALID_GHOST : tacoz_pread_all(fd, hdr, sizeof(hdr), base);
+    if (rc == TACOZ_OK) rc = parse_hdr(hdr, sizeof(hdr), &x);
+    if (rc == TACOZ_OK) {
+        h = tacoz_name_hash(name, nlen, x.seed);
+        po = x.pilots_off + 2 * bucket_of(h, x.b);
+        rc = po + 2 > size ? TACOZ_ERR_INVALID_GHOST : tacoz_pread_all(fd, pilot, 2, base + po);
+    }
+    if (rc == TACOZ_OK) {
+        so = x.slots_off + slot_of(h, le16_read(pilot), x.m) * SLOT_SIZE;
+        rc = so + SLOT_SIZE > size ? TACOZ_ERR_INVALID_GHOST
+                                   : tacoz_pread_all(fd, rec, SLOT_SIZE, base + so);
+    }
+    if (rc == TACOZ_OK) rc = slot_match(&x, rec, base, name, nlen, out);
+    tacoz_close(fd);
+    return rc;
+}
@@ -0,0 +1,245 @@
+/*
+ * tacozip_reader.c — shared read-only archive handles.
+ *
+ * Opening a reader maps the central directory once and records where each
+ * entry's record starts; unsorted directories also get an open-addressing
+ * name table. None of it changes after tacozip_reader_open(), and entry data
+ * is read with positioned reads on a single descriptor, so any number of
+ * threads can look up and read through one handle without locking.
+ * tacozip_reader_open_version() does the same for any directory a log
+ * commit published, found by generation.
+ */
+
+#include "tacozip_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct tacozip_reader {
+    int           fd;
+    tacoz_view_t  cd;         /* central directory image                    */
+    uint64_t     *rec;        /* directory offset of each entry's record    */
+    uint64_t      count;      /* entries, ghost excluded                    */
+    uint64_t     *table;      /* entry index + 1 per slot (0 = empty)       */
+    uint64_t      mask;       /* table slots - 1                            */
+    uint64_t      seed;
+    int           sorted;     /* TACO_GHOST_F_CD_SORTED: bisect instead     */
+    int           has_ghost;
+    taco_ghost_t  ghost;
+};
+
+static void entry_info(const tacoz_cdh_t *c, taco_entry_info_t *e) {
+    e->name              = c->name;
+    e->name_len          = c->name_len;
+    e->method            = c->method;
+    e->crc32             = c->crc;
+    e->compressed_size   = c->csize;
+    e->uncompressed_size = c->usize;
+    e->lfh_offset        = c->lfh_off;
+}
+
+static int parse_at(const tacozip_reader_t *r, uint64_t off, tacoz_cdh_t *c) {
+    if (off >= r->cd.len) return TACOZ_ERR_INVALID_GHOST;
+    int64_t n = tacoz_cdh_parse(r->cd.data + off, r->cd.len - (size_t)off, off, c);
+    return n > 0 ? TACOZ_OK : TACOZ_ERR_INVALID_GHOST;
+}
+
+static int is_ghost(const tacoz_cdh_t *c) {
+    return c->lfh_off == 0 && c->name_len == TACO_GHOST_NAME_LEN &&
+           memcmp(c->name, TACO_GHOST_NAME, TACO_GHOST_NAME_LEN) == 0;
+}
+
+/** Record offsets of every entry but the ghost, in directory order. */
+static int index_records(tacozip_reader_t *r, uint64_t entries) {
+    if (entries > SIZE_MAX / sizeof(*r->rec)) return TACOZ_ERR_IO;
+    r->rec = malloc((size_t)entries * sizeof(*r->rec) + 1);
+    if (!r->rec) return TACOZ_ERR_IO;
+
+    size_t off = 0;
+    for (uint64_t i = 0; i < entries; i++) {
+        tacoz_cdh_t c;
+        int64_t n = off < r->cd.len ? tacoz_cdh_parse(r->cd.data + off, r->cd.len - off, off, &c) : 0;
+        if (n <= 0) return TACOZ_ERR_INVALID_GHOST;
+        if (!(i == 0 && is_ghost(&c))) r->rec[r->count++] = off;
+        off += (size_t)n;
+    }
+    return TACOZ_OK;
+}
+
+/** Name table for unsorted directories, at most half full. */
+static int build_table(tacozip_reader_t *r) {
+    uint64_t slots = 16;
+    while (slots < 2 * r->count) slots *= 2;
+    if (slots > SIZE_MAX / sizeof(*r->table)) return TACOZ_ERR_IO;
+    r->table = calloc((size_t)slots, sizeof(*r->table));
+    if (!r->table) return TACOZ_ERR_IO;
+    r->mask = slots - 1;
+    r->seed = 0x7461636f7a6970ull;
+
+    for (uint64_t i = 0; i < r->count; i++) {
+        tacoz_cdh_t c;
+        if (parse_at(r, r->rec[i], &c) != TACOZ_OK) return TACOZ_ERR_INVALID_GHOST;
+        uint64_t s = tacoz_name_hash(c.name, c.name_len, r->seed) & r->mask;
+        while (r->table[s]) s = (s + 1) & r->mask;
+        r->table[s] = i + 1;
+    }
+    return TACOZ_OK;
+}
+
+typedef struct {
+    uint64_t      generation;
+    tacoz_tail_t *tail;
+    int           found;
+} version_find_t;
+
+static int find_version(void *user, const tacozip_log_version_t *v) {
+    version_find_t *f = (version_find_t *)user;
+    if (f->generation && v->generation != f->generation) return 0;
+    f->tail->cd_off  = v->cd_offset;
+    f->tail->cd_size = v->cd_size;
+    f->tail->entries = v->cd_entries;
+    f->found = 1;
+    return 1;
+}
+
+/** Open @p zip_path at the directory the file ends with, or with @p by_log
+ *  at the published version @p generation (0 = newest). */
+static int reader_open(const char *zip_path, int by_log, uint64_t generation,
+                       tacozip_reader_t **out) {
+    if (!zip_path || !out) return TACOZ_ERR_PARAM;
+    *out = NULL;
+
+    tacozip_reader_t *r = calloc(1, sizeof(*r));
+    if (!r) return TACOZ_ERR_IO;
+    r->fd = tacoz_open_read(zip_path);
+    if (r->fd < 0) {
+        free(r);
+        return TACOZ_ERR_IO;
+    }
+
+    /* The ghost is optional: any ZIP64 or classic archive can be read. */
+    tacoz_ghost_loc_t loc;
+    int rc = tacoz_ghost_locate(r->fd, &loc);
+    if (rc == TACOZ_OK) rc = tacoz_ghost_read(r->fd, &loc, &r->ghost);
+    if (rc == TACOZ_OK) {
+        r->has_ghost = 1;
+        r->sorted = r->ghost.version == 2 && (r->ghost.flags & TACO_GHOST_F_CD_SORTED);
+    }
+
+    tacoz_tail_t tail;
+    version_find_t f = {generation, &tail, 0};
+    if (rc == TACOZ_ERR_INVALID_GHOST) rc = TACOZ_OK;
+    if (rc == TACOZ_OK && by_log) {
+        rc = tacoz_log_walk(r->fd, r->has_ghost ? &r->ghost : NULL, find_version, &f);
+        if (rc == TACOZ_OK && !f.found) rc = TACOZ_ERR_NOT_FOUND;
+    } else if (rc == TACOZ_OK) {
+        rc = tacoz_read_tail(r->fd, &tail);
+    }
+    if (rc == TACOZ_OK) rc = tacoz_view_open(r->fd, tail.cd_off, tail.cd_size, &r->cd);
+    if (rc == TACOZ_OK) rc = index_records(r, tail.entries);
+    if (rc == TACOZ_OK && !r->sorted) rc = build_table(r);
+    if (rc != TACOZ_OK) {
+        tacozip_reader_close(r);
+        return rc;
+    }
+    *out = r;
+    return TACOZ_OK;
+}
+
+int tacozip_reader_open(const char *zip_path, tacozip_reader_t **out) {
+    return reader_open(zip_path, 0, 0, out);
+}
+
+int tacozip_reader_open_version(const char *zip_path, uint64_t generation,
+                                tacozip_reader_t **out) {
+    return reader_open(zip_path, 1, generation, out);
+}
+
+int tacozip_log_versions(const char *zip_path, tacozip_log_fn fn, void *user) {
+    if (!zip_path || !fn) return TACOZ_ERR_PARAM;
+    int fd = tacoz_open_read(zip_path);
+    if (fd < 0) return TACOZ_ERR_IO;
+
+    taco_ghost_t g;
+    tacoz_ghost_loc_t loc;
+    int rc = tacoz_ghost_locate(fd, &loc);
+    if (rc == TACOZ_OK) rc = tacoz_ghost_read(fd, &loc, &g);
+    if (rc == TACOZ_OK || rc == TACOZ_ERR_INVALID_GHOST)
+        rc = tacoz_log_walk(fd, rc == TACOZ_OK ? &g : NULL, fn, user);
+    tacoz_close(fd);
+    return rc;
+}
+
+void tacozip_reader_close(tacozip_reader_t *r) {
+    if (!r) return;
+    tacoz_view_close(&r->cd);
+    if (r->fd >= 0) tacoz_close(r->fd);
+    free(r->rec);
+    free(r->table);
+    free(r);
+}
+
+uint64_t tacozip_reader_count(const tacozip_reader_t *r) {
+    return r ? r->count : 0;
+}
+
+int tacozip_reader_ghost(const tacozip_reader_t *r, taco_ghost_t *out) {
+    if (!r || !out) return TACOZ_ERR_PARAM;
+    if (!r->has_ghost) return TACOZ_ERR_INVALID_GHOST;
+    *out = r->ghost;
+    return TACOZ_OK;
+}
+
+int tacozip_reader_entry(const tacozip_reader_t *r, uint64_t index, taco_entry_info_t *out) {
+    if (!r || !out) return TACOZ_ERR_PARAM;
+    if (index >= r->count) return TACOZ_ERR_NOT_FOUND;
+    tacoz_cdh_t c;
+    int rc = parse_at(r, r->rec[index], &c);
+    if (rc == TACOZ_OK) entry_info(&c, out);
+    return rc;
+}
+
+int tacozip_reader_find(const tacozip_reader_t *r, const char *name, taco_entry_info_t *out) {
+    if (!r || !name || !out) return TACOZ_ERR_PARAM;
+    if (r->sorted) return tacozip_cd_find(r->cd.data, r->cd.len, 1, name, out);
+
+    size_t len = strlen(name);
+    for (uint64_t s = tacoz_name_hash(name, len, r->seed) & r->mask; r->table[s];
+         s = (s + 1) & r->mask) {
+        tacoz_cdh_t c;
+        if (parse_at(r, r->rec[r->table[s] - 1], &c) != TACOZ_OK) return TACOZ_ERR_INVALID_GHOST;
+        if (c.name_len == len && memcmp(c.name, name, len) == 0) {
+            entry_info(&c, out);
+            return TACOZ_OK;
+        }
+    }
+    return TACOZ_ERR_NOT_FOUND;
+}
+
+int tacozip_reader_data_offset(const tacozip_reader_t *r, const taco_entry_info_t *e,
+                               uint64_t *offset) {
+    if (!r || !e || !offset) return TACOZ_ERR_PARAM;
+
+    /* The local header's name and extra lengths may differ from the central
+     * directory's, so the header itself says where the data starts. */
+    unsigned char lfh[TACOZ_LFH_SIZE];
+    int rc = tacoz_pread_all(r->fd, lfh, sizeof(lfh), e->lfh_offset);
+    if (rc != TACOZ_OK) return rc;
+    if (le32_read(lfh) != TACOZ_SIG_LFH) return TACOZ_ERR_INVALID_GHOST;
+    *offset = e->lfh_offset + TACOZ_LFH_SIZE + le16_read(lfh + 26) + le16_read(lfh + 28);
+    return TACOZ_OK;
+}
+
+int tacozip_reader_read(const tacozip_reader_t *r, const taco_entry_info_t *e,
+                        uint64_t offset, void *buf, size_t len, size_t *out_len) {
+    if (!r || !e || !out_len || (!buf && len)) return TACOZ_ERR_PARAM;
+    *out_len = 0;
+    if (e->method != 0) return TACOZ_ERR_PARAM;  /* STORE only */
+    if (offset >= e->compressed_size) return TACOZ_OK;
+    if (len > e->compressed_size - offset) len = (size_t)(e->compressed_size - offset);
+
+    uint64_t data;
+    int rc = tacozip_reader_data_offset(r, e, &data);
+    if (rc == TACOZ_OK && len) rc = tacoz_pread_all(r->fd, buf, len, data + offset);
+    if (rc == TACOZ_OK) *out_len = len;
+    return rc;
+}
@@ -0,0 +1,183 @@
+/*
+ * tacozip_rewrite.c — native whole-archive rewrites.
+ *
+ * Entry data is position independent (LFHs carry no absolute offsets), so an
+ * archive can be rebuilt by copying the entry region verbatim, in-kernel
+ * where possible, and re-emitting only the central directory with shifted
+ * offsets. Used when an in-place ghost update runs out of room.
+ */
+
+/* Platform-specific feature detection */
+#if defined(__linux__) || defined(__gnu_linux__)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64  /* large-file I/O on POSIX */
+#endif
+
+#include "tacozip_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Central-directory output is batched into writes of about this size. */
+#define TACOZ_REWRITE_CD_BUF (256u << 10)
+
+typedef struct {
+    int            fd;
+    uint64_t       pos;        /* output offset of buf[0]                */
+    unsigned char *buf;
+    size_t         len;
+    int64_t        delta;      /* shift applied to every entry offset     */
+    uint64_t       ghost_size; /* new stored ghost payload size           */
+    uint64_t       ghost_cdh;  /* output offset of the ghost's CD record  */
+    uint64_t       entries;
+    int            seen_ghost;
+} rewrite_cd_t;
+
+static int cd_flush(rewrite_cd_t *r) {
+    int rc = tacoz_write_all(r->fd, r->buf, r->len);
+    r->pos += r->len;
+    r->len = 0;
+    return rc;
+}
+
+static int rewrite_cdh(void *ctx, const tacoz_cdh_t *c) {
+    rewrite_cd_t *r = (rewrite_cd_t *)ctx;
+    if (TACOZ_REWRITE_CD_BUF - r->len < TACOZ_CDH_REBUILD_MAX(c->rec_len) &&
+        cd_flush(r) != TACOZ_OK)
+        return TACOZ_ERR_IO;
+
+    tacoz_cdh_t e = *c;
+    uint64_t lfh_off = c->lfh_off + (uint64_t)r->delta;
+    if (!r->seen_ghost && c->lfh_off == 0 && c->name_len == TACO_GHOST_NAME_LEN &&
+        memcmp(c->name, TACO_GHOST_NAME, TACO_GHOST_NAME_LEN) == 0) {
+        /* The ghost stays at byte 0; size and CRC are patched at the end. */
+        r->seen_ghost = 1;
+        r->ghost_cdh = r->pos + r->len;
+        e.usize = e.csize = r->ghost_size;
+        e.crc = 0;
+        lfh_off = 0;
+    }
+
+    size_t n = tacoz_cdh_rebuild(&e, lfh_off, r->buf + r->len);
+    if (n == 0) return TACOZ_ERR_INVALID_GHOST;
+    r->len += n;
+    r->entries++;
+    return 0;
+}
+
+/** Rebuild @p in_fd into @p out_fd with ghost @p g (offsets already final). */
+static int rewrite_with_ghost(int in_fd, int out_fd, taco_ghost_t *g, uint64_t slack) {
+    tacoz_ghost_loc_t loc;
+    tacoz_tail_t tail;
+    unsigned char lfh[TACOZ_LFH_SIZE], head[TACOZ_GHOST_LAYOUT_HEAD];
+    memset(&loc, 0, sizeof(loc));
+    int rc = tacoz_ghost_locate(in_fd, &loc);
+    if (rc == TACOZ_OK) rc = tacoz_read_tail(in_fd, &tail);
+    if (rc == TACOZ_OK) rc = tacoz_pread_all(in_fd, lfh, sizeof(lfh), 0);
+    size_t head_len = loc.size < sizeof(head) ? (size_t)loc.size : sizeof(head);
+    if (rc == TACOZ_OK) rc = tacoz_pread_all(in_fd, head, head_len, loc.data_off);
+    if (rc != TACOZ_OK) return rc;
+    g->generation = tacoz_ghost_generation(head, head_len) + 1;
+    /* Records are re-emitted in their current order, so sortedness carries
+     * over, and the entry region moves as a block, so a uniform run does. */
+    tacoz_ghost_keep_layout(g, head, head_len);
+
+    uint64_t old_end = loc.data_off + loc.size;
+    uint64_t size = tacoz_ghost_used(g, 2) + slack;
+    if (tail.cd_off < old_end) return TACOZ_ERR_INVALID_GHOST;
+    if (g->flags & TACO_GHOST_F_UNIFORM) {
+        /* Grow the slack so the run keeps the alignment it was written with. */
+        uint64_t bits = g->uniform_base | g->uniform_stride;
+        uint64_t align = bits & (~bits + 1);  /* lowest set bit */
+        if (align == 0 || align > TACOZ_UNIFORM_ALIGN_MAX) align = TACOZ_UNIFORM_ALIGN_MAX;
+        size += (old_end - TACOZ_LFH_TOTAL(TACO_GHOST_NAME_LEN) - size) & (align - 1);
+    }
+    if (size > UINT32_MAX) return TACOZ_ERR_PARAM;
+
+    /* Slots past the old ghost move with the entries they point at. */
+    uint64_t new_end = TACOZ_LFH_TOTAL(TACO_GHOST_NAME_LEN) + size;
+    int64_t delta = (int64_t)(new_end - old_end);
+    if (g->flags & TACO_GHOST_F_UNIFORM) g->uniform_base += (uint64_t)delta;
+    for (size_t i = 0; i < g->count; i++)
+        if (g->slots[i].offset >= old_end) g->slots[i].offset += (uint64_t)delta;
+
+    unsigned char ghost_lfh[TACOZ_LFH_TOTAL(TACO_GHOST_NAME_LEN)];
+    tacoz_ghost_lfh_build(ghost_lfh, le32_read(lfh + 10), size);
+    rc = tacoz_write_all(out_fd, ghost_lfh, sizeof(ghost_lfh));
+    unsigned char *payload = calloc(1, (size_t)size ? (size_t)size : 1);
+    if (!payload) return TACOZ_ERR_IO;
+    if (rc == TACOZ_OK) rc = tacoz_write_all(out_fd, payload, (size_t)size);
+    if (rc == TACOZ_OK) rc = tacoz_copy_fd(in_fd, old_end, out_fd, tail.cd_off - old_end);
+
+    rewrite_cd_t r;
+    memset(&r, 0, sizeof(r));
+    r.fd = out_fd;
+    r.pos = tail.cd_off + (uint64_t)delta;
+    r.delta = delta;
+    r.ghost_size = size;
+    r.buf = malloc(TACOZ_REWRITE_CD_BUF);
+    if (rc == TACOZ_OK && !r.buf) rc = TACOZ_ERR_IO;
+    if (rc == TACOZ_OK) rc = tacoz_cd_scan(in_fd, &tail, rewrite_cdh, &r);
+    if (rc == TACOZ_OK && !r.seen_ghost) rc = TACOZ_ERR_INVALID_GHOST;
+    if (rc == TACOZ_OK) rc = cd_flush(&r);
+
+    uint64_t cd_off = tail.cd_off + (uint64_t)delta;
+    if (rc == TACOZ_OK) {
+        unsigned char t[TACOZ_TAIL_SIZE];
+        tacoz_tail_build(t, r.entries, r.pos - cd_off, cd_off, r.pos);
+        rc = tacoz_write_all(out_fd, t, sizeof(t));
+    }
+
+    /* Now that the directory is final, fill in the ghost and both CRCs. */
+    if (rc == TACOZ_OK) {
+        g->cd_offset = cd_off;
+        g->cd_size = r.pos - cd_off;
+        g->cd_entries = r.entries;
+        rc = tacoz_ghost_slot_crcs(out_fd, g);
+        if (rc == TACOZ_OK) rc = tacoz_ghost_encode(g, 2, payload, (size_t)size);
+    }
+    if (rc == TACOZ_OK) {
+        unsigned char crc[4];
+        le32(crc, tacoz_crc32(0, payload, (size_t)size));
+        rc = tacoz_pwrite_all(out_fd, payload, (size_t)size, TACOZ_LFH_TOTAL(TACO_GHOST_NAME_LEN));
+        if (rc == TACOZ_OK) rc = tacoz_pwrite_all(out_fd, crc, 4, 14);
+        if (rc == TACOZ_OK) rc = tacoz_pwrite_all(out_fd, crc, 4, r.ghost_cdh + 16);
+    }
+    free(r.buf);
+    free(payload);
+    return rc;
+}
+
+int tacozip_rewrite_ghost(const char *zip_path, const taco_ghost_t *ghost, uint32_t slack,
+                          int durability) {
+    if (durability == TACOZIP_DURABLE_DEFAULT) durability = TACOZ_DURABILITY;
+    if (!zip_path || !ghost || ghost->count > TACO_GHOST_V2_MAX_SLOTS ||
+        durability < TACOZIP_DURABLE_NONE || durability > TACOZIP_DURABLE_FULL)
+        return TACOZ_ERR_PARAM;
+
+    taco_ghost_t *g = malloc(sizeof(*g));
+    if (!g) return TACOZ_ERR_IO;
+    *g = *ghost;
+
+    int in_fd = tacoz_open_read(zip_path);
+    if (in_fd < 0) {
+        free(g);
+        return TACOZ_ERR_IO;
+    }
+    char *tmp = NULL;
+    int out_fd = tacoz_create_unnamed(zip_path, &tmp);
+    int rc = out_fd < 0 ? TACOZ_ERR_IO : tacoz_lock(in_fd, 0);
+    if (rc == TACOZ_OK) rc = rewrite_with_ghost(in_fd, out_fd, g, slack);
+
+    if (rc == TACOZ_OK) rc = tacoz_publish(out_fd, tmp, zip_path, durability);
+    else if (out_fd >= 0) tacoz_close(out_fd);
+    tacoz_close(in_fd);
+    if (rc != TACOZ_OK && tmp) tacoz_unlink(tmp);
+    free(tmp);
+    free(g);
+    return rc;
+}
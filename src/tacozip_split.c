@@ -0,0 +1,623 @@
+/*
+ * tacozip_split.c — cutting an archive into self-contained shards.
+ *
+ * Shard boundaries fall between entries. A shard is a fresh ghost, the local
+ * headers and data of a run of entries copied in-kernel (in one range
+ * wherever the source has them back to back) and a central directory of its
+ * own. Shards are independent once planned, so several are written at once
+ * from the same source descriptor and directory mapping.
+ */
+
+/* Platform-specific feature detection */
+#if defined(__linux__) || defined(__gnu_linux__)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64  /* large-file I/O on POSIX */
+#endif
+
+#include "tacozip_internal.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/* Central-directory output is batched into writes of about this size. */
+#define TACOZ_SPLIT_CD_BUF (256u << 10)
+/* Shard writers when tacozip_split_opts_t::threads is 0. */
+#define TACOZ_SPLIT_THREADS 8u
+
+typedef struct {
+    uint64_t rec;    /* record offset in the directory image            */
+    uint64_t span;   /* local header + data bytes; 0 = not copied       */
+} split_entry_t;
+
+typedef struct {
+    uint64_t first;  /* entry range [first, end)                        */
+    uint64_t end;
+    uint64_t entries;
+    uint64_t size;   /* bytes written                                   */
+    int      published;
+} split_shard_t;
+
+/** A ghost slot whose bytes lie inside one entry's data. */
+typedef struct {
+    uint64_t entry;
+    uint64_t skip;   /* slot offset minus the entry's LFH offset        */
+    unsigned slot;
+} slot_ref_t;
+
+typedef struct {
+    int                 fd;
+    tacoz_view_t        cd;
+    split_entry_t      *ent;
+    uint64_t            count;
+    split_shard_t      *shards;
+    size_t              nshards;
+    const taco_ghost_t *src;        /* source ghost (count 0 if none)   */
+    int                 version;    /* format of the shards' ghosts     */
+    uint64_t            ghost_size;
+    uint32_t            dostime;
+    slot_ref_t          refs[TACO_GHOST_V2_MAX_SLOTS];
+    size_t              nrefs;      /* sorted by entry                  */
+    const char         *prefix;
+    int                 durability;
+
+    size_t              next;       /* next shard to write              */
+    int                 err;
+#ifndef _WIN32
+    pthread_mutex_t     mu;
+#endif
+} split_t;
+
+static char *shard_path(const char *prefix, size_t k) {
+    size_t n = strlen(prefix) + 32;
+    char *p = malloc(n);
+    if (p) snprintf(p, n, "%s%05zu.zip", prefix, k);
+    return p;
+}
+
+static int parse_rec(const split_t *s, uint64_t rec, tacoz_cdh_t *c) {
+    if (rec >= s->cd.len) return TACOZ_ERR_INVALID_GHOST;
+    int64_t n = tacoz_cdh_parse(s->cd.data + rec, s->cd.len - (size_t)rec, rec, c);
+    return n > 0 ? TACOZ_OK : TACOZ_ERR_INVALID_GHOST;
+}
+
+/* --------------------------------- Planning -------------------------------- */
+
+typedef struct {
+    uint64_t offset;
+    uint64_t length;
+    unsigned slot;
+    int      table;  /* a name index or ID table: left out of the shards */
+} slot_pos_t;
+
+static int slot_pos_cmp(const void *a, const void *b) {
+    const slot_pos_t *x = (const slot_pos_t *)a, *y = (const slot_pos_t *)b;
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+/** The source's slots by offset, with whole-archive tables marked. */
+static int sort_slots(const split_t *s, slot_pos_t *pos, size_t *np) {
+    *np = 0;
+    for (unsigned i = 0; i < s->src->count; i++) {
+        const taco_meta_entry_t *e = &s->src->slots[i];
+        if (e->length == 0) continue;
+        slot_pos_t *p = &pos[(*np)++];
+        p->offset = e->offset;
+        p->length = e->length;
+        p->slot = i;
+        int rc = tacoz_slot_is_table(s->fd, e, &p->table);
+        if (rc != TACOZ_OK) return rc;
+    }
+    qsort(pos, *np, sizeof(*pos), slot_pos_cmp);
+    return TACOZ_OK;
+}
+
+/** Find every entry's extent and the slots that point into it. */
+static int index_entries(split_t *s, const tacoz_tail_t *t, uint64_t body) {
+    slot_pos_t pos[TACO_GHOST_V2_MAX_SLOTS];
+    size_t np;
+    int rc = sort_slots(s, pos, &np);
+    if (rc != TACOZ_OK) return rc;
+
+    if (t->entries > SIZE_MAX / sizeof(*s->ent)) return TACOZ_ERR_IO;
+    s->ent = malloc((size_t)t->entries * sizeof(*s->ent) + 1);
+    if (!s->ent) return TACOZ_ERR_IO;
+
+    size_t off = 0;
+    for (uint64_t i = 0; i < t->entries; i++) {
+        tacoz_cdh_t c;
+        int64_t n = off < s->cd.len ? tacoz_cdh_parse(s->cd.data + off, s->cd.len - off, off, &c) : 0;
+        if (n <= 0) return TACOZ_ERR_INVALID_GHOST;
+        uint64_t rec = off;
+        off += (size_t)n;
+        if (i == 0 && body && c.lfh_off == 0) continue;  /* the source's ghost */
+
+        unsigned char lfh[TACOZ_LFH_SIZE];
+        rc = tacoz_pread_all(s->fd, lfh, sizeof(lfh), c.lfh_off);
+        if (rc != TACOZ_OK) return rc;
+        if (le32_read(lfh) != TACOZ_SIG_LFH) return TACOZ_ERR_INVALID_GHOST;
+        if (le16_read(lfh + 6) & TACOZ_GPBIT_DESCRIPTOR) return TACOZ_ERR_PARAM;
+        uint64_t data = c.lfh_off + TACOZ_LFH_SIZE + le16_read(lfh + 26) + le16_read(lfh + 28);
+        if (c.lfh_off < body || data > t->cd_off || c.csize > t->cd_off - data)
+            return TACOZ_ERR_INVALID_GHOST;
+
+        split_entry_t *e = &s->ent[s->count++];
+        e->rec = rec;
+        e->span = data + c.csize - c.lfh_off;
+
+        /* Slots are few and sorted: bisect to the first one in this entry. */
+        size_t lo = 0, hi = np;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (pos[mid].offset < data) lo = mid + 1;
+            else hi = mid;
+        }
+        for (size_t j = lo; j < np && pos[j].offset - data < c.csize; j++) {
+            if (pos[j].length > c.csize - (pos[j].offset - data)) continue;  /* straddles */
+            if (pos[j].table) {
+                e->span = 0;
+                continue;
+            }
+            slot_ref_t *r = &s->refs[s->nrefs++];
+            r->entry = s->count - 1;
+            r->skip = pos[j].offset - c.lfh_off;
+            r->slot = pos[j].slot;
+        }
+    }
+
+    /* Slots inside a table that is left out go with it. */
+    size_t keep = 0;
+    for (size_t i = 0; i < s->nrefs; i++)
+        if (s->ent[s->refs[i].entry].span) s->refs[keep++] = s->refs[i];
+    s->nrefs = keep;
+    return TACOZ_OK;
+}
+
+static int add_shard(split_t *s, size_t *cap, uint64_t first) {
+    if (s->nshards == *cap) {
+        size_t n = *cap ? *cap * 2 : 16;
+        split_shard_t *p = realloc(s->shards, n * sizeof(*p));
+        if (!p) return TACOZ_ERR_IO;
+        s->shards = p;
+        *cap = n;
+    }
+    split_shard_t *sh = &s->shards[s->nshards++];
+    memset(sh, 0, sizeof(*sh));
+    sh->first = first;
+    return TACOZ_OK;
+}
+
+/** Cut the entries into consecutive runs that fit in @p max bytes each. */
+static int plan_shards(split_t *s, uint64_t max) {
+    uint64_t fixed = TACOZ_LFH_TOTAL(TACO_GHOST_NAME_LEN) + s->ghost_size +
+                     TACOZ_CDH_TOTAL(TACO_GHOST_NAME_LEN) + TACOZ_TAIL_SIZE;
+    size_t cap = 0;
+    int rc = add_shard(s, &cap, 0);
+    uint64_t used = fixed, n = 0;
+    for (uint64_t i = 0; rc == TACOZ_OK && i < s->count; i++) {
+        if (s->ent[i].span == 0) continue;
+        tacoz_cdh_t c;
+        rc = parse_rec(s, s->ent[i].rec, &c);
+        if (rc != TACOZ_OK) break;
+
+        uint64_t cost = s->ent[i].span + TACOZ_CDH_REBUILD_MAX(c.rec_len);
+        if (n && (cost > max || used > max - cost)) {
+            s->shards[s->nshards - 1].end = i;
+            rc = add_shard(s, &cap, i);
+            used = fixed;
+            n = 0;
+        }
+        used += cost;
+        n++;
+    }
+    if (rc == TACOZ_OK) s->shards[s->nshards - 1].end = s->count;
+    return rc;
+}
+
+/* --------------------------------- Writing --------------------------------- */
+
+/** Write shard @p sh into @p fd: ghost, entries, directory, tail, then the
+ *  ghost payload and CRCs once the directory is final. */
+static int fill_shard(const split_t *s, split_shard_t *sh, int fd,
+                      unsigned char *buf, taco_ghost_t *g) {
+    tacozip_ghost_init(g);
+    g->count = s->src->count;
+    if (s->version == 2)
+        g->flags = s->src->flags & (TACO_GHOST_F_SLOT_CRC | TACO_GHOST_F_CD_SORTED);
+
+    unsigned char lfh[TACOZ_LFH_TOTAL(TACO_GHOST_NAME_LEN)];
+    tacoz_ghost_lfh_build(lfh, s->dostime, s->ghost_size);
+    unsigned char *payload = calloc(1, (size_t)s->ghost_size);
+    if (!payload) return TACOZ_ERR_IO;
+    int rc = tacoz_write_all(fd, lfh, sizeof(lfh));
+    if (rc == TACOZ_OK) rc = tacoz_write_all(fd, payload, (size_t)s->ghost_size);
+
+    /* Entries, coalescing those laid out back to back in the source. */
+    const uint64_t head = sizeof(lfh) + s->ghost_size;
+    uint64_t pos = head, run_off = 0, run_len = 0;
+    size_t r = 0;
+    for (uint64_t i = sh->first; rc == TACOZ_OK && i < sh->end; i++) {
+        const split_entry_t *e = &s->ent[i];
+        if (e->span == 0) continue;
+        tacoz_cdh_t c;
+        rc = parse_rec(s, e->rec, &c);
+        if (rc != TACOZ_OK) break;
+
+        while (r < s->nrefs && s->refs[r].entry < i) r++;
+        for (; r < s->nrefs && s->refs[r].entry == i; r++) {
+            unsigned slot = s->refs[r].slot;
+            g->slots[slot].offset = pos + s->refs[r].skip;
+            g->slots[slot].length = s->src->slots[slot].length;
+            if (s->version == 2 && s->src->inline_len[slot])
+                (void)tacoz_ghost_add_inline(g, slot, s->src->inline_data + s->src->inline_off[slot],
+                                             s->src->inline_len[slot]);
+        }
+
+        if (run_len && run_off + run_len == c.lfh_off) {
+            run_len += e->span;
+        } else {
+            if (run_len) rc = tacoz_copy_fd(s->fd, run_off, fd, run_len);
+            run_off = c.lfh_off;
+            run_len = e->span;
+        }
+        pos += e->span;
+    }
+    if (rc == TACOZ_OK && run_len) rc = tacoz_copy_fd(s->fd, run_off, fd, run_len);
+
+    /* Directory: the ghost's record, then the entries' with new offsets. */
+    const uint64_t cd_off = pos;
+    uint64_t out = cd_off, entries = 1;
+    size_t len = 0;
+    if (rc == TACOZ_OK) {
+        tacoz_cd_entry_t ge;
+        ge.lfh_off  = 0;
+        ge.size     = s->ghost_size;
+        ge.crc      = 0;  /* patched with the payload */
+        ge.mode     = TACOZ_DEFAULT_MODE;
+        ge.dostime  = s->dostime;
+        ge.name_len = TACO_GHOST_NAME_LEN;
+        ge.name     = TACO_GHOST_NAME;
+        tacoz_cdh_build(&ge, buf);
+        len = TACOZ_CDH_TOTAL(TACO_GHOST_NAME_LEN);
+    }
+    pos = head;
+    for (uint64_t i = sh->first; rc == TACOZ_OK && i < sh->end; i++) {
+        const split_entry_t *e = &s->ent[i];
+        if (e->span == 0) continue;
+        tacoz_cdh_t c;
+        rc = parse_rec(s, e->rec, &c);
+        if (rc != TACOZ_OK) break;
+        if (TACOZ_SPLIT_CD_BUF - len < TACOZ_CDH_REBUILD_MAX(c.rec_len)) {
+            rc = tacoz_write_all(fd, buf, len);
+            out += len;
+            len = 0;
+            if (rc != TACOZ_OK) break;
+        }
+        size_t n = tacoz_cdh_rebuild(&c, pos, buf + len);
+        if (n == 0) rc = TACOZ_ERR_INVALID_GHOST;
+        len += n;
+        pos += e->span;
+        entries++;
+    }
+    if (rc == TACOZ_OK) {
+        rc = tacoz_write_all(fd, buf, len);
+        out += len;
+    }
+    if (rc == TACOZ_OK) {
+        unsigned char t[TACOZ_TAIL_SIZE];
+        tacoz_tail_build(t, entries, out - cd_off, cd_off, out);
+        rc = tacoz_write_all(fd, t, sizeof(t));
+    }
+
+    if (rc == TACOZ_OK) {
+        g->cd_offset = cd_off;
+        g->cd_size = out - cd_off;
+        g->cd_entries = entries;
+        g->generation = 1;
+        rc = tacoz_ghost_slot_crcs(fd, g);
+        if (rc == TACOZ_OK) rc = tacoz_ghost_encode(g, s->version, payload, (size_t)s->ghost_size);
+    }
+    if (rc == TACOZ_OK) {
+        unsigned char crc[4];
+        le32(crc, tacoz_crc32(0, payload, (size_t)s->ghost_size));
+        rc = tacoz_pwrite_all(fd, payload, (size_t)s->ghost_size, sizeof(lfh));
+        if (rc == TACOZ_OK) rc = tacoz_pwrite_all(fd, crc, 4, 14);
+        if (rc == TACOZ_OK) rc = tacoz_pwrite_all(fd, crc, 4, cd_off + 16);
+    }
+    sh->entries = entries - 1;
+    sh->size = out + TACOZ_TAIL_SIZE;
+    free(payload);
+    return rc;
+}
+
+static int write_shard(const split_t *s, size_t k, unsigned char *buf, taco_ghost_t *g) {
+    char *path = shard_path(s->prefix, k);
+    if (!path) return TACOZ_ERR_IO;
+    char *tmp = NULL;
+    int fd = tacoz_create_unnamed(path, &tmp);
+    int rc = fd < 0 ? TACOZ_ERR_IO : fill_shard(s, &s->shards[k], fd, buf, g);
+    if (rc == TACOZ_OK) rc = tacoz_publish(fd, tmp, path, s->durability);
+    else if (fd >= 0) tacoz_close(fd);
+    if (rc != TACOZ_OK && tmp) tacoz_unlink(tmp);
+    if (rc == TACOZ_OK) s->shards[k].published = 1;
+    free(tmp);
+    free(path);
+    return rc;
+}
+
+static void split_lock(split_t *s) {
+#ifndef _WIN32
+    pthread_mutex_lock(&s->mu);
+#else
+    (void)s;
+#endif
+}
+
+static void split_unlock(split_t *s) {
+#ifndef _WIN32
+    pthread_mutex_unlock(&s->mu);
+#else
+    (void)s;
+#endif
+}
+
+/** Take shards off the shared counter until none are left or one failed. */
+static void *split_worker(void *arg) {
+    split_t *s = (split_t *)arg;
+    unsigned char *buf = malloc(TACOZ_SPLIT_CD_BUF);
+    taco_ghost_t *g = malloc(sizeof(*g));
+    int rc = buf && g ? TACOZ_OK : TACOZ_ERR_IO;
+    for (;;) {
+        split_lock(s);
+        if (rc != TACOZ_OK && s->err == TACOZ_OK) s->err = rc;
+        size_t k = s->next++;
+        int stop = s->err != TACOZ_OK || k >= s->nshards;
+        split_unlock(s);
+        if (stop) break;
+        rc = write_shard(s, k, buf, g);
+    }
+    free(buf);
+    free(g);
+    return NULL;
+}
+
+static unsigned split_threads(const tacozip_split_opts_t *o, size_t nshards) {
+#ifdef _WIN32
+    (void)o;
+    (void)nshards;
+    return 1;
+#else
+    unsigned n = o->threads;
+    if (n == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n = cpus > 0 ? (unsigned)cpus : 1u;
+        if (n > TACOZ_SPLIT_THREADS) n = TACOZ_SPLIT_THREADS;
+    }
+    return n > nshards ? (unsigned)nshards : n;
+#endif
+}
+
+static int write_shards(split_t *s, unsigned nthreads) {
+#ifndef _WIN32
+    pthread_t *tid = nthreads > 1 ? malloc((nthreads - 1) * sizeof(*tid)) : NULL;
+    unsigned started = 0;
+    pthread_mutex_init(&s->mu, NULL);
+    for (; tid && started + 1 < nthreads; started++)
+        if (pthread_create(&tid[started], NULL, split_worker, s) != 0) break;
+    split_worker(s);  /* the caller writes shards too */
+    for (unsigned i = 0; i < started; i++) pthread_join(tid[i], NULL);
+    pthread_mutex_destroy(&s->mu);
+    free(tid);
+#else
+    (void)nthreads;
+    split_worker(s);
+#endif
+    return s->err;
+}
+
+/* --------------------------------- Manifest -------------------------------- */
+
+typedef struct {
+    char  *p;
+    size_t len;
+    size_t cap;
+    int    err;
+} text_t;
+
+static void text_add(text_t *t, const char *s, size_t n) {
+    if (t->err) return;
+    if (t->cap - t->len < n) {
+        size_t cap = t->cap ? t->cap : 4096;
+        while (cap - t->len < n) cap *= 2;
+        char *p = realloc(t->p, cap);
+        if (!p) {
+            t->err = TACOZ_ERR_IO;
+            return;
+        }
+        t->p = p;
+        t->cap = cap;
+    }
+    memcpy(t->p + t->len, s, n);
+    t->len += n;
+}
+
+static void text_str(text_t *t, const char *s) {
+    text_add(t, s, strlen(s));
+}
+
+static void text_printf(text_t *t, const char *fmt, ...) {
+    char tmp[128];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= sizeof(tmp)) t->err = TACOZ_ERR_IO;
+    else text_add(t, tmp, (size_t)n);
+}
+
+/** Append @p s as a JSON string; bytes >= 0x80 pass through (UTF-8 names). */
+static void text_json(text_t *t, const char *s, size_t n) {
+    text_str(t, "\"");
+    for (size_t i = 0; i < n; i++) {
+        unsigned char ch = (unsigned char)s[i];
+        if (ch == '"' || ch == '\\') {
+            char esc[2] = { '\\', (char)ch };
+            text_add(t, esc, 2);
+        } else if (ch < 0x20) {
+            text_printf(t, "\\u%04x", ch);
+        } else {
+            text_add(t, s + i, 1);
+        }
+    }
+    text_str(t, "\"");
+}
+
+/** Name of the first (@p last = 0) or last entry written to @p sh. */
+static void text_entry_name(text_t *t, const split_t *s, const split_shard_t *sh, int last) {
+    for (uint64_t k = 0; k < sh->end - sh->first; k++) {
+        uint64_t i = last ? sh->end - 1 - k : sh->first + k;
+        tacoz_cdh_t c;
+        if (s->ent[i].span && parse_rec(s, s->ent[i].rec, &c) == TACOZ_OK) {
+            text_json(t, c.name, c.name_len);
+            return;
+        }
+    }
+    text_str(t, "null");
+}
+
+static int write_manifest(const split_t *s, const char *path) {
+    text_t t;
+    memset(&t, 0, sizeof(t));
+    text_str(&t, "{\"shards\": [");
+    for (size_t k = 0; k < s->nshards; k++) {
+        const split_shard_t *sh = &s->shards[k];
+        char *shard = shard_path(s->prefix, k);
+        if (!shard) {
+            free(t.p);
+            return TACOZ_ERR_IO;
+        }
+        text_str(&t, k ? ",\n  {\"path\": " : "\n  {\"path\": ");
+        text_json(&t, shard, strlen(shard));
+        free(shard);
+        text_printf(&t, ", \"entries\": %llu, \"size\": %llu, \"first\": ",
+                    (unsigned long long)sh->entries, (unsigned long long)sh->size);
+        text_entry_name(&t, s, sh, 0);
+        text_str(&t, ", \"last\": ");
+        text_entry_name(&t, s, sh, 1);
+        text_str(&t, "}");
+    }
+    text_str(&t, "\n]}\n");
+    if (t.err) {
+        free(t.p);
+        return t.err;
+    }
+
+    char *tmp = NULL;
+    int fd = tacoz_create_unnamed(path, &tmp);
+    int rc = fd < 0 ? TACOZ_ERR_IO : tacoz_write_all(fd, t.p, t.len);
+    if (rc == TACOZ_OK) rc = tacoz_publish(fd, tmp, path, s->durability);
+    else if (fd >= 0) tacoz_close(fd);
+    if (rc != TACOZ_OK && tmp) tacoz_unlink(tmp);
+    free(tmp);
+    free(t.p);
+    return rc;
+}
+
+/* -------------------------------- Public API ------------------------------- */
+
+void tacozip_split_opts_init(tacozip_split_opts_t *opts) {
+    if (!opts) return;
+    memset(opts, 0, sizeof(*opts));
+    opts->threads = 0;
+    opts->manifest_path = NULL;
+    opts->durability = TACOZ_DURABILITY;
+}
+
+/** Open the source and read everything planning needs. */
+static int open_source(split_t *s, const char *zip_path, taco_ghost_t *src) {
+    s->fd = tacoz_open_read(zip_path);
+    if (s->fd < 0) return TACOZ_ERR_IO;
+    int rc = tacoz_lock(s->fd, 0);
+    if (rc != TACOZ_OK) return rc;
+
+    tacoz_ghost_loc_t loc;
+    uint64_t body = 0;
+    rc = tacoz_ghost_locate(s->fd, &loc);
+    if (rc == TACOZ_OK) rc = tacoz_ghost_read(s->fd, &loc, src);
+    if (rc == TACOZ_OK) {
+        unsigned char t[4];
+        rc = tacoz_pread_all(s->fd, t, sizeof(t), 10);
+        s->dostime = le32_read(t);
+        s->version = src->version;
+        s->ghost_size = loc.size;
+        body = loc.data_off + loc.size;
+    } else if (rc == TACOZ_ERR_INVALID_GHOST) {
+        /* No ghost: the shards get an empty v1 one, as the writer's default. */
+        tacozip_ghost_init(src);
+        s->dostime = TACOZ_DOS_EPOCH;
+        s->version = 1;
+        s->ghost_size = tacoz_ghost_used(src, 1);
+        rc = TACOZ_OK;
+    }
+
+    tacoz_tail_t tail;
+    if (rc == TACOZ_OK) rc = tacoz_read_tail(s->fd, &tail);
+    if (rc == TACOZ_OK && tail.cd_off < body) rc = TACOZ_ERR_INVALID_GHOST;
+    if (rc == TACOZ_OK) rc = tacoz_view_open(s->fd, tail.cd_off, tail.cd_size, &s->cd);
+    if (rc == TACOZ_OK) rc = index_entries(s, &tail, body);
+    return rc;
+}
+
+int tacozip_split(const char *zip_path, const char *out_prefix, uint64_t max_shard_size,
+                  const tacozip_split_opts_t *opts, size_t *num_shards) {
+    tacozip_split_opts_t o;
+    if (opts) o = *opts;
+    else tacozip_split_opts_init(&o);
+    if (num_shards) *num_shards = 0;
+    if (!zip_path || !out_prefix || max_shard_size == 0 ||
+        o.durability < TACOZIP_DURABLE_NONE || o.durability > TACOZIP_DURABLE_FULL)
+        return TACOZ_ERR_PARAM;
+
+    split_t *s = calloc(1, sizeof(*s));
+    taco_ghost_t *src = malloc(sizeof(*src));
+    if (!s || !src) {
+        free(s);
+        free(src);
+        return TACOZ_ERR_IO;
+    }
+    s->fd = -1;
+    s->src = src;
+    s->prefix = out_prefix;
+    s->durability = o.durability;
+
+    int rc = open_source(s, zip_path, src);
+    if (rc == TACOZ_OK) rc = plan_shards(s, max_shard_size);
+    if (rc == TACOZ_OK) rc = write_shards(s, split_threads(&o, s->nshards));
+    if (rc == TACOZ_OK && o.manifest_path) rc = write_manifest(s, o.manifest_path);
+
+    for (size_t k = 0; rc != TACOZ_OK && k < s->nshards; k++) {
+        if (!s->shards[k].published) continue;
+        char *path = shard_path(out_prefix, k);
+        if (path) tacoz_unlink(path);
+        free(path);
+    }
+    if (rc == TACOZ_OK && num_shards) *num_shards = s->nshards;
+
+    tacoz_view_close(&s->cd);
+    if (s->fd >= 0) tacoz_close(s->fd);
+    free(s->ent);
+    free(s->shards);
+    free(s);
+    free(src);
+    return rc;
+}
@@ -0,0 +1,278 @@
+/*
+ * tacozip_srcpool.c — bounded, read-ahead ingestion of source file lists.
+ *
+ * tacozip_writer_add_files() packs a known list of files in order. Instead of
+ * paying open/fstat/read/close on the critical path for every file, the pool
+ * keeps up to `window` sources in flight. With io_uring each source becomes
+ *
+ *     STATX                         (unlinked, for size/mode/mtime)
+ *     OPENAT -> READ_FIXED -> CLOSE (linked, on a direct descriptor)
+ *
+ * reading the first TACOZ_INGEST_BUFSZ bytes into a registered buffer. CRCs
+ * are computed as read completions arrive; the writer then only copies bytes
+ * into its coalescing output buffer. Files larger than a slot, or any source
+ * the ring could not serve, are reopened synchronously and streamed. At most
+ * `window` descriptors are ever open, so huge lists never approach
+ * RLIMIT_NOFILE. Without io_uring (or on kernels missing direct descriptors)
+ * sources are opened synchronously, one at a time.
+ */
+
+/* Platform-specific feature detection */
+#if defined(__linux__) || defined(__gnu_linux__)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
+#include "tacozip_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if TACOZ_HAVE_IO_URING
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+enum { OP_OPEN = 0, OP_READ = 1, OP_CLOSE = 2, OP_STAT = 3, OPS_PER_SRC = 4 };
+
+#define STATX_WANT (STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME)
+
+typedef struct {
+    const char    *path;
+    unsigned       pending;    /* completions still outstanding        */
+    int32_t        open_res;
+    int32_t        read_res;
+    int32_t        stat_res;
+    uint32_t       crc;
+    struct statx   stx;
+} src_slot_t;
+#endif
+
+struct tacoz_srcpool {
+    const char * const *paths;
+    size_t         count;
+    size_t         next_take;     /* next path handed to the consumer    */
+    unsigned       window;
+#if TACOZ_HAVE_IO_URING
+    size_t         next_submit;   /* next path to queue                  */
+    src_slot_t    *slots;         /* ring of `window` slots              */
+    unsigned char *bufs;          /* window * TACOZ_INGEST_BUFSZ         */
+    int            fixed_bufs;    /* bufs registered with the ring       */
+    int            no_async;      /* kernel rejected an opcode           */
+#endif
+    tacoz_uring_t *ring;          /* NULL = synchronous opens            */
+};
+
+static int open_sync(const char *path, tacoz_src_t *src) {
+    src->fd = tacoz_open_read(path);
+    if (src->fd < 0) return TACOZ_ERR_IO;
+    if (tacoz_fstat(src->fd, &src->st) != TACOZ_OK) {
+        tacoz_close(src->fd);
+        src->fd = -1;
+        return TACOZ_ERR_IO;
+    }
+    return TACOZ_OK;
+}
+
+#if TACOZ_HAVE_IO_URING
+
+static unsigned char *slot_buf(const tacoz_srcpool_t *p, unsigned slot) {
+    return p->bufs + (size_t)slot * TACOZ_INGEST_BUFSZ;
+}
+
+static int queue_slot(tacoz_srcpool_t *p, size_t idx) {
+    if (tacoz_uring_sq_space(p->ring) < OPS_PER_SRC) return 0;
+
+    unsigned slot = (unsigned)(idx % p->window);
+    src_slot_t *s = &p->slots[slot];
+    s->path = p->paths[idx];
+    s->pending = OPS_PER_SRC;
+    s->open_res = s->read_res = s->stat_res = 0;
+    s->crc = 0;
+
+    uint64_t tag = (uint64_t)slot << 2;
+    struct io_uring_sqe *sqe;
+
+    sqe = tacoz_uring_sqe(p->ring);
+    sqe->opcode = IORING_OP_STATX;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (uint64_t)(uintptr_t)s->path;
+    sqe->len = STATX_WANT;
+    sqe->off = (uint64_t)(uintptr_t)&s->stx;
+    sqe->user_data = tag | OP_STAT;
+
+    /* Open straight into fixed-file slot `slot`; no fd enters the process table. */
+    sqe = tacoz_uring_sqe(p->ring);
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (uint64_t)(uintptr_t)s->path;
+    sqe->open_flags = O_RDONLY;  /* O_CLOEXEC is rejected for direct descriptors */
+    sqe->file_index = slot + 1;
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = tag | OP_OPEN;
+
+    /* A short read "fails" a plain link; hard-link so CLOSE always runs. */
+    sqe = tacoz_uring_sqe(p->ring);
+    sqe->opcode = p->fixed_bufs ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe->fd = (int32_t)slot;
+    sqe->addr = (uint64_t)(uintptr_t)slot_buf(p, slot);
+    sqe->len = TACOZ_INGEST_BUFSZ;
+    sqe->off = 0;
+    sqe->buf_index = p->fixed_bufs ? (uint16_t)slot : 0;
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+    sqe->user_data = tag | OP_READ;
+
+    sqe = tacoz_uring_sqe(p->ring);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = slot + 1;
+    sqe->user_data = tag | OP_CLOSE;
+    return 1;
+}
+
+static void complete_one(tacoz_srcpool_t *p, uint64_t user_data, int32_t res) {
+    unsigned slot = (unsigned)(user_data >> 2);
+    src_slot_t *s = &p->slots[slot];
+    switch ((int)(user_data & 3)) {
+    case OP_OPEN:
+        s->open_res = res;
+        /* Kernel without direct descriptors: stop queueing, go synchronous. */
+        if (res == -EINVAL || res == -EOPNOTSUPP) p->no_async = 1;
+        break;
+    case OP_READ:
+        s->read_res = res;
+        if (res > 0) s->crc = tacoz_crc32(0, slot_buf(p, slot), (size_t)res);
+        break;
+    case OP_STAT:
+        s->stat_res = res;
+        break;
+    default:
+        break;
+    }
+    s->pending--;
+}
+
+static void top_up(tacoz_srcpool_t *p) {
+    /* Refill in batches once half the window is consumed: one submit per batch. */
+    if (p->next_submit - p->next_take > p->window / 2) return;
+    int queued = 0;
+    while (!p->no_async && p->next_submit < p->count &&
+           p->next_submit - p->next_take < p->window) {
+        if (!queue_slot(p, p->next_submit)) break;
+        p->next_submit++;
+        queued = 1;
+    }
+    if (queued) tacoz_uring_submit(p->ring, 0);
+}
+
+static int take_ring(tacoz_srcpool_t *p, tacoz_src_t *src) {
+    top_up(p);
+    if (p->next_take >= p->next_submit) {
+        /* Nothing queued for it (SQ full or async opens disabled). */
+        p->next_submit++;
+        return open_sync(p->paths[p->next_take++], src);
+    }
+
+    unsigned slot = (unsigned)(p->next_take % p->window);
+    src_slot_t *s = &p->slots[slot];
+    while (s->pending > 0) {
+        uint64_t ud;
+        int32_t res;
+        if (tacoz_uring_cqe(p->ring, 1, &ud, &res) != 1) return TACOZ_ERR_IO;
+        complete_one(p, ud, res);
+    }
+    p->next_take++;
+
+    /* The body is complete only if the read covered the whole file. */
+    int whole = s->open_res >= 0 && s->stat_res == 0 &&
+                (s->stx.stx_mask & STATX_WANT) == STATX_WANT &&
+                S_ISREG(s->stx.stx_mode) &&
+                s->read_res >= 0 && (uint64_t)s->read_res == s->stx.stx_size;
+    if (!whole) {
+        /* Large file, racing writer or error: let the synchronous path decide. */
+        return open_sync(s->path, src);
+    }
+
+    src->data = slot_buf(p, slot);
+    src->len = (size_t)s->read_res;
+    src->crc = s->crc;
+    src->st.size = s->stx.stx_size;
+    src->st.mtime = (int64_t)s->stx.stx_mtime.tv_sec;
+    src->st.mode = s->stx.stx_mode;
+    src->st.is_regular = 1;
+    return TACOZ_OK;
+}
+
+static void ring_setup(tacoz_srcpool_t *p) {
+    if (tacoz_uring_create(p->window * OPS_PER_SRC, &p->ring) != TACOZ_OK) {
+        p->ring = NULL;
+        return;
+    }
+
+    p->slots = calloc(p->window, sizeof(*p->slots));
+    p->bufs = malloc((size_t)p->window * TACOZ_INGEST_BUFSZ);
+    if (!p->slots || !p->bufs || tacoz_uring_register_files(p->ring, p->window) != TACOZ_OK) {
+        tacoz_uring_free(p->ring);
+        p->ring = NULL;
+        return;
+    }
+
+    /* Registered buffers skip per-read page pinning; plain READ works without. */
+    struct iovec *iov = malloc(p->window * sizeof(*iov));
+    if (iov) {
+        for (unsigned i = 0; i < p->window; i++) {
+            iov[i].iov_base = slot_buf(p, i);
+            iov[i].iov_len = TACOZ_INGEST_BUFSZ;
+        }
+        p->fixed_bufs = tacoz_uring_register_buffers(p->ring, iov, p->window) == TACOZ_OK;
+        free(iov);
+    }
+}
+
+#endif /* TACOZ_HAVE_IO_URING */
+
+int tacoz_srcpool_create(unsigned window, const char * const *paths, size_t count,
+                         tacoz_srcpool_t **out) {
+    tacoz_srcpool_t *p = calloc(1, sizeof(*p));
+    if (!p) return TACOZ_ERR_IO;
+    p->paths = paths;
+    p->count = count;
+    p->window = window;
+#if TACOZ_HAVE_IO_URING
+    if (window > 0) ring_setup(p);
+#endif
+    *out = p;
+    return TACOZ_OK;
+}
+
+int tacoz_srcpool_next(tacoz_srcpool_t *p, tacoz_src_t *src) {
+    memset(src, 0, sizeof(*src));
+    src->fd = -1;
+    if (p->next_take >= p->count) return TACOZ_ERR_PARAM;
+#if TACOZ_HAVE_IO_URING
+    if (p->ring) return take_ring(p, src);
+#endif
+    return open_sync(p->paths[p->next_take++], src);
+}
+
+void tacoz_srcpool_free(tacoz_srcpool_t *p) {
+    if (!p) return;
+#if TACOZ_HAVE_IO_URING
+    if (p->ring) {
+        /* Reap everything in flight: the chained CLOSE releases each slot. */
+        for (size_t i = p->next_take; i < p->next_submit && i < p->count; i++) {
+            src_slot_t *s = &p->slots[i % p->window];
+            while (s->pending > 0) {
+                uint64_t ud;
+                int32_t res;
+                if (tacoz_uring_cqe(p->ring, 1, &ud, &res) != 1) break;
+                complete_one(p, ud, res);
+            }
+        }
+    }
+    tacoz_uring_free(p->ring);
+    free(p->slots);
+    free(p->bufs);
+#endif
+    free(p);
+}
@@ -0,0 +1,216 @@
+/*
+ * tacozip_uring.c — minimal io_uring ring used for asynchronous source I/O.
+ *
+ * Talks to the kernel with the raw io_uring_setup/io_uring_enter syscalls so
+ * no liburing dependency is needed. Built only when CMake detects
+ * <linux/io_uring.h> (TACOZ_HAVE_IO_URING); elsewhere, and on kernels or
+ * sandboxes that refuse io_uring_setup, tacoz_uring_create() fails and
+ * callers fall back to synchronous syscalls.
+ */
+
+/* Platform-specific feature detection */
+#if defined(__linux__) || defined(__gnu_linux__)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
+#include "tacozip_internal.h"
+#include <stdlib.h>
+
+#if TACOZ_HAVE_IO_URING
+
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct tacoz_uring {
+    int       fd;
+
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned  sq_mask;
+    unsigned  sq_entries;
+    unsigned  sqe_tail;       /* next SQE handed out (local)            */
+    unsigned  sqe_submitted;  /* SQEs already published to the kernel   */
+    struct io_uring_sqe *sqes;
+
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned  cq_mask;
+    struct io_uring_cqe *cqes;
+
+    void     *sq_ring;
+    size_t    sq_ring_sz;
+    void     *cq_ring;
+    size_t    cq_ring_sz;
+    size_t    sqes_sz;
+};
+
+static int sys_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_register(int fd, unsigned opcode, const void *arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static int sys_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+int tacoz_uring_create(unsigned entries, tacoz_uring_t **out) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+
+    int fd = sys_setup(entries, &p);
+    if (fd < 0) return TACOZ_ERR_IO;
+
+    tacoz_uring_t *r = calloc(1, sizeof(*r));
+    if (!r) {
+        close(fd);
+        return TACOZ_ERR_IO;
+    }
+    r->fd = fd;
+
+    r->sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_ring_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_ring_sz > r->sq_ring_sz) r->sq_ring_sz = r->cq_ring_sz;
+        r->cq_ring_sz = r->sq_ring_sz;
+    }
+
+    r->sq_ring = mmap(NULL, r->sq_ring_sz, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (r->sq_ring == MAP_FAILED) goto fail;
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        r->cq_ring = r->sq_ring;
+    } else {
+        r->cq_ring = mmap(NULL, r->cq_ring_sz, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (r->cq_ring == MAP_FAILED) goto fail;
+    }
+
+    r->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_sz, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) goto fail;
+
+    unsigned char *sq = (unsigned char *)r->sq_ring;
+    r->sq_head    = (unsigned *)(void *)(sq + p.sq_off.head);
+    r->sq_tail    = (unsigned *)(void *)(sq + p.sq_off.tail);
+    r->sq_mask    = *(unsigned *)(void *)(sq + p.sq_off.ring_mask);
+    r->sq_entries = p.sq_entries;
+    r->sqe_tail = r->sqe_submitted = *r->sq_tail;
+
+    /* SQEs are always consumed in order, so the index array is the identity. */
+    unsigned *array = (unsigned *)(void *)(sq + p.sq_off.array);
+    for (unsigned i = 0; i < p.sq_entries; i++) array[i] = i;
+
+    unsigned char *cq = (unsigned char *)r->cq_ring;
+    r->cq_head = (unsigned *)(void *)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned *)(void *)(cq + p.cq_off.tail);
+    r->cq_mask = *(unsigned *)(void *)(cq + p.cq_off.ring_mask);
+    r->cqes    = (struct io_uring_cqe *)(void *)(cq + p.cq_off.cqes);
+
+    *out = r;
+    return TACOZ_OK;
+
+fail:
+    if (r->sqes && r->sqes != MAP_FAILED) munmap(r->sqes, r->sqes_sz);
+    if (r->cq_ring && r->cq_ring != MAP_FAILED && r->cq_ring != r->sq_ring)
+        munmap(r->cq_ring, r->cq_ring_sz);
+    if (r->sq_ring && r->sq_ring != MAP_FAILED) munmap(r->sq_ring, r->sq_ring_sz);
+    close(fd);
+    free(r);
+    return TACOZ_ERR_IO;
+}
+
+void tacoz_uring_free(tacoz_uring_t *r) {
+    if (!r) return;
+    munmap(r->sqes, r->sqes_sz);
+    if (r->cq_ring != r->sq_ring) munmap(r->cq_ring, r->cq_ring_sz);
+    munmap(r->sq_ring, r->sq_ring_sz);
+    close(r->fd);
+    free(r);
+}
+
+int tacoz_uring_register_buffers(tacoz_uring_t *r, const struct iovec *iov, unsigned n) {
+    return sys_register(r->fd, IORING_REGISTER_BUFFERS, iov, n) == 0 ? TACOZ_OK : TACOZ_ERR_IO;
+}
+
+int tacoz_uring_register_files(tacoz_uring_t *r, unsigned n) {
+    int *fds = malloc(n * sizeof(*fds));
+    if (!fds) return TACOZ_ERR_IO;
+    for (unsigned i = 0; i < n; i++) fds[i] = -1;  /* sparse: filled by OPENAT */
+    int rc = sys_register(r->fd, IORING_REGISTER_FILES, fds, n);
+    free(fds);
+    return rc == 0 ? TACOZ_OK : TACOZ_ERR_IO;
+}
+
+unsigned tacoz_uring_sq_space(const tacoz_uring_t *r) {
+    unsigned head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+    return r->sq_entries - (r->sqe_tail - head);
+}
+
+struct io_uring_sqe *tacoz_uring_sqe(tacoz_uring_t *r) {
+    unsigned head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+    if (r->sqe_tail - head >= r->sq_entries) return NULL;
+    struct io_uring_sqe *sqe = &r->sqes[r->sqe_tail & r->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    r->sqe_tail++;
+    return sqe;
+}
+
+int tacoz_uring_submit(tacoz_uring_t *r, unsigned wait_nr) {
+    __atomic_store_n(r->sq_tail, r->sqe_tail, __ATOMIC_RELEASE);
+    unsigned pending = r->sqe_tail - r->sqe_submitted;
+
+    while (pending > 0 || wait_nr > 0) {
+        int n = sys_enter(r->fd, pending, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            /* CQ pressure: let the caller reap before submitting more. */
+            if (errno == EAGAIN || errno == EBUSY) return TACOZ_OK;
+            return TACOZ_ERR_IO;
+        }
+        r->sqe_submitted += (unsigned)n;
+        pending -= (unsigned)n;
+        wait_nr = 0;
+        if (n == 0) break;
+    }
+    return TACOZ_OK;
+}
+
+int tacoz_uring_cqe(tacoz_uring_t *r, int wait, uint64_t *user_data, int32_t *res) {
+    for (;;) {
+        unsigned head = *r->cq_head;
+        unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+        if (head != tail) {
+            const struct io_uring_cqe *cqe = &r->cqes[head & r->cq_mask];
+            *user_data = cqe->user_data;
+            *res = cqe->res;
+            __atomic_store_n(r->cq_head, head + 1, __ATOMIC_RELEASE);
+            return 1;
+        }
+        if (!wait) return 0;
+        if (tacoz_uring_submit(r, 1) != TACOZ_OK) return TACOZ_ERR_IO;
+    }
+}
+
+#else  /* !TACOZ_HAVE_IO_URING */
+
+int tacoz_uring_create(unsigned entries, tacoz_uring_t **out) {
+    (void)entries;
+    *out = NULL;
+    return TACOZ_ERR_IO;
+}
+
+void tacoz_uring_free(tacoz_uring_t *r) {
+    (void)r;
+}
+
+#endif /* TACOZ_HAVE_IO_URING */
@@ -0,0 +1,882 @@
+/*
+ * tacozip_writer.c — native streaming ZIP64 (STORE-only) writer.
+ *
+ * Entries are appended one at a time with tacozip_writer_add_*(); nothing but
+ * the central directory is kept in memory, in the compact store implemented by
+ * tacozip_cdstore.c. Layout of an archive produced here:
+ *
+ *   [ghost LFH + payload][LFH + data]...[central directory][ZIP64 EOCD][locator][EOCD]
+ *
+ * Every LFH carries a ZIP64 extra field (sizes) and every central-directory
+ * record carries one with sizes and LFH offset, so the output is ZIP64
+ * regardless of entry sizes, matching what the libzip path produced.
+ *
+ * The archive is built in an unnamed file in the target's directory
+ * (O_TMPFILE on Linux). tacozip_writer_finish() syncs it as the durability
+ * option asks, gives it a temporary name with linkat() and renames that over
+ * the target, so a name only ever points at a complete archive; platforms
+ * without O_TMPFILE start from a named temporary file. An aborted writer
+ * leaves the target untouched and, with an unnamed file, nothing behind.
+ */
+
+/* Platform-specific feature detection */
+#if defined(__linux__) || defined(__gnu_linux__)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#elif defined(__APPLE__) || defined(__MACH__)
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64  /* large-file I/O on POSIX */
+#endif
+
+#include "tacozip_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Uniform run states (tacozip_writer_opts_t::uniform_size). */
+enum { TACOZ_RUN_OFF = 0, TACOZ_RUN_OPEN, TACOZ_RUN_CLOSED };
+
+/* --------------------------------- Writer ---------------------------------- */
+
+struct tacozip_writer {
+    int            fd;          /* temp file descriptor                       */
+    char          *path;        /* final archive path                         */
+    char          *tmp_path;    /* temp file renamed over path on finish
+                                   (NULL while the file is unnamed)          */
+
+    unsigned char *buf;         /* output buffer                              */
+    size_t         cap;
+    size_t         len;
+    uint64_t       base;        /* file offset of buf[0]                      */
+
+    taco_ghost_t   ghost;       /* slots written into the ghost on finish     */
+    int            ghost_version;
+    unsigned       ghost_slots; /* slot capacity (7 for v1)                   */
+    size_t         ghost_size;  /* stored payload bytes                       */
+    unsigned char *ghost_buf;   /* ghost_size bytes of encoding scratch       */
+    uint32_t       ghost_dostime;
+    tacoz_cdstore_t *cd;        /* central-directory entries (ghost excluded) */
+    unsigned       open_ahead;  /* add_files read-ahead window (0 = sync)     */
+    int            sort_cd;     /* emit the directory in name order           */
+    int            durability;  /* TACOZIP_DURABLE_* applied on finish        */
+
+    int            uniform;     /* TACOZ_RUN_* state of the uniform run       */
+    int            in_meta;     /* adding a slot-referenced entry             */
+    uint64_t       uniform_size;
+    uint64_t       uniform_stride;
+    uint64_t       uniform_base;  /* data offset of run entry 0               */
+    uint64_t       uniform_count;
+    unsigned       uniform_align;
+
+    time_t         dos_cache_t; /* last converted timestamp                   */
+    uint16_t       dos_cache_time;
+    uint16_t       dos_cache_date;
+
+    int            failed;      /* sticky error once an entry is half-written */
+};
+
+static inline uint64_t out_pos(const tacozip_writer_t *w) {
+    return w->base + w->len;
+}
+
+static int out_flush(tacozip_writer_t *w) {
+    if (w->len == 0) return TACOZ_OK;
+    int rc = tacoz_write_all(w->fd, w->buf, w->len);
+    if (rc != TACOZ_OK) return rc;
+    w->base += w->len;
+    w->len = 0;
+    return TACOZ_OK;
+}
+
+/** Return a pointer to @p n contiguous free bytes (n <= cap) and commit them. */
+static unsigned char *out_reserve(tacozip_writer_t *w, size_t n) {
+    if (w->cap - w->len < n && out_flush(w) != TACOZ_OK) return NULL;
+    unsigned char *p = w->buf + w->len;
+    w->len += n;
+    return p;
+}
+
+static int out_zeros(tacozip_writer_t *w, uint64_t n) {
+    while (n > 0) {
+        size_t k = n < w->cap ? (size_t)n : w->cap;
+        unsigned char *p = out_reserve(w, k);
+        if (!p) return TACOZ_ERR_IO;
+        memset(p, 0, k);
+        n -= k;
+    }
+    return TACOZ_OK;
+}
+
+static int out_write(tacozip_writer_t *w, const void *data, size_t n) {
+    if (w->cap - w->len < n) {
+        int rc = out_flush(w);
+        if (rc != TACOZ_OK) return rc;
+        if (n >= w->cap) {
+            rc = tacoz_write_all(w->fd, data, n);
+            if (rc == TACOZ_OK) w->base += n;
+            return rc;
+        }
+    }
+    memcpy(w->buf + w->len, data, n);
+    w->len += n;
+    return TACOZ_OK;
+}
+
+/**
+ * @brief Overwrite already-emitted bytes. A header is reserved contiguously and
+ *        flushes always drain the whole buffer, so a patched field is either
+ *        entirely buffered or entirely on disk.
+ */
+static int out_patch(tacozip_writer_t *w, uint64_t off, const void *data, size_t n) {
+    if (off >= w->base) {
+        memcpy(w->buf + (size_t)(off - w->base), data, n);
+        return TACOZ_OK;
+    }
+    return tacoz_pwrite_all(w->fd, data, n, off);
+}
+
+static void dos_datetime(tacozip_writer_t *w, time_t t, uint16_t *dtime, uint16_t *ddate) {
+    if (t == w->dos_cache_t) {
+        *dtime = w->dos_cache_time;
+        *ddate = w->dos_cache_date;
+        return;
+    }
+
+    uint32_t dos = tacoz_dostime((int64_t)t);
+    *dtime = (uint16_t)dos;
+    *ddate = (uint16_t)(dos >> 16);
+    w->dos_cache_t = t;
+    w->dos_cache_time = *dtime;
+    w->dos_cache_date = *ddate;
+}
+
+/* ------------------------------ Entry plumbing ----------------------------- */
+
+typedef struct {
+    const char *name;
+    uint16_t    name_len;
+    uint16_t    dtime;
+    uint16_t    ddate;
+    uint32_t    mode;
+    uint64_t    lfh_off;
+} entry_hdr_t;
+
+static int check_arc_name(const char *arc_name, size_t *name_len) {
+    if (!arc_name) return TACOZ_ERR_PARAM;
+    size_t n = strlen(arc_name);
+    if (n == 0 || n > 0xFFFFu) return TACOZ_ERR_PARAM;
+    if (n == TACO_GHOST_NAME_LEN && memcmp(arc_name, TACO_GHOST_NAME, n) == 0)
+        return TACOZ_ERR_PARAM;  /* the ghost is managed by the writer */
+    *name_len = n;
+    return TACOZ_OK;
+}
+
+/**
+ * @brief In a uniform run, pad with zeros so the entry's data lands on
+ *        base + i * stride. A slot-referenced entry ends the run instead.
+ * @param size  Entry size, if @p known.
+ * @param known 0 for streams, whose size record_entry() checks at the end.
+ */
+static int place_uniform(tacozip_writer_t *w, const entry_hdr_t *h, uint64_t size, int known) {
+    if (w->uniform == TACOZ_RUN_OFF) return TACOZ_OK;
+    if (w->in_meta) {
+        if (w->uniform == TACOZ_RUN_OPEN) w->uniform = TACOZ_RUN_CLOSED;
+        return TACOZ_OK;
+    }
+    if (w->uniform == TACOZ_RUN_CLOSED || h->name_len > TACOZ_UNIFORM_NAME_MAX ||
+        (known && size != w->uniform_size))
+        return TACOZ_ERR_PARAM;
+
+    uint64_t hdr = TACOZ_LFH_TOTAL(h->name_len), data;
+    if (w->uniform_count == 0) {
+        data = (out_pos(w) + hdr + w->uniform_align - 1) & ~(uint64_t)(w->uniform_align - 1);
+        w->uniform_base = data;
+    } else {
+        data = w->uniform_base + w->uniform_count * w->uniform_stride;
+    }
+    return out_zeros(w, data - hdr - out_pos(w));
+}
+
+/** Emit a Local File Header; CRC and sizes may be patched later. @p size is
+ *  only a placeholder when @p known is 0. Nothing is written on error. */
+static int emit_lfh(tacozip_writer_t *w, entry_hdr_t *h, uint32_t crc, uint64_t size,
+                    int known) {
+    size_t total = TACOZ_LFH_TOTAL(h->name_len);
+    if (total > w->cap) return TACOZ_ERR_PARAM;
+    int rc = place_uniform(w, h, size, known);
+    if (rc != TACOZ_OK) return rc;
+
+    h->lfh_off = out_pos(w);
+    unsigned char *p = out_reserve(w, total);
+    if (!p) return TACOZ_ERR_IO;
+
+    le32(p +  0, TACOZ_SIG_LFH);
+    le16(p +  4, TACOZ_VERSION_ZIP64);
+    le16(p +  6, TACOZ_SET_UTF8_FLAG ? TACOZ_GPBIT_UTF8 : 0);
+    le16(p +  8, 0);                      /* method: STORE */
+    le16(p + 10, h->dtime);
+    le16(p + 12, h->ddate);
+    le32(p + 14, crc);
+    le32(p + 18, 0xFFFFFFFFu);            /* sizes live in the ZIP64 extra */
+    le32(p + 22, 0xFFFFFFFFu);
+    le16(p + 26, h->name_len);
+    le16(p + 28, TACOZ_LFH_EXTRA_SIZE);
+    memcpy(p + TACOZ_LFH_SIZE, h->name, h->name_len);
+
+    unsigned char *x = p + TACOZ_LFH_SIZE + h->name_len;
+    le16(x + 0, TACOZ_ZIP64_EXTRA_ID);
+    le16(x + 2, 16);
+    le64(x + 4, size);                    /* uncompressed */
+    le64(x + 12, size);                   /* compressed (STORE) */
+    return TACOZ_OK;
+}
+
+/** Patch CRC and sizes of an LFH emitted with placeholders. */
+static int patch_lfh(tacozip_writer_t *w, const entry_hdr_t *h, uint32_t crc,
+                     int patch_size, uint64_t size) {
+    unsigned char tmp[16];
+    le32(tmp, crc);
+    int rc = out_patch(w, h->lfh_off + 14, tmp, 4);
+    if (rc != TACOZ_OK || !patch_size) return rc;
+    le64(tmp + 0, size);
+    le64(tmp + 8, size);
+    return out_patch(w, h->lfh_off + TACOZ_LFH_SIZE + h->name_len + 4, tmp, 16);
+}
+
+/** Remember a completed entry for the central directory. */
+static int record_entry(tacozip_writer_t *w, const entry_hdr_t *h, uint32_t crc, uint64_t size) {
+    if (w->uniform == TACOZ_RUN_OPEN && !w->in_meta) {
+        if (size != w->uniform_size) return TACOZ_ERR_PARAM;  /* a stream or a file that changed */
+        w->uniform_count++;
+    }
+
+    tacoz_cd_entry_t e;
+    e.lfh_off  = h->lfh_off;
+    e.size     = size;
+    e.crc      = crc;
+    e.mode     = h->mode;
+    e.dostime  = (uint32_t)h->dtime | ((uint32_t)h->ddate << 16);
+    e.name_len = h->name_len;
+    e.name     = h->name;
+    return tacoz_cdstore_push(w->cd, &e);
+}
+
+/** Serialize one central-directory record straight into the output buffer. */
+static int emit_cdh(void *ctx, const tacoz_cd_entry_t *e) {
+    tacozip_writer_t *w = (tacozip_writer_t *)ctx;
+    unsigned char *p = out_reserve(w, TACOZ_CDH_TOTAL(e->name_len));
+    if (!p) return TACOZ_ERR_IO;
+    tacoz_cdh_build(e, p);
+    return TACOZ_OK;
+}
+
+static int begin_entry(tacozip_writer_t *w, const char *arc_name, time_t mtime,
+                       uint32_t mode, entry_hdr_t *h) {
+    if (!w) return TACOZ_ERR_PARAM;
+    if (w->failed) return w->failed;
+
+    size_t name_len;
+    int rc = check_arc_name(arc_name, &name_len);
+    if (rc != TACOZ_OK) return rc;
+
+    h->name = arc_name;
+    h->name_len = (uint16_t)name_len;
+    h->mode = mode;
+    dos_datetime(w, mtime, &h->dtime, &h->ddate);
+    return TACOZ_OK;
+}
+
+/** Mark the writer failed; the half-written entry cannot be taken back. */
+static int fail(tacozip_writer_t *w, int rc) {
+    w->failed = rc;
+    return rc;
+}
+
+/* --------------------------------- Ghost ----------------------------------- */
+
+static int write_ghost(tacozip_writer_t *w) {
+    int rc = tacoz_ghost_encode(&w->ghost, w->ghost_version, w->ghost_buf, w->ghost_size);
+    if (rc != TACOZ_OK) return rc;
+
+    entry_hdr_t h;
+    h.name = TACO_GHOST_NAME;
+    h.name_len = TACO_GHOST_NAME_LEN;
+    h.mode = TACOZ_DEFAULT_MODE;
+    dos_datetime(w, time(NULL), &h.dtime, &h.ddate);
+    w->ghost_dostime = (uint32_t)h.dtime | ((uint32_t)h.ddate << 16);
+
+    /* CRC is filled in by emit_ghost_cdh() once the payload is final. */
+    rc = emit_lfh(w, &h, 0, w->ghost_size, 1);
+    if (rc != TACOZ_OK) return rc;
+    return out_write(w, w->ghost_buf, w->ghost_size);
+}
+
+/**
+ * @brief Rewrite the ghost payload and CRC in place and emit its central
+ *        directory record, which always comes first.
+ */
+static int emit_ghost_cdh(tacozip_writer_t *w) {
+    int rc = tacoz_ghost_encode(&w->ghost, w->ghost_version, w->ghost_buf, w->ghost_size);
+    if (rc != TACOZ_OK) return rc;
+    uint32_t crc = tacoz_crc32(0, w->ghost_buf, w->ghost_size);
+
+    /* The ghost is always the first entry at offset 0. */
+    rc = out_patch(w, TACOZ_LFH_TOTAL(TACO_GHOST_NAME_LEN), w->ghost_buf, w->ghost_size);
+    if (rc != TACOZ_OK) return rc;
+
+    unsigned char tmp[4];
+    le32(tmp, crc);
+    rc = out_patch(w, 14, tmp, sizeof(tmp));
+    if (rc != TACOZ_OK) return rc;
+
+    tacoz_cd_entry_t e;
+    e.lfh_off  = 0;
+    e.size     = w->ghost_size;
+    e.crc      = crc;
+    e.mode     = TACOZ_DEFAULT_MODE;
+    e.dostime  = w->ghost_dostime;
+    e.name_len = TACO_GHOST_NAME_LEN;
+    e.name     = TACO_GHOST_NAME;
+    return emit_cdh(w, &e);
+}
+
+static void writer_free(tacozip_writer_t *w) {
+    tacoz_cdstore_free(w->cd);
+    free(w->ghost_buf);
+    free(w->buf);
+    free(w->tmp_path);
+    free(w->path);
+    free(w);
+}
+
+/* ========================================================================== */
+/*                              Public writer API                             */
+/* ========================================================================== */
+
+void tacozip_writer_opts_init(tacozip_writer_opts_t *opts) {
+    if (!opts) return;
+    memset(opts, 0, sizeof(*opts));
+    opts->buffer_size = TACOZ_COPY_BUFSZ;
+    opts->cd_mem_cap = TACOZ_CD_MEM_CAP;
+    opts->open_ahead = TACOZ_OPEN_AHEAD;
+    opts->ghost_slots = 0;
+    opts->ghost_inline = 0;
+    opts->ghost_slack = 0;
+    opts->sort_cd = 0;
+    opts->uniform_size = 0;
+    opts->uniform_align = 0;
+    opts->durability = TACOZ_DURABILITY;
+}
+
+int tacozip_writer_begin(const char *zip_path,
+                         const tacozip_writer_opts_t *opts,
+                         tacozip_writer_t **out) {
+    if (!zip_path || !out) return TACOZ_ERR_PARAM;
+    *out = NULL;
+
+    tacozip_writer_opts_t defaults;
+    if (!opts) {
+        tacozip_writer_opts_init(&defaults);
+        opts = &defaults;
+    }
+    unsigned align = opts->uniform_align ? opts->uniform_align : TACOZ_UNIFORM_ALIGN;
+    unsigned uniform_hdr = opts->uniform_size ? TACO_GHOST_V2_UNIFORM_SIZE : 0;
+    if (opts->ghost_slots > TACO_GHOST_V2_MAX_SLOTS || opts->ghost_inline > TACO_GHOST_INLINE_MAX ||
+        ((opts->ghost_inline || opts->ghost_slack || opts->sort_cd || opts->uniform_size) &&
+         !opts->ghost_slots) ||
+        (uint64_t)TACO_GHOST_V2_SIZE(opts->ghost_slots) + TACO_GHOST_V2_CRC_SIZE(opts->ghost_slots) +
+            uniform_hdr + opts->ghost_inline + opts->ghost_slack > UINT32_MAX ||
+        (align & (align - 1)) != 0 || align > TACOZ_UNIFORM_ALIGN_MAX ||
+        opts->uniform_size > UINT64_MAX / 2 ||
+        opts->durability < TACOZIP_DURABLE_NONE || opts->durability > TACOZIP_DURABLE_FULL)
+        return TACOZ_ERR_PARAM;
+
+    size_t cap = opts->buffer_size ? opts->buffer_size : TACOZ_COPY_BUFSZ;
+    if (cap < TACOZ_LFH_TOTAL(0xFFFFu)) cap = TACOZ_LFH_TOTAL(0xFFFFu);  /* largest header */
+
+    tacozip_writer_t *w = calloc(1, sizeof(*w));
+    if (!w) return TACOZ_ERR_IO;
+    w->fd = -1;
+    w->dos_cache_t = (time_t)-1;
+    w->cap = cap;
+    w->open_ahead = opts->open_ahead;
+    w->sort_cd = opts->sort_cd != 0;
+    w->durability = opts->durability;
+    tacozip_ghost_init(&w->ghost);
+    w->ghost_version = opts->ghost_slots ? 2 : 1;
+    w->ghost_slots = opts->ghost_slots ? opts->ghost_slots : TACO_GHOST_MAX_ENTRIES;
+    w->ghost_size = opts->ghost_slots ? (size_t)TACO_GHOST_V2_SIZE(opts->ghost_slots) +
+                                        TACO_GHOST_V2_CRC_SIZE(opts->ghost_slots) + uniform_hdr +
+                                        opts->ghost_inline + opts->ghost_slack
+                                      : TACO_GHOST_PAYLOAD_SIZE;
+    w->ghost_buf = malloc(w->ghost_size);
+    w->buf = malloc(cap);
+    w->path = malloc(strlen(zip_path) + 1);
+    if (!w->ghost_buf || !w->buf || !w->path) {
+        writer_free(w);
+        return TACOZ_ERR_IO;
+    }
+    strcpy(w->path, zip_path);
+
+    /* Sorting needs every name at hand, so a sorted directory never spills. */
+    if (tacoz_cdstore_create(w->sort_cd ? 0 : opts->cd_mem_cap, zip_path, &w->cd) != TACOZ_OK) {
+        writer_free(w);
+        return TACOZ_ERR_IO;
+    }
+
+    w->fd = tacoz_create_unnamed(zip_path, &w->tmp_path);
+    if (w->fd < 0) {
+        writer_free(w);
+        return TACOZ_ERR_IO;
+    }
+
+    /* Ghost first so its LFH sits at byte 0; payload patched on finish. */
+    int rc = write_ghost(w);
+    if (rc != TACOZ_OK) {
+        tacozip_writer_abort(w);
+        return rc;
+    }
+
+    /* Room in front of each entry's data for the largest allowed LFH. */
+    if (opts->uniform_size) {
+        w->uniform = TACOZ_RUN_OPEN;
+        w->uniform_size = opts->uniform_size;
+        w->uniform_align = align;
+        w->uniform_stride = (opts->uniform_size + TACOZ_LFH_TOTAL(TACOZ_UNIFORM_NAME_MAX) + align - 1) &
+                            ~(uint64_t)(align - 1);
+    }
+
+    *out = w;
+    return TACOZ_OK;
+}
+
+int tacozip_writer_set_ghost(tacozip_writer_t *w,
+                             const uint64_t *meta_offsets,
+                             const uint64_t *meta_lengths,
+                             size_t array_size) {
+    if (!w || !meta_offsets || !meta_lengths || array_size != TACO_GHOST_MAX_ENTRIES)
+        return TACOZ_ERR_PARAM;
+    taco_meta_array_t meta;
+    tacoz_arrays_to_meta(meta_offsets, meta_lengths, &meta);
+    taco_ghost_t g;
+    tacoz_ghost_from_meta(&meta, &g);
+    return tacozip_writer_set_ghost_v2(w, &g);
+}
+
+int tacozip_writer_set_ghost_v2(tacozip_writer_t *w, const taco_ghost_t *ghost) {
+    if (!w || !ghost || ghost->count > w->ghost_slots) return TACOZ_ERR_PARAM;
+    if (w->ghost_version == 2 && tacoz_ghost_used(ghost, 2) > w->ghost_size)
+        return TACOZ_ERR_PARAM;  /* inline copies exceed ghost_inline */
+    w->ghost = *ghost;
+    return TACOZ_OK;
+}
+
+/** Copy an already opened source as the next entry. Always closes fd. */
+static int add_open_file(tacozip_writer_t *w, int fd, const tacoz_filestat_t *st,
+                         const char *arc_name) {
+    if (!st->is_regular) {
+        tacoz_close(fd);
+        return TACOZ_ERR_IO;
+    }
+
+    entry_hdr_t h;
+    int rc = begin_entry(w, arc_name, (time_t)st->mtime, st->mode, &h);
+    if (rc == TACOZ_OK) rc = emit_lfh(w, &h, 0, st->size, 1);
+    if (rc != TACOZ_OK) {
+        tacoz_close(fd);
+        return rc;
+    }
+
+    /* Read straight into the output buffer; CRC is computed on the fly. */
+    uint32_t crc = 0;
+    uint64_t total = 0;
+    for (;;) {
+        if (w->len == w->cap && (rc = out_flush(w)) != TACOZ_OK) break;
+        int64_t r = tacoz_read(fd, w->buf + w->len, w->cap - w->len);
+        if (r < 0) { rc = TACOZ_ERR_IO; break; }
+        if (r == 0) break;
+        crc = tacoz_crc32(crc, w->buf + w->len, (size_t)r);
+        w->len += (size_t)r;
+        total += (uint64_t)r;
+    }
+    tacoz_close(fd);
+    if (rc != TACOZ_OK) return fail(w, rc);
+
+    /* Sizes only need patching if the file changed size while being read. */
+    rc = patch_lfh(w, &h, crc, total != st->size, total);
+    if (rc == TACOZ_OK) rc = record_entry(w, &h, crc, total);
+    return rc == TACOZ_OK ? rc : fail(w, rc);
+}
+
+/** Append a source whose whole body was already read (and checksummed). */
+static int add_read_file(tacozip_writer_t *w, const tacoz_src_t *src, const char *arc_name) {
+    entry_hdr_t h;
+    int rc = begin_entry(w, arc_name, (time_t)src->st.mtime, src->st.mode, &h);
+    if (rc == TACOZ_OK) rc = emit_lfh(w, &h, src->crc, src->len, 1);
+    if (rc != TACOZ_OK) return rc;
+
+    rc = src->len ? out_write(w, src->data, src->len) : TACOZ_OK;
+    if (rc == TACOZ_OK) rc = record_entry(w, &h, src->crc, src->len);
+    return rc == TACOZ_OK ? rc : fail(w, rc);
+}
+
+int tacozip_writer_add_file(tacozip_writer_t *w, const char *src_path, const char *arc_name) {
+    if (!src_path) return TACOZ_ERR_PARAM;
+
+    int fd = tacoz_open_read(src_path);
+    if (fd < 0) return TACOZ_ERR_IO;
+
+    tacoz_filestat_t st;
+    if (tacoz_fstat(fd, &st) != TACOZ_OK) {
+        tacoz_close(fd);
+        return TACOZ_ERR_IO;
+    }
+    return add_open_file(w, fd, &st, arc_name);
+}
+
+/** Point ghost slot @p slot at the entry just written from @p lfh_off. */
+static void point_slot(tacozip_writer_t *w, unsigned slot, uint64_t lfh_off, const char *arc_name) {
+    /* The entry is STORE, so its bytes sit right after the LFH. */
+    uint64_t data_off = lfh_off + TACOZ_LFH_TOTAL(strlen(arc_name));
+    w->ghost.slots[slot].offset = data_off;
+    w->ghost.slots[slot].length = out_pos(w) - data_off;
+    if (slot >= w->ghost.count) w->ghost.count = (uint16_t)(slot + 1);
+}
+
+int tacozip_writer_add_meta_file(tacozip_writer_t *w, const char *src_path,
+                                 const char *arc_name, unsigned slot) {
+    if (!w || !arc_name || slot >= w->ghost_slots) return TACOZ_ERR_PARAM;
+
+    uint64_t lfh_off = out_pos(w);  /* no padding: slot entries are outside the run */
+    w->in_meta = 1;
+    int rc = tacozip_writer_add_file(w, src_path, arc_name);
+    w->in_meta = 0;
+    if (rc == TACOZ_OK) point_slot(w, slot, lfh_off, arc_name);
+    return rc;
+}
+
+int tacozip_writer_add_name_index(tacozip_writer_t *w, const char *arc_name, unsigned slot) {
+    if (!w || !arc_name || slot >= w->ghost_slots) return TACOZ_ERR_PARAM;
+    if (w->failed) return w->failed;
+
+    unsigned char *index;
+    size_t len;
+    uint64_t lfh_off = out_pos(w);
+    int rc = tacoz_nameidx_build(w->cd, lfh_off + TACOZ_LFH_TOTAL(strlen(arc_name)), &index, &len);
+    if (rc != TACOZ_OK) return rc;
+
+    w->in_meta = 1;
+    rc = tacozip_writer_add_buffer(w, arc_name, index, len);
+    w->in_meta = 0;
+    if (rc == TACOZ_OK) point_slot(w, slot, lfh_off, arc_name);
+    free(index);
+    return rc;
+}
+
+int tacozip_writer_add_id_table(tacozip_writer_t *w, const char *arc_name, unsigned slot) {
+    if (!w || !arc_name || slot >= w->ghost_slots) return TACOZ_ERR_PARAM;
+    if (w->failed) return w->failed;
+
+    unsigned char *table;
+    size_t len;
+    uint64_t lfh_off = out_pos(w);
+    int rc = tacoz_idtable_build(w->cd, lfh_off + TACOZ_LFH_TOTAL(strlen(arc_name)), &table, &len);
+    if (rc != TACOZ_OK) return rc;
+
+    w->in_meta = 1;
+    rc = tacozip_writer_add_buffer(w, arc_name, table, len);
+    w->in_meta = 0;
+    if (rc == TACOZ_OK) point_slot(w, slot, lfh_off, arc_name);
+    free(table);
+    return rc;
+}
+
+int tacozip_writer_add_files(tacozip_writer_t *w,
+                             const char * const *src_files,
+                             const char * const *arc_files,
+                             size_t num_files,
+                             size_t *num_added) {
+    if (num_added) *num_added = 0;
+    if (!w || (num_files > 0 && (!src_files || !arc_files))) return TACOZ_ERR_PARAM;
+    for (size_t i = 0; i < num_files; i++)
+        if (!src_files[i]) return TACOZ_ERR_PARAM;  /* paths are read ahead */
+    if (num_files == 0) return TACOZ_OK;
+
+    unsigned window = w->open_ahead;
+    if ((size_t)window > num_files) window = (unsigned)num_files;
+
+    tacoz_srcpool_t *pool;
+    int rc = tacoz_srcpool_create(window, src_files, num_files, &pool);
+    if (rc != TACOZ_OK) return rc;
+
+    size_t i;
+    for (i = 0; i < num_files; i++) {
+        tacoz_src_t src;
+        rc = tacoz_srcpool_next(pool, &src);
+        if (rc != TACOZ_OK) break;
+        rc = src.fd >= 0 ? add_open_file(w, src.fd, &src.st, arc_files[i])
+                         : add_read_file(w, &src, arc_files[i]);
+        if (rc != TACOZ_OK) break;
+    }
+    tacoz_srcpool_free(pool);
+
+    if (num_added) *num_added = i;
+    return rc;
+}
+
+/** Copy one slice of an already opened source as the next entry. */
+static int add_slice_fd(tacozip_writer_t *w, int fd, const tacoz_filestat_t *st,
+                        const tacozip_slice_t *s, const char *arc_name) {
+    if (!st->is_regular) return TACOZ_ERR_IO;
+    if (s->offset > st->size || s->length > st->size - s->offset) return TACOZ_ERR_PARAM;
+
+    entry_hdr_t h;
+    int rc = begin_entry(w, arc_name, (time_t)st->mtime, st->mode, &h);
+    if (rc == TACOZ_OK) rc = emit_lfh(w, &h, s->has_crc ? s->crc32 : 0, s->length, 1);
+    if (rc != TACOZ_OK) return rc;
+
+    uint64_t off = s->offset;
+    uint64_t left = s->length;
+
+    /* Known CRC: the bytes never need to pass through user space. */
+    if (s->has_crc && left >= TACOZ_COPY_RANGE_MIN) {
+        if ((rc = out_flush(w)) != TACOZ_OK) return fail(w, rc);
+        int64_t copied = tacoz_copy_range(fd, off, w->fd, left);
+        if (copied < 0) return fail(w, TACOZ_ERR_IO);
+        w->base += (uint64_t)copied;
+        off += (uint64_t)copied;
+        left -= (uint64_t)copied;
+    }
+
+    uint32_t crc = 0;
+    while (left > 0) {
+        if (w->len == w->cap && (rc = out_flush(w)) != TACOZ_OK) return fail(w, rc);
+        size_t room = w->cap - w->len;
+        size_t n = left < room ? (size_t)left : room;
+        if (tacoz_pread_all(fd, w->buf + w->len, n, off) != TACOZ_OK) return fail(w, TACOZ_ERR_IO);
+        if (!s->has_crc) crc = tacoz_crc32(crc, w->buf + w->len, n);
+        w->len += n;
+        off += n;
+        left -= n;
+    }
+
+    if (s->has_crc) crc = s->crc32;
+    else if ((rc = patch_lfh(w, &h, crc, 0, s->length)) != TACOZ_OK) return fail(w, rc);
+    rc = record_entry(w, &h, crc, s->length);
+    return rc == TACOZ_OK ? rc : fail(w, rc);
+}
+
+int tacozip_writer_add_slice(tacozip_writer_t *w, const tacozip_slice_t *slice,
+                             const char *arc_name) {
+    return tacozip_writer_add_slices(w, slice, &arc_name, 1, NULL);
+}
+
+int tacozip_writer_add_slices(tacozip_writer_t *w,
+                              const tacozip_slice_t *slices,
+                              const char * const *arc_files,
+                              size_t num_slices,
+                              size_t *num_added) {
+    if (num_added) *num_added = 0;
+    if (!w || (num_slices > 0 && (!slices || !arc_files))) return TACOZ_ERR_PARAM;
+
+    int rc = TACOZ_OK;
+    int fd = -1;
+    const char *fd_path = NULL;
+    tacoz_filestat_t st;
+
+    size_t i;
+    for (i = 0; i < num_slices; i++) {
+        const tacozip_slice_t *s = &slices[i];
+        if (!s->src_path) { rc = TACOZ_ERR_PARAM; break; }
+
+        /* Slices of one blob usually come in runs: keep its descriptor open. */
+        if (fd < 0 || (s->src_path != fd_path && strcmp(s->src_path, fd_path) != 0)) {
+            if (fd >= 0) tacoz_close(fd);
+            fd_path = s->src_path;
+            fd = tacoz_open_read(fd_path);
+            if (fd < 0) { rc = TACOZ_ERR_IO; break; }
+            if (tacoz_fstat(fd, &st) != TACOZ_OK) { rc = TACOZ_ERR_IO; break; }
+        }
+
+        rc = add_slice_fd(w, fd, &st, s, arc_files[i]);
+        if (rc != TACOZ_OK) break;
+    }
+    if (fd >= 0) tacoz_close(fd);
+
+    if (num_added) *num_added = i;
+    return rc;
+}
+
+void tacozip_dir_opts_init(tacozip_dir_opts_t *opts) {
+    if (!opts) return;
+    memset(opts, 0, sizeof(*opts));
+    opts->sort = TACOZIP_SORT_PATH;
+}
+
+int tacozip_writer_add_dir(tacozip_writer_t *w, const char *root_dir,
+                           const tacozip_dir_opts_t *opts, size_t *num_added) {
+    if (num_added) *num_added = 0;
+    if (!w || !root_dir) return TACOZ_ERR_PARAM;
+
+    tacozip_dir_opts_t defaults;
+    if (!opts) {
+        tacozip_dir_opts_init(&defaults);
+        opts = &defaults;
+    }
+    if ((opts->num_include && !opts->include) || (opts->num_exclude && !opts->exclude))
+        return TACOZ_ERR_PARAM;
+
+    tacoz_dirlist_t *list;
+    int rc = tacoz_dirwalk(root_dir, opts, w->fd, &list);
+    if (rc != TACOZ_OK) return rc;
+
+    /* Archive name = prefix + relative path, assembled in one reusable buffer. */
+    size_t plen = opts->arc_prefix ? strlen(opts->arc_prefix) : 0;
+    size_t name_cap = plen + 256;
+    char *name = malloc(name_cap);
+    if (!name) rc = TACOZ_ERR_IO;
+    else if (plen) memcpy(name, opts->arc_prefix, plen);
+
+    size_t i, n = tacoz_dirlist_count(list);
+    for (i = 0; rc == TACOZ_OK && i < n; i++) {
+        const char *rel = tacoz_dirlist_path(list, i);
+        size_t rlen = strlen(rel);
+        if (plen + rlen + 1 > name_cap) {
+            char *p = realloc(name, plen + rlen + 1);
+            if (!p) { rc = TACOZ_ERR_IO; break; }
+            name = p;
+            name_cap = plen + rlen + 1;
+        }
+        memcpy(name + plen, rel, rlen + 1);
+
+        int fd;
+        tacoz_filestat_t st;
+        rc = tacoz_dirlist_open(list, i, &fd, &st);
+        if (rc != TACOZ_OK) break;
+        rc = add_open_file(w, fd, &st, name);
+        if (rc != TACOZ_OK) break;
+    }
+    free(name);
+    tacoz_dirlist_free(list);
+
+    if (num_added) *num_added = i;
+    return rc;
+}
+
+int tacozip_writer_add_buffer(tacozip_writer_t *w, const char *arc_name,
+                              const void *data, size_t len) {
+    if (!data && len > 0) return TACOZ_ERR_PARAM;
+
+    entry_hdr_t h;
+    int rc = begin_entry(w, arc_name, time(NULL), TACOZ_DEFAULT_MODE, &h);
+    if (rc != TACOZ_OK) return rc;
+
+    uint32_t crc = len ? tacoz_crc32(0, data, len) : 0;
+    rc = emit_lfh(w, &h, crc, len, 1);
+    if (rc != TACOZ_OK) return rc;
+
+    rc = len ? out_write(w, data, len) : TACOZ_OK;
+    if (rc == TACOZ_OK) rc = record_entry(w, &h, crc, len);
+    return rc == TACOZ_OK ? rc : fail(w, rc);
+}
+
+int tacozip_writer_add_stream(tacozip_writer_t *w, const char *arc_name,
+                              tacozip_read_fn read_fn, void *user) {
+    if (!read_fn) return TACOZ_ERR_PARAM;
+
+    entry_hdr_t h;
+    int rc = begin_entry(w, arc_name, time(NULL), TACOZ_DEFAULT_MODE, &h);
+    if (rc == TACOZ_OK) rc = emit_lfh(w, &h, 0, 0, 0);
+    if (rc != TACOZ_OK) return rc;
+
+    uint32_t crc = 0;
+    uint64_t total = 0;
+    for (;;) {
+        if (w->len == w->cap && (rc = out_flush(w)) != TACOZ_OK) break;
+        size_t room = w->cap - w->len;
+        int64_t r = read_fn(user, w->buf + w->len, room);
+        if (r < 0 || (uint64_t)r > room) { rc = TACOZ_ERR_IO; break; }
+        if (r == 0) break;
+        crc = tacoz_crc32(crc, w->buf + w->len, (size_t)r);
+        w->len += (size_t)r;
+        total += (uint64_t)r;
+    }
+    if (rc != TACOZ_OK) return fail(w, rc);
+
+    rc = patch_lfh(w, &h, crc, 1, total);
+    if (rc == TACOZ_OK) rc = record_entry(w, &h, crc, total);
+    return rc == TACOZ_OK ? rc : fail(w, rc);
+}
+
+int tacozip_writer_finish(tacozip_writer_t *w) {
+    if (!w) return TACOZ_ERR_PARAM;
+    if (w->failed) {
+        int rc = w->failed;
+        tacozip_writer_abort(w);
+        return rc;
+    }
+
+    /* Central directory: ghost record first, then every stored entry (in
+     * name order with sort_cd). Its extent is known up front, so the ghost
+     * can point at it. */
+    uint64_t cd_off = out_pos(w);
+    uint64_t entries = tacoz_cdstore_count(w->cd) + 1;
+    w->ghost.cd_offset  = cd_off;
+    w->ghost.cd_size    = TACOZ_CDH_SIZE + TACO_GHOST_NAME_LEN + TACOZ_CDH_EXTRA_SIZE +
+                          tacoz_cdstore_cd_size(w->cd);
+    w->ghost.cd_entries = entries;
+    w->ghost.generation = 1;
+    w->ghost.flags &= ~TACOZ_GHOST_LAYOUT_FLAGS;
+    if (w->sort_cd) w->ghost.flags |= TACO_GHOST_F_CD_SORTED;
+    if (w->uniform != TACOZ_RUN_OFF) w->ghost.flags |= TACO_GHOST_F_UNIFORM;
+    w->ghost.uniform_base   = w->uniform_base;
+    w->ghost.uniform_stride = w->uniform_stride;
+    w->ghost.uniform_size   = w->uniform_size;
+    w->ghost.uniform_count  = w->uniform_count;
+    int rc = TACOZ_OK;
+    if (w->ghost_version == 2 && (w->ghost.flags & TACO_GHOST_F_SLOT_CRC)) {
+        rc = out_flush(w);  /* slot checksums read back what was written */
+        if (rc == TACOZ_OK) rc = tacoz_ghost_slot_crcs(w->fd, &w->ghost);
+    }
+    if (rc == TACOZ_OK) rc = emit_ghost_cdh(w);
+    if (rc == TACOZ_OK) rc = w->sort_cd ? tacoz_cdstore_foreach_sorted(w->cd, emit_cdh, w)
+                                        : tacoz_cdstore_foreach(w->cd, emit_cdh, w);
+    uint64_t cd_size = out_pos(w) - cd_off;
+    if (rc == TACOZ_OK && cd_size != w->ghost.cd_size) rc = TACOZ_ERR_IO;
+
+    /* ZIP64 EOCD record + locator + classic EOCD with sentinel values */
+    unsigned char tail[TACOZ_TAIL_SIZE];
+    tacoz_tail_build(tail, entries, cd_size, cd_off, out_pos(w));
+
+    if (rc == TACOZ_OK) rc = out_write(w, tail, sizeof(tail));
+    if (rc == TACOZ_OK) rc = out_flush(w);
+    if (rc != TACOZ_OK) {
+        tacozip_writer_abort(w);
+        return rc;
+    }
+
+    rc = tacoz_publish(w->fd, w->tmp_path, w->path, w->durability);
+    w->fd = -1;
+    if (rc != TACOZ_OK) {
+        if (w->tmp_path) tacoz_unlink(w->tmp_path);
+        writer_free(w);
+        return rc;
+    }
+
+    writer_free(w);
+    return TACOZ_OK;
+}
+
+void tacozip_writer_abort(tacozip_writer_t *w) {
+    if (!w) return;
+    if (w->fd >= 0) tacoz_close(w->fd);
+    if (w->tmp_path) tacoz_unlink(w->tmp_path);
+    writer_free(w);
+}